@@ -510,6 +510,93 @@ void fe25519_invsqrt(fe25519 *r, const fe25519 *x)
   *r = t;
 }
 
+#define FE25519_BATCH_LANES 4
+
+static void fe25519_nsquare_lanes(fe25519 *r, const fe25519 *x, int n, unsigned long long lanes)
+{
+  unsigned long long l;
+  int i;
+  for (l = 0; l < lanes; ++l) fe25519_square(&r[l], &x[l]);
+  for (i = 1; i < n; ++i)
+    for (l = 0; l < lanes; ++l) fe25519_square(&r[l], &r[l]);
+}
+
+static void fe25519_mul_lanes(fe25519 *r, const fe25519 *x, const fe25519 *y, unsigned long long lanes)
+{
+  unsigned long long l;
+  for (l = 0; l < lanes; ++l) fe25519_mul(&r[l], &x[l], &y[l]);
+}
+
+// Same addition chain as fe25519_pow2523, but on up to FE25519_BATCH_LANES
+// independent inputs in lockstep.  The squarings of a single input form a
+// long dependency chain; interleaving several of them keeps the multiplier busy.
+static void fe25519_pow2523_lanes(fe25519 *out, const fe25519 *z, unsigned long long lanes)
+{
+  fe25519 t0[FE25519_BATCH_LANES];
+  fe25519 t1[FE25519_BATCH_LANES];
+  fe25519 t2[FE25519_BATCH_LANES];
+
+  fe25519_nsquare_lanes(t0, z, 1, lanes);
+  fe25519_nsquare_lanes(t1, t0, 2, lanes);
+  fe25519_mul_lanes(t1, z, t1, lanes);
+  fe25519_mul_lanes(t0, t0, t1, lanes);
+  fe25519_nsquare_lanes(t0, t0, 1, lanes);
+  fe25519_mul_lanes(t0, t1, t0, lanes);
+  fe25519_nsquare_lanes(t1, t0, 5, lanes);
+  fe25519_mul_lanes(t0, t1, t0, lanes);
+  fe25519_nsquare_lanes(t1, t0, 10, lanes);
+  fe25519_mul_lanes(t1, t1, t0, lanes);
+  fe25519_nsquare_lanes(t2, t1, 20, lanes);
+  fe25519_mul_lanes(t1, t2, t1, lanes);
+  fe25519_nsquare_lanes(t1, t1, 10, lanes);
+  fe25519_mul_lanes(t0, t1, t0, lanes);
+  fe25519_nsquare_lanes(t1, t0, 50, lanes);
+  fe25519_mul_lanes(t1, t1, t0, lanes);
+  fe25519_nsquare_lanes(t2, t1, 100, lanes);
+  fe25519_mul_lanes(t1, t2, t1, lanes);
+  fe25519_nsquare_lanes(t1, t1, 50, lanes);
+  fe25519_mul_lanes(t0, t1, t0, lanes);
+  fe25519_nsquare_lanes(t0, t0, 2, lanes);
+  fe25519_mul_lanes(out, t0, z, lanes);
+}
+
+// Sets r[i] to fe25519_invsqrt(x[i]) for 0 <= i < n.
+void fe25519_invsqrt_batch(fe25519 *r, const fe25519 *x, unsigned long long n)
+{
+  fe25519 den2, den4, den6, chk, t2;
+  fe25519 den3[FE25519_BATCH_LANES];
+  fe25519 t[FE25519_BATCH_LANES];
+  unsigned long long i, l, lanes;
+  int b;
+
+  for (i = 0; i < n; i += lanes) {
+    lanes = n - i < FE25519_BATCH_LANES ? n - i : FE25519_BATCH_LANES;
+
+    for (l = 0; l < lanes; ++l) {
+      fe25519_square(&den2, &x[i + l]);
+      fe25519_mul(&den3[l], &den2, &x[i + l]);
+      fe25519_square(&den4, &den2);
+      fe25519_mul(&den6, &den2, &den4);
+      fe25519_mul(&t[l], &den6, &x[i + l]); // x^7
+    }
+
+    fe25519_pow2523_lanes(t, t, lanes);
+
+    for (l = 0; l < lanes; ++l) {
+      fe25519_mul(&t[l], &t[l], &den3[l]);
+
+      fe25519_square(&chk, &t[l]);
+      fe25519_mul(&chk, &chk, &x[i + l]);
+
+      fe25519_mul(&t2, &t[l], &fe25519_sqrtm1);
+      b = 1 - fe25519_isone(&chk);
+      fe25519_cmov(&t[l], &t2, (unsigned char)b);
+
+      r[i + l] = t[l];
+    }
+  }
+}
+
 // Return x if x is positive, else return -x
 void fe25519_abs(fe25519* x, const fe25519* y)
 {
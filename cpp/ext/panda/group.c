@@ -247,29 +247,35 @@ int group_ge_unpack(group_ge *r, const unsigned char x[GROUP_GE_PACKEDBYTES])
   return -ret;
 }
 
-void group_ge_pack(unsigned char r[GROUP_GE_PACKEDBYTES], const group_ge *x)
+/* Computes u1, u2 and the value of which group_ge_pack needs the inverse square root */
+static void ge_pack_prepare(fe25519 *u1, fe25519 *u2, fe25519 *isrInput, const group_ge *x)
 {
-  fe25519 d, u1, u2, isr, i1, i2, zinv, deninv, nx, ny, s;
-  unsigned char b;
+  fe25519 d;
 
   /* u1    = mneg*(z+y)*(z-y) */
   fe25519_add(&d, &x->z, &x->y);
-  fe25519_sub(&u1, &x->z, &x->y);
-  fe25519_mul(&u1, &u1, &d);
+  fe25519_sub(u1, &x->z, &x->y);
+  fe25519_mul(u1, u1, &d);
 
   /* u2    = x*y # = t*z */
-  fe25519_mul(&u2, &x->x, &x->y);
+  fe25519_mul(u2, &x->x, &x->y);
 
   /* isr   = isqrt(u1*u2^2) */
-  fe25519_square(&isr, &u2);
-  fe25519_mul(&isr, &isr, &u1);
-  fe25519_invsqrt(&isr, &isr);
+  fe25519_square(isrInput, u2);
+  fe25519_mul(isrInput, isrInput, u1);
+}
+
+static void ge_pack_finish(unsigned char r[GROUP_GE_PACKEDBYTES], const group_ge *x,
+                           const fe25519 *u1, const fe25519 *u2, const fe25519 *isr)
+{
+  fe25519 d, i1, i2, zinv, deninv, nx, ny, s;
+  unsigned char b;
 
   /* i1    = isr*u1 # sqrt(mneg*(z+y)*(z-y))/(x*y) */
-  fe25519_mul(&i1, &isr, &u1);
+  fe25519_mul(&i1, isr, u1);
 
   /* i2    = isr*u2 # 1/sqrt(a*(y+z)*(y-z)) */
-  fe25519_mul(&i2, &isr, &u2);
+  fe25519_mul(&i2, isr, u2);
 
   /* z_inv = i1*i2*t # 1/z */
   fe25519_mul(&zinv, &i1, &i2);
@@ -307,6 +313,32 @@ void group_ge_pack(unsigned char r[GROUP_GE_PACKEDBYTES], const group_ge *x)
   fe25519_pack(r, &s);
 }
 
+void group_ge_pack(unsigned char r[GROUP_GE_PACKEDBYTES], const group_ge *x)
+{
+  fe25519 u1, u2, isr;
+
+  ge_pack_prepare(&u1, &u2, &isr, x);
+  fe25519_invsqrt(&isr, &isr);
+  ge_pack_finish(r, x, &u1, &u2, &isr);
+}
+
+#define GROUP_PACK_BATCH_CHUNK 32
+
+void group_ge_pack_batch(unsigned char *const *r, const group_ge *const *x, unsigned long long xlen)
+{
+  fe25519 u1[GROUP_PACK_BATCH_CHUNK], u2[GROUP_PACK_BATCH_CHUNK], isr[GROUP_PACK_BATCH_CHUNK];
+  unsigned long long i, j, n;
+
+  for (i = 0; i < xlen; i += n) {
+    n = xlen - i < GROUP_PACK_BATCH_CHUNK ? xlen - i : GROUP_PACK_BATCH_CHUNK;
+    for (j = 0; j < n; j++)
+      ge_pack_prepare(&u1[j], &u2[j], &isr[j], x[i + j]);
+    fe25519_invsqrt_batch(isr, isr, n);
+    for (j = 0; j < n; j++)
+      ge_pack_finish(r[i + j], x[i + j], &u1[j], &u2[j], &isr[j]);
+  }
+}
+
 void group_ge_add(group_ge *r, const group_ge *x, const group_ge *y)
 {
   ge25519_p1p1 t;
@@ -371,17 +403,66 @@ void group_ge_scalarmult_base(group_ge *r, const group_scalar *s)
   group_ge_scalarmult_table(r, &ge25519_base_table, s);
 }
 
+// Number of points handled by a single run of constant-time Straus.
+// Bounds the stack usage (lookup tables) to about 22KiB.
+#define GROUP_STRAUS_CT_CHUNK 8
+
+// Constant-time variant of Straus' method: like group_ge_scalarmult, but
+// the 5-bit windows of all scalars share the same doublings.
+static void multiscalarmult_straus(group_ge *r, const group_ge *x, const group_scalar *s, unsigned long long xlen)
+{
+  group_ge precomp[GROUP_STRAUS_CT_CHUNK][17], t;
+  signed char win5[GROUP_STRAUS_CT_CHUNK][51];
+  ge25519_p1p1 r_p1p1;
+  ge25519_p2 r_p2;
+  unsigned long long j;
+  int i, k;
+
+  for (j = 0; j < xlen; j++) {
+    scalar_window5(win5[j], s+j);
+    precomp[j][0] = group_ge_neutral;
+    precomp[j][1] = x[j];
+    for (i = 2; i < 16; i+=2)
+    {
+      group_ge_double(precomp[j]+i,precomp[j]+i/2);
+      group_ge_add(precomp[j]+i+1,precomp[j]+i,precomp[j]+1);
+    }
+    group_ge_double(precomp[j]+16,precomp[j]+8);
+  }
+
+  *r = group_ge_neutral;
+  for (i = 50; i >= 0; i--)
+  {
+    // set r to 32 * r
+    dbl_p1p1(&r_p1p1, (ge25519_p2 *)r);
+    for (k = 0; k < 4; k++) {
+      p1p1_to_p2(&r_p2, &r_p1p1);
+      dbl_p1p1(&r_p1p1, &r_p2);
+    }
+    p1p1_to_p3(r, &r_p1p1);
+
+    for (j = 0; j < xlen; j++) {
+      choose_t(&t, precomp[j], win5[j][i]);
+      group_ge_add(r, r, &t);
+    }
+  }
+}
+
 void group_ge_multiscalarmult(group_ge *r, const group_ge *x, const group_scalar *s, unsigned long long xlen)
 {
-  //TODO: Use Strauss
-  unsigned long long i;
+  group_ge acc = group_ge_neutral;
   group_ge t;
-  *r = group_ge_neutral;
-  for(i=0;i<xlen;i++)
-  {
-    group_ge_scalarmult(&t,x+i,s+i);
-    group_ge_add(r,r,&t);
+  unsigned long long n;
+
+  while (xlen > 0) {
+    n = xlen < GROUP_STRAUS_CT_CHUNK ? xlen : GROUP_STRAUS_CT_CHUNK;
+    multiscalarmult_straus(&t, x, s, n);
+    group_ge_add(&acc, &acc, &t);
+    x += n;
+    s += n;
+    xlen -= n;
   }
+  *r = acc;
 }
 
 int  group_ge_equals(const group_ge *x, const group_ge *y)
@@ -501,10 +582,117 @@ void group_ge_scalarmult_base_publicinputs(group_ge *r, const group_scalar *s)
   group_ge_scalarmult_table_publicinputs(r, &ge25519_base_table, s);
 }
 
+// Number of points handled by a single run of Straus' method.
+// Bounds the stack usage (lookup tables and NAFs) to about 24KiB.
+#define GROUP_STRAUS_CHUNK 16
+
+// Straus' (a.k.a. Shamir's) trick with a width-5 NAF for each scalar:
+// all scalar multiplications share the same sequence of doublings.
+static void multiscalarmult_straus_publicinputs(group_ge *r, const group_ge *x, const group_scalar *s, unsigned long long xlen)
+{
+  group_ge lut[GROUP_STRAUS_CHUNK][8];
+  signed char naf[GROUP_STRAUS_CHUNK][256];
+  group_ge dblX;
+  ge25519_p1p1 cp;
+  unsigned long long j;
+  int i, k, top = -1;
+
+  for (j = 0; j < xlen; j++) {
+    // lut[j][k] = (2k+1) * x[j]
+    group_ge_double(&dblX, x+j);
+    lut[j][0] = x[j];
+    for (k = 1; k < 8; k++)
+      group_ge_add(&lut[j][k], &lut[j][k-1], &dblX);
+
+    for (i = 0; i < 256; i++)
+      naf[j][i] = 0;
+    scalar_wnaf5(naf[j], s+j);
+    for (i = 255; i > top; i--) {
+      if (naf[j][i] != 0) {
+        top = i;
+        break;
+      }
+    }
+  }
+
+  *r = group_ge_neutral;
+  for (i = top; i >= 0; i--) {
+    if (i != top)
+      group_ge_double(r, r);
+    for (j = 0; j < xlen; j++) {
+      if (naf[j][i] > 0) {
+        add_p1p1(&cp, r, &lut[j][(naf[j][i]-1)/2]);
+        p1p1_to_p3(r, &cp);
+      } else if (naf[j][i] < 0) {
+        sub_p1p1(&cp, r, &lut[j][(-naf[j][i]-1)/2]);
+        p1p1_to_p3(r, &cp);
+      }
+    }
+  }
+}
+
 void group_ge_multiscalarmult_publicinputs(group_ge *r, const group_ge *x, const group_scalar *s, unsigned long long xlen)
 {
-  //TODO: Use Bos-Coster (and something else for small values of xlen)
-  group_ge_multiscalarmult(r,x,s,xlen);
+  group_ge acc = group_ge_neutral;
+  group_ge t;
+  unsigned long long n;
+
+  while (xlen > 0) {
+    n = xlen < GROUP_STRAUS_CHUNK ? xlen : GROUP_STRAUS_CHUNK;
+    multiscalarmult_straus_publicinputs(&t, x, s, n);
+    group_ge_add(&acc, &acc, &t);
+    x += n;
+    s += n;
+    xlen -= n;
+  }
+  *r = acc;
+}
+
+void group_ge_multiscalarmult_pippenger_publicinputs(group_ge *r, const group_ge *x, const group_scalar *s, unsigned long long xlen,
+                                                     int w, group_ge *buckets, int16_t *digits)
+{
+  int ndigits = scalar_signed_window_digits(w);
+  int nbuckets = 1 << (w-1);
+  int i, b;
+  int16_t d;
+  unsigned long long j;
+  group_ge acc = group_ge_neutral;
+  group_ge running, sum;
+  ge25519_p1p1 cp;
+
+  for (j = 0; j < xlen; j++)
+    scalar_signed_window(digits + j*(unsigned long long)ndigits, s+j, w);
+
+  for (i = ndigits-1; i >= 0; i--) {
+    if (i != ndigits-1) {
+      for (b = 0; b < w; b++)
+        group_ge_double(&acc, &acc);
+    }
+
+    // Bucket b collects the points whose digit is +/-(b+1)
+    for (b = 0; b < nbuckets; b++)
+      buckets[b] = group_ge_neutral;
+    for (j = 0; j < xlen; j++) {
+      d = digits[j*(unsigned long long)ndigits + (unsigned long long)i];
+      if (d > 0) {
+        add_p1p1(&cp, buckets+d-1, x+j);
+        p1p1_to_p3(buckets+d-1, &cp);
+      } else if (d < 0) {
+        sub_p1p1(&cp, buckets-d-1, x+j);
+        p1p1_to_p3(buckets-d-1, &cp);
+      }
+    }
+
+    // sum = sum_b (b+1) * buckets[b], using running sums
+    running = group_ge_neutral;
+    sum = group_ge_neutral;
+    for (b = nbuckets-1; b >= 0; b--) {
+      group_ge_add(&running, &running, buckets+b);
+      group_ge_add(&sum, &sum, &running);
+    }
+    group_ge_add(&acc, &acc, &sum);
+  }
+  *r = acc;
 }
 
 int  group_ge_equals_publicinputs(const group_ge *x, const group_ge *y)
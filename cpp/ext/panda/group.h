@@ -36,6 +36,8 @@ void group_ge_scalarmult_table_publicinputs(group_ge *r, const group_scalarmult_
 // Constant-time versions
 int  group_ge_unpack(group_ge *r, const unsigned char x[GROUP_GE_PACKEDBYTES]);
 void group_ge_pack(unsigned char r[GROUP_GE_PACKEDBYTES], const group_ge *x);
+// Packs x[i] into r[i] for 0 <= i < xlen, which is faster than packing them one by one.
+void group_ge_pack_batch(unsigned char *const *r, const group_ge *const *x, unsigned long long xlen);
 
 void group_ge_hashfromstr(group_ge *r, const unsigned char *s, unsigned long long slen);
 void group_ge_add(group_ge *r, const group_ge *x, const group_ge *y);
@@ -55,6 +57,11 @@ void group_ge_negate_publicinputs(group_ge *r, const group_ge *x);
 void group_ge_scalarmult_publicinputs(group_ge *r, const group_ge *x, const group_scalar *s);
 void group_ge_scalarmult_base_publicinputs(group_ge *r, const group_scalar *s);
 void group_ge_multiscalarmult_publicinputs(group_ge *r, const group_ge *x, const group_scalar *s, unsigned long long xlen);
+// Pippenger's bucket method with windows of w bits, which outperforms
+// group_ge_multiscalarmult_publicinputs for large xlen.  The caller provides
+// scratch space: 2^(w-1) buckets and xlen*scalar_signed_window_digits(w) digits.
+void group_ge_multiscalarmult_pippenger_publicinputs(group_ge *r, const group_ge *x, const group_scalar *s, unsigned long long xlen,
+                                                     int w, group_ge *buckets, int16_t *digits);
 int  group_ge_equals_publicinputs(const group_ge *x, const group_ge *y);
 int  group_ge_isneutral_publicinputs(const group_ge *x);
 
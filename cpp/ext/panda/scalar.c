@@ -1681,6 +1681,35 @@ void scalar_from64bytes(group_scalar *r, const unsigned char t[64])
   r->v[31] = (uint8_t)(t11 >> 17);
 }
 
+// Computes signed radix-2^w digits r[i] in [-2^(w-1), 2^(w-1)) with
+// s = sum_i r[i]*2^(w*i). r must have room for
+// scalar_signed_window_digits(w) digits; 2 <= w <= 15.
+int scalar_signed_window_digits(int w)
+{
+  // One extra digit for the final carry
+  return (256 + w - 1) / w + 1;
+}
+
+void scalar_signed_window(int16_t *r, const group_scalar *s, int w)
+{
+  int i, bit, pos, n = scalar_signed_window_digits(w) - 1;
+  int32_t d, carry = 0;
+
+  for (i = 0; i < n; i++) {
+    d = 0;
+    for (bit = 0; bit < w; bit++) {
+      pos = w*i + bit;
+      if (pos >= 256)
+        break;
+      d |= (int32_t)((s->v[pos >> 3] >> (pos & 7)) & 1) << bit;
+    }
+    d += carry;
+    carry = (d + (1 << (w-1))) >> w;
+    r[i] = (int16_t)(d - (carry << w));
+  }
+  r[n] = (int16_t)carry;
+}
+
 // Computes the w=5 w-NAF of s and store it into naf.
 //
 // naf is assumed to be zero-initialized and the highest three bits of s
@@ -38,6 +38,10 @@ void scalar_window4(signed char r[64], const group_scalar *s);
 void scalar_window5(signed char r[51], const group_scalar *s);
 void scalar_slide(signed char r[256], const group_scalar *s, int swindowsize);
 void scalar_wnaf5(signed char r[256], const group_scalar *s);
+// Signed radix-2^w digits r[i] in [-2^(w-1), 2^(w-1)) with s = sum_i r[i]*2^(w*i).
+// r must have room for scalar_signed_window_digits(w) digits; 2 <= w <= 15.
+int  scalar_signed_window_digits(int w);
+void scalar_signed_window(int16_t *r, const group_scalar *s, int w);
 
 void scalar_from64bytes(group_scalar *r, const unsigned char h[64]);
 void scalar_hashfromstr(group_scalar *r, const unsigned char *s, unsigned long long slen);
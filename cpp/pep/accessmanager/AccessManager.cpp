@@ -9,6 +9,8 @@
 #include <pep/async/RxIterate.hpp>
 #include <pep/auth/EnrolledParty.hpp>
 #include <pep/auth/UserGroup.hpp>
+#include <pep/database/StorageProfile.PropertySerializer.hpp>
+#include <pep/elgamal/ElgamalEncryptionBatch.hpp>
 #include <pep/morphing/MorphingPropertySerializers.hpp>
 #include <pep/morphing/RepoRecipient.hpp>
 #include <pep/networking/EndPoint.PropertySerializer.hpp>
@@ -26,6 +28,7 @@
 
 #include <numeric>
 #include <ranges>
+#include <span>
 #include <sstream>
 #include <chrono>
 
@@ -60,7 +63,6 @@ void FillTranscryptorRequestEntry(
       pseudonymTranslator.certifiedTranslateStep(
           entry.polymorphic,
           RecipientForServer(EnrolledParty::Transcryptor));
-  entry.ensurePacked();
 }
 
 const std::string LogTag ("AccessManager");
@@ -68,6 +70,13 @@ const Severity TicketRequestLoggingSeverity = Severity::Debug;
 
 constexpr size_t TsRequestBatchSize = 400U;
 
+// Number of polymorphic pseudonyms from the database that a worker rerandomizes at once.
+// Large enough for ElgamalEncryptionBatch::rerandomize() to precompute a table for the public key.
+constexpr size_t RerandomizeChunkSize = 64U;
+
+// Number of local pseudonyms that a worker decrypts (and packs) at once.
+constexpr size_t DecryptChunkSize = 64U;
+
 const size_t MaxAmaQueryResponseStrings = 25000; // See https://gitlab.pep.cs.ru.nl/pep/core/-/issues/2089#note_25719
 const std::size_t AmaQueryResponseStringsWarningThreshold = static_cast<std::size_t>(0.8 * MaxAmaQueryResponseStrings);
 
@@ -170,6 +179,7 @@ AccessManager::Parameters::Parameters(std::shared_ptr<boost::asio::io_context> i
   std::filesystem::path globalConfFile;
 
   std::filesystem::path storageFile;
+  std::optional<database::StorageProfile> storageProfile;
 
   try {
     keysFile = config.get<std::filesystem::path>("EnrolledPartyKeysFile");
@@ -180,6 +190,7 @@ AccessManager::Parameters::Parameters(std::shared_ptr<boost::asio::io_context> i
     keyServerEndPoint_ = serverEndPoints.get<EndPoint>(ServerTraits::KeyServer().configNode());
 
     storageFile = config.get<std::filesystem::path>("StorageFile");
+    storageProfile = config.get<std::optional<database::StorageProfile>>("StorageProfile");
   }
   catch (std::exception& e) {
     PEP_LOG(LogTag, Severity::Critical) << "Error with configuration file: " << e.what();
@@ -199,7 +210,7 @@ AccessManager::Parameters::Parameters(std::shared_ptr<boost::asio::io_context> i
     Serialization::FromJsonString<GlobalConfiguration>(
       ReadFile(globalConfFile)));
   setGlobalConfiguration(globalConf);
-  setBackend(std::make_shared<AccessManager::Backend>(storageFile, globalConf));
+  setBackend(std::make_shared<AccessManager::Backend>(storageFile, globalConf, storageProfile.value_or(database::StorageProfile())));
 }
 
 void AccessManager::Parameters::setGlobalConfiguration(std::shared_ptr<GlobalConfiguration> gc) {
@@ -400,7 +411,6 @@ AccessManager::handleEncryptionKeyRequest(std::shared_ptr<SignedEncryptionKeyReq
                       blindingAD.content,
                       blindingAD.invertComponent
                     );
-                    key.ensurePacked();
                   } else if (entry.keyBlindMode == KeyBlindMode::Unblind) {
                     // do nothing --- we need the transcryptor to help out
                   } else {
@@ -409,6 +419,9 @@ AccessManager::handleEncryptionKeyRequest(std::shared_ptr<SignedEncryptionKeyReq
                     throw Error(msg.str());
                   }
                   return key;
+                },
+                [](std::span<EncryptedKey> keys) {
+                  ElgamalEncryption::EnsurePacked(keys);
                 })
               .flat_map([start_time, server, dwNumUnblind, lpResponse, request, clientCertificateChain, recipient, localPseudonyms
                 ](std::vector<EncryptedKey> keys) -> messaging::MessageBatches {
@@ -490,8 +503,13 @@ AccessManager::handleEncryptionKeyRequest(std::shared_ptr<SignedEncryptionKeyReq
                                 blindingAD.content,
                                 blindingAD.invertComponent,
                                 *recipient);
-                              key.ensurePacked();
                               return i; // we have to return something
+                            },
+                            [lpResponse](std::span<size_t> is) {
+                              std::vector<const CurvePoint*> points;
+                              for (auto i : is)
+                                lpResponse->keys[i].addPointsTo(points);
+                              CurvePoint::PackBatch(points);
                             })
                           .map([server, lpResponse, start_time](std::vector<size_t>) {
                             server->lpMetrics_->enckeyRequestDuration.Observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
@@ -606,24 +624,43 @@ AccessManager::handleTicketRequest2(std::shared_ptr<SignedTicketRequest2> signed
   // more often, it's better to change batched_map()
   auto indexes = RangeToVector(views::iota(std::size_t{}, ctx->pps.size()));
   messaging::MessageBatches result =
-    ctx->server->workerPool_->batched_map<8>(std::move(indexes),
+    ctx->server->workerPool_->chunked_map<RerandomizeChunkSize>(std::move(indexes),
         ObserveOnAsio(*ctx->server->getIoContext()),
-      [ctx](size_t i) {
-    const Backend::Pp& pp = ctx->pps[i];
-    TranscryptorRequestEntry& entry = ctx->tsReqEntries.entries[i];
-
+      [ctx](std::span<size_t> is) {
     // Rerandomize old PPs (ie. from the database)
     // To prevent multiple users receiving identical PPs
-    if (pp.isClientProvided)
-      entry.polymorphic = pp.pp;
-    else
-      entry.polymorphic = pp.pp.rerandomize();
-
+    ElgamalEncryptionBatch old;
+    std::vector<size_t> oldIndexes;
+    for (auto i : is) {
+      const Backend::Pp& pp = ctx->pps[i];
+      if (pp.isClientProvided) {
+        ctx->tsReqEntries.entries[i].polymorphic = pp.pp;
+      }
+      else {
+        old.push_back(pp.pp.getValidElgamalEncryption());
+        oldIndexes.push_back(i);
+      }
+    }
+    auto rerandomized = old.rerandomize();
+    for (size_t j = 0; j < oldIndexes.size(); j++)
+      ctx->tsReqEntries.entries[oldIndexes[j]].polymorphic = PolymorphicPseudonym(rerandomized[j]);
+    return std::vector<size_t>(is.begin(), is.end());
+  }).flat_map([ctx](std::vector<size_t> indexes) {
+    return ctx->server->workerPool_->batched_map<8>(std::move(indexes),
+        ObserveOnAsio(*ctx->server->getIoContext()),
+      [ctx](size_t i) {
     FillTranscryptorRequestEntry(
-        entry,
+        ctx->tsReqEntries.entries[i],
         ctx->server->pseudonymTranslator(),
         ctx->userRecipient);
     return i;
+  },
+  [ctx](std::span<size_t> is) {
+    std::vector<const CurvePoint*> points;
+    for (auto i : is)
+      ctx->tsReqEntries.entries[i].addPointsTo(points);
+    CurvePoint::PackBatch(points);
+  });
   }).flat_map([ctx](std::vector<size_t> is) {
     // Send request to transcryptor
 
@@ -654,26 +691,47 @@ AccessManager::handleTicketRequest2(std::shared_ptr<SignedTicketRequest2> signed
     if (ctx->ticket.userGroup == UserGroup::DataAdministrator && !ctx->ticket.accessSubjects.empty()) {
       PEP_LOG(LogTag, Severity::Info) << "Granting " << ctx->ticket.userGroup << " unchecked access to " << ctx->ticket.accessSubjects.size() << " participant(s)";
     }
-    for (size_t i = 0; i < ctx->ticket.accessSubjects.size(); i++) {
-      LocalPseudonym localPseudonym = ctx->ticket.accessSubjects[i].accessManager.decrypt(ctx->server->pseudonymKey_);
+
+    // Decrypt the local pseudonyms on the worker pool. They are packed there as well,
+    // so that looking them up in the database on the IO thread is cheap.
+    auto indexes = RangeToVector(views::iota(std::size_t{}, ctx->ticket.accessSubjects.size()));
+    return ctx->server->workerPool_->chunked_map<DecryptChunkSize>(std::move(indexes),
+        ObserveOnAsio(*ctx->server->getIoContext()),
+      [ctx](std::span<size_t> is) {
+      std::vector<LocalPseudonym> localPseudonyms;
+      localPseudonyms.reserve(is.size());
+      for (auto i : is) {
+        localPseudonyms.push_back(ctx->ticket.accessSubjects[i].accessManager.decrypt(ctx->server->pseudonymKey_));
+      }
+      std::vector<const CurvePoint*> points;
+      points.reserve(localPseudonyms.size());
+      for (const auto& localPseudonym : localPseudonyms) {
+        points.push_back(&localPseudonym.getValidCurvePoint());
+      }
+      CurvePoint::PackBatch(points);
+      return localPseudonyms;
+    }).flat_map([ctx, id = std::move(resp.id)](std::vector<LocalPseudonym> localPseudonyms) {
+      // Back on the IO thread: the backend's storage is not thread safe
       if (ctx->ticket.userGroup != UserGroup::DataAdministrator) {
-        ctx->server->backend_->checkParticipantAccess(ctx->ticket.userGroup, localPseudonym, ctx->participantModes, ctx->ticket.timestamp);
+        ctx->server->backend_->checkParticipantsAccess(ctx->ticket.userGroup, localPseudonyms, ctx->participantModes, ctx->ticket.timestamp);
       }
-      if (ctx->pps[i].isClientProvided && !ctx->server->backend_->hasLocalPseudonym(localPseudonym)) {
-        if (ctx->ticket.hasMode("write")) {
-          ctx->server->backend_->storeLocalPseudonymAndPP(localPseudonym, ctx->ticket.accessSubjects[i].polymorphic);
+      if (ctx->ticket.hasMode("write")) {
+        for (size_t i = 0; i < localPseudonyms.size(); i++) {
+          if (ctx->pps[i].isClientProvided && !ctx->server->backend_->hasLocalPseudonym(localPseudonyms[i])) {
+            ctx->server->backend_->storeLocalPseudonymAndPP(localPseudonyms[i], ctx->ticket.accessSubjects[i].polymorphic);
+          }
         }
       }
-    }
 
-    // All seems fine: finally, we log the ticket at the transcryptor
-    ctx->signedTicket = SignedTicket2(std::move(ctx->ticket), *ctx->server->getSigningIdentity());
+      // All seems fine: finally, we log the ticket at the transcryptor
+      ctx->signedTicket = SignedTicket2(std::move(ctx->ticket), *ctx->server->getSigningIdentity());
 
-    LogIssuedTicketRequest logReq;
-    logReq.ticket = ctx->signedTicket;
-    logReq.id = resp.id;
-    PEP_LOG(LogTag, TicketRequestLoggingSeverity) << "Ticket request " << ctx->requestNumber << " logging issued ticket";
-    return ctx->server->transcryptorProxy_.requestLogIssuedTicket(std::move(logReq));
+      LogIssuedTicketRequest logReq;
+      logReq.ticket = ctx->signedTicket;
+      logReq.id = id;
+      PEP_LOG(LogTag, TicketRequestLoggingSeverity) << "Ticket request " << ctx->requestNumber << " logging issued ticket";
+      return ctx->server->transcryptorProxy_.requestLogIssuedTicket(std::move(logReq));
+    });
   }).map([ctx](LogIssuedTicketResponse resp) {
     PEP_LOG(LogTag, TicketRequestLoggingSeverity) << "Ticket request " << ctx->requestNumber << " finishing up";
     ctx->signedTicket.addTranscryptorSignature(std::move(resp.signature));
@@ -760,6 +818,10 @@ rxcpp::observable<FakeVoid> AccessManager::removeOrAddParticipantsInGroupsForReq
       entry.polymorphic = list[i];
           FillTranscryptorRequestEntry(entry, self->pseudonymTranslator());
     }
+    std::vector<const CurvePoint*> points;
+    for (const auto& entry : tsRequestEntries.entries)
+      entry.addPointsTo(points);
+    CurvePoint::PackBatch(points);
     return self->transcryptorProxy_.requestTranscryption(std::move(tsRequest), messaging::MakeSingletonTail(tsRequestEntries))
       .map([server = SharedFrom(*self), participantGroup, performRemove](const TranscryptorResponse& resp) -> FakeVoid {
         for (const LocalPseudonyms& pseudonyms : resp.entries) {
@@ -838,12 +900,26 @@ AccessManager::handleAmaQuery(std::shared_ptr<SignedAmaQuery> signedRequest) {
          });
 }
 
+template <typename TQuery>
+auto AccessManager::queryBackend(TQuery query) {
+  if (!backend_->hasReadConnections()) {
+    return rxcpp::observable<>::just(query(*backend_)).as_dynamic();
+  }
+  return rxcpp::observable<>::just(backend_)
+    .observe_on(workerPool_->worker())
+    .map([query = std::move(query)](std::shared_ptr<Backend> backend) { return query(*backend); })
+    .observe_on(ObserveOnAsio(*getIoContext()))
+    .as_dynamic();
+}
+
 messaging::MessageBatches AccessManager::handleUserQuery(std::shared_ptr<SignedUserQuery> signedRequest) {
   auto certified = signedRequest->open(*this->getRootCAs());
-  const auto& request = certified.message;
   auto accessGroup = certified.signatory.organizationalUnit();
 
-  return messaging::BatchSingleMessage(backend_->performUserQuery(request, accessGroup));
+  return queryBackend([request = certified.message, accessGroup](Backend& backend) { return backend.performUserQuery(request, accessGroup); })
+    .map([](UserQueryResponse response) -> messaging::MessageSequence {
+      return rxcpp::rxs::just(std::make_shared<std::string>(Serialization::ToString(std::move(response))));
+    });
 }
 
 messaging::MessageBatches AccessManager::handleUserMutationRequest(std::shared_ptr<SignedUserMutationRequest> signedRequest) {
@@ -946,16 +1022,16 @@ messaging::MessageBatches AccessManager::handleFindUserRequest(
 
 messaging::MessageBatches AccessManager::handleStructureMetadataRequest(std::shared_ptr<SignedStructureMetadataRequest> signedRequest) {
   auto certified = signedRequest->open(*this->getRootCAs());
-  const auto& request = certified.message;
   auto userGroup = certified.signatory.organizationalUnit();
 
-  auto entries = backend_->handleStructureMetadataRequest(request, userGroup);
-  return
-      RxIterate(std::move(entries))
-      .map([](StructureMetadataEntry entry) {
-        return rxcpp::observable<>::from(std::make_shared<std::string>(Serialization::ToString(std::move(entry))))
-            .as_dynamic();
-      });
+  return queryBackend([request = certified.message, userGroup](Backend& backend) { return backend.handleStructureMetadataRequest(request, userGroup); })
+    .flat_map([](std::vector<StructureMetadataEntry> entries) {
+      return RxIterate(std::move(entries))
+        .map([](StructureMetadataEntry entry) {
+          return rxcpp::observable<>::from(std::make_shared<std::string>(Serialization::ToString(std::move(entry))))
+              .as_dynamic();
+        });
+    });
 }
 
 messaging::MessageBatches AccessManager::handleSetStructureMetadataRequest(
@@ -100,6 +100,11 @@ private:
   rxcpp::observable<FakeVoid> addParticipantsToGroupsForRequest(const AmaMutationRequest& amRequest);
   rxcpp::observable<FakeVoid> removeParticipantsFromGroupsForRequest(const AmaMutationRequest& amRequest);
 
+  /// \brief Produces the result of a read-only Backend query, which runs on the worker pool if the backend has read connections.
+  /// \remark Without read connections, the query shares the connection that mutations use, so it runs (synchronously) on the I/O thread.
+  template <typename TQuery>
+  auto queryBackend(TQuery query);
+
 
 public:
   /// \brief Splits up the given columnGroups over multiple responses to make sure the response message lengths do not exceed their max size.
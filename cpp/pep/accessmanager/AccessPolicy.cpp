@@ -0,0 +1,165 @@
+#include <pep/accessmanager/AccessPolicy.hpp>
+
+#include <ranges>
+
+namespace pep {
+
+namespace {
+
+const std::set<std::string> NoGroups;
+const std::set<ColumnGroupAccessRule> NoColumnGroupAccessRules;
+
+}
+
+AccessPolicy::AccessPolicy()
+  : lastChanged_(TimeNow()) {
+}
+
+void AccessPolicy::changed() {
+  lastChanged_ = TimeNow();
+}
+
+size_t AccessPolicy::getOrAddParticipantIndex(const LocalPseudonym& localPseudonym) {
+  auto [position, added] = participantIndices_.try_emplace(std::string(localPseudonym.pack()), participantIndices_.size());
+  if (added) {
+    // Keep all sets the same size so that they can be combined with bitwise operators
+    for (auto& members : std::views::values(participantGroupMembers_)) {
+      members.push_back(false);
+    }
+  }
+  return position->second;
+}
+
+std::optional<size_t> AccessPolicy::findParticipantIndex(const LocalPseudonym& localPseudonym) const {
+  auto position = participantIndices_.find(std::string(localPseudonym.pack()));
+  if (position == participantIndices_.end()) {
+    return std::nullopt;
+  }
+  return position->second;
+}
+
+void AccessPolicy::addParticipantToGroup(const LocalPseudonym& localPseudonym, const std::string& participantGroup) {
+  auto index = this->getOrAddParticipantIndex(localPseudonym);
+  auto [position, added] = participantGroupMembers_.try_emplace(participantGroup);
+  if (added) {
+    position->second.resize(this->participantCount());
+  }
+  position->second.set(index);
+  this->changed();
+}
+
+void AccessPolicy::removeParticipantFromGroup(const LocalPseudonym& localPseudonym, const std::string& participantGroup) {
+  auto index = this->findParticipantIndex(localPseudonym);
+  auto position = participantGroupMembers_.find(participantGroup);
+  if (index.has_value() && position != participantGroupMembers_.end()) {
+    position->second.reset(*index);
+  }
+  this->changed();
+}
+
+void AccessPolicy::addParticipantGroupAccessRule(const std::string& participantGroup, const std::string& userGroup, const std::string& mode) {
+  participantGroupRules_[userGroup][mode].insert(participantGroup);
+  this->changed();
+}
+
+void AccessPolicy::removeParticipantGroupAccessRule(const std::string& participantGroup, const std::string& userGroup, const std::string& mode) {
+  participantGroupRules_[userGroup][mode].erase(participantGroup);
+  this->changed();
+}
+
+const std::set<std::string>& AccessPolicy::getGrantingParticipantGroups(const std::string& userGroup, const std::string& mode) const {
+  auto modes = participantGroupRules_.find(userGroup);
+  if (modes == participantGroupRules_.end()) {
+    return NoGroups;
+  }
+  auto groups = modes->second.find(mode);
+  if (groups == modes->second.end()) {
+    return NoGroups;
+  }
+  return groups->second;
+}
+
+std::optional<AccessPolicy::ParticipantSet> AccessPolicy::getGrantedParticipants(const std::string& userGroup, const std::string& mode) const {
+  const auto& groups = this->getGrantingParticipantGroups(userGroup, mode);
+  if (groups.contains("*")) { // All participants are implicitly in "*"
+    return std::nullopt;
+  }
+
+  ParticipantSet result(this->participantCount());
+  for (const auto& group : groups) {
+    auto members = participantGroupMembers_.find(group);
+    if (members != participantGroupMembers_.end()) {
+      result |= members->second;
+    }
+  }
+  return result;
+}
+
+void AccessPolicy::addColumnGroup(const std::string& columnGroup) {
+  columnGroups_.insert(columnGroup);
+  this->changed();
+}
+
+void AccessPolicy::removeColumnGroup(const std::string& columnGroup) {
+  columnGroups_.erase(columnGroup);
+  this->changed();
+}
+
+void AccessPolicy::addColumnToGroup(const std::string& column, const std::string& columnGroup) {
+  columnGroupColumns_.insert(ColumnGroupColumn{ .columnGroup = columnGroup, .column = column });
+  columnGroupsByColumn_[column].insert(columnGroup);
+  this->changed();
+}
+
+void AccessPolicy::removeColumnFromGroup(const std::string& column, const std::string& columnGroup) {
+  columnGroupColumns_.erase(ColumnGroupColumn{ .columnGroup = columnGroup, .column = column });
+  auto groups = columnGroupsByColumn_.find(column);
+  if (groups != columnGroupsByColumn_.end()) {
+    groups->second.erase(columnGroup);
+    if (groups->second.empty()) {
+      columnGroupsByColumn_.erase(groups);
+    }
+  }
+  this->changed();
+}
+
+void AccessPolicy::addColumnGroupAccessRule(const std::string& columnGroup, const std::string& userGroup, const std::string& mode) {
+  columnGroupRules_[userGroup].insert(ColumnGroupAccessRule{ .columnGroup = columnGroup, .userGroup = userGroup, .mode = mode });
+  this->changed();
+}
+
+void AccessPolicy::removeColumnGroupAccessRule(const std::string& columnGroup, const std::string& userGroup, const std::string& mode) {
+  columnGroupRules_[userGroup].erase(ColumnGroupAccessRule{ .columnGroup = columnGroup, .userGroup = userGroup, .mode = mode });
+  this->changed();
+}
+
+const std::set<std::string>& AccessPolicy::getColumnGroupsContaining(const std::string& column) const {
+  auto position = columnGroupsByColumn_.find(column);
+  if (position == columnGroupsByColumn_.end()) {
+    return NoGroups;
+  }
+  return position->second;
+}
+
+std::set<ColumnGroupColumn> AccessPolicy::getColumnGroupColumns(std::span<const std::string> columnGroups) const {
+  std::set<ColumnGroupColumn> result;
+  for (const auto& columnGroup : columnGroups) {
+    // Entries are ordered by column group first, so the group's columns are adjacent
+    for (auto i = columnGroupColumns_.lower_bound(ColumnGroupColumn{ .columnGroup = columnGroup, .column = {} });
+         i != columnGroupColumns_.end() && i->columnGroup == columnGroup;
+         ++i) {
+      result.insert(*i);
+    }
+  }
+  return result;
+}
+
+const std::set<ColumnGroupAccessRule>& AccessPolicy::getColumnGroupAccessRules(const std::string& userGroup) const {
+  auto position = columnGroupRules_.find(userGroup);
+  if (position == columnGroupRules_.end()) {
+    return NoColumnGroupAccessRules;
+  }
+  return position->second;
+}
+
+}
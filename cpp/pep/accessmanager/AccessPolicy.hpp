@@ -0,0 +1,80 @@
+#pragma once
+
+#include <pep/accessmanager/Records.hpp>
+#include <pep/utils/Timestamp.hpp>
+
+#include <optional>
+#include <set>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+#include <boost/dynamic_bitset.hpp>
+
+namespace pep {
+
+/// \brief In-memory copy of the current participant-group and column-group access policy of the access manager.
+/// \details Contains participant-group memberships (as bitsets over a dense participant index), column-group memberships,
+/// and the access rules for both kinds of groups, so that the (frequent) access checks for tickets don't have to query
+/// the time-travelling database tables. AccessManager::Backend::Storage keeps the policy up to date as it records changes.
+/// The policy only reflects the state at (or after) the time of the last change: access checks for earlier moments in
+/// time must query the database instead.
+class AccessPolicy {
+public:
+  /// Set of participants, indexed by the participants' findParticipantIndex(). Always has participantCount() bits.
+  using ParticipantSet = boost::dynamic_bitset<uint64_t>;
+
+  AccessPolicy();
+
+  /// Whether the policy reflects the state at the specified moment in time, i.e. the policy hasn't changed since.
+  bool isCurrentAt(Timestamp at) const noexcept { return at >= lastChanged_; }
+
+  /* Participant groups */
+  void addParticipantToGroup(const LocalPseudonym& localPseudonym, const std::string& participantGroup);
+  void removeParticipantFromGroup(const LocalPseudonym& localPseudonym, const std::string& participantGroup);
+  void addParticipantGroupAccessRule(const std::string& participantGroup, const std::string& userGroup, const std::string& mode);
+  void removeParticipantGroupAccessRule(const std::string& participantGroup, const std::string& userGroup, const std::string& mode);
+
+  size_t participantCount() const noexcept { return participantIndices_.size(); }
+  /// \return The participant's index into ParticipantSets, or std::nullopt if the participant has never been in a participant group
+  std::optional<size_t> findParticipantIndex(const LocalPseudonym& localPseudonym) const;
+
+  /// \brief Gets the participant groups for which the user group has been granted the mode.
+  const std::set<std::string>& getGrantingParticipantGroups(const std::string& userGroup, const std::string& mode) const;
+  /// \brief Gets the participants for which the user group has been granted the mode, i.e. the members of the granting participant groups.
+  /// \return The granted participants, or std::nullopt if the mode has been granted for participant group "*", i.e. for all participants
+  std::optional<ParticipantSet> getGrantedParticipants(const std::string& userGroup, const std::string& mode) const;
+
+  /* Column groups */
+  void addColumnGroup(const std::string& columnGroup);
+  void removeColumnGroup(const std::string& columnGroup);
+  void addColumnToGroup(const std::string& column, const std::string& columnGroup);
+  void removeColumnFromGroup(const std::string& column, const std::string& columnGroup);
+  void addColumnGroupAccessRule(const std::string& columnGroup, const std::string& userGroup, const std::string& mode);
+  void removeColumnGroupAccessRule(const std::string& columnGroup, const std::string& userGroup, const std::string& mode);
+
+  const std::set<std::string>& getColumnGroups() const noexcept { return columnGroups_; }
+  /// \brief Gets the column groups containing the column.
+  const std::set<std::string>& getColumnGroupsContaining(const std::string& column) const;
+  /// \brief Gets the columns in the column groups, ordered like AccessManager::Backend::Storage::getColumnGroupColumns does.
+  std::set<ColumnGroupColumn> getColumnGroupColumns(std::span<const std::string> columnGroups) const;
+  /// \brief Gets the column-group access rules for the user group, ordered like AccessManager::Backend::Storage::getColumnGroupAccessRules does.
+  const std::set<ColumnGroupAccessRule>& getColumnGroupAccessRules(const std::string& userGroup) const;
+
+private:
+  void changed();
+  size_t getOrAddParticipantIndex(const LocalPseudonym& localPseudonym);
+
+  Timestamp lastChanged_;
+
+  std::unordered_map<std::string, size_t> participantIndices_; // By packed local pseudonym
+  std::unordered_map<std::string, ParticipantSet> participantGroupMembers_;
+  std::unordered_map<std::string, std::unordered_map<std::string, std::set<std::string>>> participantGroupRules_; // Participant groups by mode by user group
+
+  std::set<std::string> columnGroups_;
+  std::set<ColumnGroupColumn> columnGroupColumns_;
+  std::unordered_map<std::string, std::set<std::string>> columnGroupsByColumn_;
+  std::unordered_map<std::string, std::set<ColumnGroupAccessRule>> columnGroupRules_; // By user group
+};
+
+}
@@ -12,6 +12,8 @@
 
 #include <boost/algorithm/string/join.hpp>
 
+#include <unordered_set>
+
 namespace pep {
 
 namespace {
@@ -42,8 +44,8 @@ void EnsureStructureMetadataAccess(AccessMode mode, StructureMetadataType subjec
 
 }
 
-AccessManager::Backend::Backend(const std::filesystem::path& path, std::shared_ptr<GlobalConfiguration> globalConf)
-  : Backend(std::make_shared<AccessManager::Backend::Storage>(path, globalConf)) {
+AccessManager::Backend::Backend(const std::filesystem::path& path, std::shared_ptr<GlobalConfiguration> globalConf, database::StorageProfile storageProfile)
+  : Backend(std::make_shared<AccessManager::Backend::Storage>(path, globalConf, std::move(storageProfile))) {
 }
 
 // ********** START AMA Operations For Requests **********
@@ -334,24 +336,99 @@ void AccessManager::Backend::checkParticipantAccess(const std::string& userGroup
                                                    const LocalPseudonym& localPseudonym,
                                                    const std::vector<std::string>& modes,
                                                    Timestamp at) {
-  // What ParticipantGroups is this localPseudonym in?
-  auto pgps = storage_->getParticipantGroupParticipants(at, {.localPseudonyms = std::vector<LocalPseudonym>{localPseudonym}});
-  std::vector<std::string> participantGroups{"*"}; // All participants are implicitly added to "*"
-  participantGroups.reserve(participantGroups.size() + pgps.size());
-  std::transform(pgps.cbegin(), pgps.cend(), std::back_inserter(participantGroups), [](auto& entry) {
-    return entry.participantGroup;
-  });
+  this->checkParticipantsAccess(userGroup, std::span(&localPseudonym, 1), modes, at);
+}
 
-  std::vector<std::string> errorMessageParts;
+void AccessManager::Backend::checkParticipantsAccess(const std::string& userGroup,
+                                                    std::span<const LocalPseudonym> localPseudonyms,
+                                                    const std::vector<std::string>& modes,
+                                                    Timestamp at) {
+  if (localPseudonyms.empty()) {
+    return;
+  }
+
+  if (auto policy = storage_->getAccessPolicy(at)) {
+    // Intersect the (bit)sets of participants for which the userGroup has been granted each of the modes.
+    // Modes that are granted for all participants (i.e. for participant group "*") need no further checking.
+    std::vector<std::string> checkedModes;
+    std::vector<AccessPolicy::ParticipantSet> grantedPerMode;
+    for (auto& mode : modes) {
+      if (auto granted = policy->getGrantedParticipants(userGroup, mode)) {
+        checkedModes.push_back(mode);
+        grantedPerMode.push_back(std::move(*granted));
+      }
+    }
+    if (checkedModes.empty()) {
+      return;
+    }
+    auto grantedAllModes = grantedPerMode.front();
+    for (size_t i = 1; i < grantedPerMode.size(); ++i) {
+      grantedAllModes &= grantedPerMode[i];
+    }
+
+    for (auto& localPseudonym : localPseudonyms) {
+      auto index = policy->findParticipantIndex(localPseudonym);
+      if (index.has_value() && grantedAllModes.test(*index)) {
+        continue;
+      }
+      std::vector<std::string> errorMessageParts;
+      for (size_t i = 0; i < checkedModes.size(); ++i) {
+        if (!index.has_value() || !grantedPerMode[i].test(*index)) {
+          errorMessageParts.push_back("Access denied to participant for mode " + Logging::Escape(checkedModes[i]));
+        }
+      }
+      throw Error(boost::algorithm::join(errorMessageParts, "\n"));
+    }
+    return;
+  }
+
+  // The policy has changed since the requested time: query the database.
+  // What ParticipantGroups grant the userGroup the requested modes?
+  std::unordered_map<std::string, std::vector<std::string>> grantingGroups; // Per mode
+  for (auto& pgar : storage_->getParticipantGroupAccessRules(at, {.userGroups = std::vector<std::string>{userGroup}, .modes = modes})) {
+    grantingGroups[pgar.mode].push_back(pgar.participantGroup);
+  }
+
+  // All participants are implicitly added to "*", so modes granted for "*" need no further checking.
+  // For the other modes we look up the (packed) local pseudonyms in the granting groups.
+  std::vector<std::string> checkedModes, checkedGroups;
   for (auto& mode : modes) {
-    auto pgars = storage_->getParticipantGroupAccessRules(at, {.participantGroups = participantGroups, .userGroups = std::vector<std::string>{userGroup}, .modes = std::vector<std::string>{mode}});
-    if (pgars.empty()) { // Stating the opposite, if there is an access rule for ANY of the participantGroups, all is
-                         // well.
-      errorMessageParts.push_back("Access denied to participant for mode " + Logging::Escape(mode));
+    auto& groups = grantingGroups[mode];
+    if (std::find(groups.cbegin(), groups.cend(), "*") == groups.cend()) {
+      checkedModes.push_back(mode);
+      checkedGroups.insert(checkedGroups.end(), groups.cbegin(), groups.cend());
     }
   }
-  if (errorMessageParts.size() > 0) {
-    throw Error(boost::algorithm::join(errorMessageParts, "\n"));
+  if (checkedModes.empty()) {
+    return;
+  }
+
+  std::unordered_map<std::string, std::unordered_set<std::string>> participantsWithMode; // Per mode
+  if (!checkedGroups.empty()) {
+    std::unordered_map<std::string, std::vector<std::string>> participantsInGroup;
+    for (auto& pgp : storage_->getParticipantGroupParticipants(at, {.participantGroups = checkedGroups})) {
+      participantsInGroup[pgp.participantGroup].emplace_back(pgp.localPseudonym.begin(), pgp.localPseudonym.end());
+    }
+    for (auto& mode : checkedModes) {
+      auto& participants = participantsWithMode[mode];
+      for (auto& group : grantingGroups[mode]) {
+        auto& packed = participantsInGroup[group];
+        participants.insert(packed.begin(), packed.end());
+      }
+    }
+  }
+
+  for (auto& localPseudonym : localPseudonyms) {
+    auto packed = std::string(localPseudonym.pack());
+    std::vector<std::string> errorMessageParts;
+    for (auto& mode : checkedModes) {
+      if (!participantsWithMode[mode].contains(packed)) {
+        errorMessageParts.push_back("Access denied to participant for mode " + Logging::Escape(mode));
+      }
+    }
+    if (errorMessageParts.size() > 0) {
+      throw Error(boost::algorithm::join(errorMessageParts, "\n"));
+    }
   }
 }
 
@@ -420,16 +497,23 @@ void AccessManager::Backend::checkParticipantGroupAccess(std::span<const std::st
   }
   else {
     std::vector<std::string> errorMessageParts;
+    auto policy = storage_->getAccessPolicy(timestamp);
     ParticipantGroupAccessRuleFilter filter{
       .participantGroups = RangeToVector(participantGroups),
       .userGroups = {{userGroup}},
       .modes = {{}},
     };
     for (auto& mode : modes) {
-      filter.modes->assign({mode});
-      auto allowedParticipantGroups = RangeToCollection<std::unordered_set>(
-        storage_->getParticipantGroupAccessRules(timestamp, filter)
-        | views::transform(std::mem_fn(&ParticipantGroupAccessRule::participantGroup)));
+      std::set<std::string> allowedParticipantGroups;
+      if (policy != nullptr) {
+        allowedParticipantGroups = policy->getGrantingParticipantGroups(userGroup, mode);
+      }
+      else {
+        filter.modes->assign({mode});
+        allowedParticipantGroups = RangeToCollection<std::set>(
+          storage_->getParticipantGroupAccessRules(timestamp, filter)
+          | views::transform(std::mem_fn(&ParticipantGroupAccessRule::participantGroup)));
+      }
       for (auto& pg : participantGroups) {
         if (!allowedParticipantGroups.contains(pg)) {
           errorMessageParts.push_back("Access denied to " + Logging::Escape(userGroup) + " for mode "
@@ -495,14 +579,21 @@ std::unordered_map<std::string, IndexList> AccessManager::Backend::unfoldColumnG
   }
 
   // Process the loose columns
+  auto policy = storage_->getAccessPolicy(at);
   for (auto& column : columns) {
     // What columnGroups is this column in?
-    auto cgcs = storage_->getColumnGroupColumns(at, {.columns = std::vector<std::string>{column}});
     std::vector<std::string> associatedColumnGroups{};
-    associatedColumnGroups.reserve(cgcs.size());
-    std::transform(cgcs.cbegin(), cgcs.cend(), std::back_inserter(associatedColumnGroups), [](auto& entry) {
-      return entry.columnGroup;
-    });
+    if (policy != nullptr) {
+      const auto& containing = policy->getColumnGroupsContaining(column);
+      associatedColumnGroups.assign(containing.cbegin(), containing.cend());
+    }
+    else {
+      auto cgcs = storage_->getColumnGroupColumns(at, {.columns = std::vector<std::string>{column}});
+      associatedColumnGroups.reserve(cgcs.size());
+      std::transform(cgcs.cbegin(), cgcs.cend(), std::back_inserter(associatedColumnGroups), [](auto& entry) {
+        return entry.columnGroup;
+      });
+    }
     for (auto& requiredMode : modes) {
       bool accessGranted = false;
       for (auto& cg : associatedColumnGroups) {
@@ -532,7 +623,9 @@ std::unordered_map<std::string, IndexList> AccessManager::Backend::unfoldColumnG
   columnGroupMap.reserve(columnGroups.size());
   std::set<ColumnGroupColumn> cgcs = {};
   if (!columnGroups.empty()) {
-    cgcs = storage_->getColumnGroupColumns(at, {.columnGroups = {columnGroups}});
+    cgcs = policy != nullptr
+      ? policy->getColumnGroupColumns(columnGroups)
+      : storage_->getColumnGroupColumns(at, {.columnGroups = {columnGroups}});
     for (auto& cgc : cgcs) {
       // Add the column to the columns vector if it is not already there.
       auto pos = std::find(columns.cbegin(), columns.cend(), cgc.column);
@@ -689,20 +782,25 @@ AmaQueryResponse AccessManager::Backend::performAMAQuery(const AmaQuery& query,
 UserQueryResponse AccessManager::Backend::performUserQuery(const UserQuery& query, const std::string& userGroup) {
   UserGroup::EnsureAccess({ UserGroup::AccessAdministrator, UserGroup::RepositoryManager }, userGroup, "Querying users");
 
-  return storage_->executeUserQuery(query);
+  UserQueryResponse result;
+  storage_->read([&] { result = storage_->executeUserQuery(query); });
+  return result;
 }
 
 ColumnAccess AccessManager::Backend::handleColumnAccessRequest(const ColumnAccessRequest& request,
                                                              const std::string& userGroup) {
   ColumnAccess result;
   auto now = TimeNow();
+  auto policy = storage_->getAccessPolicy(now);
 
   if (request.includeImplicitlyGranted
       && userGroup == UserGroup::DataAdministrator) { // Data administrator has implicit "read-meta" access to all
                                                        // column groups
-    auto allCgs = storage_->getColumnGroups(now);
+    auto allCgs = policy != nullptr
+      ? policy->getColumnGroups()
+      : RangeToCollection<std::set>(storage_->getColumnGroups(now) | std::views::transform(std::mem_fn(&ColumnGroup::name)));
     for (const auto& cg : allCgs) {
-      auto& modes = result.columnGroups[cg.name].modes;
+      auto& modes = result.columnGroups[cg].modes;
       auto end = modes.cend();
       if (std::find(modes.cbegin(), end, "read-meta") == end) {
         modes.push_back("read-meta");
@@ -710,7 +808,9 @@ ColumnAccess AccessManager::Backend::handleColumnAccessRequest(const ColumnAcces
     }
   }
 
-  auto cgars = storage_->getColumnGroupAccessRules(now, {.userGroups = std::vector<std::string>{userGroup}});
+  auto cgars = policy != nullptr
+    ? policy->getColumnGroupAccessRules(userGroup)
+    : storage_->getColumnGroupAccessRules(now, {.userGroups = std::vector<std::string>{userGroup}});
   for (auto& cgar : cgars) {
     auto& allowedModes = result.columnGroups[cgar.columnGroup].modes;
     allowedModes.push_back(cgar.mode);
@@ -749,7 +849,10 @@ ColumnAccess AccessManager::Backend::handleColumnAccessRequest(const ColumnAcces
                  [](auto& entry) { return entry.first; });
   // For each columnGroup in the result, look up all associated columns and add them to both the "columns" vector, and
   // the groupProperties in the map.
-  for (auto& cgc : storage_->getColumnGroupColumns(now, {.columnGroups = columnGroupsInMap})) {
+  auto cgcs = policy != nullptr
+    ? policy->getColumnGroupColumns(columnGroupsInMap)
+    : storage_->getColumnGroupColumns(now, {.columnGroups = columnGroupsInMap});
+  for (auto& cgc : cgcs) {
     auto begin = result.columns.begin(), end = result.columns.end();
     auto pos = std::find(begin, end, cgc.column);
     uint32_t index = static_cast<uint32_t>(pos - begin);
@@ -851,13 +954,17 @@ std::vector<StructureMetadataEntry> AccessManager::Backend::handleStructureMetad
   EnsureStructureMetadataAccess(AccessMode::Read, request.subjectType, userGroup);
 
   const Timestamp now = TimeNow();
-  return {storage_->getStructureMetadata(
-      now,
-      request.subjectType,
-      {
-          .subjects = request.subjects,
-          .keys = request.keys,
-      })};
+  std::vector<StructureMetadataEntry> result;
+  storage_->read([&] {
+    result = storage_->getStructureMetadata(
+        now,
+        request.subjectType,
+        {
+            .subjects = request.subjects,
+            .keys = request.keys,
+        });
+  });
+  return result;
 }
 
 void AccessManager::Backend::handleSetStructureMetadataRequestHead(
@@ -879,6 +986,10 @@ void AccessManager::Backend::handleSetStructureMetadataRequestEntry(
   storage_->setStructureMetadata(subjectType, entry.subjectKey.subject, entry.subjectKey.key, entry.value);
 }
 
+bool AccessManager::Backend::hasReadConnections() const {
+  return storage_->hasReadConnections();
+}
+
 std::filesystem::path AccessManager::Backend::getStoragePath() {
   return storage_->getPath();
 }
@@ -3,6 +3,7 @@
 #include <pep/accessmanager/UserMessages.hpp>
 
 #include <pep/accessmanager/AccessManager.hpp>
+#include <pep/database/StorageProfile.hpp>
 
 namespace pep {
 
@@ -17,15 +18,23 @@ public:
 
   Backend() = delete; // AccessManager::Backend needs a properly configured storage
   Backend(std::shared_ptr<AccessManager::Backend::Storage> storage) : storage_(storage) {}
-  Backend(const std::filesystem::path& path, std::shared_ptr<GlobalConfiguration> globalConf);
+  Backend(const std::filesystem::path& path, std::shared_ptr<GlobalConfiguration> globalConf, database::StorageProfile storageProfile = {});
 
   void setAccessManager(AccessManager* accessManager) { accessManager_ = accessManager; }
 
+  /// \brief Whether the storage has read connections, allowing queries such as performUserQuery() and
+  ///        handleStructureMetadataRequest() to be invoked from other threads than the one that performs mutations.
+  bool hasReadConnections() const;
+
   // Purely passing through to AccessManager::Backend::Storage
 
   void addParticipantToGroup(const LocalPseudonym& localPseudonym, const std::string& group);
   void removeParticipantFromGroup(const LocalPseudonym& localPseudonym, const std::string& group);
   void checkParticipantAccess(const std::string& userGroup, const LocalPseudonym& localPseudonym, const std::vector<std::string>& modes, Timestamp at);
+  /// \brief Check whether the userGroup at the timestamp is granted the access modes for all of the participants.
+  /// \details Equivalent to calling checkParticipantAccess() for every participant, but looks up the access rules and participant groups only once.
+  /// \throws Error for the first participant that is not granted all access modes.
+  void checkParticipantsAccess(const std::string& userGroup, std::span<const LocalPseudonym> localPseudonyms, const std::vector<std::string>& modes, Timestamp at);
   bool hasLocalPseudonym(const LocalPseudonym& localPseudonym);
   void storeLocalPseudonymAndPP(const LocalPseudonym& localPseudonym, const PolymorphicPseudonym& polymorphicPseudonym);
 
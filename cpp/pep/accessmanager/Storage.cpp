@@ -6,9 +6,11 @@
 #include <pep/accessmanager/LegacyAuthserverStorage.hpp>
 
 #include <pep/auth/UserGroup.hpp>
+#include <pep/database/RecordChecksumChain.hpp>
 #include <pep/database/Storage.hpp>
 #include <pep/utils/Bitpacking.hpp>
 #include <pep/utils/CollectionUtils.hpp>
+#include <pep/utils/Defer.hpp>
 #include <pep/utils/OpenSSLHasher.hpp>
 #include <pep/elgamal/ElgamalSerializers.hpp>
 
@@ -77,6 +79,8 @@ auto CreateAmDb(const std::string& path) {
       make_column("timestamp", &ParticipantGroupRecord::timestamp),
       make_column("tombstone", &ParticipantGroupRecord::tombstone),
       make_column("name", &ParticipantGroupRecord::name)),
+    database::make_current_records_table<ParticipantGroupRecord>("CurrentParticipantGroups"),
+    database::make_current_records_trigger<ParticipantGroupRecord>("trg_CurrentParticipantGroups"),
 
     make_index("idx_ParticipantGroupParticipants",
       &ParticipantGroupParticipantRecord::localPseudonym,
@@ -91,6 +95,8 @@ auto CreateAmDb(const std::string& path) {
       make_column("tombstone", &ParticipantGroupParticipantRecord::tombstone),
       make_column("localPseudonym", &ParticipantGroupParticipantRecord::localPseudonym),
       make_column("participantGroup", &ParticipantGroupParticipantRecord::participantGroup)),
+    database::make_current_records_table<ParticipantGroupParticipantRecord>("CurrentParticipantGroupParticipants"),
+    database::make_current_records_trigger<ParticipantGroupParticipantRecord>("trg_CurrentParticipantGroupParticipants"),
 
     make_index("idx_ColumnGroups",
       &ColumnGroupRecord::name,
@@ -103,6 +109,8 @@ auto CreateAmDb(const std::string& path) {
       make_column("timestamp", &ColumnGroupRecord::timestamp),
       make_column("tombstone", &ColumnGroupRecord::tombstone),
       make_column("name", &ColumnGroupRecord::name)),
+    database::make_current_records_table<ColumnGroupRecord>("CurrentColumnGroups"),
+    database::make_current_records_trigger<ColumnGroupRecord>("trg_CurrentColumnGroups"),
 
     make_index("idx_ColumnGroupColumns",
       &ColumnGroupColumnRecord::column,
@@ -117,6 +125,8 @@ auto CreateAmDb(const std::string& path) {
       make_column("tombstone", &ColumnGroupColumnRecord::tombstone),
       make_column("column", &ColumnGroupColumnRecord::column),
       make_column("columnGroup", &ColumnGroupColumnRecord::columnGroup)),
+    database::make_current_records_table<ColumnGroupColumnRecord>("CurrentColumnGroupColumns"),
+    database::make_current_records_trigger<ColumnGroupColumnRecord>("trg_CurrentColumnGroupColumns"),
 
     make_index("idx_ColumnGroupAccessRules",
       &ColumnGroupAccessRuleRecord::userGroup,
@@ -133,6 +143,8 @@ auto CreateAmDb(const std::string& path) {
       make_column("columnGroup", &ColumnGroupAccessRuleRecord::columnGroup),
       make_column("accessGroup", &ColumnGroupAccessRuleRecord::userGroup),
       make_column("mode", &ColumnGroupAccessRuleRecord::mode)),
+    database::make_current_records_table<ColumnGroupAccessRuleRecord>("CurrentColumnGroupAccessRules"),
+    database::make_current_records_trigger<ColumnGroupAccessRuleRecord>("trg_CurrentColumnGroupAccessRules"),
 
     make_index("idx_GroupAccessRules",
       &ParticipantGroupAccessRuleRecord::userGroup,
@@ -149,6 +161,8 @@ auto CreateAmDb(const std::string& path) {
       make_column("group", &ParticipantGroupAccessRuleRecord::participantGroup),
       make_column("accessGroup", &ParticipantGroupAccessRuleRecord::userGroup),
       make_column("mode", &ParticipantGroupAccessRuleRecord::mode)),
+    database::make_current_records_table<ParticipantGroupAccessRuleRecord>("CurrentGroupAccessRules"),
+    database::make_current_records_trigger<ParticipantGroupAccessRuleRecord>("trg_CurrentGroupAccessRules"),
 
     make_index("idx_Columns",
       &ColumnRecord::name,
@@ -161,6 +175,8 @@ auto CreateAmDb(const std::string& path) {
       make_column("timestamp", &ColumnRecord::timestamp),
       make_column("tombstone", &ColumnRecord::tombstone),
       make_column("name", &ColumnRecord::name)),
+    database::make_current_records_table<ColumnRecord>("CurrentColumns"),
+    database::make_current_records_trigger<ColumnRecord>("trg_CurrentColumns"),
 
     make_unique_index("idx_ColumnNameMappings",
       &ColumnNameMappingRecord::original),
@@ -183,6 +199,8 @@ auto CreateAmDb(const std::string& path) {
       make_column("identifier", &UserIdRecord::identifier),
       make_column("isPrimaryId", &UserIdRecord::isPrimaryId, default_value(false)),
       make_column("isDisplayId", &UserIdRecord::isDisplayId, default_value(false))),
+    database::make_current_records_table<UserIdRecord>("CurrentUserIds"),
+    database::make_current_records_trigger<UserIdRecord>("trg_CurrentUserIds"),
 
     make_index("idx_UserGroups",
       &UserGroupRecord::userGroupId,
@@ -198,6 +216,8 @@ auto CreateAmDb(const std::string& path) {
       make_column("userGroupId", &UserGroupRecord::userGroupId),
       make_column("name", &UserGroupRecord::name),
       make_column("maxAuthValiditySeconds", &UserGroupRecord::maxAuthValiditySeconds)),
+    database::make_current_records_table<UserGroupRecord>("CurrentUserGroups"),
+    database::make_current_records_trigger<UserGroupRecord>("trg_CurrentUserGroups"),
 
     make_index("idx_UserGroupUsers",
       &UserGroupUserRecord::internalUserId,
@@ -213,6 +233,8 @@ auto CreateAmDb(const std::string& path) {
       make_column("internalUserId", &UserGroupUserRecord::internalUserId),
       make_column("userGroupId", &UserGroupUserRecord::userGroupId),
       make_column("expirationTimestamp", &UserGroupUserRecord::expirationTimestamp)),
+    database::make_current_records_table<UserGroupUserRecord>("CurrentUserGroupUsers"),
+    database::make_current_records_trigger<UserGroupUserRecord>("trg_CurrentUserGroupUsers"),
 
     make_index("idx_StructureMetadata",
       &StructureMetadataRecord::subjectType,
@@ -230,7 +252,9 @@ auto CreateAmDb(const std::string& path) {
       make_column("internalSubjectId", &StructureMetadataRecord::internalSubjectId),
       make_column("metadataGroup", &StructureMetadataRecord::metadataGroup),
       make_column("subkey", &StructureMetadataRecord::subkey),
-      make_column("value", &StructureMetadataRecord::value))
+      make_column("value", &StructureMetadataRecord::value)),
+    database::make_current_records_table<StructureMetadataRecord>("CurrentStructureMetadata"),
+    database::make_current_records_trigger<StructureMetadataRecord>("trg_CurrentStructureMetadata")
   );
 }
 
@@ -241,9 +265,33 @@ struct AccessManager::Backend::Storage::Implementor : database::Storage<CreateAm
   using Storage::Storage;
 };
 
+namespace {
+
+template <database::Record... RecordTypes>
+void RebuildCurrentRecords(AccessManager::Backend::Storage::Implementor& implementor) {
+  (implementor.rebuildCurrentRecords<RecordTypes>(), ...);
+}
+
+}
+
 void AccessManager::Backend::Storage::ensureInitialized() {
   implementor_->syncSchema();
 
+  // Records may have been inserted when the "current records" tables (or the triggers that maintain them) didn't exist yet
+  PEP_LOG(LogTag, Severity::Info) << "Rebuilding current records tables ...";
+  RebuildCurrentRecords<
+    ParticipantGroupRecord,
+    ParticipantGroupParticipantRecord,
+    ColumnGroupRecord,
+    ColumnGroupColumnRecord,
+    ColumnGroupAccessRuleRecord,
+    ParticipantGroupAccessRuleRecord,
+    ColumnRecord,
+    UserIdRecord,
+    UserGroupRecord,
+    UserGroupUserRecord,
+    StructureMetadataRecord>(*implementor_);
+
   if (implementor_->raw.count<ColumnGroupRecord>(limit(1)) != 0)
     return;
 
@@ -461,6 +509,7 @@ void AccessManager::Backend::Storage::ensureUpToDate() {
       throw std::runtime_error("LP and PP format was not up to date, so an upgrade was attempted. But the backup file "
         + backupPath.string() + " already exists. An upgrade was apparently already attempted, but failed. Manual correction is required.");
     }
+    implementor_->checkpoint(); // Make the database file self-contained before copying it
     std::filesystem::copy_file(this->storagePath_, backupPath);
     PEP_LOG(LogTag, Severity::Info) << "Backed up storage to \"" << backupPath.string() << "\". Backup is " << std::filesystem::file_size(backupPath) << " bytes.";
     auto transactionGuard = implementor_->raw.transaction_guard();
@@ -572,9 +621,9 @@ void AccessManager::Backend::Storage::syncColumnGroupContents(const std::string&
   }
 }
 
-AccessManager::Backend::Storage::Storage( const std::filesystem::path& path, std::shared_ptr<GlobalConfiguration> globalConf) {
+AccessManager::Backend::Storage::Storage( const std::filesystem::path& path, std::shared_ptr<GlobalConfiguration> globalConf, database::StorageProfile profile) {
   storagePath_ = path;
-  implementor_ = std::make_shared<Implementor>(path.string());
+  implementor_ = std::make_shared<Implementor>(path.string(), std::move(profile));
   globalConf_ = globalConf;
 
   ensureInitialized();
@@ -597,88 +646,84 @@ AccessManager::Backend::Storage::Storage( const std::filesystem::path& path, std
     );
 
   removeOrphanedRecords();
+  createChecksumChains();
+
+  PEP_LOG(LogTag, Severity::Info) << "Loading access policy ...";
+  accessPolicy_ = loadAccessPolicy();
   PEP_LOG(LogTag, Severity::Info) << "Ready to accept requests!";
 }
 
 namespace { // TODO: move together with other anonymously-scoped code (at top of source)
 
-template<typename T, int version = 0>
-void ComputeChecksumImpl(std::shared_ptr<AccessManager::Backend::Storage::Implementor> storageImplementor,
-    std::optional<uint64_t> maxCheckpoint, uint64_t& checksum, uint64_t& checkpoint) {
-  checkpoint = 1;
-  checksum = 0;
-  if (!maxCheckpoint)
-    maxCheckpoint = std::numeric_limits<int64_t>::max();
-
-  for (const auto& record : storageImplementor->raw.iterate<T>(
-      where(c(&T::seqno) < static_cast<int64_t>(*maxCheckpoint) - 1))) {
-    checkpoint = std::max(checkpoint, static_cast<uint64_t>(record.seqno + 2));
-    if constexpr (version == 0) {
-      checksum ^= record.checksum();
-    }
-    else {
-      checksum ^= record.checksum(version);
-    }
-  }
+template <typename TRecord>
+using ChecksumChainFor = database::RecordChecksumChain<AccessManager::Backend::Storage::Implementor, TRecord>;
+
+template <typename TRecord, int version>
+std::unique_ptr<ChecksumChainFor<TRecord>> MakeVersionedChecksumChain(std::string name, std::shared_ptr<AccessManager::Backend::Storage::Implementor> storageImplementor) {
+  return std::make_unique<ChecksumChainFor<TRecord>>(std::move(name), std::move(storageImplementor),
+    [](const TRecord& record) { return record.checksum(version); });
 }
 
 //TODO: this checksum is only useful to check the migration for #1642. When that has succeeded, this checksum can be removed in a following release.
-static void ComputeLegacyUserGroupUserChecksumImpl(std::shared_ptr<AccessManager::Backend::Storage::Implementor> storageImplementor, std::optional<uint64_t> maxCheckpoint, uint64_t& checksum, uint64_t& checkpoint)  {
-  checkpoint = 1;
-  checksum = 0;
-  if (!maxCheckpoint)
-    maxCheckpoint = std::numeric_limits<int64_t>::max();
-
-  for (auto record : storageImplementor->raw.iterate<UserGroupUserRecord>(
-      where(c(&UserGroupUserRecord::seqno) < static_cast<int64_t>(*maxCheckpoint) - 1))) {
+std::unique_ptr<ChecksumChainFor<UserGroupUserRecord>> MakeLegacyUserGroupUserChecksumChain(std::shared_ptr<AccessManager::Backend::Storage::Implementor> storageImplementor) {
+  auto recordChecksum = [storageImplementor](const UserGroupUserRecord& record) {
     LegacyUserGroupUserRecord legacyRecord(record);
 
     bool found = false;
-    for (auto &record : storageImplementor->raw.iterate<pep::UserGroupRecord>(
+    for (auto &userGroup : storageImplementor->raw.iterate<pep::UserGroupRecord>(
              where(c(&pep::UserGroupRecord::userGroupId) == record.userGroupId
                && c(&pep::UserGroupRecord::timestamp) <= record.timestamp),
              order_by(&pep::UserGroupRecord::seqno).desc(), limit(1))) {
-      legacyRecord.group = record.name;
+      legacyRecord.group = userGroup.name;
       found = true;
     }
     if(!found)
       throw Error("Could not find user group");
 
-    checkpoint = std::max(checkpoint, static_cast<uint64_t>(legacyRecord.seqno + 2));
-    checksum ^= legacyRecord.checksum();
-  }
-}
-
-// We used to store localPseudonyms and polymorphicPseudonyms as protobufs.
-// In order to make sure the conversion went right, we want to make sure there are no checksum chain errors.
-// So we add v2 checksums that use the current representation, and convert the local- and polymorphic pseudonyms to the old format for the
-// existing checksum. The old version of the checksum can be removed in a later release
-const std::unordered_map<std::string, decltype(&ComputeChecksumImpl<SelectStarPseudonymRecord>)>
-    computeChecksumImpls {
-  {"select-start-pseud", &ComputeChecksumImpl<SelectStarPseudonymRecord, 1>},
-  {"select-start-pseud-v2", &ComputeChecksumImpl<SelectStarPseudonymRecord, 2>},
-  {"participant-groups", &ComputeChecksumImpl<ParticipantGroupRecord>},
-  {"participant-group-participants", &ComputeChecksumImpl<ParticipantGroupParticipantRecord, 1>},
-  {"participant-group-participants-v2", &ComputeChecksumImpl<ParticipantGroupParticipantRecord, 2>},
-  {"column-groups", &ComputeChecksumImpl<ColumnGroupRecord>},
-  {"columns", &ComputeChecksumImpl<ColumnRecord>},
-  {"column-group-columns", &ComputeChecksumImpl<ColumnGroupColumnRecord>},
-  {"column-group-accessrule", &ComputeChecksumImpl<ColumnGroupAccessRuleRecord>},
-  {"group-accessrule", &ComputeChecksumImpl<ParticipantGroupAccessRuleRecord>},
-  {"user-ids", &ComputeChecksumImpl<UserIdRecord>},
-  {"user-groups", &ComputeChecksumImpl<UserGroupRecord>},
-  {"user-group-users", &ComputeChecksumImpl<UserGroupUserRecord>},
-  {"user-group-users-legacy", ComputeLegacyUserGroupUserChecksumImpl},
-  {"structure-metadata", &ComputeChecksumImpl<StructureMetadataRecord>},
-};
+    return legacyRecord.checksum();
+  };
+  return std::make_unique<ChecksumChainFor<UserGroupUserRecord>>("user-group-users-legacy", storageImplementor, std::move(recordChecksum));
+}
 
 }
 
+void AccessManager::Backend::Storage::createChecksumChains() {
+  // Can't assign an { initializer-list } to checksumChains_ because it requires copy construction of the elements, which std::unique_ptr<> doesn't support.
+  //
+  // We used to store localPseudonyms and polymorphicPseudonyms as protobufs.
+  // In order to make sure the conversion went right, we want to make sure there are no checksum chain errors.
+  // So we add v2 checksums that use the current representation, and convert the local- and polymorphic pseudonyms to the old format for the
+  // existing checksum. The old version of the checksum can be removed in a later release
+  checksumChains_.insert(MakeVersionedChecksumChain<SelectStarPseudonymRecord, 1>("select-start-pseud", implementor_));
+  checksumChains_.insert(MakeVersionedChecksumChain<SelectStarPseudonymRecord, 2>("select-start-pseud-v2", implementor_));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<ParticipantGroupRecord>>("participant-groups", implementor_));
+  checksumChains_.insert(MakeVersionedChecksumChain<ParticipantGroupParticipantRecord, 1>("participant-group-participants", implementor_));
+  checksumChains_.insert(MakeVersionedChecksumChain<ParticipantGroupParticipantRecord, 2>("participant-group-participants-v2", implementor_));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<ColumnGroupRecord>>("column-groups", implementor_));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<ColumnRecord>>("columns", implementor_));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<ColumnGroupColumnRecord>>("column-group-columns", implementor_));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<ColumnGroupAccessRuleRecord>>("column-group-accessrule", implementor_));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<ParticipantGroupAccessRuleRecord>>("group-accessrule", implementor_));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<UserIdRecord>>("user-ids", implementor_));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<UserGroupRecord>>("user-groups", implementor_));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<UserGroupUserRecord>>("user-group-users", implementor_));
+  checksumChains_.insert(MakeLegacyUserGroupUserChecksumChain(implementor_));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<StructureMetadataRecord>>("structure-metadata", implementor_));
+}
+
+bool AccessManager::Backend::Storage::hasReadConnections() const {
+  return implementor_->hasReadConnections();
+}
+
+void AccessManager::Backend::Storage::read(const std::function<void()>& callback) const {
+  implementor_->read([&callback](auto&) { callback(); });
+}
+
 std::vector<std::string> AccessManager::Backend::Storage::getChecksumChainNames() {
   std::vector<std::string> ret;
-  ret.reserve(computeChecksumImpls.size());
-  for (const auto& pair : computeChecksumImpls) {
-    ret.push_back(pair.first);
+  ret.reserve(checksumChains_.size());
+  for (const auto& chain : checksumChains_) {
+    ret.push_back(chain->name());
   }
   return ret;
 }
@@ -686,9 +731,46 @@ std::vector<std::string> AccessManager::Backend::Storage::getChecksumChainNames(
 void AccessManager::Backend::Storage::computeChecksum(const std::string& chain,
       std::optional<uint64_t> maxCheckpoint, uint64_t& checksum,
       uint64_t& checkpoint) {
-  if (computeChecksumImpls.count(chain) == 0)
+  auto position = checksumChains_.find(chain);
+  if (position == checksumChains_.cend()) {
     throw Error("No such checksum chain");
-  computeChecksumImpls.at(chain)(implementor_, maxCheckpoint, checksum, checkpoint);
+  }
+
+  auto result = (*position)->get(maxCheckpoint.value_or(std::numeric_limits<int64_t>::max()));
+  checksum = result.checksum;
+  checkpoint = result.checkpoint;
+}
+
+AccessPolicy AccessManager::Backend::Storage::loadAccessPolicy() const {
+  const Timestamp now = TimeNow();
+  AccessPolicy result;
+  for (const auto& pgp : getParticipantGroupParticipants(now)) {
+    result.addParticipantToGroup(pgp.getLocalPseudonym(), pgp.participantGroup);
+  }
+  for (const auto& pgar : getParticipantGroupAccessRules(now)) {
+    result.addParticipantGroupAccessRule(pgar.participantGroup, pgar.userGroup, pgar.mode);
+  }
+  for (const auto& cg : getColumnGroups(now)) {
+    result.addColumnGroup(cg.name);
+  }
+  for (const auto& cgc : getColumnGroupColumns(now)) {
+    result.addColumnToGroup(cgc.column, cgc.columnGroup);
+  }
+  for (const auto& cgar : getColumnGroupAccessRules(now)) {
+    result.addColumnGroupAccessRule(cgar.columnGroup, cgar.userGroup, cgar.mode);
+  }
+  return result;
+}
+
+const AccessPolicy* AccessManager::Backend::Storage::getAccessPolicy(Timestamp at) {
+  if (!accessPolicy_.has_value()) {
+    PEP_LOG(LogTag, Severity::Info) << "Reloading access policy";
+    accessPolicy_ = loadAccessPolicy();
+  }
+  if (!accessPolicy_->isCurrentAt(at)) {
+    return nullptr;
+  }
+  return &*accessPolicy_;
 }
 
 std::vector<PolymorphicPseudonym> AccessManager::Backend::Storage::getPPs() {
@@ -748,8 +830,7 @@ bool AccessManager::Backend::Storage::hasParticipantGroup(const std::string& nam
 std::set<ParticipantGroup> AccessManager::Backend::Storage::getParticipantGroups(const Timestamp& timestamp, const ParticipantGroupFilter& filter) const {
   using namespace std::ranges;
   return RangeToCollection<std::set>(
-    implementor_->getCurrentRecords(
-      c(&ParticipantGroupRecord::timestamp) <= TicksSinceEpoch<milliseconds>(timestamp) &&
+    implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(timestamp),
       (!filter.participantGroups.has_value()
         || in(&ParticipantGroupRecord::name, filter.participantGroups.value_or(emptyVector))),
       &ParticipantGroupRecord::name)
@@ -776,6 +857,8 @@ void AccessManager::Backend::Storage::removeParticipantGroup(const std::string&
   }
 
   auto guard = implementor_->raw.transaction_guard();
+  bool committed = false;
+  PEP_DEFER(if (!committed) accessPolicy_.reset()); // Changes to the policy aren't rolled back along with the transaction
 
   const Timestamp now = TimeNow();
 
@@ -818,6 +901,7 @@ void AccessManager::Backend::Storage::removeParticipantGroup(const std::string&
   implementor_->raw.insert(ParticipantGroupRecord(name, true));
 
   guard.commit();
+  committed = true;
 }
 
 /* Core operations on ParticipantGroupParticipants */
@@ -841,9 +925,8 @@ std::set<ParticipantGroupParticipant> AccessManager::Backend::Storage::getPartic
   }
 
   return RangeToCollection<std::set>(
-    implementor_->getCurrentRecords(
-      c(&ParticipantGroupParticipantRecord::timestamp) <= TicksSinceEpoch<milliseconds>(timestamp)
-      && (!filter.participantGroups.has_value()
+    implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(timestamp),
+      (!filter.participantGroups.has_value()
         || in(&ParticipantGroupParticipantRecord::participantGroup, filter.participantGroups.value_or(emptyVector)))
       && (!filter.localPseudonyms.has_value()
         || in(&ParticipantGroupParticipantRecord::localPseudonym, serializedLocalPseudonyms)),
@@ -873,6 +956,9 @@ void AccessManager::Backend::Storage::addParticipantToGroup(const LocalPseudonym
   }
 
   implementor_->raw.insert(ParticipantGroupParticipantRecord(localPseudonym, participantGroup));
+  if (accessPolicy_.has_value()) {
+    accessPolicy_->addParticipantToGroup(localPseudonym, participantGroup);
+  }
 }
 
 void AccessManager::Backend::Storage::removeParticipantFromGroup(const LocalPseudonym& localPseudonym, const std::string& participantGroup) {
@@ -884,6 +970,9 @@ void AccessManager::Backend::Storage::removeParticipantFromGroup(const LocalPseu
   }
 
   implementor_->raw.insert(ParticipantGroupParticipantRecord(localPseudonym, participantGroup, true));
+  if (accessPolicy_.has_value()) {
+    accessPolicy_->removeParticipantFromGroup(localPseudonym, participantGroup);
+  }
 }
 
 
@@ -902,9 +991,8 @@ std::set<ParticipantGroupAccessRule> AccessManager::Backend::Storage::getPartici
   const Timestamp& timestamp, const ParticipantGroupAccessRuleFilter& filter) const {
   using namespace std::ranges;
   return RangeToCollection<std::set>(
-    implementor_->getCurrentRecords(
-      c(&ParticipantGroupAccessRuleRecord::timestamp) <= TicksSinceEpoch<milliseconds>(timestamp)
-      && (!filter.participantGroups.has_value()
+    implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(timestamp),
+      (!filter.participantGroups.has_value()
         || in(&ParticipantGroupAccessRuleRecord::participantGroup, filter.participantGroups.value_or(emptyVector)))
       && (!filter.userGroups.has_value()
         || in(&ParticipantGroupAccessRuleRecord::userGroup, filter.userGroups.value_or(emptyVector)))
@@ -948,6 +1036,9 @@ void AccessManager::Backend::Storage::createParticipantGroupAccessRule(
   }
 
   implementor_->raw.insert(ParticipantGroupAccessRuleRecord(participantGroup, userGroup, mode));
+  if (accessPolicy_.has_value()) {
+    accessPolicy_->addParticipantGroupAccessRule(participantGroup, userGroup, mode);
+  }
 }
 
 void AccessManager::Backend::Storage::removeParticipantGroupAccessRule(
@@ -962,6 +1053,9 @@ void AccessManager::Backend::Storage::removeParticipantGroupAccessRule(
   }
 
   implementor_->raw.insert(ParticipantGroupAccessRuleRecord(participantGroup, userGroup, mode, true));
+  if (accessPolicy_.has_value()) {
+    accessPolicy_->removeParticipantGroupAccessRule(participantGroup, userGroup, mode);
+  }
 }
 
 
@@ -981,9 +1075,8 @@ std::optional<std::string> AccessManager::Backend::Storage::getColumnCaseInsensi
 std::set<Column> AccessManager::Backend::Storage::getColumns(const Timestamp& timestamp, const ColumnFilter& filter) const {
   using namespace std::ranges;
   return RangeToCollection<std::set>(
-    implementor_->getCurrentRecords(
-      c(&ColumnRecord::timestamp) <= TicksSinceEpoch<milliseconds>(timestamp)
-      && (!filter.columns.has_value()
+    implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(timestamp),
+      (!filter.columns.has_value()
         || in(&ColumnRecord::name, filter.columns.value_or(emptyVector))),
       &ColumnRecord::name)
     | views::transform([](std::string name) {
@@ -1007,6 +1100,9 @@ void AccessManager::Backend::Storage::createColumn(const std::string& name) {
   }
   implementor_->raw.insert(ColumnRecord(name));
   implementor_->raw.insert(ColumnGroupColumnRecord(name, "*"));
+  if (accessPolicy_.has_value()) {
+    accessPolicy_->addColumnToGroup(name, "*");
+  }
 }
 
 void AccessManager::Backend::Storage::removeColumn(const std::string& name) {
@@ -1016,6 +1112,8 @@ void AccessManager::Backend::Storage::removeColumn(const std::string& name) {
     throw Error(msg.str());
   }
   auto guard = implementor_->raw.transaction_guard();
+  bool committed = false;
+  PEP_DEFER(if (!committed) accessPolicy_.reset()); // Changes to the policy aren't rolled back along with the transaction
 
   const Timestamp now = TimeNow();
 
@@ -1034,8 +1132,12 @@ void AccessManager::Backend::Storage::removeColumn(const std::string& name) {
   implementor_->raw.insert(ColumnRecord(name, true));
   // Remove from column group *
   implementor_->raw.insert(ColumnGroupColumnRecord(name, "*", true));
+  if (accessPolicy_.has_value()) {
+    accessPolicy_->removeColumnFromGroup(name, "*");
+  }
 
   guard.commit();
+  committed = true;
 }
 
 /* Core operations on ColumnGroups */
@@ -1046,9 +1148,8 @@ bool AccessManager::Backend::Storage::hasColumnGroup(const std::string& name) {
 std::set<ColumnGroup> AccessManager::Backend::Storage::getColumnGroups(const Timestamp& timestamp, const ColumnGroupFilter& filter) const {
   using namespace std::ranges;
   return RangeToCollection<std::set>(
-    implementor_->getCurrentRecords(
-      c(&ColumnGroupRecord::timestamp) <= TicksSinceEpoch<milliseconds>(timestamp)
-      && (!filter.columnGroups.has_value()
+    implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(timestamp),
+      (!filter.columnGroups.has_value()
         || in(&ColumnGroupRecord::name, filter.columnGroups.value_or(emptyVector))),
       &ColumnGroupRecord::name)
     | views::transform([](std::string name) {
@@ -1064,6 +1165,9 @@ void AccessManager::Backend::Storage::createColumnGroup(const std::string& name)
     throw Error(msg.str());
   }
   implementor_->raw.insert(ColumnGroupRecord(name));
+  if (accessPolicy_.has_value()) {
+    accessPolicy_->addColumnGroup(name);
+  }
 }
 
 void AccessManager::Backend::Storage::removeColumnGroup(const std::string& name, const bool force) {
@@ -1073,6 +1177,8 @@ void AccessManager::Backend::Storage::removeColumnGroup(const std::string& name,
     throw Error(msg.str());
   }
   auto guard = implementor_->raw.transaction_guard();
+  bool committed = false;
+  PEP_DEFER(if (!committed) accessPolicy_.reset()); // Changes to the policy aren't rolled back along with the transaction
 
   const Timestamp now = TimeNow();
 
@@ -1115,8 +1221,12 @@ void AccessManager::Backend::Storage::removeColumnGroup(const std::string& name,
 
   // If we ended up here, it is safe to remove the columnGroup.
   implementor_->raw.insert(ColumnGroupRecord(name, true));
+  if (accessPolicy_.has_value()) {
+    accessPolicy_->removeColumnGroup(name);
+  }
 
   guard.commit();
+  committed = true;
 }
 
 /* Core operations on ColumnGroupColumns */
@@ -1130,9 +1240,8 @@ bool AccessManager::Backend::Storage::hasColumnInGroup(
 std::set<ColumnGroupColumn> AccessManager::Backend::Storage::getColumnGroupColumns(const Timestamp& timestamp, const ColumnGroupColumnFilter& filter) const {
   using namespace std::ranges;
   return RangeToCollection<std::set>(
-    implementor_->getCurrentRecords(
-      c(&ColumnGroupColumnRecord::timestamp) <= TicksSinceEpoch<milliseconds>(timestamp)
-      && (!filter.columnGroups.has_value()
+    implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(timestamp),
+      (!filter.columnGroups.has_value()
         || in(&ColumnGroupColumnRecord::columnGroup, filter.columnGroups.value_or(emptyVector)))
       && (!filter.columns.has_value()
         || in(&ColumnGroupColumnRecord::column, filter.columns.value_or(emptyVector))),
@@ -1162,6 +1271,9 @@ void AccessManager::Backend::Storage::addColumnToGroup(
     throw Error(msg.str());
   }
   implementor_->raw.insert(ColumnGroupColumnRecord(column, columnGroup));
+  if (accessPolicy_.has_value()) {
+    accessPolicy_->addColumnToGroup(column, columnGroup);
+  }
 }
 
 void AccessManager::Backend::Storage::removeColumnFromGroup(
@@ -1173,6 +1285,9 @@ void AccessManager::Backend::Storage::removeColumnFromGroup(
     throw Error(msg.str());
   }
   implementor_->raw.insert(ColumnGroupColumnRecord(column, columnGroup, true));
+  if (accessPolicy_.has_value()) {
+    accessPolicy_->removeColumnFromGroup(column, columnGroup);
+  }
 }
 
 /* Core operations on ColumnGroup Access Rules */
@@ -1189,9 +1304,8 @@ bool AccessManager::Backend::Storage::hasColumnGroupAccessRule(
 std::set<ColumnGroupAccessRule> AccessManager::Backend::Storage::getColumnGroupAccessRules(const Timestamp& timestamp, const ColumnGroupAccessRuleFilter& filter) const {
   using namespace std::ranges;
   return RangeToCollection<std::set>(
-    implementor_->getCurrentRecords(
-      c(&ColumnGroupAccessRuleRecord::timestamp) <= TicksSinceEpoch<milliseconds>(timestamp)
-      && (!filter.columnGroups.has_value()
+    implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(timestamp),
+      (!filter.columnGroups.has_value()
         || in(&ColumnGroupAccessRuleRecord::columnGroup, filter.columnGroups.value_or(emptyVector)))
       && (!filter.userGroups.has_value()
         || in(&ColumnGroupAccessRuleRecord::userGroup, filter.userGroups.value_or(emptyVector)))
@@ -1235,6 +1349,9 @@ void AccessManager::Backend::Storage::createColumnGroupAccessRule(
 
   implementor_->raw.insert(ColumnGroupAccessRuleRecord(
       columnGroup, userGroup, mode));
+  if (accessPolicy_.has_value()) {
+    accessPolicy_->addColumnGroupAccessRule(columnGroup, userGroup, mode);
+  }
 }
 
 void AccessManager::Backend::Storage::removeColumnGroupAccessRule(
@@ -1250,6 +1367,9 @@ void AccessManager::Backend::Storage::removeColumnGroupAccessRule(
 
   implementor_->raw.insert(ColumnGroupAccessRuleRecord(
       columnGroup, userGroup, mode, true));
+  if (accessPolicy_.has_value()) {
+    accessPolicy_->removeColumnGroupAccessRule(columnGroup, userGroup, mode);
+  }
 }
 
 /* Core operations on Column Name Mappings */
@@ -1503,37 +1623,36 @@ std::optional<int64_t> AccessManager::Backend::Storage::findInternalUserId(const
     for (auto& id: identifiers) { boost::to_lower(id); }
     return identifiers;
   };
-  const auto timeCondition = c(&UserIdRecord::timestamp) <= TicksSinceEpoch<milliseconds>(at);
+  const auto atMillis = TicksSinceEpoch<milliseconds>(at);
 
   // There is some code duplication that is hard to remove, because the types passed to toOptional are different
   return (caseSensitivity == CaseSensitive)
-      ? toOptional(implementor_->getCurrentRecords(
-            timeCondition && in(&UserIdRecord::identifier, identifiers),
+      ? toOptional(implementor_->getCurrentRecordsAt(atMillis,
+            in(&UserIdRecord::identifier, identifiers),
             &UserIdRecord::internalUserId))
-      : toOptional(implementor_->getCurrentRecords(
-            timeCondition && in(lower(&UserIdRecord::identifier), toLower(identifiers)),
+      : toOptional(implementor_->getCurrentRecordsAt(atMillis,
+            in(lower(&UserIdRecord::identifier), toLower(identifiers)),
             &UserIdRecord::internalUserId));
 }
 
 std::unordered_set<std::string> AccessManager::Backend::Storage::getAllIdentifiersForUser(int64_t internalUserId, Timestamp at) const {
   return RangeToCollection<std::unordered_set>(
-    implementor_->getCurrentRecords(
-      c(&UserIdRecord::timestamp) <= TicksSinceEpoch<milliseconds>(at)
-      && c(&UserIdRecord::internalUserId) == internalUserId,
+    implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(at),
+      c(&UserIdRecord::internalUserId) == internalUserId,
       &UserIdRecord::identifier)
   );
 }
 
 std::optional<std::string> AccessManager::Backend::Storage::getPrimaryIdentifierForUser(int64_t internalUserId, Timestamp at) const {
   using namespace pep::database;
-  return RangeToOptional(implementor_->getCurrentRecords(c(&UserIdRecord::timestamp) <= TicksSinceEpoch<milliseconds>(at)
-        && c(&UserIdRecord::internalUserId) == internalUserId, having(c(&UserIdRecord::isPrimaryId) == true), &UserIdRecord::identifier));
+  return RangeToOptional(implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(at),
+        c(&UserIdRecord::internalUserId) == internalUserId, having(c(&UserIdRecord::isPrimaryId) == true), &UserIdRecord::identifier));
 }
 
 std::optional<std::string> AccessManager::Backend::Storage::getDisplayIdentifierForUser(int64_t internalUserId, Timestamp at) const {
   using namespace pep::database;
-  return RangeToOptional(implementor_->getCurrentRecords(c(&UserIdRecord::timestamp) <= TicksSinceEpoch<milliseconds>(at)
-        && c(&UserIdRecord::internalUserId) == internalUserId, having(c(&UserIdRecord::isDisplayId) == true), &UserIdRecord::identifier));
+  return RangeToOptional(implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(at),
+        c(&UserIdRecord::internalUserId) == internalUserId, having(c(&UserIdRecord::isDisplayId) == true), &UserIdRecord::identifier));
 }
 
 void AccessManager::Backend::Storage::setPrimaryIdentifierForUser(std::string uid) {
@@ -1615,8 +1734,8 @@ void AccessManager::Backend::Storage::setDisplayIdentifierForUser(int64_t intern
 
 std::optional<int64_t> AccessManager::Backend::Storage::findUserGroupId(std::string_view name, Timestamp at) const {
   using pep::database::having;
-  return RangeToOptional(implementor_->getCurrentRecords(
-    c(&UserGroupRecord::timestamp) <= TicksSinceEpoch<milliseconds>(at),
+  return RangeToOptional(implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(at),
+    true,
       having(c(&UserGroupRecord::name) == name),
       &UserGroupRecord::userGroupId));
 }
@@ -1631,9 +1750,8 @@ int64_t AccessManager::Backend::Storage::getUserGroupId(std::string_view name, T
 
 std::optional<std::string> AccessManager::Backend::Storage::getUserGroupName(int64_t userGroupId, Timestamp at) const {
   return RangeToOptional(
-    implementor_->getCurrentRecords(
-      c(&UserGroupRecord::timestamp) <= TicksSinceEpoch<milliseconds>(at)
-      && c(&UserGroupRecord::userGroupId) == userGroupId,
+    implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(at),
+      c(&UserGroupRecord::userGroupId) == userGroupId,
       &UserGroupRecord::name)
   );
 }
@@ -1642,17 +1760,15 @@ std::vector<UserGroup> AccessManager::Backend::Storage::getUserGroupsForUser(int
   using namespace std::ranges;
   using namespace pep::database;
   std::vector<int64_t> groupIds = RangeToCollection<std::vector>(
-    implementor_->getCurrentRecords(
-      c(&UserGroupUserRecord::internalUserId) == internalUserId
-      && c(&UserGroupUserRecord::timestamp) <= TicksSinceEpoch<milliseconds>(at),
+    implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(at),
+      c(&UserGroupUserRecord::internalUserId) == internalUserId,
       having(is_null(&UserGroupUserRecord::expirationTimestamp) || c(&UserGroupUserRecord::expirationTimestamp) >= TicksSinceEpoch<milliseconds>(at)),
       &UserGroupUserRecord::userGroupId)
   );
 
   return RangeToCollection<std::vector>(
-    implementor_->getCurrentRecords(
-      in(&UserGroupRecord::userGroupId, groupIds)
-      && c(&UserGroupRecord::timestamp) <= TicksSinceEpoch<milliseconds>(at),
+    implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(at),
+      in(&UserGroupRecord::userGroupId, groupIds),
         &UserGroupRecord::name, &UserGroupRecord::maxAuthValiditySeconds)
   | views::transform([](auto tuple) {
     auto& [name, maxAuthValiditySeconds] = tuple;
@@ -1817,9 +1933,8 @@ UserQueryResponse AccessManager::Backend::Storage::executeUserQuery(const UserQu
 
   std::map<int64_t, QRUser> usersInfo;
   // List users matching user filter
-  for (auto internalId: implementor_->getCurrentRecords(
-         c(&UserIdRecord::timestamp) <= TicksSinceEpoch<milliseconds>(timestamp)
-         && instr(lower(&UserIdRecord::identifier), boost::to_lower_copy(query.userFilter)) /*true if filter is empty*/,
+  for (auto internalId: implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(timestamp),
+         instr(lower(&UserIdRecord::identifier), boost::to_lower_copy(query.userFilter)) /*true if filter is empty*/,
          &UserIdRecord::internalUserId)) {
     // Add internalId, we add all identifiers below
     usersInfo.try_emplace(internalId);
@@ -1827,9 +1942,8 @@ UserQueryResponse AccessManager::Backend::Storage::executeUserQuery(const UserQu
 
   std::unordered_set<int64_t> groupsWithUsers;
   // List group memberships for filtered groups & users
-  for (auto tuple: implementor_->getCurrentRecords(
-         c(&UserGroupUserRecord::timestamp) <= TicksSinceEpoch<milliseconds>(timestamp)
-         && (query.groupFilter.empty()
+  for (auto tuple: implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(timestamp),
+         (query.groupFilter.empty()
            || in(&UserGroupUserRecord::userGroupId,
              // Avoid passing list to query when not filtered
              RangeToVector(views::keys(!query.groupFilter.empty() ? groups : Default<decltype(groups)>))) )
@@ -1867,9 +1981,8 @@ UserQueryResponse AccessManager::Backend::Storage::executeUserQuery(const UserQu
 
   // Fetch all identifiers for the selected users,
   //  not just the ones that satisfy the specific user identifier filter
-  for (auto tuple: implementor_->getCurrentRecords(
-         c(&UserIdRecord::timestamp) <= TicksSinceEpoch<milliseconds>(timestamp)
-         && in(&UserIdRecord::internalUserId, RangeToVector(views::keys(usersInfo))),
+  for (auto tuple: implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(timestamp),
+         in(&UserIdRecord::internalUserId, RangeToVector(views::keys(usersInfo))),
          &UserIdRecord::internalUserId, &UserIdRecord::identifier, &UserIdRecord::isPrimaryId, &UserIdRecord::isDisplayId)) {
     auto& [internalId, identifier, isPrimaryId, isDisplayId] = tuple;
 
@@ -1948,9 +2061,8 @@ std::vector<StructureMetadataKey> AccessManager::Backend::Storage::getStructureM
   }
   using namespace std::ranges;
   return RangeToVector(
-    implementor_->getCurrentRecords(
-      c(&StructureMetadataRecord::timestamp) <= TicksSinceEpoch<milliseconds>(timestamp)
-      && c(&StructureMetadataRecord::subjectType) == ToUnderlying(subjectType)
+    implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(timestamp),
+      c(&StructureMetadataRecord::subjectType) == ToUnderlying(subjectType)
       && c(&StructureMetadataRecord::subject) == subject,
       &StructureMetadataRecord::metadataGroup,
       &StructureMetadataRecord::subkey)
@@ -1968,9 +2080,8 @@ std::vector<StructureMetadataKey> AccessManager::Backend::Storage::getStructureM
   assert(HasInternalId(subjectType));
   using namespace std::ranges;
   return RangeToVector(
-    implementor_->getCurrentRecords(
-      c(&StructureMetadataRecord::timestamp) <= TicksSinceEpoch<milliseconds>(timestamp)
-      && c(&StructureMetadataRecord::subjectType) == ToUnderlying(subjectType)
+    implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(timestamp),
+      c(&StructureMetadataRecord::subjectType) == ToUnderlying(subjectType)
       && c(&StructureMetadataRecord::internalSubjectId) == internalSubjectId,
       &StructureMetadataRecord::metadataGroup,
       &StructureMetadataRecord::subkey)
@@ -2006,9 +2117,8 @@ std::vector<StructureMetadataEntry> AccessManager::Backend::Storage::getStructur
   }
 
   return RangeToVector(
-    implementor_->getCurrentRecords(
-      c(&StructureMetadataRecord::timestamp) <= TicksSinceEpoch<milliseconds>(timestamp)
-      && c(&StructureMetadataRecord::subjectType) == ToUnderlying(subjectType)
+    implementor_->getCurrentRecordsAt(TicksSinceEpoch<milliseconds>(timestamp),
+      c(&StructureMetadataRecord::subjectType) == ToUnderlying(subjectType)
       // If we have no subject filters, we return all subjects. If we do have subject filters, we either need to check directly, or via internalId.
       // If we have a non-empty filter, it is still possible that internalSubjectIds is empty. because no subjects match the filter.
       // But in that case, we don't want to return everything. That is why we don't check the emptiness of internalSubjectIds.
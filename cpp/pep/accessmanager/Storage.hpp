@@ -1,11 +1,13 @@
 #pragma once
 
 #include <filesystem>
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <set>
 #include <vector>
 
+#include <pep/accessmanager/AccessPolicy.hpp>
 #include <pep/accessmanager/Backend.hpp>
 #include <pep/structure/ColumnName.hpp>
 #include <pep/accessmanager/Records.hpp>
@@ -13,6 +15,9 @@
 #include <pep/rsk-pep/Pseudonyms.hpp>
 #include <pep/accessmanager/UserMessages.hpp>
 #include <pep/accessmanager/UserIdFlags.hpp>
+#include <pep/database/ChecksumChain.hpp>
+#include <pep/database/StorageProfile.hpp>
+#include <pep/utils/PropertyBasedContainer.hpp>
 
 namespace pep {
 
@@ -30,6 +35,8 @@ private:
   std::shared_ptr<GlobalConfiguration> globalConf_;
   std::filesystem::path storagePath_;
   std::unordered_map<LocalPseudonym, PolymorphicPseudonym> lpToPpMap_; // Use a map as checking existence and retrieval of a key takes O(1) time
+  std::optional<AccessPolicy> accessPolicy_; // Loaded on demand; discarded when changes to it may have been rolled back
+  PropertyBasedContainer<std::unique_ptr<database::ChecksumChain>, &database::ChecksumChain::name>::set checksumChains_;
 
   // Initialisation
 
@@ -61,8 +68,17 @@ private:
   std::optional<std::string> getSubjectForInternalId(StructureMetadataType subjectType, int64_t internalId,
                                                          Timestamp at) const;
 
+  AccessPolicy loadAccessPolicy() const;
+  void createChecksumChains();
+
 public:
-  Storage(const std::filesystem::path &path, std::shared_ptr<GlobalConfiguration> globalConf);
+  Storage(const std::filesystem::path &path, std::shared_ptr<GlobalConfiguration> globalConf, database::StorageProfile profile = {});
+
+  /// \brief Whether read() uses connections of its own, allowing (read-only) methods to be invoked from other threads
+  bool hasReadConnections() const;
+  /// \brief Invokes the callback with one of the database's read connections bound to the calling thread: see database::Storage<>::read().
+  /// \remark Only read-only methods that don't use in-memory state (such as the access policy) may be invoked from the callback.
+  void read(const std::function<void()>& callback) const;
 
   // Sanity checks
   std::vector<std::string> getChecksumChainNames();
@@ -74,6 +90,10 @@ public:
     return storagePath_;
   }
 
+  /// \brief Gets the in-memory access policy, if it reflects the state at the specified moment in time.
+  /// \return The policy, or nullptr if it has changed since \p at. Callers should then query the (time-travelling) getters below instead.
+  const AccessPolicy* getAccessPolicy(Timestamp at);
+
   /* Core operations on Participants */
   /// \brief get a vector containing all polymorphic pseudonyms currently known
   /// \return The polymorphic pseudonyms
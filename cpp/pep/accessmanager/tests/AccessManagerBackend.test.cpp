@@ -6,6 +6,7 @@
 #include <pep/accessmanager/Storage.hpp>
 
 #include <filesystem>
+#include <thread>
 #include <gmock/gmock-matchers.h>
 
 using namespace pep;
@@ -406,6 +407,37 @@ TEST_F(AccessManagerBackendTest, assertParticipantAccess_no_access) {
   }
 }
 
+TEST_F(AccessManagerBackendTest, assertParticipantsAccess) {
+  backend->checkParticipantsAccess(constants.userGroup1, std::vector{constants.localPseudonym1}, {"access", "enumerate"}, TimeNow());
+  backend->checkParticipantsAccess("Research Assessor", std::vector{constants.localPseudonym1, constants.localPseudonym2}, {"access", "enumerate"}, TimeNow());
+  backend->checkParticipantsAccess(constants.userGroup1, std::vector<LocalPseudonym>{}, {"access", "enumerate"}, TimeNow());
+
+  try {
+    backend->checkParticipantsAccess(constants.userGroup1, std::vector{constants.localPseudonym1, constants.localPseudonym2}, {"access", "enumerate"}, TimeNow());
+    FAIL() << "This should not have run without exceptions.";
+  }
+  catch (const Error& e) {
+    std::string expectedMessage = "Access denied to participant for mode \"access\"\nAccess denied to participant for mode \"enumerate\"";
+    EXPECT_EQ(e.what(), expectedMessage);
+  }
+}
+
+TEST_F(AccessManagerBackendTest, assertParticipantAccess_at_earlier_time) {
+  auto before = TimeNow();
+  std::this_thread::sleep_for(std::chrono::milliseconds(2)); // Ensure that the change gets a later timestamp
+  storage->addParticipantToGroup(constants.localPseudonym2, constants.pg1);
+
+  // Checks at the current time use the (updated) in-memory access policy...
+  EXPECT_NE(storage->getAccessPolicy(TimeNow()), nullptr);
+  backend->checkParticipantAccess(constants.userGroup1, constants.localPseudonym2, {"access", "enumerate"}, TimeNow());
+  // ... but checks at earlier times must (and do) use the state at that time
+  EXPECT_EQ(storage->getAccessPolicy(before), nullptr);
+  EXPECT_THROW(backend->checkParticipantAccess(constants.userGroup1, constants.localPseudonym2, {"access"}, before), Error);
+
+  storage->removeParticipantFromGroup(constants.localPseudonym2, constants.pg1);
+  EXPECT_THROW(backend->checkParticipantAccess(constants.userGroup1, constants.localPseudonym2, {"access"}, TimeNow()), Error);
+}
+
 TEST_F(AccessManagerBackendTest, AMAquery_noFilter){
   AmaQuery request;
   auto response = backend->performAMAQuery(request, "Access Administrator");
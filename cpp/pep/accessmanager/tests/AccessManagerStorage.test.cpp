@@ -5,6 +5,7 @@
 #include <pep/accessmanager/tests/TestSuiteGlobalConfiguration.hpp>
 #include <pep/structure/StructureSerializers.hpp>
 #include <pep/utils/File.hpp>
+#include <pep/utils/Filesystem.hpp>
 
 #include <chrono>
 #include <filesystem>
@@ -852,6 +853,29 @@ TEST_F(AccessManagerStorageTest, executeQuery_filtered_user_and_group) {
   EXPECT_EQ(groupNames, std::vector{groupA1}) << "should return double-filtered group names";
 }
 
+TEST_F(AccessManagerStorageTest, executeQuery_on_read_connection) {
+  namespace fs = pep::filesystem;
+  fs::Temporary temp{fs::temp_directory_path() / fs::RandomizedName("pepTest-AccessManager-Storage-%%%%-%%%%-%%%%")};
+  fs::create_directory(temp.path());
+  database::StorageProfile profile;
+  profile.journalMode = "WAL";
+  profile.readConnections = 1;
+  storage = std::make_shared<AccessManager::Backend::Storage>(temp.path() / "accessmanager.sqlite", globalConf, profile);
+  ASSERT_TRUE(storage->hasReadConnections());
+
+  const UserGroup group = UserGroup("MyGroup", {});
+  storage->createUserGroup(group);
+
+  UserQueryResponse response;
+  std::thread reader([&response] {
+    storage->read([&response] { response = storage->executeUserQuery({TimeNow(), "", ""}); });
+  });
+  reader.join();
+  storage.reset(); // Before the temporary directory is removed
+  PrepareSortedMine(response);
+  EXPECT_EQ(response.userGroups, std::vector{group}) << "should see data committed through the writing connection";
+}
+
 // ====
 
 using MetadataMap = std::map<std::string /*subject*/, std::map<StructureMetadataKey, std::string /*value*/>>;
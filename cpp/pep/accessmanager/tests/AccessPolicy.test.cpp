@@ -0,0 +1,80 @@
+#include <pep/accessmanager/AccessPolicy.hpp>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace pep;
+
+namespace {
+
+TEST(AccessPolicy, GrantsParticipantsThroughGroups) {
+  AccessPolicy policy;
+  auto first = LocalPseudonym::Random(), second = LocalPseudonym::Random(), third = LocalPseudonym::Random();
+
+  policy.addParticipantToGroup(first, "group");
+  policy.addParticipantToGroup(second, "other group");
+  policy.addParticipantToGroup(third, "unused group");
+  policy.addParticipantGroupAccessRule("group", "user group", "access");
+  policy.addParticipantGroupAccessRule("other group", "user group", "access");
+  policy.addParticipantGroupAccessRule("group", "user group", "enumerate");
+
+  EXPECT_EQ(3U, policy.participantCount());
+  EXPECT_FALSE(policy.findParticipantIndex(LocalPseudonym::Random()).has_value());
+  EXPECT_EQ((std::set<std::string>{ "group", "other group" }), policy.getGrantingParticipantGroups("user group", "access"));
+  EXPECT_TRUE(policy.getGrantingParticipantGroups("other user group", "access").empty());
+
+  auto access = policy.getGrantedParticipants("user group", "access");
+  ASSERT_TRUE(access.has_value());
+  ASSERT_EQ(policy.participantCount(), access->size());
+  EXPECT_TRUE(access->test(*policy.findParticipantIndex(first)));
+  EXPECT_TRUE(access->test(*policy.findParticipantIndex(second)));
+  EXPECT_FALSE(access->test(*policy.findParticipantIndex(third)));
+
+  auto both = *access & *policy.getGrantedParticipants("user group", "enumerate");
+  EXPECT_EQ(1U, both.count());
+  EXPECT_TRUE(both.test(*policy.findParticipantIndex(first)));
+
+  policy.removeParticipantFromGroup(first, "group");
+  EXPECT_FALSE(policy.getGrantedParticipants("user group", "enumerate")->any());
+
+  // Rules for participant group "*" grant access to all participants, including ones that aren't in any group
+  policy.addParticipantGroupAccessRule("*", "user group", "enumerate");
+  EXPECT_FALSE(policy.getGrantedParticipants("user group", "enumerate").has_value());
+  policy.removeParticipantGroupAccessRule("*", "user group", "enumerate");
+  EXPECT_TRUE(policy.getGrantedParticipants("user group", "enumerate").has_value());
+}
+
+TEST(AccessPolicy, LooksUpColumnGroups) {
+  AccessPolicy policy;
+  policy.addColumnGroup("group");
+  policy.addColumnGroup("other group");
+  policy.addColumnToGroup("column", "group");
+  policy.addColumnToGroup("column", "other group");
+  policy.addColumnToGroup("other column", "other group");
+  policy.addColumnGroupAccessRule("group", "user group", "read");
+
+  EXPECT_EQ((std::set<std::string>{ "group", "other group" }), policy.getColumnGroupsContaining("column"));
+  EXPECT_TRUE(policy.getColumnGroupsContaining("unknown column").empty());
+  EXPECT_EQ((std::set<ColumnGroupColumn>{ { "other group", "column" }, { "other group", "other column" } }),
+    policy.getColumnGroupColumns(std::vector<std::string>{ "other group" }));
+  EXPECT_EQ((std::set<ColumnGroupAccessRule>{ { "group", "user group", "read" } }), policy.getColumnGroupAccessRules("user group"));
+
+  policy.removeColumnFromGroup("column", "group");
+  policy.removeColumnGroup("group");
+  EXPECT_EQ(std::set<std::string>{ "other group" }, policy.getColumnGroups());
+  EXPECT_EQ(std::set<std::string>{ "other group" }, policy.getColumnGroupsContaining("column"));
+}
+
+TEST(AccessPolicy, IsCurrentAfterLastChange) {
+  AccessPolicy policy;
+  auto before = TimeNow();
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  policy.addColumnGroup("group");
+
+  EXPECT_FALSE(policy.isCurrentAt(before));
+  EXPECT_TRUE(policy.isCurrentAt(TimeNow()));
+}
+
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <optional>
+#include <span>
+#include <stdexcept>
 
 #include <rxcpp/operators/rx-observe_on.hpp>
 #include <rxcpp/operators/rx-merge.hpp>
@@ -41,6 +44,57 @@ class WorkerPool : private boost::noncopyable {
       Coordination accWorker,
       Functor f) {
     using T = std::invoke_result_t<Functor, S>;
+    return batched_map<batchSize>(std::move(xs), accWorker, f, [](std::span<T>) {});
+  }
+
+  // As above, but additionally runs onBatch on the results of each batch
+  // (on the same worker), e.g. to pack them at once using CurvePoint::PackBatch().
+  template<size_t batchSize, typename S, typename Functor, typename Coordination, typename BatchFunctor>
+  rxcpp::observable<std::vector<std::invoke_result_t<Functor, S>>>
+  batched_map(
+      std::vector<S> xs,
+      Coordination accWorker,
+      Functor f,
+      BatchFunctor onBatch) {
+    using T = std::invoke_result_t<Functor, S>;
+    return map_batches<batchSize, T>(std::move(xs), accWorker,
+      [f, onBatch](std::span<S> in, std::span<T> out) {
+        for (size_t i = 0; i < in.size(); i++)
+          out[i] = f(std::move(in[i]));
+        onBatch(out);
+      });
+  }
+
+  // Like batched_map, but runs f on entire batches at once: f receives
+  // the inputs of a batch as a std::span<S> and returns a std::vector
+  // with their results (in order).  Use this for bulk operations, such as
+  // those of ElgamalEncryptionBatch.
+  template<size_t batchSize, typename S, typename Functor, typename Coordination>
+  rxcpp::observable<std::invoke_result_t<Functor, std::span<S>>>
+  chunked_map(
+      std::vector<S> xs,
+      Coordination accWorker,
+      Functor f) {
+    using T = typename std::invoke_result_t<Functor, std::span<S>>::value_type;
+    return map_batches<batchSize, T>(std::move(xs), accWorker,
+      [f](std::span<S> in, std::span<T> out) {
+        auto results = f(in);
+        if (results.size() != out.size())
+          throw std::logic_error("chunked_map functor returned wrong number of results");
+        std::move(results.begin(), results.end(), out.begin());
+      });
+  }
+
+ private:
+  // Splits the given vector into batches; runs processBatch(inputs, outputs)
+  // in parallel on each of the batches and return the concatenated outputs
+  // on the given worker.
+  template<size_t batchSize, typename T, typename S, typename Coordination, typename BatchFunctor>
+  rxcpp::observable<std::vector<T>>
+  map_batches(
+      std::vector<S> xs,
+      Coordination accWorker,
+      BatchFunctor processBatch) {
     using T_iter = std::vector<T>::iterator;
     using S_iter = std::vector<S>::iterator;
 
@@ -78,17 +132,13 @@ class WorkerPool : private boost::noncopyable {
     // thus invalidates the iterators into it.  To keep xsPtr alive, we
     // capture it in the final callback.
     return rxcpp::observable<>::iterate(std::move(batches))
-    .map([this, f, accWorker](Batch batch) -> rxcpp::observable<bool> {
+    .map([this, processBatch, accWorker](Batch batch) -> rxcpp::observable<bool> {
       // Handle each batch on separate worker
       return rxcpp::observable<>::just(std::move(batch))
       .observe_on(this->worker())
-      .map([f](Batch batch) {
-        auto it = batch.in_begin;
-        auto out = batch.out;
-        while (it != batch.in_end) {
-          *out = f(std::move(*it));
-          it++; out++;
-        }
+      .map([processBatch](Batch batch) {
+        auto size = static_cast<size_t>(batch.in_end - batch.in_begin);
+        processBatch(std::span<S>(batch.in_begin, size), std::span<T>(batch.out, size));
         return true; // rxcpp doesn't like void
       }).observe_on(accWorker);
     })
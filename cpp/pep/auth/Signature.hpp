@@ -58,6 +58,7 @@ public:
       bool isLogCopy=false,
       SignatureScheme scheme=SignatureScheme::V4);
 
+  const std::string& signature() const noexcept { return signature_; }
   const X509CertificateChain& certificateChain() const noexcept { return certificateChain_; }
   Timestamp timestamp() const { return timestamp_; }
 
@@ -4,18 +4,57 @@
 
 #include <openssl/rand.h>
 
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <optional>
 #include <random>
+#include <span>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 
 #include <pep/utils/OpensslUtils.hpp>
 #include <pep/elgamal/CurvePoint.hpp>
 #include <pep/elgamal/CurveScalar.hpp>
+#include <pep/rsk/Proofs.hpp>
 #include <pep/rsk/RskTranslator.hpp>
+#include <pep/rsk/ScalarMultTableFile.hpp>
 #include <pep/rsk-pep/Pseudonyms.hpp>
+#include <pep/utils/Exceptions.hpp>
+#include <pep/utils/Filesystem.hpp>
 #include <pep/utils/Random.hpp>
 #include <pep/utils/OpenSSLHasher.hpp>
 #include <pep/accessmanager/AccessManagerSerializers.hpp>
 #include <pep/storagefacility/StorageFacilitySerializers.hpp>
+#include <pep/structure/ShortPseudonyms.hpp>
+#include <pep/async/OnAsio.hpp>
+#include <pep/async/RxInstead.hpp>
+#include <pep/async/RxParallelConcat.hpp>
+#include <pep/async/WorkerPool.hpp>
+#include <pep/messaging/MessagingSerializers.hpp>
+#include <pep/messaging/Node.hpp>
+#include <pep/networking/tests/TestServerFactory.test.hpp>
+
+#ifdef PEP_BENCHMARK_STORAGE_FACILITY
+# include <pep/networking/EndPoint.PropertySerializer.hpp>
+# include <pep/storagefacility/FileStore.hpp>
+# include <pep/storagefacility/PagePutWindow.hpp>
+# include <pep/storagefacility/PageStore.hpp>
+# include <pep/storagefacility/S3Credentials.PropertySerializer.hpp>
+# include <pep/storagefacility/SFIdSerializer.hpp>
+# include <pep/rsk/EGCache.hpp>
+# include <pep/utils/Configuration.hpp>
+# include <prometheus/registry.h>
+# include <rxcpp/operators/rx-flat_map.hpp>
+#endif
+
+#ifdef PEP_BENCHMARK_ACCESS_MANAGER
+# include <pep/accessmanager/AccessPolicy.hpp>
+# include <pep/database/RecordChecksumChain.hpp>
+# include <pep/database/Storage.hpp>
+# include <pep/utils/Bitpacking.hpp>
+#endif
 
 namespace {
 void SetBytesProcessed(benchmark::State& state, size_t bytesPerIteration)
@@ -54,6 +93,24 @@ static void BM_CurvePointPack(benchmark::State& state) {
 }
 BENCHMARK(BM_CurvePointPack);
 
+// Compare items per second with BM_CurvePointPack
+static void BM_CurvePointPackBatch(benchmark::State& state) {
+  std::vector<pep::CurvePoint> pts;
+  for (int64_t i = 0; i < state.range(0); i++)
+    pts.push_back(pep::CurvePoint::Random() + pep::CurvePoint::Random());
+  for (auto _ : state) {
+    // Copy the points to prevent CurvePoint from caching the packed result.
+    auto copies = pts;
+    std::vector<const pep::CurvePoint*> ptrs;
+    for (const auto& pt : copies)
+      ptrs.push_back(&pt);
+    pep::CurvePoint::PackBatch(ptrs);
+    benchmark::DoNotOptimize(copies.back().pack());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CurvePointPackBatch)->RangeMultiplier(4)->Range(1, 256);
+
 static void BM_CurvePointAdd(benchmark::State& state) {
   pep::CurvePoint pt(boost::algorithm::unhex(std::string(
        "b01d60504aa5f4c5bd9a7541c457661f9a789d18cb4e136e91d3c953488bd208")));
@@ -92,6 +149,36 @@ static void BM_ScalarMultTable(benchmark::State& state) {
 }
 BENCHMARK(BM_ScalarMultTable);
 
+// Obtaining state.range(0) tables after a (server) restart, by computing
+// them, or by loading them from a ScalarMultTableFile written earlier.
+static void BM_EGCacheWarmUp(benchmark::State& state, bool fromFile) {
+  namespace fs = pep::filesystem;
+  fs::Temporary temp{fs::temp_directory_path() / fs::RandomizedName("pepBenchmark-ScalarMultTableFile-%%%%-%%%%-%%%%")};
+  std::vector<pep::CurvePoint> points(static_cast<size_t>(state.range(0)));
+  std::generate(points.begin(), points.end(), pep::CurvePoint::Random);
+  if (fromFile) {
+    pep::ScalarMultTableFile file(temp.path());
+    for (const auto& point : points)
+      file.store(point, pep::CurvePoint::ScalarMultTable(point));
+  }
+
+  auto& cache = pep::EGCache::get();
+  for (auto _ : state) {
+    state.PauseTiming();
+    cache.setTableStore(nullptr);
+    cache.setMemoryBudget(pep::EGCache::DefaultMemoryBudget); // evicts all tables
+    state.ResumeTiming();
+    if (fromFile)
+      cache.setTableStore(std::make_shared<pep::ScalarMultTableFile>(temp.path()));
+    for (const auto& point : points)
+      benchmark::DoNotOptimize(cache.scalarMultTable(point));
+  }
+  cache.setTableStore(nullptr);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_CAPTURE(BM_EGCacheWarmUp, Compute, false)->Arg(16)->Arg(256);
+BENCHMARK_CAPTURE(BM_EGCacheWarmUp, FromFile, true)->Arg(16)->Arg(256);
+
 static void BM_ScalarBaseMult(benchmark::State& state) {
   auto scalar = pep::CurveScalar::From64Bytes("1234567890123456789012345678901234567890123456789012345678901234");
   for (auto _ : state)
@@ -130,6 +217,22 @@ static void BM_PublicScalarMult(benchmark::State& state) {
 }
 BENCHMARK(BM_PublicScalarMult);
 
+template <typename Scalar>
+static void BM_MultiScalarMult(benchmark::State& state) {
+  std::vector<Scalar> scalars;
+  std::vector<pep::CurvePoint> points;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    scalars.emplace_back(pep::CurveScalar::Random());
+    points.push_back(pep::CurvePoint::Random());
+  }
+  for (auto _ : state)
+    benchmark::DoNotOptimize(pep::CurvePoint::MultiScalarMult(std::span<const Scalar>(scalars), points));
+  // Compare items per second with BM_ScalarMult and BM_PublicScalarMult
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_MultiScalarMult<pep::CurveScalar>)->RangeMultiplier(2)->Range(2, 4096);
+BENCHMARK(BM_MultiScalarMult<pep::PublicCurveScalar>)->RangeMultiplier(2)->Range(2, 4096);
+
 static void BM_CurvePointElligatorHash(benchmark::State& state) {
   for (auto _ : state)
     pep::CurvePoint::Hash("test string");
@@ -210,6 +313,50 @@ static void BM_GenerateKeyFactor(benchmark::State& state) {
 BENCHMARK(BM_GenerateKeyFactor);
 
 
+namespace {
+struct RskProofBenchmarkData {
+  pep::ReshuffleRekeyVerifiers verifiers;
+  std::vector<pep::ElgamalEncryption> pre;
+  std::vector<pep::ElgamalEncryption> post;
+  std::vector<pep::RskProof> proofs;
+};
+
+RskProofBenchmarkData CreateRskProofBenchmarkData(size_t count) {
+  auto reshuffle = pep::CurveScalar::Random();
+  auto rekey = pep::CurveScalar::Random();
+  auto publicKey = pep::CurvePoint::Random();
+  RskProofBenchmarkData result{.verifiers = pep::ReshuffleRekeyVerifiers::Compute(reshuffle, rekey, publicKey)};
+  for (size_t i = 0; i < count; i++) {
+    result.pre.emplace_back(pep::CurvePoint::Random(), pep::CurvePoint::Random(), publicKey);
+    result.proofs.push_back(pep::RskProof::CertifiedRsk(result.pre.back(), result.post.emplace_back(), reshuffle, rekey));
+  }
+  return result;
+}
+}
+
+static void BM_RskProofVerify(benchmark::State& state) {
+  auto data = CreateRskProofBenchmarkData(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    for (size_t i = 0; i < data.proofs.size(); i++)
+      data.proofs[i].verify(data.pre[i], data.post[i], data.verifiers);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RskProofVerify)->Arg(64);
+
+// Compare items per second with BM_RskProofVerify
+static void BM_RskProofBatchVerify(benchmark::State& state) {
+  auto data = CreateRskProofBenchmarkData(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    pep::ScalarMultProof::BatchVerifier batch;
+    for (size_t i = 0; i < data.proofs.size(); i++)
+      data.proofs[i].addTo(batch, data.pre[i], data.post[i], data.verifiers);
+    batch.verify();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RskProofBatchVerify)->RangeMultiplier(4)->Range(1, 256);
+
 static void BM_PageDecrypt(benchmark::State& state) {
   pep::DataPayloadPage page;
   std::string plaintext(1000*1000, '\0');
@@ -378,6 +525,679 @@ static void BM_VerifyDigest(benchmark::State& state) {
 }
 BENCHMARK(BM_VerifyDigest);
 
+// Generates a short pseudonym that doesn't collide with state.range(0) existing ones, like the registration server does when registering a participant.
+// Looking candidates up in a hash set (state.range(1) == 1) should take the same time regardless of the number of existing pseudonyms,
+// while comparing candidates to every existing pseudonym (state.range(1) == 0) scales with that number.
+static void BM_GenerateUniqueShortPseudonym(benchmark::State& state) {
+  constexpr std::string_view prefix = "BENCH";
+  constexpr std::size_t length = 10;
+  const auto existingCount = static_cast<std::size_t>(state.range(0));
+
+  std::unordered_set<std::string> existing;
+  existing.reserve(existingCount);
+  while (existing.size() < existingCount) {
+    existing.insert(pep::GenerateShortPseudonym(prefix, length));
+  }
+
+  if (state.range(1) == 1) {
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(pep::GenerateUniqueShortPseudonym(prefix, length, existing));
+    }
+  }
+  else {
+    std::vector<std::string> scanned(existing.begin(), existing.end());
+    for (auto _ : state) {
+      std::string generated;
+      do {
+        generated = pep::GenerateShortPseudonym(prefix, length);
+      } while (std::ranges::find(scanned, generated) != scanned.end());
+      scanned.push_back(generated);
+      benchmark::DoNotOptimize(generated);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GenerateUniqueShortPseudonym)->ArgsProduct({ { 1'000, 1'000'000 }, { 0, 1 } });
+
+#ifndef __EMSCRIPTEN__
+namespace {
+// Replies to a PingRequest once its tail has been received completely
+class TailDrainingRequestHandler : public pep::messaging::RequestHandler {
+private:
+  pep::messaging::MessageBatches handlePingRequest(std::shared_ptr<pep::PingRequest> request, pep::messaging::MessageSequence tail) {
+    auto response = std::make_shared<std::string>(pep::Serialization::ToString(pep::PingResponse(request->id())));
+    return rxcpp::observable<>::just(tail.op(pep::RxInstead(response)).as_dynamic());
+  }
+
+public:
+  TailDrainingRequestHandler() {
+    RegisterRequestHandlers(*this, &TailDrainingRequestHandler::handlePingRequest);
+  }
+};
+
+// Stands in for the storage facility: replies to a PingRequest with a stream of
+// (serialized) encrypted pages, like the storage facility replies to a DataReadRequest2
+class PageServingRequestHandler : public pep::messaging::RequestHandler {
+private:
+  std::vector<std::shared_ptr<std::string>> pages_;
+
+  pep::messaging::MessageBatches handlePingRequest(std::shared_ptr<pep::PingRequest>) {
+    return rxcpp::observable<>::just(rxcpp::observable<>::iterate(pages_).as_dynamic());
+  }
+
+public:
+  explicit PageServingRequestHandler(std::vector<std::shared_ptr<std::string>> pages)
+    : pages_(std::move(pages)) {
+    RegisterRequestHandlers(*this, &PageServingRequestHandler::handlePingRequest);
+  }
+};
+
+// A client connected to a server across a loopback TLS connection
+class LoopbackConnection {
+private:
+  boost::asio::io_context& ioContext_;
+  TlsTestServerFactory factory_;
+  std::shared_ptr<pep::networking::Protocol::ServerParameters> serverParameters_;
+  std::shared_ptr<pep::messaging::Node> server_;
+  std::shared_ptr<pep::messaging::Node> client_;
+
+public:
+  std::shared_ptr<pep::messaging::Connection> connection;
+  std::exception_ptr error;
+
+  LoopbackConnection(boost::asio::io_context& ioContext, uint16_t port, pep::messaging::RequestHandler& handler)
+    : ioContext_(ioContext) {
+    serverParameters_ = factory_.createServerParameters(ioContext_, port);
+    server_ = pep::messaging::Node::Create(*serverParameters_, handler);
+    client_ = pep::messaging::Node::Create(*factory_.createClientParameters(*serverParameters_));
+
+    server_->start().subscribe([](const pep::messaging::Connection::Attempt::Result&) { /* ignore */ }, [](std::exception_ptr) { /* ignore */ });
+    client_->start().subscribe(
+      [this](const pep::messaging::Connection::Attempt::Result& result) {
+        if (result) {
+          connection = *result;
+        }
+        else {
+          error = result.exception();
+        }
+        ioContext_.stop();
+      },
+      [this](std::exception_ptr e) { error = e; ioContext_.stop(); });
+    ioContext_.run();
+  }
+
+  ~LoopbackConnection() {
+    connection.reset();
+    ioContext_.restart();
+    client_->shutdown().subscribe([](pep::FakeVoid) { /* ignore */ }, [](std::exception_ptr) { /* ignore */ });
+    server_->shutdown().subscribe([](pep::FakeVoid) { /* ignore */ }, [](std::exception_ptr) { /* ignore */ });
+    ioContext_.run();
+  }
+};
+}
+
+// Sends state.range(1) messages of state.range(0) bytes each (as the tail of a
+// single request) across a loopback TLS connection
+static void BM_MessagingThroughput(benchmark::State& state) {
+  constexpr uint16_t Port = 2023;
+  auto messageSize = static_cast<size_t>(state.range(0));
+  auto messageCount = static_cast<size_t>(state.range(1));
+
+  boost::asio::io_context ioContext;
+  TailDrainingRequestHandler handler;
+  LoopbackConnection loopback(ioContext, Port, handler);
+  if (loopback.error != nullptr) {
+    state.SkipWithError(pep::GetExceptionMessage(loopback.error).c_str());
+  }
+
+  auto message = std::make_shared<std::string>(messageSize, 'x');
+  std::vector<std::shared_ptr<std::string>> tail(messageCount, message);
+  for (auto _ : state) {
+    ioContext.restart();
+    loopback.connection->sendRequest(std::make_shared<std::string>(pep::Serialization::ToString(pep::PingRequest())),
+      rxcpp::observable<>::just(rxcpp::observable<>::iterate(tail).as_dynamic()))
+      .subscribe(
+        [](const std::string&) { /* ignore */ },
+        [&loopback, &ioContext](std::exception_ptr e) { loopback.error = e; ioContext.stop(); },
+        [&ioContext]() { ioContext.stop(); });
+    ioContext.run();
+    if (loopback.error != nullptr) {
+      state.SkipWithError(pep::GetExceptionMessage(loopback.error).c_str());
+      break;
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+  SetBytesProcessed(state, messageCount * messageSize);
+}
+BENCHMARK(BM_MessagingThroughput)->Args({64, 4096})->Args({1024, 4096})->Args({256 * 1024, 64})->Unit(benchmark::kMillisecond);
+
+// Downloads state.range(0) pages of 1 MB from a storage facility stand-in across a
+// loopback TLS connection, and decrypts them either on the IO thread or (like
+// CoreClient::retrieveData) on the WorkerPool, state.range(1) pages at a time.
+static void BM_PageDownload(benchmark::State& state) {
+  constexpr uint16_t Port = 2024;
+  auto pageCount = static_cast<size_t>(state.range(0));
+  auto parallelism = static_cast<size_t>(state.range(1));
+
+  std::string plaintext(1000 * 1000, '\0');
+  pep::Metadata md;
+  std::string key;
+  key.resize(32);
+  std::vector<std::shared_ptr<std::string>> pages;
+  for (size_t i = 0; i < pageCount; ++i) {
+    pep::DataPayloadPage page;
+    page.pageNumber = i;
+    page.setEncrypted(plaintext, key, md);
+    pages.push_back(std::make_shared<std::string>(pep::Serialization::ToString(std::move(page))));
+  }
+
+  boost::asio::io_context ioContext;
+  PageServingRequestHandler handler(std::move(pages));
+  LoopbackConnection loopback(ioContext, Port, handler);
+  if (loopback.error != nullptr) {
+    state.SkipWithError(pep::GetExceptionMessage(loopback.error).c_str());
+  }
+
+  auto workerPool = pep::WorkerPool::getShared();
+  auto decrypt = [&key, &md](const std::string& serialized) {
+    return pep::Serialization::FromString<pep::DataPayloadPage>(serialized).decrypt(key, md).size();
+  };
+  for (auto _ : state) {
+    ioContext.restart();
+    auto responses = loopback.connection->sendRequest(std::make_shared<std::string>(pep::Serialization::ToString(pep::PingRequest())));
+    rxcpp::observable<size_t> decrypted = parallelism == 0
+      ? responses.map(decrypt).as_dynamic()
+      : responses.map([&ioContext, workerPool, decrypt](std::string serialized) {
+          return rxcpp::observable<>::just(std::move(serialized))
+            .observe_on(workerPool->worker())
+            .map(decrypt)
+            .observe_on(pep::ObserveOnAsio(ioContext));
+        })
+        .op(pep::RxParallelConcat(parallelism));
+
+    size_t received = 0;
+    decrypted.subscribe(
+        [&received](size_t size) { received += size; },
+        [&loopback, &ioContext](std::exception_ptr e) { loopback.error = e; ioContext.stop(); },
+        [&ioContext]() { ioContext.stop(); });
+    ioContext.run();
+    if (loopback.error != nullptr) {
+      state.SkipWithError(pep::GetExceptionMessage(loopback.error).c_str());
+      break;
+    }
+    if (received != pageCount * plaintext.size()) {
+      state.SkipWithError("Received wrong number of bytes");
+      break;
+    }
+  }
+
+  SetBytesProcessed(state, pageCount * plaintext.size());
+}
+BENCHMARK(BM_PageDownload)->Args({64, 0})->Args({64, 4})->Args({64, 16})->Unit(benchmark::kMillisecond);
+#endif
+
+#ifdef PEP_BENCHMARK_STORAGE_FACILITY
+// Configuration for a page store in the "data" subdirectory of the given (benchmark) directory
+static pep::Configuration FileStoreBenchmarkPageStoreConfig(const std::filesystem::path& directory) {
+  std::filesystem::create_directories(directory / "data" / "bucket");
+  boost::property_tree::ptree localConf;
+  localConf.put("DataDir", (directory / "data").string());
+  localConf.put("Bucket", "bucket");
+  boost::property_tree::ptree pageStoreConf;
+  pageStoreConf.put_child("Local", localConf);
+  return pep::Configuration::FromPtree(pageStoreConf);
+}
+
+// Starting a FileStore holding state.range(0) (synthetic) entries: 10 columns
+// per participant, 2 versions per cell.  The store is filled once, outside of
+// the measurement.  Note that filling it takes a while for the larger sizes.
+static void BM_FileStoreStartup(benchmark::State& state, pep::EntryStorage::Type storageType) {
+  namespace fs = pep::filesystem;
+  constexpr int64_t ColumnsPerParticipant = 10;
+  constexpr int64_t VersionsPerCell = 2;
+
+  fs::Temporary temp{fs::temp_directory_path() / fs::RandomizedName("pepBenchmark-FileStore-%%%%-%%%%-%%%%")};
+  auto pageStoreConfig = FileStoreBenchmarkPageStoreConfig(temp.path());
+  auto io_context = std::make_shared<boost::asio::io_context>();
+  auto open = [&]() {
+    return pep::FileStore::Create(temp.path() / "meta", pageStoreConfig, io_context, nullptr, storageType);
+  };
+
+  {
+    auto store = open();
+    auto point = pep::CurvePoint::Random();
+    auto participants = state.range(0) / (ColumnsPerParticipant * VersionsPerCell);
+    for (int64_t p = 0; p < participants; ++p) {
+      auto participant = pep::LocalPseudonym::Random();
+      for (int64_t c = 0; c < ColumnsPerParticipant; ++c) {
+        pep::EntryName name(participant, "Column" + std::to_string(c));
+        for (int64_t v = 1; v <= VersionsPerCell; ++v) {
+          auto change = store->modifyEntry(name, true);
+          change->setContent(std::make_unique<pep::EntryContent>(
+            pep::EntryContent::Metadata(),
+            pep::EntryContent::PayloadData({.polymorphicKey = pep::EncryptedKey(point, point, point), .blindingTimestamp = pep::Timestamp(std::chrono::milliseconds{v}), .scheme = pep::EncryptionScheme::V3}, nullptr)));
+          std::move(*change).commit(pep::Timestamp(std::chrono::milliseconds{v}));
+        }
+      }
+    }
+  }
+
+  for (auto _ : state) {
+    auto store = open();
+    state.PauseTiming();
+    store.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_CAPTURE(BM_FileStoreStartup, Directory, pep::EntryStorage::Type::Directory)
+  ->Arg(10'000)->Arg(100'000)->Arg(1'000'000)->Unit(benchmark::kMillisecond)->Iterations(3);
+BENCHMARK_CAPTURE(BM_FileStoreStartup, Log, pep::EntryStorage::Type::Log)
+  ->Arg(10'000)->Arg(100'000)->Arg(1'000'000)->Arg(10'000'000)->Unit(benchmark::kMillisecond)->Iterations(3);
+
+// Storing small (inline) cells, waiting until they are durable after every
+// state.range(0) of them, as the storage facility does when that many requests
+// are committed at the same time.  Compare items per second with range 1 to see
+// what group commit gains.
+static void BM_FileStoreStoreSmallCells(benchmark::State& state, pep::EntryStorage::Type storageType) {
+  namespace fs = pep::filesystem;
+  fs::Temporary temp{fs::temp_directory_path() / fs::RandomizedName("pepBenchmark-FileStore-%%%%-%%%%-%%%%")};
+  auto io_context = std::make_shared<boost::asio::io_context>();
+  auto store = pep::FileStore::Create(temp.path() / "meta", FileStoreBenchmarkPageStoreConfig(temp.path()), io_context, nullptr, storageType);
+  auto workerPool = pep::WorkerPool::getShared();
+  auto point = pep::CurvePoint::Random();
+  auto page = std::make_shared<std::string>(100, 'x');
+
+  for (auto _ : state) {
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      auto change = store->modifyEntry(pep::EntryName(pep::LocalPseudonym::Random(), "Column"), true);
+      change->setContent(std::make_unique<pep::EntryContent>(
+        pep::EntryContent::Metadata(),
+        pep::EntryContent::PayloadData({.polymorphicKey = pep::EncryptedKey(point, point, point), .blindingTimestamp = pep::Timestamp(std::chrono::milliseconds{1}), .scheme = pep::EncryptionScheme::V3}, nullptr)));
+      change->appendPage(page, page->size(), 0).subscribe([](const std::string&) {});
+      std::move(*change).commit(pep::Timestamp(std::chrono::milliseconds{1}));
+    }
+    store->whenDurable(workerPool).subscribe([](pep::FakeVoid) {});
+    io_context->run();
+    io_context->restart();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_CAPTURE(BM_FileStoreStoreSmallCells, Directory, pep::EntryStorage::Type::Directory)
+  ->Arg(1)->Arg(16)->Arg(256)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_FileStoreStoreSmallCells, Log, pep::EntryStorage::Type::Log)
+  ->Arg(1)->Arg(16)->Arg(256)->Unit(benchmark::kMicrosecond);
+
+namespace {
+std::string GetEnvOr(const char* name, const std::string& defaultValue) {
+  //NOLINTNEXTLINE(concurrency-mt-unsafe) std::getenv is thread safe as long as we do not setenv/unsetenv/putenv
+  auto value = std::getenv(name);
+  return value != nullptr ? std::string(value) : defaultValue;
+}
+}
+
+// Uploads 64 MiB as pages of state.range(0) bytes to an S3 server, putting up
+// to state.range(1) pages at a time (through a 128 MiB PagePutWindow), like the
+// storage facility stores the pages of a (large) cell.  Pages of 16 MiB and up
+// are sent as multipart uploads.  Requires a (local) S3 server such as s3proxy,
+// located by the same PEP_S3_* environment variables as the storage facility's
+// unit tests: see storagefacility/tests/sftest.hpp.
+static void BM_S3PageStoreUpload(benchmark::State& state) {
+  constexpr size_t TotalBytes = 64 * 1024 * 1024;
+  auto pageSize = static_cast<size_t>(state.range(0));
+  auto parallelism = static_cast<size_t>(state.range(1));
+
+  boost::property_tree::ptree s3Conf;
+  pep::SerializeProperties(s3Conf, "EndPoint", pep::EndPoint(
+    GetEnvOr("PEP_S3_HOST", "localhost"),
+    static_cast<uint16_t>(std::stoi(GetEnvOr("PEP_S3_PORT", "9000"))),
+    GetEnvOr("PEP_S3_EXPECT_COMMON_NAME", "S3")));
+  pep::SerializeProperties(s3Conf, "Credentials", pep::s3::Credentials{
+    .accessKey = GetEnvOr("PEP_S3_ACCESS_KEY", "MyAccessKey"),
+    .secret = GetEnvOr("PEP_S3_SECRET_KEY", "MySecret"),
+    .service = GetEnvOr("PEP_S3_SERVICE_NAME", "s3"),
+  });
+  s3Conf.put("CaCertificateFile", GetEnvOr("PEP_ROOT_CA", "rootCA.cert"));
+  auto bucket = GetEnvOr("PEP_S3_TEST_BUCKET", "myBucket");
+  s3Conf.put("WriteToBucket", bucket);
+  pep::SerializeProperties(s3Conf, "ReadFromBuckets", std::vector{ bucket });
+  s3Conf.put("MaxConnections", std::max<size_t>(parallelism, 5));
+  s3Conf.put("MultipartThreshold", 16 * 1024 * 1024);
+  boost::property_tree::ptree pageStoreConf;
+  pageStoreConf.put_child("S3", s3Conf);
+
+  auto io_context = std::make_shared<boost::asio::io_context>();
+  auto store = pep::PageStore::Create(io_context, std::make_shared<prometheus::Registry>(), pep::Configuration::FromPtree(pageStoreConf));
+  auto page = std::make_shared<std::string>(pep::RandomString(pageSize));
+  auto prefix = boost::algorithm::hex(pep::RandomString(8));
+  size_t iteration = 0;
+
+  for (auto _ : state) {
+    std::exception_ptr error;
+    auto window = pep::PagePutWindow::Create(128 * 1024 * 1024);
+    rxcpp::observable<>::range<size_t>(0, TotalBytes / pageSize - 1)
+      .map([&store, &window, &page, &prefix, iteration](size_t i) {
+        return window->put(page->size(), store->put(prefix + "-" + std::to_string(iteration) + "-" + std::to_string(i), std::vector{ page }));
+      })
+      .op(pep::RxParallelConcat(parallelism))
+      .subscribe(
+        [](const std::string&) { /* ignore */ },
+        [&error, &io_context](std::exception_ptr e) { error = e; io_context->stop(); },
+        [&io_context]() { io_context->stop(); });
+    io_context->run();
+    io_context->restart();
+    ++iteration;
+    if (error != nullptr) {
+      state.SkipWithError(pep::GetExceptionMessage(error).c_str());
+      break;
+    }
+  }
+
+  store.reset();
+  io_context->run();
+  SetBytesProcessed(state, TotalBytes);
+}
+BENCHMARK(BM_S3PageStoreUpload)
+  ->Args({1024 * 1024, 1})->Args({1024 * 1024, 8})
+  ->Args({32 * 1024 * 1024, 1})->Args({32 * 1024 * 1024, 2})
+  ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// The per-ID work of a storage facility metadata read of state.range(0) IDs:
+// decrypting the (SF) IDs into entry names, and rerandomizing the entries'
+// polymorphic keys.  Done on the calling thread (like the storage facility
+// used to, on its I/O thread) when state.range(1) is zero, or in batches on
+// the WorkerPool (like it does now) otherwise.
+static void BM_SFMetadataReadIds(benchmark::State& state) {
+  auto idCount = static_cast<size_t>(state.range(0));
+  auto onWorkerPool = state.range(1) != 0;
+
+  auto encIdKey = pep::RandomString(32);
+  auto publicKey = pep::ElgamalPublicKey::Random();
+  std::vector<std::string> ids;
+  std::vector<pep::ElgamalEncryption> keys;
+  for (size_t i = 0; i < idCount; ++i) {
+    pep::EntryName name(pep::LocalPseudonym::Random(), "Column" + std::to_string(i % 100));
+    ids.push_back(pep::Serialization::ToString(pep::EncryptedSFId(encIdKey, pep::SFId{ name.string(), pep::Timestamp(std::chrono::milliseconds{i + 1}) }), false));
+    keys.emplace_back(publicKey, pep::CurvePoint::Random());
+  }
+
+  auto decrypt = [&encIdKey](const std::string& id) {
+    auto sfid = pep::Serialization::FromString<pep::EncryptedSFId>(id, false).decrypt(encIdKey);
+    return pep::EntryName::Parse(sfid.path).string().size();
+  };
+  auto rerandomize = [](const pep::ElgamalEncryption& key) {
+    return pep::EGCache::get().rerandomize(key);
+  };
+  auto pack = [](std::span<pep::ElgamalEncryption> keys) {
+    std::vector<const pep::CurvePoint*> points;
+    for (const auto& key : keys)
+      key.addPointsTo(points);
+    pep::CurvePoint::PackBatch(points);
+  };
+
+  boost::asio::io_context ioContext;
+  auto workerPool = pep::WorkerPool::getShared();
+  for (auto _ : state) {
+    if (!onWorkerPool) {
+      for (const auto& id : ids)
+        benchmark::DoNotOptimize(decrypt(id));
+      std::vector<pep::ElgamalEncryption> rerandomized;
+      rerandomized.reserve(keys.size());
+      for (const auto& key : keys)
+        rerandomized.push_back(rerandomize(key));
+      pack(rerandomized);
+      benchmark::DoNotOptimize(rerandomized);
+      continue;
+    }
+
+    // Batch sizes as used by the storage facility
+    size_t results = 0;
+    workerPool->batched_map<64>(ids, pep::ObserveOnAsio(ioContext), decrypt)
+      .flat_map([&](std::vector<size_t> decrypted) {
+        results += decrypted.size();
+        return workerPool->batched_map<8>(keys, pep::ObserveOnAsio(ioContext), rerandomize, pack);
+      })
+      .subscribe([&results](const std::vector<pep::ElgamalEncryption>& rerandomized) { results += rerandomized.size(); });
+    ioContext.run();
+    ioContext.restart();
+    if (results != 2 * idCount) {
+      state.SkipWithError("Processed wrong number of IDs");
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SFMetadataReadIds)->Args({10'000, 0})->Args({10'000, 1})->Unit(benchmark::kMillisecond)->UseRealTime();
+#endif
+
+#ifdef PEP_BENCHMARK_ACCESS_MANAGER
+// Checks a ticket's access to state.range(0) participants against an access policy
+// of 100k participants, spread over 100 participant groups, like
+// AccessManager::Backend::checkParticipantsAccess does for current tickets.
+static void BM_AccessPolicyTicketCheck(benchmark::State& state) {
+  constexpr size_t participantCount = 100'000, groupCount = 100;
+  const std::string userGroup = "Research Assessor";
+  const std::vector<std::string> modes{ "access", "enumerate" };
+
+  pep::AccessPolicy policy;
+  std::vector<pep::LocalPseudonym> participants;
+  participants.reserve(participantCount);
+  for (size_t i = 0; i < participantCount; ++i) {
+    participants.push_back(pep::LocalPseudonym::Random());
+    policy.addParticipantToGroup(participants.back(), "Group" + std::to_string(i % groupCount));
+  }
+  // Grant access to half of the groups, and enumerate access to all of them
+  for (size_t i = 0; i < groupCount; ++i) {
+    auto group = "Group" + std::to_string(i);
+    if (i % 2 == 0) {
+      policy.addParticipantGroupAccessRule(group, userGroup, "access");
+    }
+    policy.addParticipantGroupAccessRule(group, userGroup, "enumerate");
+  }
+
+  // Request participants in the accessible groups
+  std::vector<pep::LocalPseudonym> requested;
+  for (size_t i = 0; requested.size() < static_cast<size_t>(state.range(0)); i += 2) {
+    requested.push_back(participants[i % participantCount]);
+  }
+
+  for (auto _ : state) {
+    std::optional<pep::AccessPolicy::ParticipantSet> granted;
+    for (const auto& mode : modes) {
+      auto participantsWithMode = policy.getGrantedParticipants(userGroup, mode);
+      granted = granted.has_value() ? *granted & *participantsWithMode : std::move(*participantsWithMode);
+    }
+    for (const auto& participant : requested) {
+      auto index = policy.findParticipantIndex(participant);
+      if (!index.has_value() || !granted->test(*index)) {
+        state.SkipWithError("Participant access unexpectedly denied");
+        break;
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AccessPolicyTicketCheck)->Arg(1)->Arg(1'000)->Arg(50'000);
+
+namespace {
+
+struct BenchmarkChecksumRecord {
+  int64_t seqno{};
+  std::vector<char> checksumNonce;
+
+  uint64_t checksum() const {
+    return pep::UnpackUint64BE(pep::Sha256().digest(std::string(checksumNonce.begin(), checksumNonce.end())));
+  }
+};
+
+auto MakeBenchmarkChecksumStorage(const std::string& path) {
+  using namespace sqlite_orm;
+  return make_storage(path,
+    make_table("BenchmarkChecksumRecords",
+      make_column("seqno", &BenchmarkChecksumRecord::seqno, primary_key().autoincrement()),
+      make_column("checksumNonce", &BenchmarkChecksumRecord::checksumNonce)));
+}
+
+using BenchmarkChecksumStorage = pep::database::Storage<MakeBenchmarkChecksumStorage>;
+using BenchmarkChecksumChain = pep::database::RecordChecksumChain<BenchmarkChecksumStorage, BenchmarkChecksumRecord>;
+
+}
+
+// Appends a record to a table of state.range(0) records and then calculates the table's checksum chain,
+// like the access manager does when the watchdog requests its chains after every change.
+// The incremental (cached) chain (state.range(1) == 1) should take the same time regardless of table size,
+// while recalculating the chain from scratch (state.range(1) == 0) scales with the number of records.
+static void BM_ChecksumChainAfterAppend(benchmark::State& state) {
+  auto storage = std::make_shared<BenchmarkChecksumStorage>(pep::database::BasicStorage::StoreInMemory);
+  storage->syncSchema();
+  {
+    auto guard = storage->raw.transaction_guard();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      storage->raw.insert(BenchmarkChecksumRecord{ .checksumNonce = pep::RandomVector<char>(16) });
+    }
+    guard.commit();
+  }
+
+  constexpr uint64_t latest = std::numeric_limits<int64_t>::max();
+  auto chain = std::make_unique<BenchmarkChecksumChain>("benchmark", storage);
+  benchmark::DoNotOptimize(chain->get(latest));
+
+  for (auto _ : state) {
+    storage->raw.insert(BenchmarkChecksumRecord{ .checksumNonce = pep::RandomVector<char>(16) });
+    if (state.range(1) == 0) {
+      chain = std::make_unique<BenchmarkChecksumChain>("benchmark", storage);
+    }
+    benchmark::DoNotOptimize(chain->get(latest));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ChecksumChainAfterAppend)->ArgsProduct({ { 1'000, 10'000, 100'000 }, { 0, 1 } });
+
+namespace {
+
+struct BenchmarkHistoryRecord {
+  int64_t seqno{};
+  int64_t timestamp{};
+  bool tombstone{};
+  int64_t subject{};
+  std::string value;
+
+  static inline const std::tuple RecordIdentifier{ &BenchmarkHistoryRecord::subject };
+};
+
+auto MakeBenchmarkHistoryStorage(const std::string& path) {
+  using namespace sqlite_orm;
+  return make_storage(path,
+    make_index("idx_BenchmarkHistoryRecords", &BenchmarkHistoryRecord::subject),
+    make_table("BenchmarkHistoryRecords",
+      make_column("seqno", &BenchmarkHistoryRecord::seqno, primary_key().autoincrement()),
+      make_column("timestamp", &BenchmarkHistoryRecord::timestamp),
+      make_column("tombstone", &BenchmarkHistoryRecord::tombstone),
+      make_column("subject", &BenchmarkHistoryRecord::subject),
+      make_column("value", &BenchmarkHistoryRecord::value)),
+    pep::database::make_current_records_table<BenchmarkHistoryRecord>("CurrentBenchmarkHistoryRecords"),
+    pep::database::make_current_records_trigger<BenchmarkHistoryRecord>("trg_CurrentBenchmarkHistoryRecords"));
+}
+
+using BenchmarkHistoryStorage = pep::database::Storage<MakeBenchmarkHistoryStorage>;
+
+}
+
+// Lists the current values of 1000 subjects whose records have been changed (a total of) state.range(0) times,
+// like the access manager does when e.g. enumerating column groups.
+// Served from the current records table (state.range(1) == 1), the cost should depend on the number of subjects only,
+// while selecting the latest records from the full history (state.range(1) == 0) scales with the number of changes.
+static void BM_CurrentRecordsWithHistory(benchmark::State& state) {
+  constexpr int64_t subjectCount = 1'000;
+  BenchmarkHistoryStorage storage(pep::database::BasicStorage::StoreInMemory);
+  storage.syncSchema();
+  {
+    auto guard = storage.raw.transaction_guard();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      storage.raw.insert(BenchmarkHistoryRecord{
+        .timestamp = i,
+        .subject = i % subjectCount,
+        .value = std::to_string(i),
+      });
+    }
+    guard.commit();
+  }
+
+  const auto now = state.range(0);
+  for (auto _ : state) {
+    auto values = state.range(1) == 0
+      ? pep::RangeToVector(storage.getCurrentRecords(sqlite_orm::c(&BenchmarkHistoryRecord::timestamp) <= now, &BenchmarkHistoryRecord::value))
+      : storage.getCurrentRecordsAt(now, true, &BenchmarkHistoryRecord::value);
+    if (values.size() != static_cast<size_t>(std::min(subjectCount, state.range(0)))) {
+      state.SkipWithError("Unexpected number of current records");
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CurrentRecordsWithHistory)->ArgsProduct({ { 10'000, 100'000, 2'000'000 }, { 0, 1 } })->Unit(benchmark::kMillisecond);
+
+// Looks up a subject's current value while another thread continuously commits batches of changes through "raw",
+// like a read-heavy request handler contending with access manager mutations.
+// With the default (rollback) journal (state.range(0) == 0) reads use a second storage, waiting for every commit to finish,
+// while a WAL profile's read connection (state.range(0) == 1) lets reads proceed on the last committed state.
+static void BM_StorageReadsDuringWrites(benchmark::State& state) {
+  namespace fs = pep::filesystem;
+  using namespace sqlite_orm;
+  constexpr int64_t subjectCount = 1'000;
+  constexpr int batchSize = 100;
+
+  fs::Temporary temp{fs::temp_directory_path() / fs::RandomizedName("pepBenchmark-Storage-%%%%-%%%%-%%%%")};
+  fs::create_directory(temp.path());
+  auto path = (temp.path() / "storage.sqlite").string();
+  pep::database::StorageProfile profile;
+  if (state.range(0) != 0) {
+    profile.journalMode = "WAL";
+    profile.synchronous = "NORMAL";
+    profile.readConnections = 1;
+  }
+  BenchmarkHistoryStorage storage(path, profile);
+  storage.syncSchema();
+  std::optional<BenchmarkHistoryStorage> separate;
+  if (!storage.hasReadConnections()) {
+    separate.emplace(path, profile);
+  }
+
+  std::atomic<bool> stop = false;
+  std::thread writer([&] {
+    int64_t written = 0;
+    while (!stop) {
+      auto guard = storage.raw.transaction_guard();
+      for (int i = 0; i < batchSize; ++i, ++written) {
+        storage.raw.insert(BenchmarkHistoryRecord{
+          .timestamp = written,
+          .subject = written % subjectCount,
+          .value = std::to_string(written),
+        });
+      }
+      guard.commit();
+    }
+  });
+
+  int64_t subject = 0;
+  auto lookup = [&subject](auto& raw) {
+    return raw.select(&BenchmarkHistoryRecord::value,
+      where(c(&BenchmarkHistoryRecord::subject) == subject++ % subjectCount),
+      order_by(&BenchmarkHistoryRecord::seqno).desc(),
+      limit(1));
+  };
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(separate.has_value() ? lookup(separate->raw) : storage.read(lookup));
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  stop = true;
+  writer.join();
+}
+BENCHMARK(BM_StorageReadsDuringWrites)->Arg(0)->Arg(1)->UseRealTime();
+#endif
+
 static constexpr std::size_t NumRandomBytes{64}; // For CurveScalar::Random
 
 // Around 180 MiB/s on my laptop
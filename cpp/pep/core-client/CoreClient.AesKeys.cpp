@@ -4,10 +4,14 @@
 #include <pep/async/RxInstead.hpp>
 #include <pep/async/RxIterate.hpp>
 #include <pep/async/WaitGroup.hpp>
+#include <pep/elgamal/ElgamalEncryptionBatch.hpp>
 #include <pep/utils/OpenSSLHasher.hpp>
 
 #include <rxcpp/operators/rx-flat_map.hpp>
 
+#include <span>
+#include <vector>
+
 namespace pep {
 
 namespace {
@@ -105,11 +109,19 @@ CoreClient::unblindAndDecryptKeys(
     });
   }).flat_map([this](std::vector<EncryptedKey> encKeys){
     // Step two: we decrypt the retrieved keys.
-    return getWorkerPool()->batched_map<8>(std::move(encKeys),
+    return getWorkerPool()->chunked_map<8>(std::move(encKeys),
            ObserveOnAsio(*ioContext_),
-        [this](EncryptedKey encKey) {
-      auto point = encKey.decrypt(privateKeyData_);
-      return AESKey(point);
+        [this](std::span<EncryptedKey> encKeys) {
+      auto points = ElgamalEncryptionBatch(encKeys).decrypt(privateKeyData_);
+      std::vector<const CurvePoint*> toPack;
+      for (const auto& point : points)
+        toPack.push_back(&point);
+      CurvePoint::PackBatch(toPack); // for AESKey
+      std::vector<AESKey> keys;
+      keys.reserve(points.size());
+      for (const auto& point : points)
+        keys.emplace_back(point);
+      return keys;
     });
   });
 }
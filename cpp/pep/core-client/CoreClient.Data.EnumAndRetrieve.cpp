@@ -7,7 +7,7 @@
 #include <pep/storagefacility/DataPayloadPage.hpp>
 #include <pep/utils/Log.hpp>
 #include <pep/async/CreateObservable.hpp>
-#include <pep/async/RxBeforeCompletion.hpp>
+#include <pep/async/RxInstead.hpp>
 #include <pep/async/RxRequireCount.hpp>
 #include <pep/utils/Shared.hpp>
 
@@ -246,12 +246,15 @@ CoreClient::enumerateAndRetrieveData2(const EnumerateAndRetrieveData2Opts& opts)
                 .flat_map([](
                   rxcpp::observable<FakeVoid> job) { return job; }) // Retrieve AES keys and encrypted pages *concurrently* (because of *flat*_map)
                 .as_dynamic() // Reduce compiler memory usage
-                .op(RxBeforeCompletion(
-                  [ctx, enumResults]() { // When both AES key retrieval and encrypted page retrieval have been completed...
-                    assert(enumResults->size() == ctx->keys.size());
+                .op(RxInstead(FakeVoid())) // When both AES key retrieval and encrypted page retrieval have been completed...
+                .flat_map([this, ctx, enumResults](FakeVoid) {
+                  assert(enumResults->size() == ctx->keys.size());
 
-                    // Iterate over EnumerateResult entries that we've retrieved data for
-                    for (size_t i = 0U; i < enumResults->size(); ++i) {
+                  // ... decrypt the EnumerateResult entries that we've retrieved data for on the worker pool
+                  auto indices = RangeToVector(std::ranges::views::iota(size_t{}, enumResults->size()));
+                  return getWorkerPool()->batched_map<1>(std::move(indices),
+                    ObserveOnAsio(*ioContext_),
+                    [ctx, enumResults](size_t i) {
                       auto& enumResult = *(*enumResults)[i];
                       const auto& key = ctx->keys[i];
 
@@ -281,11 +284,16 @@ CoreClient::enumerateAndRetrieveData2(const EnumerateAndRetrieveData2Opts& opts)
                                 << res.fileSize << " bytes";
                         throw std::runtime_error(message.str());
                       }
-
-                      // Emit the item to the subscriber
-                      ctx->subscriber->on_next(std::move(res));
-                    }
-                  }));
+                      return res;
+                    })
+                    .map([ctx](std::vector<EnumerateAndRetrieveResult> results) {
+                      // Emit the items (in order) to the subscriber
+                      for (auto& res : results) {
+                        ctx->subscriber->on_next(std::move(res));
+                      }
+                      return FakeVoid();
+                    });
+                });
             });
         })
         .subscribe(
@@ -4,6 +4,7 @@
 #include <pep/async/RxFilterNullopt.hpp>
 #include <pep/async/RxIndexed.hpp>
 #include <pep/async/RxIterate.hpp>
+#include <pep/async/RxParallelConcat.hpp>
 #include <pep/async/RxToVector.hpp>
 #include <pep/ticketing/TicketingSerializers.hpp>
 #include <pep/storagefacility/DataPayloadPageStreamOrder.hpp>
@@ -13,6 +14,7 @@
 #include <rxcpp/operators/rx-concat.hpp>
 #include <rxcpp/operators/rx-flat_map.hpp>
 #include <rxcpp/operators/rx-group_by.hpp>
+#include <rxcpp/operators/rx-observe_on.hpp>
 #include <rxcpp/operators/rx-take.hpp>
 #include <rxcpp/operators/rx-zip.hpp>
 
@@ -22,6 +24,10 @@ namespace {
 
 const std::string LogTag("CoreClient.Data.Read");
 
+// Maximum number of pages that retrieveData() has the worker pool decrypt at once. Pages
+// decrypted ahead of the one being emitted are cached, so this also bounds that cache.
+constexpr size_t MaxPagesDecryptingInParallel = 16;
+
 template <typename TTicketItem, typename TSpecifiedItem>
 void FillHistoryRequestIndices(const SignedTicket2& ticket,
   std::optional<Ticket2>& unsignedTicket,
@@ -165,6 +171,11 @@ CoreClient::retrieveData(
               struct BatchContext {
                 DataPayloadPageStreamOrder order;
                 std::vector<FileContext> files;
+                decltype(DataPayloadPage::index) latestDecryptedFileIndex = 0;
+              };
+              struct DecryptedPage {
+                decltype(DataPayloadPage::index) index{};
+                std::string content;
               };
 
               auto ctx = std::make_shared<BatchContext>();
@@ -177,20 +188,37 @@ CoreClient::retrieveData(
                     .ids = RangeToVector(ctx->files
                         | views::transform([](const FileContext& file) { return file.fileKey.entry->id; })),
                   })
-                  .map([](DataPayloadPage page) {
+                  .map([this, ctx](DataPayloadPage page) -> rxcpp::observable<DecryptedPage> {
+                    if (page.index >= ctx->files.size()) {
+                      throw std::runtime_error(std::format("Received out-of-bounds file index: {} >= {}",
+                          page.index, ctx->files.size()));
+                    }
+                    ctx->order.check(page);
+
+                    // Decrypt on the worker pool, so that we don't hold up network IO
+                    const FileKey& fileKey = ctx->files[page.index].fileKey;
+                    return rxcpp::observable<>::just(std::move(page))
+                        .observe_on(getWorkerPool()->worker())
+                        .map([entry = fileKey.entry, key = fileKey.symmetricKey](const DataPayloadPage& page) {
+                          return DecryptedPage{
+                            .index = page.index,
+                            .content = page.decrypt(key, entry->metadata),
+                          };
+                        })
+                        .observe_on(ObserveOnAsio(*ioContext_));
+                  })
+                  // Decrypt multiple pages in parallel, but process them in order
+                  .op(RxParallelConcat(MaxPagesDecryptingInParallel))
+                  .map([](DecryptedPage page) {
                     return std::optional{std::move(page)};
                   })
                   // Add nullopt sentinel to make sure we check if all files have been fully retrieved
-                  .concat(rxcpp::observable<>::just(std::optional<DataPayloadPage>()))
-                  .map([ctx](const std::optional<DataPayloadPage>& page) -> std::optional<RetrievePage> {
+                  .concat(rxcpp::observable<>::just(std::optional<DecryptedPage>()))
+                  .map([ctx](std::optional<DecryptedPage> page) -> std::optional<RetrievePage> {
                     const auto index = page ? page->index : ctx->files.size();
-                    if (page && index >= ctx->files.size()) {
-                      throw std::runtime_error(std::format("Received out-of-bounds file index: {} >= {}",
-                          index, ctx->files.size()));
-                    }
 
                     // Check previous file(s)
-                    for (auto betweenIdx = ctx->order.latestFileIndex(); betweenIdx < index; ++betweenIdx) {
+                    for (auto betweenIdx = ctx->latestDecryptedFileIndex; betweenIdx < index; ++betweenIdx) {
                       const FileContext& prevFileCtx = ctx->files[betweenIdx];
                       const EnumerateResult& prevEntry = *prevFileCtx.fileKey.entry;
                       if (prevFileCtx.bytesWritten < prevEntry.fileSize) {
@@ -201,15 +229,14 @@ CoreClient::retrieveData(
                     }
                     // Return when we received the sentinel: we just wanted to check remaining files
                     if (!page) { return {}; }
-
-                    ctx->order.check(*page);
+                    ctx->latestDecryptedFileIndex = index;
 
                     FileContext& file = ctx->files[index];
                     const EnumerateResult& entry = *file.fileKey.entry;
                     RetrievePage retrievedPage{
                       .fileIndex = file.fileKey.fileIndex,
                       .entry = file.fileKey.entry,
-                      .content = page->decrypt(file.fileKey.symmetricKey, entry.metadata),
+                      .content = std::move(page->content),
                     };
                     // Omit empty pages
                     if (retrievedPage.content.empty()) { return {}; }
@@ -5,11 +5,7 @@
 #include <string>
 #include <boost/noncopyable.hpp>
 
-namespace pep {
-
-struct TranscryptorStorageBackend;
-
-namespace transcryptor {
+namespace pep::database {
 
 /// \brief Base class for checksum chain calculations (which derived classes implement in their their "calculate" methods).
 /// \remark Caches the last calculated result, allowing it to be
@@ -33,7 +29,8 @@ private:
 protected:
   explicit ChecksumChain(std::string name) noexcept : name_(std::move(name)) {}
 
-  virtual Result calculate(std::shared_ptr<TranscryptorStorageBackend> storage, const Result& partial, uint64_t maxCheckpoint) const = 0;
+  /// \brief Extends the "partial" result with the records at checkpoints after partial.checkpoint, up to (and including) "maxCheckpoint".
+  virtual Result calculate(const Result& partial, uint64_t maxCheckpoint) const = 0;
 
   static uint64_t SeqNoToCheckpoint(int64_t seqNo) noexcept;
   static int64_t CheckpointToSeqNo(uint64_t checkpoint) noexcept;
@@ -45,9 +42,7 @@ public:
 
   /// \brief Returns the checksum chain's value at the highest available checkpoint not exceeding the specified one
   /// \remark Caches the last computed result to prevent excessive (re-)calculation.
-  Result get(std::shared_ptr<TranscryptorStorageBackend> storage, uint64_t maxCheckpoint);
+  Result get(uint64_t maxCheckpoint);
 };
 
-
-} // End namespace transcryptor
-} // End namespace pep
+}
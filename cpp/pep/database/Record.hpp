@@ -33,4 +33,11 @@ concept Record = requires(T rec) {
 /// Timestamp as milliseconds since Unix epoch, used for in database
 using UnixMillis = std::int64_t;
 
+/// \brief Row of a Record type's "current records" table, which lists the latest record for every RecordIdentifier.
+/// \remark Add such a table to a database::Storage<> using make_current_records_table and make_current_records_trigger.
+template <Record RecordType>
+struct CurrentRecord {
+  std::int64_t seqno{};
+};
+
 }
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <pep/database/ChecksumChain.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+
+#include <sqlite_orm/sqlite_orm.h>
+
+namespace pep::database {
+
+/// \brief Checksum chain over the records of a single (append-only) table, using the records' "seqno" as checkpoint source.
+/// \tparam TStorage A database::Storage<> type containing a table for TRecord
+/// \tparam TRecord A record type with an (autoincremented) "seqno" field
+/// \remark Records must never be changed or removed once they've been included in a (cached) result.
+template <typename TStorage, typename TRecord>
+class RecordChecksumChain : public ChecksumChain {
+public:
+  using RecordChecksum = std::function<uint64_t(const TRecord&)>;
+
+private:
+  std::shared_ptr<TStorage> storage_;
+  RecordChecksum recordChecksum_;
+
+protected:
+  Result calculate(const Result& partial, uint64_t maxCheckpoint) const override {
+    using namespace sqlite_orm;
+
+    assert(partial.checkpoint < maxCheckpoint);
+    auto result = partial;
+
+    int64_t minSeqNo = -1; // The full chain includes all sequence numbers (0 or higher, i.e. greater than -1)
+    if (partial.checkpoint != EmptyTableCheckpoint) { // If we have a (previously calculated) partial result...
+      assert(partial.checkpoint > EmptyTableCheckpoint);
+      minSeqNo = CheckpointToSeqNo(partial.checkpoint); // ... only process records (with sequence numbers) that aren't included in the partial result yet
+    }
+
+    for (const auto& record : storage_->raw.template iterate<TRecord>(
+      where(c(&TRecord::seqno) > minSeqNo // Only process entries that aren't included in the "partial" result yet
+        && c(&TRecord::seqno) <= CheckpointToSeqNo(maxCheckpoint)))) { // Only process entries up to (and including) the specified "maxCheckpoint"
+
+      // Keep track of the highest checkpoint encountered: we're iterating/processing in arbitrary order
+      result.checkpoint = std::max(result.checkpoint, SeqNoToCheckpoint(record.seqno));
+      result.checksum ^= recordChecksum_(record);
+    }
+
+    return result;
+  }
+
+public:
+  RecordChecksumChain(std::string name, std::shared_ptr<TStorage> storage,
+    RecordChecksum recordChecksum = [](const TRecord& record) { return record.checksum(); })
+    : ChecksumChain(std::move(name)), storage_(std::move(storage)), recordChecksum_(std::move(recordChecksum)) {
+  }
+};
+
+}
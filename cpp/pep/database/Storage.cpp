@@ -1,8 +1,26 @@
 #include <pep/database/Storage.hpp>
 
+#include <pep/utils/Defer.hpp>
+
 #include <format>
+#include <functional>
 
 namespace {
+using RowCallback = std::function<void(int columns, char** values)>;
+
+void Execute(sqlite3* connection, const std::string& sql, RowCallback onRow = [](int, char**) {}) {
+  char* error = nullptr;
+  auto result = sqlite3_exec(connection, sql.c_str(), [](void* callback, int columns, char** values, char**) {
+    (*static_cast<RowCallback*>(callback))(columns, values);
+    return 0;
+  }, &onRow, &error);
+  if (result != SQLITE_OK) {
+    std::string message = error != nullptr ? error : sqlite3_errstr(result);
+    sqlite3_free(error);
+    throw std::runtime_error(std::format("Could not execute \"{}\": {}", sql, message));
+  }
+}
+
 std::string GenerateSchemaErrorMessage(std::string_view table, pep::database::SchemaError::Reason reason) {
   using namespace pep::database;
   switch (reason) {
@@ -22,8 +40,37 @@ SchemaError::SchemaError(std::string table, Reason reason)
 
 const char* const BasicStorage::StoreInMemory = ":memory:";
 
-BasicStorage::BasicStorage(const std::string& path)
-  : isPersistent(path != StoreInMemory) {
+BasicStorage::BasicStorage(const std::string& path, StorageProfile profile)
+  : isPersistent(path != StoreInMemory), path_(path), profile_(std::move(profile)) {
+}
+
+void BasicStorage::applyProfile(sqlite3* connection, bool readOnly) const {
+  for (const auto& pragma : profile_.getPragmas(readOnly)) {
+    Execute(connection, pragma);
+  }
+}
+
+void BasicStorage::checkpoint() const {
+  if (!isPersistent) {
+    return;
+  }
+
+  sqlite3* connection = nullptr;
+  auto opened = sqlite3_open_v2(path_.c_str(), &connection, SQLITE_OPEN_READWRITE, nullptr);
+  PEP_DEFER(sqlite3_close(connection)); // Also required if opening failed
+  if (opened != SQLITE_OK) {
+    throw std::runtime_error(std::format("Could not open {} for checkpointing: {}", path_, sqlite3_errmsg(connection)));
+  }
+  sqlite3_busy_timeout(connection, static_cast<int>(profile_.busyTimeout.count()));
+
+  // The first result column is nonzero if the checkpoint was blocked: https://www.sqlite.org/pragma.html#pragma_wal_checkpoint
+  bool blocked = false;
+  Execute(connection, "PRAGMA wal_checkpoint(TRUNCATE)", [&blocked](int, char** values) {
+    blocked = values[0] != nullptr && std::string_view(values[0]) != "0";
+  });
+  if (blocked) {
+    throw std::runtime_error("Could not complete checkpoint for " + path_);
+  }
 }
 
 }
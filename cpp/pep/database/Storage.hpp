@@ -1,9 +1,19 @@
 #pragma once
 
 #include <pep/database/Record.hpp>
+#include <pep/database/StorageProfile.hpp>
+#include <pep/utils/CollectionUtils.hpp>
 #include <pep/utils/Log.hpp>
 #include <pep/utils/MiscUtil.hpp>
 
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <vector>
+
 #include <sqlite_orm/sqlite_orm.h>
 
 namespace pep::database {
@@ -27,6 +37,54 @@ struct having {
   T expr_;
 };
 
+namespace detail {
+
+template <typename T>
+inline constexpr bool IsNullable = false;
+template <typename T>
+inline constexpr bool IsNullable<std::optional<T>> = true;
+
+} // End namespace detail
+
+/// \brief Defines the table listing the current records of the specified Record type: see CurrentRecord<>.
+/// \remark Pass the result to sqlite_orm::make_storage, together with the make_current_records_trigger that keeps the table up to date.
+/// \remark Defined with a (fully) lowercase name so it matches other sqlite_orm constructs
+template <Record RecordType>
+auto make_current_records_table(std::string name) {
+  using namespace sqlite_orm;
+  return make_table(std::move(name),
+    make_column("seqno", &CurrentRecord<RecordType>::seqno, primary_key()));
+}
+
+/// \brief Defines a trigger that updates the make_current_records_table for the specified Record type whenever a record is inserted,
+/// i.e. as part of the same transaction.
+/// \remark The trigger looks up the previous record with the same RecordIdentifier: an index on the RecordIdentifier columns keeps that cheap.
+/// \remark Defined with a (fully) lowercase name so it matches other sqlite_orm constructs
+template <Record RecordType>
+auto make_current_records_trigger(std::string name) {
+  using namespace sqlite_orm;
+  using Current = CurrentRecord<RecordType>;
+  auto sameAsNew = []<typename T>(T RecordType::* id) {
+    if constexpr (detail::IsNullable<T>) { // NULL values are considered equal, as they are in the GROUP BY clauses of getCurrentRecords
+      return c(id) == new_(id) || (is_null(id) && is_null(new_(id)));
+    }
+    else {
+      return c(id) == new_(id);
+    }
+  };
+  auto sameIdentifierAsNew = std::apply([&sameAsNew](auto... ids) { return (sameAsNew(ids) && ...); }, RecordType::RecordIdentifier);
+  return make_trigger(std::move(name),
+    after()
+      .insert()
+      .on<RecordType>()
+      .begin(
+        // The new record supersedes the (previously) current one with the same RecordIdentifier, i.e. the latest one before it
+        remove_all<Current>(where(in(&Current::seqno, select(max(&RecordType::seqno),
+          where(sameIdentifierAsNew && c(&RecordType::seqno) < new_(&RecordType::seqno)))))),
+        insert(into<Current>(), columns(&Current::seqno), values(std::make_tuple(new_(&RecordType::seqno)))))
+      .end());
+}
+
 /// Non-template base class for Storage<> (defined below).
 struct BasicStorage {
   /// Whether the storage is stored on a persistent medium (TRUE) or in memory (FALSE)
@@ -35,9 +93,19 @@ struct BasicStorage {
   /// Specify this as the "path" to construct a Storage<> that's non-persistent, i.e. backed by memory
   static const char* const StoreInMemory;
 
+  /// \brief Moves the contents of the write-ahead log (if any) into the database file, e.g. so that the file can be copied by itself.
+  /// \throws std::runtime_error if the checkpoint could not be completed, e.g. because other connections kept reading.
+  void checkpoint() const;
+
 private:
   template <auto MakeRaw> friend struct Storage;
-  explicit BasicStorage(const std::string& path);
+  BasicStorage(const std::string& path, StorageProfile profile);
+
+  /// Executes the profile's pragmas on a newly opened connection
+  void applyProfile(sqlite3* connection, bool readOnly) const;
+
+  std::string path_;
+  StorageProfile profile_;
 };
 
 /// \brief Helper for storage using sqlite-orm.
@@ -69,8 +137,65 @@ struct Storage : public BasicStorage {
 
   /// \brief Constructor
   /// \param path The path to the sqlite database file. Pass StoreInMemory to initialize non-persistent storage.
-  explicit Storage(std::string path)
-    : BasicStorage(path), raw(MakeRaw(std::move(path))) {}
+  /// \param profile The connection settings to apply. Only applied to persistent storage, which then keeps its connection(s) open.
+  explicit Storage(std::string path, StorageProfile profile = {})
+    : BasicStorage(path, std::move(profile)), raw(MakeRaw(path)) {
+    if (isPersistent) {
+      raw.on_open = [this](sqlite3* connection) { applyProfile(connection, false); };
+      raw.open_forever();
+
+      for (unsigned i = 0; i < profile_.readConnections; ++i) {
+        // Constructed in place from the MakeRaw prvalue, i.e. without copying the sqlite_orm storage
+        auto& reader = readers_.emplace_back(new Raw(MakeRaw(path)));
+        reader->on_open = [this](sqlite3* connection) { applyProfile(connection, true); };
+        reader->open_forever();
+        idleReaders_.push_back(reader.get());
+      }
+    }
+  }
+
+  Storage(const Storage&) = delete;
+  Storage& operator=(const Storage&) = delete;
+
+  /// \brief Whether read() hands out connections of its own, i.e. whether it may be invoked concurrently with (other) use of "raw".
+  [[nodiscard]] bool hasReadConnections() const noexcept { return !readers_.empty(); }
+
+  /// \brief Invokes the callback with a read-only connection (of type Raw&) that no other thread is using, waiting for one to become available if needed.
+  ///        Query helpers such as getCurrentRecords(), invoked by the callback on the calling thread, use the same connection.
+  /// \remark Allows concurrent reads from multiple threads, which also proceed while "raw" is writing (since the profile requires WAL journalMode).
+  ///         The callback's reads share a single transaction, so they all see the data that was committed before the first one.
+  /// \remark Without read connections, i.e. for non-persistent storage or a profile specifying none, the callback receives "raw" itself.
+  ///         Callers must then prevent concurrent use of the storage: see hasReadConnections().
+  /// \remark Lazily evaluated results (e.g. from raw.iterate or getCurrentRecords) must be consumed before the callback returns.
+  template <typename TCallback>
+  decltype(auto) read(TCallback&& callback) {
+    if (readers_.empty() || threadReader_.storage == this) { // No pool, or nested invocation that can keep using the thread's reader
+      return std::invoke(std::forward<TCallback>(callback), connection());
+    }
+
+    Raw* reader;
+    {
+      std::unique_lock lock(readersMutex_);
+      readerAvailable_.wait(lock, [this] { return !idleReaders_.empty(); });
+      reader = idleReaders_.back();
+      idleReaders_.pop_back();
+    }
+    struct Release {
+      Storage& storage;
+      ThreadReader previous;
+      ~Release() {
+        {
+          std::lock_guard lock(storage.readersMutex_);
+          storage.idleReaders_.push_back(threadReader_.reader);
+        }
+        threadReader_ = previous;
+        storage.readerAvailable_.notify_one();
+      }
+    } release{ *this, threadReader_ };
+    threadReader_ = { this, reader };
+    auto transaction = reader->transaction_guard(); // Rolled back (i.e. ended) when we're done: there's nothing to commit
+    return std::invoke(std::forward<TCallback>(callback), *reader);
+  }
 
   /// \brief Sync the database schema if that causes no data loss. Throws an error otherwise.
   /// \param allow_old_column_removal Whether removal of old columns is allowed. When set to true, columns that are in the database, but not in the `make_storage` call, will be removed. If set to false, this will produce an error
@@ -177,6 +302,57 @@ struct Storage : public BasicStorage {
   ///   (or single values if a single column was specified)
   template <Record RecordType, typename... ColTypes>
   [[nodiscard]] auto getCurrentRecords(auto whereCondition, ColTypes RecordType::*... selectColumns);
+
+  /* Methods for Record types with a make_current_records_table (and make_current_records_trigger) */
+
+  /// \brief (Re)fills the make_current_records_table from the full record history.
+  /// \remark Invoke after syncSchema(), since records may have been inserted when the table (or its trigger) didn't exist yet.
+  template <Record RecordType>
+  void rebuildCurrentRecords();
+
+  /// \brief Whether the make_current_records_table reflects the state at the specified moment, i.e. whether no records have been created since.
+  /// \remark Assumes that records are inserted with (non-decreasing) creation timestamps.
+  template <Record RecordType>
+  [[nodiscard]] bool isCurrentAt(UnixMillis at);
+
+  /// \brief Like currentRecordExists, for the state at the specified moment.
+  /// \remark Served from the make_current_records_table if it reflects the state at that moment, and from the record history otherwise.
+  ///          The results only match currentRecordExists if the whereCondition refers to RecordIdentifier columns only:
+  ///          use the havingCondition to filter on other columns.
+  template <Record RecordType, typename havingT = bool>
+  [[nodiscard]] bool currentRecordExistsAt(UnixMillis at, auto whereCondition, having<havingT> havingCondition = having(true));
+
+  /// \brief Like getCurrentRecords, for the state at the specified moment.
+  /// \remark Served from the make_current_records_table if it reflects the state at that moment, and from the record history otherwise.
+  ///          The results only match getCurrentRecords if the whereCondition refers to RecordIdentifier columns only:
+  ///          use the havingCondition to filter on other columns.
+  /// \returns Vector of tuples with columns from \p selectColumns
+  ///   (or single values if a single column was specified)
+  template <Record RecordType, typename havingT, typename... ColTypes>
+  [[nodiscard]] auto getCurrentRecordsAt(UnixMillis at, auto whereCondition, having<havingT> havingCondition, ColTypes RecordType::*... selectColumns);
+
+  /// \brief Like getCurrentRecords, for the state at the specified moment.
+  /// \remark See the overload accepting a havingCondition.
+  template <Record RecordType, typename... ColTypes>
+  [[nodiscard]] auto getCurrentRecordsAt(UnixMillis at, auto whereCondition, ColTypes RecordType::*... selectColumns);
+
+private:
+  /// The read connection that read() handed to the current thread, if any
+  struct ThreadReader {
+    const Storage* storage = nullptr;
+    Raw* reader = nullptr;
+  };
+  static inline thread_local ThreadReader threadReader_;
+
+  /// The connection for query helpers to use: the thread's read connection inside read(), or "raw" otherwise
+  Raw& connection() {
+    return threadReader_.storage == this ? *threadReader_.reader : raw;
+  }
+
+  std::vector<std::unique_ptr<Raw>> readers_;
+  std::vector<Raw*> idleReaders_;
+  std::mutex readersMutex_;
+  std::condition_variable readerAvailable_;
 };
 
 template <auto MakeRaw> template <Record RecordType>
@@ -187,7 +363,7 @@ template <auto MakeRaw> template <Record RecordType>
 template <auto MakeRaw> template <Record RecordType, typename havingT>
 [[nodiscard]] bool Storage<MakeRaw>::currentRecordExists(auto whereCondition, having<havingT> havingCondition) {
   using namespace sqlite_orm;
-  auto result = raw.iterate(select(
+  auto result = connection().iterate(select(
     columns(max(&RecordType::seqno)),
     where(std::move(whereCondition)),
     std::apply(PEP_WRAP_FN(group_by), RecordType::RecordIdentifier)
@@ -203,7 +379,7 @@ template <auto MakeRaw> template <Record RecordType, typename havingT, typename.
 [[nodiscard]] auto Storage<MakeRaw>::getCurrentRecords(auto whereCondition, having<havingT> havingCondition, ColTypes RecordType::*... selectColumns) {
   static_assert(sizeof...(ColTypes) > 0, "No columns specified");
   using namespace sqlite_orm;
-  return raw.iterate(select(
+  return connection().iterate(select(
     // SQLite will pick these columns from the row with the max() value:
     // https://www.sqlite.org/lang_select.html#bareagg
     columns(max(&RecordType::seqno), selectColumns...),
@@ -217,7 +393,7 @@ template <auto MakeRaw> template <Record RecordType, typename... ColTypes>
 [[nodiscard]] auto Storage<MakeRaw>::getCurrentRecords(auto whereCondition, ColTypes RecordType::*... selectColumns) {
   static_assert(sizeof...(ColTypes) > 0, "No columns specified");
   using namespace sqlite_orm;
-  return raw.iterate(select(
+  return connection().iterate(select(
     // SQLite will pick these columns from the row with the max() value:
     // https://www.sqlite.org/lang_select.html#bareagg
     columns(max(&RecordType::seqno), selectColumns...),
@@ -228,4 +404,64 @@ template <auto MakeRaw> template <Record RecordType, typename... ColTypes>
 
 }
 
+template <auto MakeRaw> template <Record RecordType>
+void Storage<MakeRaw>::rebuildCurrentRecords() {
+  using namespace sqlite_orm;
+  using Current = CurrentRecord<RecordType>;
+  auto guard = raw.transaction_guard();
+  raw.template remove_all<Current>();
+  for (const auto& seqno : raw.select(
+    max(&RecordType::seqno),
+    std::apply(PEP_WRAP_FN(group_by), RecordType::RecordIdentifier))) {
+    raw.replace(Current{ .seqno = *seqno });
+  }
+  guard.commit();
+}
+
+template <auto MakeRaw> template <Record RecordType>
+[[nodiscard]] bool Storage<MakeRaw>::isCurrentAt(UnixMillis at) {
+  using namespace sqlite_orm;
+  // Records are created with the current time, so the latest one (by seqno) has the highest timestamp
+  auto latest = connection().select(&RecordType::timestamp, order_by(&RecordType::seqno).desc(), limit(1));
+  return latest.empty() || latest.front() <= at;
+}
+
+template <auto MakeRaw> template <Record RecordType, typename havingT>
+[[nodiscard]] bool Storage<MakeRaw>::currentRecordExistsAt(UnixMillis at, auto whereCondition, having<havingT> havingCondition) {
+  using namespace sqlite_orm;
+  if (!isCurrentAt<RecordType>(at)) {
+    return currentRecordExists<RecordType>(c(&RecordType::timestamp) <= at && std::move(whereCondition), std::move(havingCondition));
+  }
+  auto result = connection().iterate(select(
+    columns(&RecordType::seqno),
+    where(in(&RecordType::seqno, select(&CurrentRecord<RecordType>::seqno))
+      && c(&RecordType::tombstone) == false
+      && std::move(whereCondition)
+      && std::move(havingCondition.expr_)),
+    limit(1)
+  ));
+  return result.begin() != result.end();
+}
+
+template <auto MakeRaw> template <Record RecordType, typename havingT, typename... ColTypes>
+[[nodiscard]] auto Storage<MakeRaw>::getCurrentRecordsAt(UnixMillis at, auto whereCondition, having<havingT> havingCondition, ColTypes RecordType::*... selectColumns) {
+  static_assert(sizeof...(ColTypes) > 0, "No columns specified");
+  using namespace sqlite_orm;
+  if (!isCurrentAt<RecordType>(at)) {
+    return RangeToVector(getCurrentRecords<RecordType>(c(&RecordType::timestamp) <= at && std::move(whereCondition), std::move(havingCondition), selectColumns...));
+  }
+  return RangeToVector(connection().iterate(select(
+    columns(selectColumns...),
+    where(in(&RecordType::seqno, select(&CurrentRecord<RecordType>::seqno))
+      && c(&RecordType::tombstone) == false
+      && std::move(whereCondition)
+      && std::move(havingCondition.expr_))
+  )) | std::views::transform([](auto tuple) { return TryUnwrapTuple(std::move(tuple)); }));
+}
+
+template <auto MakeRaw> template <Record RecordType, typename... ColTypes>
+[[nodiscard]] auto Storage<MakeRaw>::getCurrentRecordsAt(UnixMillis at, auto whereCondition, ColTypes RecordType::*... selectColumns) {
+  return getCurrentRecordsAt<RecordType>(at, std::move(whereCondition), having(true), selectColumns...);
+}
+
 }
@@ -0,0 +1,33 @@
+#include <pep/database/StorageProfile.PropertySerializer.hpp>
+
+namespace pep {
+
+void PropertySerializer<database::StorageProfile>::write(boost::property_tree::ptree& destination, const database::StorageProfile& value) const {
+  SerializeProperties(destination, "JournalMode", value.journalMode);
+  SerializeProperties(destination, "Synchronous", value.synchronous);
+  SerializeProperties(destination, "CacheSize", value.cacheSize);
+  SerializeProperties(destination, "MmapSize", value.mmapSize);
+  SerializeProperties(destination, "BusyTimeoutMs", value.busyTimeout.count());
+  SerializeProperties(destination, "ReadConnections", value.readConnections);
+}
+
+database::StorageProfile PropertySerializer<database::StorageProfile>::read(const boost::property_tree::ptree& source, const DeserializationContext& context) const {
+  database::StorageProfile result;
+  if (auto journalMode = DeserializeProperties<std::optional<std::string>>(source, "JournalMode", context)) {
+    result.journalMode = std::move(*journalMode);
+  }
+  if (auto synchronous = DeserializeProperties<std::optional<std::string>>(source, "Synchronous", context)) {
+    result.synchronous = std::move(*synchronous);
+  }
+  result.cacheSize = DeserializeProperties<std::optional<int64_t>>(source, "CacheSize", context).value_or(result.cacheSize);
+  result.mmapSize = DeserializeProperties<std::optional<int64_t>>(source, "MmapSize", context).value_or(result.mmapSize);
+  if (auto busyTimeout = DeserializeProperties<std::optional<int64_t>>(source, "BusyTimeoutMs", context)) {
+    result.busyTimeout = std::chrono::milliseconds(*busyTimeout);
+  }
+  result.readConnections = DeserializeProperties<std::optional<unsigned>>(source, "ReadConnections", context).value_or(result.readConnections);
+
+  result.getPragmas(false); // Throws if values are invalid
+  return result;
+}
+
+}
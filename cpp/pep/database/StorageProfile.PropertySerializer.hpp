@@ -0,0 +1,16 @@
+#pragma once
+
+#include <pep/database/StorageProfile.hpp>
+#include <pep/utils/PropertySerializer.hpp>
+
+namespace pep {
+
+/// \remark Properties that aren't specified keep their StorageProfile default value.
+template <>
+class PropertySerializer<database::StorageProfile> : public PropertySerializerByValue<database::StorageProfile> {
+public:
+  void write(boost::property_tree::ptree& destination, const database::StorageProfile& value) const override;
+  database::StorageProfile read(const boost::property_tree::ptree& source, const DeserializationContext& context) const override;
+};
+
+}
@@ -0,0 +1,47 @@
+#include <pep/database/StorageProfile.hpp>
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string_view>
+
+namespace pep::database {
+
+namespace {
+
+// Values are pasted into SQL statements, so we only accept known ones
+template <size_t N>
+const std::string& Validate(const std::string& value, const std::array<std::string_view, N>& supported, std::string_view pragma) {
+  if (std::ranges::find(supported, value) == supported.end()) {
+    throw std::invalid_argument("Unsupported " + std::string(pragma) + " value: " + value);
+  }
+  return value;
+}
+
+constexpr std::array<std::string_view, 6> JournalModes{ "DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF" };
+constexpr std::array<std::string_view, 4> SynchronousLevels{ "OFF", "NORMAL", "FULL", "EXTRA" };
+
+}
+
+std::vector<std::string> StorageProfile::getPragmas(bool readOnly) const {
+  Validate(journalMode, JournalModes, "journal_mode");
+  if (readConnections != 0 && journalMode != "WAL") {
+    throw std::invalid_argument("Read connections require WAL journal_mode instead of " + journalMode);
+  }
+
+  std::vector<std::string> result;
+  // Set the busy timeout first so that subsequent statements wait for (instead of fail on) locks held by other connections
+  result.push_back("PRAGMA busy_timeout = " + std::to_string(busyTimeout.count()));
+  if (!readOnly) { // The journal mode is a property of the database (file), which the writing connection sets
+    result.push_back("PRAGMA journal_mode = " + journalMode);
+  }
+  result.push_back("PRAGMA synchronous = " + Validate(synchronous, SynchronousLevels, "synchronous"));
+  result.push_back("PRAGMA cache_size = " + std::to_string(cacheSize));
+  result.push_back("PRAGMA mmap_size = " + std::to_string(mmapSize));
+  if (readOnly) {
+    result.push_back("PRAGMA query_only = ON");
+  }
+  return result;
+}
+
+}
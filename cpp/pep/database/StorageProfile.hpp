@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pep::database {
+
+/// \brief Connection settings for (persistent) SQLite storage, applied whenever a Storage<> opens a connection.
+/// \remark Defaults match SQLite's own (durable) behavior. Deployments can opt in to e.g. write-ahead logging
+///         ("WAL" journal mode) with "NORMAL" synchronization, which lets readers proceed while a writer commits
+///         but may lose the last transaction(s) upon power loss.
+struct StorageProfile {
+  /// Value for "PRAGMA journal_mode": one of DELETE, TRUNCATE, PERSIST, MEMORY, WAL or OFF
+  std::string journalMode = "DELETE";
+  /// Value for "PRAGMA synchronous": one of OFF, NORMAL, FULL or EXTRA
+  std::string synchronous = "FULL";
+  /// Value for "PRAGMA cache_size": a number of pages if positive, or a number of KiB if negative
+  int64_t cacheSize = -2000;
+  /// Value for "PRAGMA mmap_size": the number of database bytes that SQLite may memory-map. Zero disables memory mapping.
+  int64_t mmapSize = 0;
+  /// How long a connection waits for locks held by other connections before failing with SQLITE_BUSY
+  std::chrono::milliseconds busyTimeout = std::chrono::seconds(5);
+  /// \brief Number of additional (query_only) connections that Storage<>::read() hands out, e.g. to worker threads.
+  /// \remark Requires WAL journalMode: other journal modes block readers while a writer commits.
+  unsigned readConnections = 0;
+
+  /// \brief Produces the SQL statements that apply this profile to a newly opened connection.
+  /// \param readOnly Whether the connection is one of the readConnections
+  /// \throws std::invalid_argument if the journalMode or synchronous value is not supported, or if readConnections are requested without WAL
+  std::vector<std::string> getPragmas(bool readOnly) const;
+};
+
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <sqlite_orm/sqlite_orm.h>
+#include <pep/database/RecordChecksumChain.hpp>
+#include <pep/database/Storage.hpp>
+
+#include <limits>
+
+namespace {
+using namespace sqlite_orm;
+
+struct ChecksummedRecord {
+  int64_t seqno{};
+  int64_t value{};
+
+  uint64_t checksum() const { return static_cast<uint64_t>(value); }
+};
+
+auto MakeChecksummedStorage(const std::string& path) {
+  return make_storage(path,
+    make_table("Checksummed",
+      make_column("seqno", &ChecksummedRecord::seqno, primary_key().autoincrement()),
+      make_column("value", &ChecksummedRecord::value)));
+}
+
+using ChecksummedStorage = pep::database::Storage<MakeChecksummedStorage>;
+using Chain = pep::database::RecordChecksumChain<ChecksummedStorage, ChecksummedRecord>;
+
+constexpr uint64_t Latest = std::numeric_limits<int64_t>::max();
+
+class ChecksumChainTest : public ::testing::Test {
+protected:
+  std::shared_ptr<ChecksummedStorage> storage = std::make_shared<ChecksummedStorage>(pep::database::BasicStorage::StoreInMemory);
+  size_t processed = 0;
+  Chain chain{ "checksummed", storage, [this](const ChecksummedRecord& record) {
+    ++processed;
+    return record.checksum();
+  } };
+
+  void SetUp() override {
+    storage->syncSchema();
+  }
+
+  uint64_t insert(int64_t value) {
+    auto seqno = storage->raw.insert(ChecksummedRecord{ .value = value });
+    return static_cast<uint64_t>(seqno) + 2U; // The record's checkpoint
+  }
+};
+
+TEST_F(ChecksumChainTest, empty_table_produces_initial_checkpoint) {
+  auto result = chain.get(Latest);
+  EXPECT_EQ(result.checksum, 0U);
+  EXPECT_EQ(result.checkpoint, 1U);
+}
+
+TEST_F(ChecksumChainTest, only_processes_records_after_cached_checkpoint) {
+  auto first = insert(1);
+  insert(2);
+  auto third = insert(4);
+
+  auto result = chain.get(Latest);
+  EXPECT_EQ(result.checksum, 7U);
+  EXPECT_EQ(result.checkpoint, third);
+  EXPECT_EQ(processed, 3U);
+
+  // Re-requesting the same checkpoint is served from the cache
+  result = chain.get(third);
+  EXPECT_EQ(result.checksum, 7U);
+  EXPECT_EQ(processed, 3U);
+
+  auto fourth = insert(8);
+  result = chain.get(Latest);
+  EXPECT_EQ(result.checksum, 15U);
+  EXPECT_EQ(result.checkpoint, fourth);
+  EXPECT_EQ(processed, 4U);
+
+  // Requesting an earlier checkpoint discards the cache
+  result = chain.get(first);
+  EXPECT_EQ(result.checksum, 1U);
+  EXPECT_EQ(result.checkpoint, first);
+  EXPECT_EQ(processed, 5U);
+}
+
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <sqlite_orm/sqlite_orm.h>
+#include <pep/database/Storage.hpp>
+#include <pep/utils/Filesystem.hpp>
+
+#include <optional>
+#include <set>
+
+namespace {
+using namespace sqlite_orm;
+using pep::database::CurrentRecord;
+using pep::database::having;
+
+struct SettingRecord {
+  int64_t seqno{};
+  int64_t timestamp{};
+  bool tombstone{};
+  std::string name;
+  std::optional<int64_t> scope;
+  std::string value;
+
+  static inline const std::tuple RecordIdentifier{
+    &SettingRecord::name,
+    &SettingRecord::scope,
+  };
+};
+
+auto MakeSettingsStorage(const std::string& path) {
+  return make_storage(path,
+    make_table("Settings",
+      make_column("seqno", &SettingRecord::seqno, primary_key().autoincrement()),
+      make_column("timestamp", &SettingRecord::timestamp),
+      make_column("tombstone", &SettingRecord::tombstone),
+      make_column("name", &SettingRecord::name),
+      make_column("scope", &SettingRecord::scope),
+      make_column("value", &SettingRecord::value)),
+    pep::database::make_current_records_table<SettingRecord>("CurrentSettings"),
+    pep::database::make_current_records_trigger<SettingRecord>("trg_CurrentSettings"));
+}
+
+using SettingsStorage = pep::database::Storage<MakeSettingsStorage>;
+
+class CurrentRecordsTest : public ::testing::Test {
+protected:
+  SettingsStorage storage{ pep::database::BasicStorage::StoreInMemory };
+
+  void SetUp() override {
+    storage.syncSchema();
+  }
+
+  void insert(int64_t timestamp, std::string name, std::optional<int64_t> scope, std::string value, bool tombstone = false) {
+    storage.raw.insert(SettingRecord{
+      .timestamp = timestamp,
+      .tombstone = tombstone,
+      .name = std::move(name),
+      .scope = scope,
+      .value = std::move(value),
+    });
+  }
+
+  std::set<std::string> valuesAt(int64_t timestamp) {
+    return pep::RangeToCollection<std::set>(storage.getCurrentRecordsAt(timestamp, true, &SettingRecord::value));
+  }
+
+  std::set<std::string> valuesFromHistory(int64_t timestamp) {
+    return pep::RangeToCollection<std::set>(storage.getCurrentRecords(c(&SettingRecord::timestamp) <= timestamp, &SettingRecord::value));
+  }
+};
+
+TEST_F(CurrentRecordsTest, trigger_keeps_latest_record_per_identifier) {
+  insert(1, "color", std::nullopt, "red");
+  insert(2, "color", 1, "green");
+  insert(3, "size", std::nullopt, "large");
+  insert(4, "color", std::nullopt, "blue"); // Supersedes "red", including its NULL scope
+  insert(5, "size", std::nullopt, "large", true);
+
+  EXPECT_EQ(3U, storage.raw.count<CurrentRecord<SettingRecord>>());
+  EXPECT_TRUE(storage.isCurrentAt<SettingRecord>(5));
+  EXPECT_FALSE(storage.isCurrentAt<SettingRecord>(4));
+
+  EXPECT_EQ((std::set<std::string>{ "green", "blue" }), valuesAt(5));
+  EXPECT_EQ(valuesFromHistory(5), valuesAt(5));
+  EXPECT_TRUE(storage.currentRecordExistsAt<SettingRecord>(5, c(&SettingRecord::name) == "color", having(c(&SettingRecord::value) == "blue")));
+  EXPECT_FALSE(storage.currentRecordExistsAt<SettingRecord>(5, c(&SettingRecord::name) == "size"));
+}
+
+TEST_F(CurrentRecordsTest, earlier_moments_are_served_from_history) {
+  insert(1, "color", std::nullopt, "red");
+  insert(3, "color", std::nullopt, "blue");
+
+  EXPECT_EQ(std::set<std::string>{ "red" }, valuesAt(2));
+  EXPECT_TRUE(storage.currentRecordExistsAt<SettingRecord>(2, c(&SettingRecord::name) == "color", having(c(&SettingRecord::value) == "red")));
+  EXPECT_TRUE(valuesAt(0).empty());
+}
+
+TEST_F(CurrentRecordsTest, rebuild_restores_current_records) {
+  insert(1, "color", std::nullopt, "red");
+  insert(2, "color", std::nullopt, "blue");
+  insert(3, "size", 1, "small");
+
+  storage.raw.remove_all<CurrentRecord<SettingRecord>>();
+  EXPECT_TRUE(valuesAt(3).empty());
+
+  storage.rebuildCurrentRecords<SettingRecord>();
+  EXPECT_EQ((std::set<std::string>{ "blue", "small" }), valuesAt(3));
+}
+
+TEST(CurrentRecords, helpers_use_read_connection_inside_read) {
+  namespace fs = pep::filesystem;
+  fs::Temporary temp{fs::temp_directory_path() / fs::RandomizedName("pepTest-Database-CurrentRecords-%%%%-%%%%-%%%%")};
+  fs::create_directory(temp.path());
+  pep::database::StorageProfile profile;
+  profile.journalMode = "WAL";
+  profile.readConnections = 1;
+  SettingsStorage storage((temp.path() / "settings.sqlite").string(), profile);
+  storage.syncSchema();
+
+  auto guard = storage.raw.transaction_guard();
+  storage.raw.insert(SettingRecord{ .timestamp = 1, .name = "color", .value = "red" });
+  EXPECT_TRUE(storage.currentRecordExists<SettingRecord>(c(&SettingRecord::name) == "color")) << "Outside read(), helpers should use the writing connection";
+  storage.read([&storage](auto&) {
+    EXPECT_FALSE(storage.currentRecordExists<SettingRecord>(c(&SettingRecord::name) == "color")) << "Inside read(), helpers should not see uncommitted data";
+  });
+  guard.commit();
+  storage.read([&storage](auto&) {
+    EXPECT_EQ(std::set<std::string>{ "red" }, pep::RangeToCollection<std::set>(storage.getCurrentRecordsAt(1, true, &SettingRecord::value)));
+  });
+}
+
+}
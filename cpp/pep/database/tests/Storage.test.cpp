@@ -145,4 +145,85 @@ TEST_F(StorageTest, syncSchema_with_new_table_succeeds) {
   }
 }
 
+TEST_F(StorageTest, default_profile_is_durable) {
+  auto dbPath = getDbPath();
+  pep::database::Storage<MakeStorageBase> storage(dbPath.string());
+  storage.syncSchema();
+  storage.raw.replace(MyTableRecord{ .id = 1, .key = "key" });
+
+  EXPECT_EQ(2, storage.raw.pragma.synchronous()) << "Default profile should synchronize FULLy";
+  EXPECT_FALSE(std::filesystem::exists(dbPath.string() + "-wal")) << "Default profile should not use write-ahead logging";
+}
+
+TEST_F(StorageTest, checkpoint_empties_write_ahead_log) {
+  auto dbPath = getDbPath();
+  pep::database::StorageProfile profile;
+  profile.journalMode = "WAL";
+  pep::database::Storage<MakeStorageBase> storage(dbPath.string(), profile);
+  storage.syncSchema();
+  storage.raw.replace(MyTableRecord{ .id = 1, .key = "key" });
+
+  auto walPath = dbPath.string() + "-wal";
+  ASSERT_TRUE(std::filesystem::exists(walPath));
+  EXPECT_NE(0U, std::filesystem::file_size(walPath));
+  storage.checkpoint();
+  EXPECT_EQ(0U, std::filesystem::file_size(walPath));
+}
+
+TEST_F(StorageTest, read_connections_see_committed_data_only) {
+  pep::database::StorageProfile profile;
+  profile.journalMode = "WAL";
+  profile.readConnections = 2;
+  pep::database::Storage<MakeStorageBase> storage(getDbPath().string(), profile);
+  storage.syncSchema();
+  ASSERT_TRUE(storage.hasReadConnections());
+
+  auto countRecords = [&storage] {
+    return storage.read([](auto& raw) { return raw.template count<MyTableRecord>(); });
+  };
+
+  auto guard = storage.raw.transaction_guard();
+  storage.raw.replace(MyTableRecord{ .id = 1, .key = "key" });
+  EXPECT_EQ(0, countRecords()) << "Write-ahead logging should allow reads during a write transaction";
+  guard.commit();
+  EXPECT_EQ(1, countRecords());
+}
+
+TEST_F(StorageTest, read_connections_refuse_writes) {
+  pep::database::StorageProfile profile;
+  profile.journalMode = "WAL";
+  profile.readConnections = 1;
+  pep::database::Storage<MakeStorageBase> storage(getDbPath().string(), profile);
+  storage.syncSchema();
+
+  EXPECT_ANY_THROW(storage.read([](auto& raw) { raw.replace(MyTableRecord{ .id = 1, .key = "key" }); }));
+  EXPECT_EQ(0, storage.raw.count<MyTableRecord>());
+}
+
+TEST_F(StorageTest, read_falls_back_to_raw_without_read_connections) {
+  pep::database::Storage<MakeStorageBase> storage(getDbPath().string());
+  EXPECT_FALSE(storage.hasReadConnections());
+  storage.read([&storage](auto& raw) { EXPECT_EQ(&storage.raw, &raw); });
+}
+
+TEST(StorageProfile, rejects_unsupported_values) {
+  pep::database::StorageProfile profile;
+  EXPECT_NO_THROW(profile.getPragmas(false));
+  profile.journalMode = "WAL; DROP TABLE MyTable";
+  EXPECT_THROW(profile.getPragmas(false), std::invalid_argument);
+  EXPECT_THROW(profile.getPragmas(true), std::invalid_argument);
+  profile.journalMode = "WAL";
+  profile.synchronous = "SOMETIMES";
+  EXPECT_THROW(profile.getPragmas(false), std::invalid_argument);
+}
+
+TEST(StorageProfile, read_connections_require_wal) {
+  pep::database::StorageProfile profile;
+  profile.readConnections = 1;
+  EXPECT_THROW(profile.getPragmas(false), std::invalid_argument);
+  profile.journalMode = "WAL";
+  EXPECT_NO_THROW(profile.getPragmas(false));
+  EXPECT_NO_THROW(profile.getPragmas(true));
+}
+
 }
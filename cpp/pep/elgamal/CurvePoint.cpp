@@ -1,6 +1,10 @@
 #include <pep/elgamal/CurvePoint.hpp>
 
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <stdexcept>
+#include <vector>
 
 #include <pep/crypto/ConstTime.hpp>
 #include <pep/utils/Random.hpp>
@@ -27,6 +31,24 @@ void CurvePoint::ensurePacked() const {
   state_ = State::GotBoth;
 }
 
+void CurvePoint::PackBatch(std::span<const CurvePoint* const> points) {
+  std::vector<const CurvePoint*> toPack;
+  std::vector<uint8_t*> packed;
+  std::vector<const group_ge*> unpacked;
+  for (auto point : points) {
+    if (point != nullptr && point->state_ == State::GotUnpacked) {
+      toPack.push_back(point);
+      packed.push_back(reinterpret_cast<uint8_t*>(point->packed_.data()));
+      unpacked.push_back(&point->unpacked_);
+    }
+  }
+  if (toPack.empty())
+    return;
+  group_ge_pack_batch(packed.data(), unpacked.data(), unpacked.size());
+  for (auto point : toPack)
+    point->state_ = State::GotBoth;
+}
+
 std::string_view CurvePoint::pack() const {
   ensurePacked();
   return SpanToString(packed_);
@@ -111,6 +133,83 @@ CurvePoint CurvePoint::mult(const PublicCurveScalar& s) const {
   return r;
 }
 
+namespace {
+
+// From this number of points on, Pippenger's method beats Straus' method.
+// Determined using BM_MultiScalarMult.
+constexpr size_t PippengerThreshold = 512;
+
+// Returns the window size (in bits) for Pippenger's method that minimizes
+// the number of point additions for the given number of points.
+int PippengerWindowBits(size_t points) {
+  int best = 2;
+  size_t bestCost = std::numeric_limits<size_t>::max();
+  for (int w = 2; w <= 15; ++w) {
+    auto cost = static_cast<size_t>(scalar_signed_window_digits(w)) * (points + (size_t{1} << w));
+    if (cost < bestCost) {
+      best = w;
+      bestCost = cost;
+    }
+  }
+  return best;
+}
+
+void CheckMultiScalarMultSizes(size_t scalars, size_t points) {
+  if (scalars != points) {
+    throw std::invalid_argument("Multi-scalar multiplication requires as many scalars as points");
+  }
+}
+
+}
+
+std::vector<group_ge> CurvePoint::UnpackAll(std::span<const CurvePoint> points) {
+  std::vector<group_ge> result;
+  result.reserve(points.size());
+  for (const auto& point : points) {
+    result.push_back(*point.unpack());
+  }
+  return result;
+}
+
+CurvePoint CurvePoint::MultiScalarMult(
+    std::span<const CurveScalar> scalars,
+    std::span<const CurvePoint> points) {
+  CheckMultiScalarMultSizes(scalars.size(), points.size());
+  auto unpacked = UnpackAll(points);
+  std::vector<group_scalar> inner;
+  inner.reserve(scalars.size());
+  for (const auto& scalar : scalars) {
+    inner.push_back(scalar.inner_);
+  }
+  CurvePoint r(State::GotUnpacked);
+  group_ge_multiscalarmult(&r.unpacked_, unpacked.data(), inner.data(), unpacked.size());
+  return r;
+}
+
+CurvePoint CurvePoint::MultiScalarMult(
+    std::span<const PublicCurveScalar> scalars,
+    std::span<const CurvePoint> points) {
+  CheckMultiScalarMultSizes(scalars.size(), points.size());
+  auto unpacked = UnpackAll(points);
+  std::vector<group_scalar> inner;
+  inner.reserve(scalars.size());
+  for (const auto& scalar : scalars) {
+    inner.push_back(scalar.inner_);
+  }
+  CurvePoint r(State::GotUnpacked);
+  if (unpacked.size() < PippengerThreshold) {
+    group_ge_multiscalarmult_publicinputs(&r.unpacked_, unpacked.data(), inner.data(), unpacked.size());
+  }
+  else {
+    auto w = PippengerWindowBits(unpacked.size());
+    std::vector<group_ge> buckets(size_t{1} << (w - 1));
+    std::vector<int16_t> digits(unpacked.size() * static_cast<size_t>(scalar_signed_window_digits(w)));
+    group_ge_multiscalarmult_pippenger_publicinputs(&r.unpacked_, unpacked.data(), inner.data(), unpacked.size(),
+        w, buckets.data(), digits.data());
+  }
+  return r;
+}
+
 /// \brief Derive CurvePoint from a string
 ///
 /// The string is hashed using SHA512 and then embedded into the group
@@ -174,6 +273,18 @@ CurvePoint::ScalarMultTable::ScalarMultTable(const CurvePoint& point) { //NOLINT
   group_scalarmult_table_compute(&internal_, point.unpack());
 }
 
+std::string_view CurvePoint::ScalarMultTable::raw() const {
+  return {reinterpret_cast<const char*>(&internal_), RawBytes};
+}
+
+std::unique_ptr<CurvePoint::ScalarMultTable> CurvePoint::ScalarMultTable::FromRaw(std::string_view raw) {
+  if (raw.size() != RawBytes)
+    throw std::invalid_argument("Raw ScalarMultTable has invalid size");
+  std::unique_ptr<ScalarMultTable> result(new ScalarMultTable());
+  std::memcpy(&result->internal_, raw.data(), RawBytes);
+  return result;
+}
+
 CurvePoint CurvePoint::ScalarMultTable::mult(const CurveScalar& s) const {
   CurvePoint r(State::GotUnpacked);
   group_ge_scalarmult_table(&r.unpacked_, &internal_, &s.inner_);
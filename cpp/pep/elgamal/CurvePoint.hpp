@@ -9,8 +9,11 @@ extern "C" {
 #include <array>
 #include <compare>
 #include <cstdlib>
+#include <memory>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include <pep/elgamal/CurveScalar.hpp>
 #include <pep/utils/CollectionUtils.hpp>
@@ -43,6 +46,10 @@ class CurvePoint {
   // all requests.
   void ensurePacked() const;
 
+  // Calls ensurePacked() on all given CurvePoints (skipping null pointers),
+  // which is considerably faster than calling it on each of them separately.
+  static void PackBatch(std::span<const CurvePoint* const> points);
+
   // If a CurvePoint is read by multiple threads at the same time, which
   // either is not packed or unpacked, then the lazy (un)packing can cause
   // a memory corruption.  See eg #791.
@@ -59,7 +66,17 @@ class CurvePoint {
     CurvePoint mult(const CurveScalar& p) const;
     CurvePoint mult(const PublicCurveScalar& p) const;
 
+    // The table's internal representation, e.g. to store it on disk.
+    // It depends on the platform, so it should only be read back by
+    // FromRaw() in a build for the same platform.  FromRaw() does not
+    // check that raw is the table of any point.
+    static constexpr size_t RawBytes = sizeof(group_scalarmult_table);
+    std::string_view raw() const;
+    static std::unique_ptr<ScalarMultTable> FromRaw(std::string_view raw);
+
   private:
+    ScalarMultTable() = default;
+
     group_scalarmult_table internal_;
   };
 
@@ -84,6 +101,21 @@ class CurvePoint {
   [[nodiscard]] friend CurvePoint operator*(const CurveScalar& s, const CurvePoint& p) { return p.mult(s); }
   [[nodiscard]] friend CurvePoint operator*(const PublicCurveScalar& s, const CurvePoint& p)  { return p.mult(s); }
 
+  /// Computes the sum of scalars[i] * points[i] at once, which is considerably
+  /// faster than computing and adding the products one by one.
+  /// Uses (constant-time) Straus' method.
+  /// \throws std::invalid_argument if the spans differ in size
+  [[nodiscard]] static CurvePoint MultiScalarMult(
+      std::span<const CurveScalar> scalars,
+      std::span<const CurvePoint> points);
+  /// Computes the sum of scalars[i] * points[i] for public scalars.
+  /// Not constant time: uses Straus' method with wNAF digits for few points,
+  /// and Pippenger's bucket method for many points.
+  /// \throws std::invalid_argument if the spans differ in size
+  [[nodiscard]] static CurvePoint MultiScalarMult(
+      std::span<const PublicCurveScalar> scalars,
+      std::span<const CurvePoint> points);
+
   static CurvePoint Random();
 
   static CurvePoint Hash(std::string_view s);
@@ -107,6 +139,8 @@ class CurvePoint {
   // it first, if necessary).
   group_ge* unpack() const;
 
+  static std::vector<group_ge> UnpackAll(std::span<const CurvePoint> points);
+
   [[nodiscard]] CurvePoint mult(const CurveScalar& s) const;
   [[nodiscard]] CurvePoint mult(const PublicCurveScalar& s) const;
   [[nodiscard]] static CurvePoint BaseMult(const CurveScalar& s);
@@ -111,6 +111,26 @@ ElgamalEncryption ElgamalEncryption::reshuffleRekey(const CurveScalar& reshuffle
   };
 }
 
+/// \brief rerandomize, reshuffle and rekey an ElgamalEncryption triple.
+///
+/// Equivalent to rerandomize().reshuffleRekey(reshuffle, rekey), but computes
+/// both resulting points with a single two-point multi-scalar multiplication each.
+/// \param reshuffle the CurveScalar to reshuffle with
+/// \param rekey the ElgamalTranslationKey to rekey along
+ElgamalEncryption ElgamalEncryption::rerandomizeReshuffleRekey(const CurveScalar& reshuffle, const ElgamalTranslationKey& rekey) const {
+  auto rerandomize = CurveScalar::Random();
+  auto reshuffleOverRekey = reshuffle * rekey.invert();
+  const CurveScalar bScalars[] = { reshuffleOverRekey, reshuffleOverRekey * rerandomize };
+  const CurvePoint bPoints[] = { b, CurvePoint::Base };
+  const CurveScalar cScalars[] = { reshuffle, reshuffle * rerandomize };
+  const CurvePoint cPoints[] = { c, publicKey };
+  return {
+    CurvePoint::MultiScalarMult(bScalars, bPoints),
+    CurvePoint::MultiScalarMult(cScalars, cPoints),
+    rekey * publicKey,
+  };
+}
+
 /// \return The public key of the ElgamalEncryption.
 const ElgamalPublicKey& ElgamalEncryption::getPublicKey() const {
   return publicKey;
@@ -160,9 +180,20 @@ ElgamalEncryption ElgamalEncryption::FromPacked(std::string_view packed) {
 }
 
 void ElgamalEncryption::ensurePacked() const {
-  b.ensurePacked();
-  c.ensurePacked();
-  publicKey.ensurePacked();
+  const CurvePoint* points[] = { &b, &c, &publicKey };
+  CurvePoint::PackBatch(points);
+}
+
+void ElgamalEncryption::EnsurePacked(std::span<const ElgamalEncryption> encryptions) {
+  std::vector<const CurvePoint*> points;
+  points.reserve(3 * encryptions.size());
+  for (const auto& encryption : encryptions)
+    encryption.addPointsTo(points);
+  CurvePoint::PackBatch(points);
+}
+
+void ElgamalEncryption::addPointsTo(std::vector<const CurvePoint*>& points) const {
+  points.insert(points.end(), { &b, &c, &publicKey });
 }
 
 void ElgamalEncryption::ensureThreadSafe() const {
@@ -2,7 +2,9 @@
 
 #include <pep/elgamal/CurvePoint.hpp>
 
+#include <span>
 #include <utility>
+#include <vector>
 
 namespace pep {
 using ElgamalPrivateKey = CurveScalar;
@@ -31,6 +33,7 @@ class ElgamalEncryption {
   [[nodiscard]] ElgamalEncryption rekey(const ElgamalTranslationKey& rekey) const;
   [[nodiscard]] ElgamalEncryption reshuffle(const CurveScalar& reshuffle) const;
   [[nodiscard]] ElgamalEncryption reshuffleRekey(const CurveScalar& reshuffle, const ElgamalTranslationKey& rekey) const;
+  [[nodiscard]] ElgamalEncryption rerandomizeReshuffleRekey(const CurveScalar& reshuffle, const ElgamalTranslationKey& rekey) const;
 
   const ElgamalPublicKey& getPublicKey() const;
 
@@ -45,6 +48,11 @@ class ElgamalEncryption {
   // Ensures the underlying CurvePoint's are pre-packed for serialization.
   // See CurvePoint::ensurePacked().
   void ensurePacked() const;
+  // Same as calling ensurePacked() on each of the encryptions, but faster.
+  // See CurvePoint::PackBatch().
+  static void EnsurePacked(std::span<const ElgamalEncryption> encryptions);
+  // Adds the underlying CurvePoint's to points, to pack them using CurvePoint::PackBatch().
+  void addPointsTo(std::vector<const CurvePoint*>& points) const;
   void ensureThreadSafe() const;
 
   [[nodiscard]] auto operator<=>(const ElgamalEncryption& other) const = default;
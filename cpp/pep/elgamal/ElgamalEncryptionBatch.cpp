@@ -0,0 +1,147 @@
+#include <pep/elgamal/ElgamalEncryptionBatch.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+namespace pep {
+
+namespace {
+
+// Number of (most recently added) distinct public keys that push_back()
+// compares a new public key against.  Batches usually contain only a few
+// distinct public keys: this bounds the cost when they don't.
+constexpr size_t MaxComparedPublicKeys = 8;
+
+// From this number of elements sharing a public key on, computing a
+// ScalarMultTable for it speeds up rerandomize().
+// Determined using BM_ScalarMultTableCompute, BM_ScalarMultTable and BM_ScalarMult.
+constexpr size_t ScalarMultTableThreshold = 32;
+
+}
+
+ElgamalEncryptionBatch::ElgamalEncryptionBatch(std::span<const ElgamalEncryption> encryptions) {
+  reserve(encryptions.size());
+  for (const auto& encryption : encryptions)
+    push_back(encryption);
+}
+
+void ElgamalEncryptionBatch::reserve(size_t size) {
+  b_.reserve(size);
+  c_.reserve(size);
+  publicKeyIndices_.reserve(size);
+}
+
+void ElgamalEncryptionBatch::push_back(const ElgamalEncryption& encryption) {
+  auto compareFrom = publicKeys_.size() - std::min(publicKeys_.size(), MaxComparedPublicKeys);
+  auto found = std::find(publicKeys_.begin() + static_cast<ptrdiff_t>(compareFrom), publicKeys_.end(), encryption.publicKey);
+  if (found == publicKeys_.end()) {
+    found = publicKeys_.insert(publicKeys_.end(), encryption.publicKey);
+  }
+  b_.push_back(encryption.b);
+  c_.push_back(encryption.c);
+  publicKeyIndices_.push_back(static_cast<uint32_t>(found - publicKeys_.begin()));
+}
+
+ElgamalEncryption ElgamalEncryptionBatch::operator[](size_t i) const {
+  return ElgamalEncryption(b_.at(i), c_.at(i), publicKeys_[publicKeyIndices_.at(i)]);
+}
+
+std::vector<ElgamalEncryption> ElgamalEncryptionBatch::toVector() const {
+  std::vector<ElgamalEncryption> result;
+  result.reserve(size());
+  for (size_t i = 0; i < size(); i++)
+    result.emplace_back(b_[i], c_[i], publicKeys_[publicKeyIndices_[i]]);
+  return result;
+}
+
+ElgamalEncryptionBatch ElgamalEncryptionBatch::withPublicKeys(
+    std::vector<CurvePoint> b,
+    std::vector<CurvePoint> c,
+    std::vector<CurvePoint> publicKeys) const {
+  ElgamalEncryptionBatch result;
+  result.b_ = std::move(b);
+  result.c_ = std::move(c);
+  result.publicKeys_ = std::move(publicKeys);
+  result.publicKeyIndices_ = publicKeyIndices_;
+  return result;
+}
+
+/// \brief rerandomize all ElgamalEncryption triples.
+/// \see ElgamalEncryption::rerandomize()
+ElgamalEncryptionBatch ElgamalEncryptionBatch::rerandomize() const {
+  std::vector<size_t> uses(publicKeys_.size());
+  for (auto index : publicKeyIndices_)
+    uses[index]++;
+  std::vector<std::unique_ptr<CurvePoint::ScalarMultTable>> tables(publicKeys_.size());
+  for (size_t i = 0; i < publicKeys_.size(); i++) {
+    if (uses[i] >= ScalarMultTableThreshold)
+      tables[i] = std::make_unique<CurvePoint::ScalarMultTable>(publicKeys_[i]);
+  }
+
+  std::vector<CurvePoint> b, c;
+  b.reserve(size());
+  c.reserve(size());
+  for (size_t i = 0; i < size(); i++) {
+    auto rerandomize = CurveScalar::Random();
+    auto index = publicKeyIndices_[i];
+    b.push_back(b_[i] + (rerandomize * CurvePoint::Base));
+    c.push_back(c_[i] + (tables[index] ? tables[index]->mult(rerandomize) : rerandomize * publicKeys_[index]));
+  }
+  return withPublicKeys(std::move(b), std::move(c), publicKeys_);
+}
+
+/// \brief rekey all ElgamalEncryption triples.
+/// \see ElgamalEncryption::rekey()
+ElgamalEncryptionBatch ElgamalEncryptionBatch::rekey(const ElgamalTranslationKey& rekey) const {
+  auto rekeyInverse = rekey.invert();
+  std::vector<CurvePoint> b, publicKeys;
+  b.reserve(size());
+  for (const auto& point : b_)
+    b.push_back(rekeyInverse * point);
+  publicKeys.reserve(publicKeys_.size());
+  for (const auto& publicKey : publicKeys_)
+    publicKeys.push_back(rekey * publicKey);
+  return withPublicKeys(std::move(b), c_, std::move(publicKeys));
+}
+
+/// \brief reshuffle and rekey all ElgamalEncryption triples.
+/// \see ElgamalEncryption::reshuffleRekey()
+ElgamalEncryptionBatch ElgamalEncryptionBatch::reshuffleRekey(const CurveScalar& reshuffle, const ElgamalTranslationKey& rekey) const {
+  auto reshuffleOverRekey = reshuffle * rekey.invert();
+  std::vector<CurvePoint> b, c, publicKeys;
+  b.reserve(size());
+  c.reserve(size());
+  for (size_t i = 0; i < size(); i++) {
+    b.push_back(reshuffleOverRekey * b_[i]);
+    c.push_back(reshuffle * c_[i]);
+  }
+  publicKeys.reserve(publicKeys_.size());
+  for (const auto& publicKey : publicKeys_)
+    publicKeys.push_back(rekey * publicKey);
+  return withPublicKeys(std::move(b), std::move(c), std::move(publicKeys));
+}
+
+/// \brief decrypt all ElgamalEncryption triples.
+/// \see ElgamalEncryption::decrypt()
+std::vector<CurvePoint> ElgamalEncryptionBatch::decrypt(const ElgamalPrivateKey& privateKey) const {
+  std::vector<CurvePoint> result;
+  result.reserve(size());
+  for (size_t i = 0; i < size(); i++)
+    result.push_back(c_[i] - (privateKey * b_[i]));
+  return result;
+}
+
+void ElgamalEncryptionBatch::ensurePacked() const {
+  std::vector<const CurvePoint*> points;
+  points.reserve(b_.size() + c_.size() + publicKeys_.size());
+  for (const auto& point : b_)
+    points.push_back(&point);
+  for (const auto& point : c_)
+    points.push_back(&point);
+  for (const auto& point : publicKeys_)
+    points.push_back(&point);
+  CurvePoint::PackBatch(points);
+}
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <pep/elgamal/ElgamalEncryption.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace pep {
+
+/// A sequence of ElgamalEncryption triples, stored as separate arrays of
+/// b's, c's and (deduplicated) public keys.  Its bulk operations are
+/// equivalent to calling the corresponding ElgamalEncryption methods on
+/// each element, but share the work that the elements have in common:
+/// - rekey() and reshuffleRekey() invert the translation key only once,
+///   and rekey every distinct public key only once;
+/// - rerandomize() uses a CurvePoint::ScalarMultTable for public keys
+///   that are shared by many elements;
+/// - ensurePacked() packs all points at once, see CurvePoint::PackBatch().
+class ElgamalEncryptionBatch {
+public:
+  ElgamalEncryptionBatch() = default;
+  explicit ElgamalEncryptionBatch(std::span<const ElgamalEncryption> encryptions);
+
+  size_t size() const { return b_.size(); }
+  bool empty() const { return b_.empty(); }
+  void reserve(size_t size);
+  void push_back(const ElgamalEncryption& encryption);
+
+  ElgamalEncryption operator[](size_t i) const;
+  std::vector<ElgamalEncryption> toVector() const;
+
+  [[nodiscard]] ElgamalEncryptionBatch rerandomize() const;
+  [[nodiscard]] ElgamalEncryptionBatch rekey(const ElgamalTranslationKey& rekey) const;
+  [[nodiscard]] ElgamalEncryptionBatch reshuffleRekey(const CurveScalar& reshuffle, const ElgamalTranslationKey& rekey) const;
+  [[nodiscard]] std::vector<CurvePoint> decrypt(const ElgamalPrivateKey& privateKey) const;
+
+  // Ensures the underlying CurvePoint's are pre-packed for serialization.
+  // See CurvePoint::ensurePacked().
+  void ensurePacked() const;
+
+private:
+  std::vector<CurvePoint> b_;
+  std::vector<CurvePoint> c_;
+  // Distinct public keys, and for every element the index of its public key.
+  std::vector<CurvePoint> publicKeys_;
+  std::vector<uint32_t> publicKeyIndices_;
+
+  ElgamalEncryptionBatch withPublicKeys(std::vector<CurvePoint> b, std::vector<CurvePoint> c, std::vector<CurvePoint> publicKeys) const;
+};
+
+}
@@ -3,6 +3,11 @@
 
 #include <gtest/gtest.h>
 
+#include <initializer_list>
+#include <span>
+#include <string>
+#include <vector>
+
 namespace {
 
 TEST(CurvePointTest, TestCompare) {
@@ -46,6 +51,30 @@ TEST(CurvePointTest, TestSub) {
   [[maybe_unused]] pep::CurvePoint pointC = pointA - pointB;
 }
 
+TEST(CurvePointTest, TestPackBatch) {
+  std::vector<pep::CurvePoint> points;
+  std::vector<std::string> expected;
+  for (int i = 0; i < 50; i++) {
+    pep::CurvePoint point = pep::CurvePoint::Random() + pep::CurvePoint::Random();
+    expected.emplace_back(pep::CurvePoint(point).pack());
+    points.push_back(point);
+  }
+  (void) points[3].pack(); // already packed
+  points.emplace_back(); // neutral element
+  expected.emplace_back(pep::CurvePoint().pack());
+
+  std::vector<const pep::CurvePoint*> pointers{nullptr};
+  for (const auto& point : points)
+    pointers.push_back(&point);
+  pointers.push_back(&points.front()); // duplicate
+  pep::CurvePoint::PackBatch(pointers);
+
+  for (size_t i = 0; i < points.size(); i++) {
+    EXPECT_EQ(expected[i], points[i].pack()) << "for point " << i;
+  }
+  pep::CurvePoint::PackBatch({});
+}
+
 TEST(CurvePointTest, TestFromText) {
   EXPECT_THROW(pep::CurvePoint::FromText(""), std::invalid_argument);
 }
@@ -88,6 +117,52 @@ TEST(CurvePointTest, TestPublicMult) {
   }
 }
 
+template <typename Scalar>
+void TestMultiScalarMult(std::initializer_list<size_t> sizes) {
+  for (size_t n : sizes) {
+    std::vector<Scalar> scalars;
+    std::vector<pep::CurvePoint> points;
+    pep::CurvePoint expected;
+    for (size_t i = 0; i < n; i++) {
+      scalars.emplace_back(pep::CurveScalar::Random());
+      points.push_back(pep::CurvePoint::Random());
+      expected = expected + scalars.back() * points.back();
+    }
+    EXPECT_EQ(expected, pep::CurvePoint::MultiScalarMult(std::span<const Scalar>(scalars), points)) << "for " << n << " points";
+  }
+
+  std::vector<Scalar> scalars(2);
+  std::vector<pep::CurvePoint> points(3);
+  EXPECT_THROW((void) pep::CurvePoint::MultiScalarMult(std::span<const Scalar>(scalars), points), std::invalid_argument);
+}
+
+TEST(CurvePointTest, TestMultiScalarMult) {
+  TestMultiScalarMult<pep::CurveScalar>({0, 1, 2, 7, 8, 9, 20});
+}
+
+TEST(CurvePointTest, TestPublicMultiScalarMult) {
+  // Includes sizes for which Pippenger's method is used
+  TestMultiScalarMult<pep::PublicCurveScalar>({0, 1, 2, 15, 16, 17, 40, 128, 600});
+}
+
+TEST(CurvePointTest, TestMultiScalarMultEdgeCases) {
+  const pep::CurveScalar one = pep::CurveScalar::One();
+  const auto point = pep::CurvePoint::Random();
+  std::vector<pep::CurvePoint> points(600, point);
+  std::vector<pep::PublicCurveScalar> scalars(600, pep::PublicCurveScalar(one));
+  scalars.front() = pep::PublicCurveScalar(pep::CurveScalar() - one); // largest scalar
+  scalars.back() = pep::PublicCurveScalar(); // zero
+
+  // Straus: -1 + 1 + 1
+  EXPECT_EQ(point, pep::CurvePoint::MultiScalarMult(std::span(scalars).first(3), std::span(points).first(3)));
+  // Pippenger: -1 + 598 * 1 + 0
+  pep::CurveScalar expected;
+  for (int i = 0; i < 597; i++) {
+    expected = expected + one;
+  }
+  EXPECT_EQ(pep::PublicCurveScalar(expected) * point, pep::CurvePoint::MultiScalarMult(scalars, points));
+}
+
 TEST(CurvePointTest, TestAddSub) {
   pep::CurvePoint pointA = pep::CurvePoint::Random();
   pep::CurvePoint pointB = pep::CurvePoint::Random();
@@ -62,4 +62,16 @@ TEST(ElgamalEncryptionTest, ReRandomizeTest) {
   EXPECT_NE(enc, reshuffled);
 }
 
+TEST(ElgamalEncryptionTest, RerandomizeReshuffleRekeyTest) {
+  auto [private_key, public_key] = pep::ElgamalEncryption::CreateKeyPair();
+  pep::CurvePoint test_CurvePoint = pep::CurvePoint::Random();
+  pep::CurveScalar reshuffle = pep::CurveScalar::Random();
+  pep::ElgamalTranslationKey rekey(pep::CurveScalar::Random());
+  pep::ElgamalEncryption enc(public_key, test_CurvePoint);
+  pep::ElgamalEncryption translated = enc.rerandomizeReshuffleRekey(reshuffle, rekey);
+  EXPECT_NE(enc.reshuffleRekey(reshuffle, rekey), translated);
+  EXPECT_EQ(enc.reshuffleRekey(reshuffle, rekey).publicKey, translated.publicKey);
+  EXPECT_EQ(reshuffle * test_CurvePoint, translated.decrypt(rekey * private_key));
+}
+
 }
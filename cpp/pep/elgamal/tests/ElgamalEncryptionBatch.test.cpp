@@ -0,0 +1,94 @@
+#include <pep/elgamal/ElgamalEncryptionBatch.hpp>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace {
+
+struct TestBatch {
+  std::vector<pep::ElgamalPrivateKey> privateKeys;
+  std::vector<pep::CurvePoint> messages;
+  std::vector<pep::ElgamalEncryption> encryptions;
+  std::vector<size_t> keyIndices; // Index into privateKeys for every encryption
+};
+
+// Creates encryptions under alternating public keys, using each key the specified number of times
+TestBatch CreateTestBatch(std::vector<size_t> usesPerKey) {
+  TestBatch result;
+  std::vector<pep::ElgamalPublicKey> publicKeys;
+  for (size_t i = 0; i < usesPerKey.size(); i++) {
+    auto [privateKey, publicKey] = pep::ElgamalEncryption::CreateKeyPair();
+    result.privateKeys.push_back(privateKey);
+    publicKeys.push_back(publicKey);
+  }
+  for (bool added = true; added;) {
+    added = false;
+    for (size_t key = 0; key < usesPerKey.size(); key++) {
+      if (usesPerKey[key] > 0) {
+        usesPerKey[key]--;
+        result.messages.push_back(pep::CurvePoint::Random());
+        result.encryptions.emplace_back(publicKeys[key], result.messages.back());
+        result.keyIndices.push_back(key);
+        added = true;
+      }
+    }
+  }
+  return result;
+}
+
+// Creates encryptions under alternating public keys
+TestBatch CreateTestBatch(size_t size, size_t keys) {
+  std::vector<size_t> usesPerKey(keys, size / keys);
+  for (size_t i = 0; i < size % keys; i++)
+    usesPerKey[i]++;
+  return CreateTestBatch(std::move(usesPerKey));
+}
+
+TEST(ElgamalEncryptionBatchTest, Elements) {
+  auto test = CreateTestBatch(20, 3);
+  pep::ElgamalEncryptionBatch batch(test.encryptions);
+  ASSERT_EQ(test.encryptions.size(), batch.size());
+  EXPECT_EQ(test.encryptions, batch.toVector());
+  for (size_t i = 0; i < batch.size(); i++)
+    EXPECT_EQ(test.encryptions[i], batch[i]);
+  EXPECT_THROW((void) batch[batch.size()], std::out_of_range);
+  EXPECT_TRUE(pep::ElgamalEncryptionBatch().empty());
+}
+
+TEST(ElgamalEncryptionBatchTest, Decrypt) {
+  auto test = CreateTestBatch(20, 3);
+  pep::ElgamalEncryptionBatch batch(test.encryptions);
+  auto decrypted = batch.decrypt(test.privateKeys[1]);
+  ASSERT_EQ(batch.size(), decrypted.size());
+  for (size_t i = 0; i < batch.size(); i++)
+    EXPECT_EQ(test.encryptions[i].decrypt(test.privateKeys[1]), decrypted[i]);
+}
+
+TEST(ElgamalEncryptionBatchTest, Rerandomize) {
+  // Enough uses (ScalarMultTableThreshold is 32) to use a ScalarMultTable for the first public key, but not for the second
+  auto test = CreateTestBatch({ 50, 10 });
+  auto rerandomized = pep::ElgamalEncryptionBatch(test.encryptions).rerandomize();
+  rerandomized.ensurePacked();
+  ASSERT_EQ(test.encryptions.size(), rerandomized.size());
+  for (size_t i = 0; i < rerandomized.size(); i++) {
+    EXPECT_NE(test.encryptions[i], rerandomized[i]);
+    EXPECT_EQ(test.encryptions[i].publicKey, rerandomized[i].publicKey);
+    EXPECT_EQ(test.messages[i], rerandomized[i].decrypt(test.privateKeys[test.keyIndices[i]]));
+  }
+}
+
+TEST(ElgamalEncryptionBatchTest, RekeyAndReshuffleRekey) {
+  auto test = CreateTestBatch(20, 3);
+  pep::ElgamalEncryptionBatch batch(test.encryptions);
+  auto reshuffle = pep::CurveScalar::Random();
+  pep::ElgamalTranslationKey rekey(pep::CurveScalar::Random());
+  auto rekeyed = batch.rekey(rekey);
+  auto reshuffledRekeyed = batch.reshuffleRekey(reshuffle, rekey);
+  for (size_t i = 0; i < batch.size(); i++) {
+    EXPECT_EQ(test.encryptions[i].rekey(rekey), rekeyed[i]);
+    EXPECT_EQ(test.encryptions[i].reshuffleRekey(reshuffle, rekey), reshuffledRekeyed[i]);
+  }
+}
+
+}
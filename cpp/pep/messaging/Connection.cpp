@@ -2,6 +2,7 @@
 #include <pep/async/RxBeforeTermination.hpp>
 #include <pep/messaging/Node.hpp>
 #include <pep/messaging/ConnectionFailureException.hpp>
+#include <pep/messaging/MessageCompression.hpp>
 #include <pep/messaging/MessagingSerializers.hpp>
 #include <pep/utils/Defer.hpp>
 #include <pep/utils/Exceptions.hpp>
@@ -18,6 +19,14 @@ namespace {
 
 const std::string LogTag = "Messaging connection";
 
+// Stop draining the scheduler once a write holds this many bytes, so that we don't keep (copies of) too many
+// messages in memory, and a reply to an incoming message isn't held up for too long
+constexpr size_t MaxBytesPerWrite = 1024 * 1024;
+
+// Bodies up to this size are copied into the buffer that also holds the message headers. This corresponds to the maximum
+// TLS record size: an SSL stream encrypts every buffer it's given into (at least) one record of its own
+constexpr size_t MaxCoalescedBodySize = 16 * 1024;
+
 class RequestRefusedException : public Error {
 public:
   explicit inline RequestRefusedException(const std::string& reason) : Error(reason) {}
@@ -34,7 +43,7 @@ void Connection::handleHeaderReceived(const networking::SizedTransfer::Result& r
 
   try {
     assert(*result == sizeof(messageInHeader_));
-    auto header = MessageHeader::Decode(messageInHeader_);
+    auto header = MessageHeader::Decode(messageInHeader_, compressionNegotiated_);
     auto length = header.length();
 
     if (length > MaxSizeOfMessage) {
@@ -75,30 +84,79 @@ void Connection::ensureSend() {
     return;
   sendActive_ = true;
 
-  // we have to send in two stages, first a header of 8 bytes consiting of a message length and a message id
-  auto entry = scheduler_->pop();
-  MessageProperties properties = entry.properties;
-  messageOutBody_ = entry.content;
-  assert(messageOutBody_);
+  // Drain the scheduler into a single write, so that a burst of (small) messages doesn't cost a system call
+  // (and, for TLS, a record) per header and per body
+  std::vector<std::pair<EncodedMessageHeader, std::shared_ptr<std::string>>> messages;
+  size_t total = 0U, coalesced = 0U;
+  do {
+    // Check the size before we pop, so that messages that we already popped are sent before we raise an error
+    const auto& next = scheduler_->peek();
+    assert(next.content);
+    if (next.content->size() >= MaxSizeOfMessage) {
+      if (!messages.empty()) {
+        break; // We'll raise the error when we're invoked again, i.e. after the preceding messages have been sent
+      }
+      std::ostringstream msg;
+      msg << "Message queued to be sent is too large.  ("
+        << "Size=" << next.content->size() << ", Type="
+        << DescribeMessageMagic(*next.content)
+        << ")";
+      throw std::runtime_error(msg.str());
+    }
 
-  PEP_LOG(LogTag, Severity::Verbose) << "Connection::ensureSend outgoing message streamId=" << properties.messageId().streamId() << " (to " << describe() << ")";
+    auto entry = scheduler_->pop();
+    MessageProperties properties = entry.properties;
+    auto body = std::move(entry.content);
 
-  if (messageOutBody_->size() >= MaxSizeOfMessage) {
-    std::ostringstream msg;
-    msg << "Message queued to be sent is too large.  ("
-      << "Size=" << messageOutBody_->size() << ", Type="
-      << DescribeMessageMagic(*messageOutBody_)
-      << ")";
-    throw std::runtime_error(msg.str());
-  }
+    PEP_LOG(LogTag, Severity::Verbose) << "Connection::ensureSend outgoing message streamId=" << properties.messageId().streamId() << " (to " << describe() << ")";
 
-  assert(messageOutBody_->length() <= std::numeric_limits<MessageLength>::max());
-  MessageHeader header(static_cast<MessageLength>(messageOutBody_->length()), properties);
-  messageOutHeader_ = header.encode();
+    bool compressed = false;
+    if (compressionNegotiated_) {
+      if (auto compressedBody = MessageCompression::TryCompress(*body)) {
+        body = std::make_shared<std::string>(std::move(*compressedBody));
+        compressed = true;
+      }
+    }
 
-  // after the message header is written, call the second stage to send the body
-  binary_->asyncWrite(&messageOutHeader_, sizeof(messageOutHeader_), [self = SharedFrom(*this)](const networking::SizedTransfer::Result& result) {
-    self->handleHeaderSent(result);
+    assert(body->length() <= std::numeric_limits<MessageLength>::max());
+    MessageHeader header(static_cast<MessageLength>(body->length()), properties, compressed);
+    total += sizeof(EncodedMessageHeader) + body->size();
+    coalesced += sizeof(EncodedMessageHeader);
+    if (body->size() <= MaxCoalescedBodySize) {
+      coalesced += body->size();
+    }
+    messages.emplace_back(header.encode(), std::move(body));
+  } while (total < MaxBytesPerWrite && scheduler_->available());
+
+  // Copy headers and small bodies into a single buffer, which we reserve up front so that the regions we
+  // pass to the transport remain valid
+  std::vector<std::string_view> sources;
+  messagesOutCoalesced_.clear();
+  messagesOutCoalesced_.reserve(coalesced);
+  size_t pending = 0U; // offset of coalesced data that hasn't been added to the sources yet
+  auto addCoalesced = [this, &sources, &pending]() {
+    if (messagesOutCoalesced_.size() > pending) {
+      sources.emplace_back(messagesOutCoalesced_.data() + pending, messagesOutCoalesced_.size() - pending);
+      pending = messagesOutCoalesced_.size();
+    }
+  };
+  for (auto& [header, body] : messages) {
+    messagesOutCoalesced_.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (body->size() <= MaxCoalescedBodySize) {
+      messagesOutCoalesced_.append(*body);
+    }
+    else {
+      addCoalesced();
+      sources.emplace_back(*body);
+      messagesOutBodies_.emplace_back(std::move(body));
+    }
+  }
+  addCoalesced();
+  assert(messagesOutCoalesced_.size() == coalesced);
+
+  PEP_LOG(LogTag, Severity::Verbose) << "Connection::ensureSend sending " << messages.size() << " message(s) in " << total << " bytes (to " << describe() << ")";
+  binary_->asyncGatherWrite(std::move(sources), [self = SharedFrom(*this)](const networking::SizedTransfer::Result& result) {
+    self->handleMessagesSent(result);
     });
 }
 
@@ -161,37 +219,19 @@ void Connection::start() {
   }
 }
 
-void Connection::handleHeaderSent(const networking::SizedTransfer::Result& result) {
-  PEP_LOG(LogTag, Severity::Verbose) << "handleHeaderSent (" << describe() << ")";
-  if (!this->prepareBodyTransfer(result)) {
-    return;
-  }
-
-  PEP_LOG(LogTag, Severity::Verbose) << "Sending body (" << describe() << ")";
-
-  if (!messageOutBody_ || messageOutBody_->empty()) {
-    handleMessageSent(networking::SizedTransfer::Result::Success(0));
-    return;
-  }
-
-  binary_->asyncWrite(messageOutBody_->data(), messageOutBody_->length(), [self = SharedFrom(*this)](const networking::SizedTransfer::Result& result) {
-    self->handleMessageSent(result);
-    });
-}
-
-void Connection::handleMessageSent(const networking::SizedTransfer::Result& result) {
+void Connection::handleMessagesSent(const networking::SizedTransfer::Result& result) {
   if (!result) {
     handleError(result.exception());
     return;
   }
-  /* at this point, a message was successfully sent
+  /* at this point, the messages were successfully sent
    */
 
-  PEP_LOG(LogTag, Severity::Verbose) << "Connection:handleMessageSent: "
-    << "completed sending message to " << describe();
+  PEP_LOG(LogTag, Severity::Verbose) << "Connection:handleMessagesSent: "
+    << "completed sending " << *result << " bytes to " << describe();
 
-  /* free body */
-  messageOutBody_.reset();
+  /* free bodies */
+  messagesOutBodies_.clear();
   sendActive_ = false;
 
   lastSend_ = std::chrono::steady_clock::now();
@@ -226,11 +266,11 @@ void Connection::handleKeepAliveTimerExpired(const boost::system::error_code& er
 
   // set empty message
   messageOutHeader_ = MessageHeader::MakeForControlMessage().encode();
-  assert(messageOutBody_ == nullptr);
+  assert(messagesOutBodies_.empty());
 
   // send async
   binary_->asyncWrite(&messageOutHeader_, sizeof(messageOutHeader_), [self = SharedFrom(*this)](const networking::SizedTransfer::Result& result) {
-    self->handleMessageSent(result);
+    self->handleMessagesSent(result);
     });
 }
 
@@ -259,7 +299,7 @@ void Connection::handleMessageReceived(const networking::SizedTransfer::Result&
   }
 
   try {
-    auto header = MessageHeader::Decode(messageInHeader_);
+    auto header = MessageHeader::Decode(messageInHeader_, compressionNegotiated_);
     assert(*result == header.length());
     const auto& messageId = header.properties().messageId();
 
@@ -291,7 +331,9 @@ void Connection::handleMessageReceived(const networking::SizedTransfer::Result&
 std::string Connection::getReceivedMessageContent(const MessageHeader& header) {
   const auto& messageId = header.properties().messageId();
 
-  auto result = messageInBody_.substr(0U, header.length());
+  auto result = header.compressed()
+    ? MessageCompression::Decompress(std::string_view(messageInBody_).substr(0U, header.length()), MaxSizeOfMessage)
+    : messageInBody_.substr(0U, header.length());
 
   PEP_LOG(LogTag, Severity::Verbose) << "Incoming " << messageId.type().describe() << " ("
     << (result.size() >= sizeof(MessageMagic) ? DescribeMessageMagic(result) : "no valid message magic")
@@ -394,7 +436,13 @@ void Connection::IncomingRequestTail::handleChunk(const Flags& flags, std::share
   }
 }
 
-MessageBatches Connection::handleVersionRequest(std::shared_ptr<std::string> request [[maybe_unused]], MessageSequence chunks [[maybe_unused]] ) {
+MessageBatches Connection::handleVersionRequest(std::shared_ptr<std::string> request, MessageSequence chunks [[maybe_unused]] ) {
+  // The peer sends its VersionRequest before any other message, so we know whether we may (send and) receive compressed messages before we
+  // receive the first one. Other VersionRequests (e.g. sent by ServerProxy::requestVersion) don't withdraw an earlier announcement.
+  if (Serialization::FromString<VersionRequest>(*request, false).acceptsCompressedMessages) {
+    compressionNegotiated_ = true;
+  }
+
   VersionResponse response{ BinaryVersion::current, ConfigVersion::Current() };
   MessageSequence retval = rxcpp::observable<>::from(std::make_shared<std::string>(Serialization::ToString(response)));
   return rxcpp::observable<>::from(retval);
@@ -529,9 +577,10 @@ void Connection::clearState(bool reconnecting) {
   keepAliveTimerRunning_ = false;
   // Clear state for outgoing messages
   sendActive_ = false;
-  messageOutBody_.reset();
+  messagesOutBodies_.clear();
   // Clear state for incoming messages
   versionValidated_ = false;
+  compressionNegotiated_ = false;
 
   // Discard cached incoming requests
   prematureRequests_.clear();
@@ -567,7 +616,7 @@ void Connection::performVersionCheck() {
   // Keep instance alive until version check has been performed
   auto self = SharedFrom(*this);
 
-  this->sendRequest(MakeSharedCopy(Serialization::ToString(VersionRequest())), std::nullopt, true)
+  this->sendRequest(MakeSharedCopy(Serialization::ToString(VersionRequest{ .acceptsCompressedMessages = true })), std::nullopt, true)
     .map([](std::string_view response) {return Serialization::FromString<VersionResponse>(response); })
     .observe_on(ObserveOnAsio(ioContext_))
     .subscribe(
@@ -42,17 +42,18 @@ public:
 private:
   bool sendActive_ = false;
 
-  // helper buffer for output
+  // helper buffers for output: the headers and (small) bodies of the messages being sent are coalesced into
+  // messagesOutCoalesced_, while larger bodies are sent straight from the strings kept alive in messagesOutBodies_
   EncodedMessageHeader messageOutHeader_{};
-  std::shared_ptr<std::string> messageOutBody_;
+  std::string messagesOutCoalesced_;
+  std::vector<std::shared_ptr<std::string>> messagesOutBodies_;
 
   // buffer to read incoming messages
   EncodedMessageHeader messageInHeader_{};
   std::string messageInBody_;
 
-  // sending a message is in two stages: first sending a header, afterwards sending a body. These are completion handlers associated with them
-  void handleHeaderSent(const networking::SizedTransfer::Result& result);
-  void handleMessageSent(const networking::SizedTransfer::Result& result);
+  // all messages available from the scheduler (up to a byte budget) are sent with a single (gather) write. This is its completion handler
+  void handleMessagesSent(const networking::SizedTransfer::Result& result);
 
   // receiving a message is in two stages: first receiving a header, afterwards receiving a body. These are completion handlers associated with them
   void handleHeaderReceived(const networking::SizedTransfer::Result& result);
@@ -118,12 +119,13 @@ private:
 private:
   bool versionValidated_ = false;
   bool versionCheckScheduled_ = false;
+  bool compressionNegotiated_ = false; // set when the peer's VersionRequest announces that it accepts compressed messages
   std::optional<ExponentialBackoff> versionCheckBackoff_;
 
   void handleBinaryConnectionEstablished();
   void postponeVersionCheck();
   void performVersionCheck();
-  MessageBatches handleVersionRequest(std::shared_ptr<std::string> request [[maybe_unused]], MessageSequence chunks [[maybe_unused]]);
+  MessageBatches handleVersionRequest(std::shared_ptr<std::string> request, MessageSequence chunks [[maybe_unused]]);
   void handleVersionResponse(const VersionResponse& response);
 
   // ******************** Miscellaneous ********************
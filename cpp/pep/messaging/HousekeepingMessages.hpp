@@ -6,7 +6,9 @@
 
 namespace pep {
 
-struct VersionRequest {};
+struct VersionRequest {
+  bool acceptsCompressedMessages = false;
+};
 
 struct VersionResponse {
   BinaryVersion binary;
@@ -0,0 +1,134 @@
+#include <pep/messaging/MessageCompression.hpp>
+
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include <array>
+#include <cassert>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace pep::messaging {
+
+namespace {
+
+// Compression must be considerably cheaper than sending the bytes it saves
+const auto CompressionLevel = boost::iostreams::zlib::best_speed;
+
+// A message type is considered incompressible if compression saves less than 1/MinSavingsDivisor of a body
+constexpr size_t MinSavingsDivisor = 16;
+
+// Number of messages of an incompressible type that are sent uncompressed before we try to compress one again
+constexpr uint32_t SkipAfterIncompressible = 64;
+
+struct TypeState {
+  uint32_t skip = 0;
+  MessageCompression::Savings savings;
+};
+
+class TypeStates {
+private:
+  std::mutex mutex_;
+  std::unordered_map<MessageMagic, TypeState> states_;
+
+public:
+  // Returns the registered magic of the body, or 0 for bodies that are not (recognized as) messages
+  static MessageMagic GetMagic(std::string_view body) {
+    assert(body.size() >= sizeof(MessageMagic));
+    auto magic = GetMessageMagic(body);
+    return BasicMessageMagician::DescribeMessageMagic(magic).has_value() ? magic : 0U;
+  }
+
+  bool shouldTry(MessageMagic magic) {
+    std::lock_guard lock(mutex_);
+    auto& state = states_[magic];
+    if (state.skip == 0U) {
+      return true;
+    }
+    --state.skip;
+    return false;
+  }
+
+  void recordIncompressible(MessageMagic magic) {
+    std::lock_guard lock(mutex_);
+    states_[magic].skip = SkipAfterIncompressible;
+  }
+
+  void recordCompressed(MessageMagic magic, size_t uncompressed, size_t compressed) {
+    std::lock_guard lock(mutex_);
+    auto& savings = states_[magic].savings;
+    ++savings.messages;
+    savings.uncompressedBytes += uncompressed;
+    savings.compressedBytes += compressed;
+  }
+
+  std::map<std::string, MessageCompression::Savings> getSavings() {
+    std::map<std::string, MessageCompression::Savings> result;
+    std::lock_guard lock(mutex_);
+    for (const auto& [magic, state] : states_) {
+      if (state.savings.messages != 0U) {
+        result.emplace(magic == 0U ? "unknown" : DescribeMessageMagic(magic), state.savings);
+      }
+    }
+    return result;
+  }
+};
+
+TypeStates& GetTypeStates() {
+  static TypeStates result;
+  return result;
+}
+
+}
+
+std::optional<std::string> MessageCompression::TryCompress(std::string_view body) {
+  if (body.size() < MinBodySize) {
+    return std::nullopt;
+  }
+  auto& states = GetTypeStates();
+  auto magic = TypeStates::GetMagic(body);
+  if (!states.shouldTry(magic)) {
+    return std::nullopt;
+  }
+
+  std::string result;
+  result.reserve(body.size() / 2U);
+  {
+    boost::iostreams::filtering_ostream out;
+    out.push(boost::iostreams::zlib_compressor(boost::iostreams::zlib_params(CompressionLevel)));
+    out.push(boost::iostreams::back_inserter(result));
+    out.write(body.data(), static_cast<std::streamsize>(body.size()));
+  } // Destruction flushes the compressor into the result
+
+  if (result.size() > body.size() - body.size() / MinSavingsDivisor) {
+    states.recordIncompressible(magic);
+    return std::nullopt;
+  }
+  states.recordCompressed(magic, body.size(), result.size());
+  return result;
+}
+
+std::string MessageCompression::Decompress(std::string_view compressed, size_t maxSize) {
+  boost::iostreams::filtering_istreambuf in;
+  in.push(boost::iostreams::zlib_decompressor());
+  in.push(boost::iostreams::array_source(compressed.data(), compressed.size()));
+
+  std::string result;
+  std::array<char, 64 * 1024> buffer{};
+  for (auto read = boost::iostreams::read(in, buffer.data(), buffer.size()); read > 0; read = boost::iostreams::read(in, buffer.data(), buffer.size())) {
+    if (result.size() + static_cast<size_t>(read) > maxSize) {
+      throw std::runtime_error("Decompressed message would exceed " + std::to_string(maxSize) + " bytes");
+    }
+    result.append(buffer.data(), static_cast<size_t>(read));
+  }
+  return result;
+}
+
+std::map<std::string, MessageCompression::Savings> MessageCompression::GetSavings() {
+  return GetTypeStates().getSavings();
+}
+
+}
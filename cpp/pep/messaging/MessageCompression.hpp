@@ -0,0 +1,44 @@
+#pragma once
+
+#include <pep/serialization/MessageMagic.hpp>
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace pep::messaging {
+
+/// \brief (zlib) compression of message bodies, for use on connections that negotiated it during their version check.
+/// \remark Keeps track of the compressibility of every message type. Types whose bodies don't compress (well), such as
+///         encrypted page data, are then skipped for a while to avoid wasting CPU time on them.
+class MessageCompression {
+public:
+  /// \brief Bodies smaller than this aren't worth compressing.
+  static constexpr size_t MinBodySize = 1024;
+
+  /// \brief Bytes saved by compressing the bodies of a single message type.
+  struct Savings {
+    uint64_t messages = 0; ///< Number of compressed messages
+    uint64_t uncompressedBytes = 0; ///< Size of those messages' bodies before compression
+    uint64_t compressedBytes = 0; ///< Size of those messages' bodies after compression
+  };
+
+  /// \brief Compresses a message body if that is worthwhile.
+  /// \param body The (serialized) message body.
+  /// \return The compressed body, or std::nullopt if the body should be sent uncompressed.
+  static std::optional<std::string> TryCompress(std::string_view body);
+
+  /// \brief Decompresses a message body produced by TryCompress.
+  /// \param compressed The compressed message body.
+  /// \param maxSize The maximum size of the decompressed body.
+  /// \return The decompressed message body.
+  /// \remark Throws if the data cannot be decompressed or would exceed maxSize bytes.
+  static std::string Decompress(std::string_view compressed, size_t maxSize);
+
+  /// \brief Returns the bytes saved by compression (in this process) so far, keyed by message type.
+  static std::map<std::string, Savings> GetSavings();
+};
+
+}
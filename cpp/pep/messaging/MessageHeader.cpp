@@ -26,12 +26,18 @@ const double NetMessageCapacityFactor = 1 - SerializationCapacityOverheadFactor;
 const size_t NetMessageCapacity = static_cast<size_t>(NetMessageCapacityFactor * MaxSizeOfMessage);
 
 
-MessageHeader::MessageHeader(MessageLength length, MessageProperties properties)
-  : length_(length), properties_(properties) {
+MessageHeader::MessageHeader(MessageLength length, MessageProperties properties, bool compressed)
+  : length_(length), properties_(properties), compressed_(compressed) {
   if (properties_.messageId().type().value() == MessageType::Control) {
     if (length_ != 0U) {
       throw std::runtime_error(std::format("Control messages must have zero length, length is {}", length_));
     }
+    if (compressed_) {
+      throw std::runtime_error("Control messages cannot be compressed");
+    }
+  }
+  if (compressed_ && (properties_.messageId().streamId().value() & detail::encoding_layout::CompressedBit)) {
+    throw std::runtime_error(std::format("Stream ID {} cannot be combined with the compressed bit", properties_.messageId().streamId().value()));
   }
 }
 
@@ -46,12 +52,17 @@ MessageHeader MessageHeader::MakeForControlMessage() noexcept {
 EncodedMessageHeader MessageHeader::encode() const noexcept {
   return EncodedMessageHeader{
     .length = htonl(length_),
-    .properties = htonl(properties_.encode())
+    .properties = htonl(properties_.encode() | (compressed_ ? detail::encoding_layout::CompressedBit : 0U))
   };
 }
 
-MessageHeader MessageHeader::Decode(const EncodedMessageHeader& encoded) {
-  return MessageHeader(ntohl(encoded.length), ntohl(encoded.properties));
+MessageHeader MessageHeader::Decode(const EncodedMessageHeader& encoded, bool compressionNegotiated) {
+  auto length = ntohl(encoded.length);
+  auto properties = ntohl(encoded.properties);
+  if (compressionNegotiated && (properties & detail::encoding_layout::CompressedBit)) {
+    return MessageHeader(length, MessageProperties::DecodeFrom(properties & ~detail::encoding_layout::CompressedBit), true);
+  }
+  return MessageHeader(length, properties);
 }
 
 }
@@ -32,20 +32,26 @@ static_assert(sizeof(EncodedMessageHeader) == sizeof(EncodedMessageHeader::lengt
 class MessageHeader {
 public:
 
-  MessageHeader(MessageLength length, MessageProperties properties);
+  MessageHeader(MessageLength length, MessageProperties properties, bool compressed = false);
   MessageHeader(MessageLength length, EncodedMessageProperties properties); // parameters in host (hardware) order, e.g. little endian on x86_64
 
   static MessageHeader MakeForControlMessage() noexcept;
 
   MessageLength length() const noexcept { return length_; }
   const MessageProperties& properties() const noexcept { return properties_; }
+  bool compressed() const noexcept { return compressed_; } ///< Whether the message body is compressed: see MessageCompression
 
   EncodedMessageHeader encode() const noexcept;
-  static MessageHeader Decode(const EncodedMessageHeader& encoded);
+  /// \brief Decodes a header received from a peer
+  /// \param encoded The header as it was received
+  /// \param compressionNegotiated Whether compression has been negotiated with the peer, i.e. whether the peer may have set the "compressed" bit.
+  ///        Otherwise that bit is considered part of the stream ID.
+  static MessageHeader Decode(const EncodedMessageHeader& encoded, bool compressionNegotiated = false);
 
 private:
   MessageLength length_;
   MessageProperties properties_;
+  bool compressed_ = false;
 };
 
 }
@@ -96,7 +96,7 @@ StreamId StreamId::BeforeFirst() noexcept {
 
 StreamId StreamId::MakeNext(const StreamId& previous) noexcept {
   static_assert(ControlStreamId == 0U, "We roll over to 1, so that we skip over the control stream id");
-  constexpr auto maxStreamId = encoding_layout::StreamIdBits;
+  constexpr auto maxStreamId = encoding_layout::StreamIdBits & ~encoding_layout::CompressedBit;
   return StreamId((previous.value() != maxStreamId) ? previous.value() + 1U : 1U);
 }
 
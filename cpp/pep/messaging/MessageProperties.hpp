@@ -21,6 +21,11 @@ constexpr EncodedMessageProperties TypeBits = 0b1000U << (32 - 4); // single hig
 constexpr EncodedMessageProperties FlagBits = 0b0111U << (32 - 4); // (the next-highest) three bits for state-related flags
 constexpr EncodedMessageProperties StreamIdBits = ~(TypeBits | FlagBits); // remaining bits for a unique (serial) number for every request+response cycle
 
+// The highest stream ID bit doubles as a "compressed" flag on connections that negotiated message compression (see MessageHeader).
+// We never use this bit for our own stream IDs, but (older) peers that don't support compression may.
+constexpr EncodedMessageProperties CompressedBit = 0b1000U << (32 - 8);
+static_assert(CompressedBit == (StreamIdBits + 1U) >> 1, "The compressed bit is the highest stream ID bit");
+
 } // namespace detail::encoding_layout
 
 // The (single) high bit in EncodedMessageProperties indicates message type
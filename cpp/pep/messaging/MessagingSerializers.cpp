@@ -44,6 +44,14 @@ void Serializer<PingResponse>::moveIntoProtocolBuffer(proto::PingResponse& dest,
   Serialization::MoveIntoProtocolBuffer(*dest.mutable_timestamp(), value.timestamp_);
 }
 
+VersionRequest Serializer<VersionRequest>::fromProtocolBuffer(proto::VersionRequest&& source) const {
+  return VersionRequest{ source.accepts_compressed_messages() };
+}
+
+void Serializer<VersionRequest>::moveIntoProtocolBuffer(proto::VersionRequest& dest, VersionRequest value) const {
+  dest.set_accepts_compressed_messages(value.acceptsCompressedMessages);
+}
+
 VersionResponse Serializer<VersionResponse>::fromProtocolBuffer(proto::VersionResponse&& source) const {
   std::optional<ConfigVersion> config;
   if (source.has_config_version()) {
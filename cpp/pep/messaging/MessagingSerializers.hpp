@@ -11,7 +11,7 @@ PEP_DEFINE_CODED_SERIALIZER(PingRequest);
 PEP_DEFINE_CODED_SERIALIZER(PingResponse);
 PEP_DEFINE_SIGNED_SERIALIZATION(PingResponse);
 
-PEP_DEFINE_EMPTY_SERIALIZER(VersionRequest);
+PEP_DEFINE_CODED_SERIALIZER(VersionRequest);
 PEP_DEFINE_CODED_SERIALIZER(VersionResponse);
 
 }
@@ -78,6 +78,11 @@ Scheduler::OutgoingMessage Scheduler::pop() {
   return result;
 }
 
+const Scheduler::OutgoingMessage& Scheduler::peek() const {
+  assert(!outgoing_.empty());
+  return outgoing_.front();
+}
+
 bool Scheduler::available() const noexcept {
   return !outgoing_.empty();
 }
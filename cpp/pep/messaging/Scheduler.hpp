@@ -46,6 +46,11 @@ public:
   /// \remark only call when the "available" method returns TRUE.
   OutgoingMessage pop();
 
+  /// \brief Provides the message that "pop" would return, without removing it from the queue(-like interface)
+  /// \return the message to be sent next
+  /// \remark only call when the "available" method returns TRUE.
+  const OutgoingMessage& peek() const;
+
   /// \brief Determines if there's at least one message ready to be sent.
   /// \return TRUE if there's a message ready to be sent; FALSE if not
   /// \remark indicates whether the "pop" method may be invoked
@@ -0,0 +1,87 @@
+#include <pep/messaging/MessageCompression.hpp>
+#include <pep/messaging/MessageHeader.hpp>
+#include <pep/messaging/MessagingSerializers.hpp>
+#include <pep/utils/Bitpacking.hpp>
+#include <pep/utils/Random.hpp>
+
+#include <gtest/gtest.h>
+
+namespace pep::messaging {
+namespace {
+
+std::string MakeCompressibleBody(size_t size) {
+  std::string result;
+  while (result.size() < size) {
+    result += "column1,column2,column3\n";
+  }
+  result.resize(size);
+  return result;
+}
+
+TEST(MessageCompression, RoundTrip) {
+  auto body = MakeCompressibleBody(64 * 1024);
+  auto compressed = MessageCompression::TryCompress(body);
+  ASSERT_TRUE(compressed.has_value());
+  EXPECT_LT(compressed->size(), body.size() / 4);
+  EXPECT_EQ(MessageCompression::Decompress(*compressed, body.size()), body);
+}
+
+TEST(MessageCompression, SkipsSmallBodies) {
+  EXPECT_FALSE(MessageCompression::TryCompress(MakeCompressibleBody(MessageCompression::MinBodySize - 1U)).has_value());
+}
+
+TEST(MessageCompression, SkipsIncompressibleTypes) {
+  // Use a (registered) message type that no other test uses, since this test affects the way its bodies are compressed
+  auto magic = PackUint32BE(MessageMagician<PingResponse>::GetMagic());
+  EXPECT_FALSE(MessageCompression::TryCompress(magic + RandomString(16 * 1024)).has_value());
+  // Subsequent bodies of this type aren't compressed, even if they could be
+  EXPECT_FALSE(MessageCompression::TryCompress(magic + MakeCompressibleBody(16 * 1024)).has_value());
+  // ...while those of other types still are
+  EXPECT_TRUE(MessageCompression::TryCompress(MakeCompressibleBody(16 * 1024)).has_value());
+}
+
+TEST(MessageCompression, RecordsSavings) {
+  auto before = MessageCompression::GetSavings()["unknown"];
+  auto body = MakeCompressibleBody(8 * 1024);
+  auto compressed = MessageCompression::TryCompress(body);
+  ASSERT_TRUE(compressed.has_value());
+
+  auto after = MessageCompression::GetSavings()["unknown"];
+  EXPECT_EQ(after.messages, before.messages + 1U);
+  EXPECT_EQ(after.uncompressedBytes, before.uncompressedBytes + body.size());
+  EXPECT_EQ(after.compressedBytes, before.compressedBytes + compressed->size());
+}
+
+TEST(MessageCompression, DecompressRejectsOversizedResult) {
+  auto body = MakeCompressibleBody(64 * 1024);
+  auto compressed = MessageCompression::TryCompress(body);
+  ASSERT_TRUE(compressed.has_value());
+  EXPECT_ANY_THROW(MessageCompression::Decompress(*compressed, body.size() - 1U));
+}
+
+TEST(MessageCompression, DecompressRejectsCorruptData) {
+  EXPECT_ANY_THROW(MessageCompression::Decompress("this is not zlib data", 1024));
+}
+
+TEST(MessageCompression, HeaderFlag) {
+  MessageProperties properties(MessageId(MessageType::Request, StreamId(12345U)), Flags::ClosingPayload);
+  auto encoded = MessageHeader(100U, properties, true).encode();
+
+  auto negotiated = MessageHeader::Decode(encoded, true);
+  EXPECT_TRUE(negotiated.compressed());
+  EXPECT_EQ(negotiated.length(), 100U);
+  EXPECT_EQ(negotiated.properties().encode(), properties.encode());
+
+  // Without negotiation, the bit is part of the (legacy) stream ID
+  auto legacy = MessageHeader::Decode(encoded);
+  EXPECT_FALSE(legacy.compressed());
+  EXPECT_NE(legacy.properties().messageId().streamId(), properties.messageId().streamId());
+}
+
+TEST(MessageCompression, OwnStreamIdsExcludeCompressedBit) {
+  auto last = StreamId(detail::encoding_layout::CompressedBit - 1U);
+  EXPECT_EQ(StreamId::MakeNext(last).value(), 1U);
+}
+
+}
+}
@@ -63,4 +63,10 @@ void Connection::asyncWrite(const void* source, size_t bytes, const SizedTransfe
   }
 }
 
+void Connection::asyncGatherWrite(std::vector<std::string_view> sources, const SizedTransfer::Handler& onTransferred) {
+  if (auto socket = this->getSocketOrNotifyTransferFailure(onTransferred)) {
+    socket->asyncGatherWrite(std::move(sources), onTransferred);
+  }
+}
+
 }
@@ -48,6 +48,9 @@ public:
 
   /// \copydoc Transport::asyncWrite
   void asyncWrite(const void* source, size_t bytes, const SizedTransfer::Handler& onTransferred) override;
+
+  /// \copydoc Transport::asyncGatherWrite
+  void asyncGatherWrite(std::vector<std::string_view> sources, const SizedTransfer::Handler& onTransferred) override;
 };
 
 }
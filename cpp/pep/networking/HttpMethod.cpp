@@ -10,6 +10,7 @@ const boost::bimap<HttpMethod::Value, std::string> HTTP_METHOD_STRING_MAPPINGS =
   result.insert({ HttpMethod::Get, "GET" });
   result.insert({ HttpMethod::Post, "POST" });
   result.insert({ HttpMethod::Put, "PUT" });
+  result.insert({ HttpMethod::Delete, "DELETE" });
   return result;
   }();
 
@@ -14,7 +14,8 @@ public:
   enum Value {
     Get,
     Post,
-    Put
+    Put,
+    Delete
   };
 
   /// \brief Constructor.
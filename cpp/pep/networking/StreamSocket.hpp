@@ -1,6 +1,8 @@
 #pragma once
 
 #include <functional>
+#include <vector>
+#include <boost/asio/buffer.hpp>
 #include <boost/asio/read.hpp>
 #include <boost/asio/read_until.hpp>
 #include <boost/asio/streambuf.hpp>
@@ -17,6 +19,7 @@ private:
   std::function<void(void*, size_t, const Handler&)> asyncRead_;
   std::function<void(boost::asio::streambuf&, const char*, const Handler&)> asyncReadUntil_;
   std::function<void(const void*, size_t, const Handler&)> asyncWrite_;
+  std::function<void(std::vector<boost::asio::const_buffer>, const Handler&)> asyncGatherWrite_;
 
 public:
   /// \brief Constructs a new instance for the specified Boost stream socket.
@@ -27,7 +30,8 @@ public:
   explicit StreamSocket(TSocket& implementor)
     : asyncRead_([&implementor](void* buffer, size_t bytes, const Handler& handler) { boost::asio::async_read(implementor, boost::asio::buffer(buffer, bytes), boost::asio::transfer_exactly(bytes), handler); }),
     asyncReadUntil_([&implementor](boost::asio::streambuf& buffer, const char* delimiter, const Handler& handler) { boost::asio::async_read_until(implementor, buffer, delimiter, handler); }),
-    asyncWrite_([&implementor](const void* buffer, size_t bytes, const Handler& handler) { boost::asio::async_write(implementor, boost::asio::buffer(buffer, bytes), handler); }) {
+    asyncWrite_([&implementor](const void* buffer, size_t bytes, const Handler& handler) { boost::asio::async_write(implementor, boost::asio::buffer(buffer, bytes), handler); }),
+    asyncGatherWrite_([&implementor](std::vector<boost::asio::const_buffer> buffers, const Handler& handler) { boost::asio::async_write(implementor, std::move(buffers), handler); }) {
   }
 
   /// \brief Asynchronously reads (receives) data from the socket, placing it into a caller-provided buffer.
@@ -51,6 +55,13 @@ public:
   /// \param handler A callback function that's invoked when the data has been sent, or when the operation has failed.
   /// \remark Caller must ensure that the StreamSocket instance and the "buffer" parameter remain valid for the duration of the operation, i.e. until the "handler" has been invoked.
   void asyncWrite(const void* buffer, size_t bytes, const Handler& handler) { asyncWrite_(buffer, bytes, handler); }
+
+  /// \brief Asynchronously writes (sends) data from multiple caller-provided buffers to the socket, in a single operation.
+  /// \param buffers The buffers containing the data to send.
+  /// \param handler A callback function that's invoked when the data has been sent, or when the operation has failed.
+  /// \remark Caller must ensure that the StreamSocket instance and the memory referenced by the "buffers" remain valid for the duration of the operation, i.e. until the "handler" has been invoked.
+  /// \remark An SSL stream encrypts (at least) one record per buffer, so callers should combine small buffers before passing them to this method.
+  void asyncGatherWrite(std::vector<boost::asio::const_buffer> buffers, const Handler& handler) { asyncGatherWrite_(std::move(buffers), handler); }
 };
 
 }
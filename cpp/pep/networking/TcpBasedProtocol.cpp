@@ -111,6 +111,22 @@ void TcpBasedProtocol::Socket::asyncWrite(const void* source, size_t bytes, cons
     });
 }
 
+void TcpBasedProtocol::Socket::asyncGatherWrite(std::vector<std::string_view> sources, const SizedTransfer::Handler& onTransferred) {
+  size_t bytes = 0U;
+  std::vector<boost::asio::const_buffer> buffers;
+  buffers.reserve(sources.size());
+  for (auto source : sources) {
+    bytes += source.size();
+    buffers.emplace_back(source.data(), source.size());
+  }
+  this->startTransfer(pendingWriteBytes_, bytes);
+
+  this->streamSocket().asyncGatherWrite(std::move(buffers), [self = SharedFrom(*this), onTransferred](const boost::system::error_code& error, size_t bytes) {
+    self->onTransferComplete(self->pendingWriteBytes_, error, bytes);
+    onTransferred(BoostOperationResult(error, bytes));
+    });
+}
+
 TcpBasedProtocol::ClientComponent::ClientComponent(const ClientParameters& parameters)
   : Protocol::ClientComponent(parameters)
   , TcpBound(parameters.tcp())
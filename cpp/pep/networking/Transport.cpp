@@ -1,7 +1,28 @@
 #include <pep/networking/Transport.hpp>
 
+#include <memory>
+
 namespace pep::networking {
 
+namespace {
+
+void WriteSequentially(Transport& transport, std::shared_ptr<const std::vector<std::string_view>> sources, size_t index, size_t written, const SizedTransfer::Handler& onTransferred) {
+  if (index == sources->size()) {
+    onTransferred(SizedTransfer::Result::Success(written));
+    return;
+  }
+  auto source = (*sources)[index];
+  transport.asyncWrite(source.data(), source.size(), [&transport, sources, index, written, onTransferred](const SizedTransfer::Result& result) {
+    if (!result) {
+      onTransferred(result);
+      return;
+    }
+    WriteSequentially(transport, sources, index + 1U, written + *result, onTransferred);
+    });
+}
+
+}
+
 Transport::Transport() {
   lifeCycleStatusForwarding_ = LifeCycler::onStatusChange.subscribe([this](const StatusChange& change) {
     this->handleLifeCycleStatusChanged(change);
@@ -20,6 +41,10 @@ Transport::ConnectivityStatus Transport::setConnectivityStatus(ConnectivityStatu
   return static_cast<Transport::ConnectivityStatus>(this->setStatus(static_cast<Status>(status)));
 }
 
+void Transport::asyncGatherWrite(std::vector<std::string_view> sources, const SizedTransfer::Handler& onTransferred) {
+  WriteSequentially(*this, std::make_shared<const std::vector<std::string_view>>(std::move(sources)), 0U, 0U, onTransferred);
+}
+
 void Transport::handleLifeCycleStatusChanged(const StatusChange& change) const {
   ConnectivityChange converted{ static_cast<ConnectivityStatus>(change.previous), static_cast<ConnectivityStatus>(change.updated) };
   onConnectivityChange.notify(converted);
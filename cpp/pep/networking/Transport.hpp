@@ -5,6 +5,9 @@
 #include <pep/utils/EnumUtils.hpp>
 #include <boost/core/noncopyable.hpp>
 
+#include <string_view>
+#include <vector>
+
 namespace pep::networking {
 
 using SizedTransfer = OperationInvocation<size_t>;
@@ -87,6 +90,15 @@ public:
   /// \param onTransferred A function that will be invoked when the write action has completed or failed
   virtual void asyncWrite(const void* source, size_t bytes, const SizedTransfer::Handler& onTransferred) = 0;
 
+  /// \brief Asynchronously writes the concatenation of multiple memory regions to the Transport
+  /// \param sources The memory regions containing the data to be written. Caller must ensure that the memory (regions)
+  ///   remain valid until the callback function is invoked.
+  /// \param onTransferred A function that will be invoked when the write action has completed or failed. On success, it
+  ///   receives the total number of bytes written.
+  /// \remark The default implementation writes the regions one after the other using asyncWrite. Inheritors should
+  ///   override it if they can pass all regions to the underlying layer at once.
+  virtual void asyncGatherWrite(std::vector<std::string_view> sources, const SizedTransfer::Handler& onTransferred);
+
 protected:
   Transport();
 
@@ -16,7 +16,7 @@ public:
   }
 };
 
-void TestClientServerBasics(TestServerFactory& factory) {
+void TestClientServerBasics(TestServerFactory& factory, bool gather = false) {
   constexpr size_t MessageSize = 1024;
 
   boost::asio::io_context context;
@@ -31,7 +31,7 @@ void TestClientServerBasics(TestServerFactory& factory) {
   auto server = pep::networking::Server::Create(*serverParameters);
   auto started = pep::MakeSharedCopy(false), stopped = pep::MakeSharedCopy(false);
   auto serverConnectionAttempt = std::make_shared<pep::EventSubscription>();
-  *serverConnectionAttempt = server->onConnectionAttempt.subscribe([MessageSize, sent, server, serverConnectionAttempt, started, stopped, protocol](const pep::networking::Connection::Attempt::Result& result) {
+  *serverConnectionAttempt = server->onConnectionAttempt.subscribe([MessageSize, sent, gather, server, serverConnectionAttempt, started, stopped, protocol](const pep::networking::Connection::Attempt::Result& result) {
     ASSERT_FALSE(*started) << protocol << " server produced multiple ConnectResults";
     *started = true;
 
@@ -49,7 +49,7 @@ void TestClientServerBasics(TestServerFactory& factory) {
     ASSERT_TRUE(connection->isConnected()) << protocol << " server produced non-connected connection";
     ASSERT_FALSE(*stopped) << protocol << " server cannot be stopped multiple times";
 
-    connection->asyncWrite(sent->data(), MessageSize, [MessageSize, server, serverConnectionAttempt, stopped, protocol, connection](const pep::networking::SizedTransfer::Result& result) {
+    auto onWritten = [MessageSize, server, serverConnectionAttempt, stopped, protocol, connection](const pep::networking::SizedTransfer::Result& result) {
       ASSERT_FALSE(*stopped) << protocol << " server cannot be stopped multiple times";
       // Ensure that our server stops (and hence the process exits) even if a test assertion (below) fails
       serverConnectionAttempt->cancel();
@@ -58,7 +58,15 @@ void TestClientServerBasics(TestServerFactory& factory) {
 
       ASSERT_TRUE(result) << protocol << " async write produced an error: " << pep::GetExceptionMessage(result.exception());
       ASSERT_EQ(MessageSize, *result) << protocol << " async write didn't write expected number of bytes";
-      });
+      };
+    if (gather) {
+      // Write the message in (unequally sized) parts, including an empty one
+      std::string_view whole(*sent);
+      connection->asyncGatherWrite({ whole.substr(0, 100), whole.substr(100, 0), whole.substr(100, 900), whole.substr(1000) }, onWritten);
+    }
+    else {
+      connection->asyncWrite(sent->data(), MessageSize, onWritten);
+    }
     });
   server->start();
 
@@ -103,3 +111,13 @@ TEST_F(ClientServer, Tls) {
   TlsTestServerFactory factory;
   TestClientServerBasics(factory);
 }
+
+TEST_F(ClientServer, TcpGatherWrite) {
+  TcpTestServerFactory factory;
+  TestClientServerBasics(factory, true);
+}
+
+TEST_F(ClientServer, TlsGatherWrite) {
+  TlsTestServerFactory factory;
+  TestClientServerBasics(factory, true);
+}
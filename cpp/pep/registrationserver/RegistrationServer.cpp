@@ -12,6 +12,7 @@
 #include <pep/async/RxToUnorderedMap.hpp>
 #include <pep/structure/ShortPseudonyms.hpp>
 #include <pep/auth/EnrolledParty.hpp>
+#include <pep/database/StorageProfile.PropertySerializer.hpp>
 #include <pep/registrationserver/RegistrationServerSerializers.hpp>
 #include <pep/networking/EndPoint.PropertySerializer.hpp>
 #include <pep/morphing/MorphingPropertySerializers.hpp>
@@ -98,23 +99,32 @@ int ParseSqliteSelectCountResult(void *pArg, int argc, char **argv, char **colum
 class RegistrationServer::ShortPseudonymCache : public std::enable_shared_from_this<ShortPseudonymCache> {
   friend class SharedConstructor<ShortPseudonymCache>;
 
+public:
+  /// Existing short pseudonyms (and participant identifiers), indexed so that duplicates can be detected without scanning them all
+  using Index = std::unordered_set<std::string>;
+
 private:
-  std::shared_ptr<RxCache<std::string>> rx_;
-  std::vector<std::string> local_;
+  std::shared_ptr<RxCache<std::shared_ptr<Index>>> rx_;
 
 private:
   ShortPseudonymCache(RegistrationServer& server, const std::filesystem::path& shadowStorageFile)
-    : rx_(CreateRxCache([&server, shadowStorageFile]() {return server.initPseudonymStorage(shadowStorageFile); })) {
+    : rx_(CreateRxCache([&server, shadowStorageFile]() {
+        return server.initPseudonymStorage(shadowStorageFile)
+          .reduce(std::make_shared<Index>(), [](std::shared_ptr<Index> index, std::string value) {
+            index->insert(std::move(value));
+            return index;
+          });
+      })) {
   }
 
 public:
-  void add(const std::string& localValue) { local_.push_back(localValue); }
-  rxcpp::observable<std::string> observe() const { return rx_->observe().concat(RxIterate(local_)); }
+  /// \brief Emits the (single) index, which is built once and then updated by the caller when it generates new short pseudonyms.
+  rxcpp::observable<std::shared_ptr<Index>> observe() const { return rx_->observe(); }
 
   static std::shared_ptr<ShortPseudonymCache> Create(RegistrationServer& server, const std::filesystem::path& shadowStorageFile) {
     auto result = std::shared_ptr<ShortPseudonymCache>(new ShortPseudonymCache(server, shadowStorageFile));
     result->rx_->observe().subscribe( // Ensure cache is populated immediately
-      [](const std::string&) {},
+      [](std::shared_ptr<Index>) {},
       [](std::exception_ptr) {} // Ignore errors during preloading: just let the cache recover when it is re-observed
     );
     return result;
@@ -128,6 +138,7 @@ RegistrationServer::Parameters::Parameters(std::shared_ptr<boost::asio::io_conte
 
   try {
     setShadowStorageFile(config.get<std::filesystem::path>("ShadowStorageFile"));
+    setShadowStorageProfile(config.get<std::optional<database::StorageProfile>>("ShadowStorageProfile").value_or(database::StorageProfile()));
     shadowPublicKeyFile = config.get<std::filesystem::path>("ShadowPublicKeyFile");
   }
   catch (std::exception& e) {
@@ -178,6 +189,15 @@ void RegistrationServer::Parameters::setShadowStorageFile(const std::filesystem:
   shadowStorageFile_ = std::filesystem::weakly_canonical(shadowStorageFile);
 }
 
+/// \return Connection settings for the shadow storage
+const database::StorageProfile& RegistrationServer::Parameters::getShadowStorageProfile() const {
+  return shadowStorageProfile_;
+}
+/// \param shadowStorageProfile Connection settings for the shadow storage
+void RegistrationServer::Parameters::setShadowStorageProfile(const database::StorageProfile& shadowStorageProfile) {
+  shadowStorageProfile_ = shadowStorageProfile;
+}
+
 /// \return Public key of the shadow storage
 const AsymmetricKey& RegistrationServer::Parameters::getShadowPublicKey() const {
   return shadowPublicKey_;
@@ -221,6 +241,15 @@ bool RegistrationServer::openDatabase(const std::filesystem::path& file) {
       throw std::runtime_error("Error opening SQLite database");
     }
 
+    // Apply the configured connection settings
+    for (const auto& pragma : shadowStorageProfile_.getPragmas(false)) {
+      err = sqlite3_exec(shadowStorage_, pragma.c_str(), nullptr, nullptr, nullptr);
+      if (err != SQLITE_OK) {
+        PEP_LOG(LogTag, Severity::Warning) << "Error executing \"" << pragma << "\": " << sqlite3_errmsg(shadowStorage_);
+        throw std::runtime_error("Error configuring SQLite database");
+      }
+    }
+
     // Create table if it does not exist yet
     err = sqlite3_exec(shadowStorage_, "CREATE TABLE IF NOT EXISTS `ShadowShortPseudonyms` (`EncryptedIdentifier`  BLOB, `EncryptedShortPseudonym`  BLOB);", nullptr, nullptr, nullptr);
     if (err != SQLITE_OK) {
@@ -400,6 +429,7 @@ RegistrationServer::RegistrationServer(std::shared_ptr<Parameters> parameters)
   : SigningServer(parameters),
   client_(parameters->getClient()),
   shadowPublicKey_(parameters->getShadowPublicKey()),
+  shadowStorageProfile_(parameters->getShadowStorageProfile()),
   globalConfiguration_(CreateRxCache([client = client_]() {return RxEnsureProgress(*client->getIoContext(), "Global configuration retrieval", client->getGlobalConfiguration()); })),
   shortPseudonyms_(ShortPseudonymCache::Create(*this, parameters->getShadowStorageFile())) // cannot get a shared_ptr<RegistrationServer> during construction
 #ifdef WITH_CASTOR
@@ -459,21 +489,10 @@ void RegistrationServer::storeShortPseudonymShadow(const std::string& encryptedI
 }
 
 rxcpp::observable<std::string> RegistrationServer::generatePseudonym(std::string prefix, std::size_t len) {
-  auto sp = GenerateShortPseudonym(prefix, len);
   return shortPseudonyms_->observe()
-    .map([sp](std::string existing) {return sp == existing; }) // Compare generated SP to each existing one
-    .filter([](bool exists) {return exists; }) // Only return a (TRUE) value if we generated a duplicate
-    .concat(rxcpp::observable<>::just(false)) // Append a default FALSE value: no, we didn't generate a duplicate
-    .first() // Determine if we generated a duplicate: either the initial TRUE if we generated it, or the trailing (default) FALSE if we didn't generate it
-    .flat_map([self = SharedFrom(*this), prefix, len, sp](bool duplicate) -> rxcpp::observable<std::string> { // Either return the generated SP or generate a new one
-    if (duplicate) {
-      return self->generatePseudonym(prefix, len);
-    } else {
-      self->shortPseudonyms_->add(sp);
-      return rxcpp::observable<>::just(sp).as_dynamic();
-    }
-  })
-    ;
+    .map([prefix, len](std::shared_ptr<ShortPseudonymCache::Index> existing) {
+    return GenerateUniqueShortPseudonym(prefix, len, *existing); // Also adds the SP to the index, so it won't be generated again
+  });
 }
 
 rxcpp::observable<ShortPseudonymDefinition> RegistrationServer::getShortPseudonymDefinitions() const {
@@ -2,6 +2,7 @@
 
 #include <pep/core-client/CoreClient_fwd.hpp>
 #include <pep/async/RxCache.hpp>
+#include <pep/database/StorageProfile.hpp>
 #include <pep/server/SigningServer.hpp>
 #include <pep/structure/GlobalConfiguration.hpp>
 #include <pep/registrationserver/RegistrationServerMessages.hpp>
@@ -44,6 +45,11 @@ class RegistrationServer : public SigningServer {
     /// \param shadowStorageFile Path to the shadow storage file
     void setShadowStorageFile(const std::filesystem::path& shadowStorageFile);
 
+    /// \return Connection settings for the shadow storage
+    const database::StorageProfile& getShadowStorageProfile() const;
+    /// \param shadowStorageProfile Connection settings for the shadow storage
+    void setShadowStorageProfile(const database::StorageProfile& shadowStorageProfile);
+
     /// \return Public key of the shadow storage
     const AsymmetricKey& getShadowPublicKey() const;
     /// \param shadowPublicKey Public key of the shadow storage
@@ -62,6 +68,7 @@ class RegistrationServer : public SigningServer {
    private:
     std::shared_ptr<CoreClient> client_;
     std::filesystem::path shadowStorageFile_;
+    database::StorageProfile shadowStorageProfile_;
     AsymmetricKey shadowPublicKey_;
 #ifdef WITH_CASTOR
     std::shared_ptr<castor::CastorConnection> castorConnection_;
@@ -89,6 +96,7 @@ private:
   ::sqlite3* shadowStorage_ = nullptr;
   std::shared_ptr<CoreClient> client_;
   AsymmetricKey shadowPublicKey_;
+  database::StorageProfile shadowStorageProfile_;
   std::shared_ptr<RxCache<std::shared_ptr<GlobalConfiguration>>> globalConfiguration_;
   std::shared_ptr<ShortPseudonymCache> shortPseudonyms_;
 #ifdef WITH_CASTOR
@@ -3,6 +3,8 @@
 #include <pep/rsk-pep/KeyDomain.hpp>
 #include <pep/utils/CollectionUtils.hpp>
 
+#include <stdexcept>
+
 using namespace pep;
 
 // Public interface: doc comments in declaration
@@ -64,6 +66,37 @@ void PseudonymTranslator::checkTranslationProof(
       verifiers);
 }
 
+std::optional<size_t> PseudonymTranslator::findInvalidTranslationProof(
+    std::span<const TranslationProofCheck> checks
+) const {
+  ScalarMultProof::BatchVerifier batch;
+  try {
+    for (const auto& check : checks) {
+      check.proof.addTo(
+          batch,
+          check.preTranslate.getValidElgamalEncryption(),
+          check.postTranslate.getValidElgamalEncryption(),
+          check.verifiers);
+    }
+    batch.verify();
+    return std::nullopt;
+  }
+  catch (const InvalidProof&) {
+    // Fall through: the batch cannot tell us which proof is invalid
+  }
+
+  for (size_t i = 0; i < checks.size(); ++i) {
+    try {
+      checkTranslationProof(checks[i].preTranslate, checks[i].postTranslate, checks[i].proof, checks[i].verifiers);
+    }
+    catch (const InvalidProof&) {
+      return i;
+    }
+  }
+  // Unreachable unless the batch check has a bug: a valid set of proofs always passes it
+  throw std::logic_error("Batch verification of translation proofs failed, but all proofs are valid");
+}
+
 CurveScalar PseudonymTranslator::generateKeyComponent(const RekeyRecipient& recipient) const {
   return rsk_.generateKeyComponent(
       rsk_.generateKeyFactor(recipient),
@@ -6,6 +6,8 @@
 #include <pep/rsk/Proofs.hpp>
 #include <pep/rsk/RskTranslator.hpp>
 
+#include <optional>
+#include <span>
 #include <utility>
 
 namespace pep {
@@ -71,6 +73,22 @@ public:
       const EncryptedLocalPseudonym& postTranslate,
       const RskProof& proof, const ReshuffleRekeyVerifiers& verifiers) const;
 
+  /// Input for \c findInvalidTranslationProof: the parameters of a single \c checkTranslationProof call
+  struct TranslationProofCheck {
+    const EncryptedPseudonym& preTranslate;
+    const EncryptedLocalPseudonym& postTranslate;
+    const RskProof& proof;
+    const ReshuffleRekeyVerifiers& verifiers;
+  };
+
+  /// Check multiple translation proofs at once, which is considerably faster than calling
+  /// \c checkTranslationProof for each of them
+  /// \param checks Translation proofs to check
+  /// \returns Index (into \p checks) of the first invalid proof, or \c std::nullopt if all proofs are valid
+  /// \throws std::invalid_argument for invalid pseudonym
+  [[nodiscard]] std::optional<size_t> findInvalidTranslationProof(
+      std::span<const TranslationProofCheck> checks) const;
+
   /// Generate a pseudonym encryption key component for \p recipient
   /// \returns Pseudonym encryption key component
   [[nodiscard]] CurveScalar generateKeyComponent(const RekeyRecipient& recipient) const;
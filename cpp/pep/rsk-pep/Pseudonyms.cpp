@@ -49,6 +49,10 @@ void LocalPseudonym::ensurePacked() const {
   point_.ensurePacked();
 }
 
+void LocalPseudonym::addPointsTo(std::vector<const CurvePoint*>& points) const {
+  points.push_back(&point_);
+}
+
 void LocalPseudonym::ensureThreadSafe() const {
   point_.ensureThreadSafe();
 }
@@ -94,6 +98,10 @@ void EncryptedPseudonym::ensurePacked() const {
   encryption_.ensurePacked();
 }
 
+void EncryptedPseudonym::addPointsTo(std::vector<const CurvePoint*>& points) const {
+  encryption_.addPointsTo(points);
+}
+
 void EncryptedPseudonym::ensureThreadSafe() const {
   encryption_.ensureThreadSafe();
 }
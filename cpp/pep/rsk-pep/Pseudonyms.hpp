@@ -7,6 +7,7 @@
 #include <functional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace pep {
 
@@ -53,6 +54,8 @@ public:
 
   /// Ensure we have a packed representation available
   void ensurePacked() const;
+  /// Add inner \c CurvePoint to \p points, to pack it using \c CurvePoint::PackBatch
+  void addPointsTo(std::vector<const CurvePoint*>& points) const;
   /// Ensure we have a packed and unpacked representation available
   void ensureThreadSafe() const;
 };
@@ -103,6 +106,8 @@ public:
 
   /// Ensure we have a packed representation available
   void ensurePacked() const;
+  /// Add inner \c CurvePoint s to \p points, to pack them using \c CurvePoint::PackBatch
+  void addPointsTo(std::vector<const CurvePoint*>& points) const;
   /// Ensure we have a packed and unpacked representation available
   void ensureThreadSafe() const;
 };
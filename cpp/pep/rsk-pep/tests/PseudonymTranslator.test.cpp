@@ -6,6 +6,7 @@
 
 #include <memory>
 #include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -89,4 +90,31 @@ TEST_F(PseudonymTranslatorTest, certifiedTranslate) {
   translateTest(true);
 }
 
+TEST_F(PseudonymTranslatorTest, findInvalidTranslationProof) {
+  const PseudonymTranslator::Recipient userA1(1, {.reshuffle = "GroupA", .rekey = "User1"});
+  const auto& translator = translators.front();
+  const auto verifiers = translator.computeTranslationProofVerifiers(userA1, masterPublicEncryptionKey);
+
+  std::vector<PolymorphicPseudonym> polymorphs;
+  std::vector<EncryptedLocalPseudonym> translated;
+  std::vector<RskProof> proofs;
+  for (unsigned i{}; i < 10; ++i) {
+    polymorphs.push_back(PolymorphicPseudonym::FromIdentifier(masterPublicEncryptionKey, "PEP" + std::to_string(i)));
+    auto [afterStep, proof] = translator.certifiedTranslateStep(polymorphs.back(), userA1);
+    translated.push_back(afterStep);
+    proofs.push_back(proof);
+  }
+
+  std::vector<PseudonymTranslator::TranslationProofCheck> checks;
+  for (size_t i{}; i < polymorphs.size(); ++i) {
+    checks.push_back({polymorphs[i], translated[i], proofs[i], verifiers});
+  }
+  EXPECT_EQ(translator.findInvalidTranslationProof(checks), std::nullopt);
+  EXPECT_EQ(translator.findInvalidTranslationProof({}), std::nullopt);
+
+  // Swap the proofs of two entries: both become invalid, the first one should be reported
+  std::swap(proofs[3], proofs[7]);
+  EXPECT_EQ(translator.findInvalidTranslationProof(checks), std::optional<size_t>{3});
+}
+
 }
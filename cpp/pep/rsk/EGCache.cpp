@@ -1,58 +1,69 @@
 #include <pep/rsk/EGCache.hpp>
 
-#include <pep/utils/Timestamp.hpp>
 #include <pep/utils/Log.hpp>
 #include <pep/utils/Singleton.hpp>
 
 #include <boost/core/noncopyable.hpp>
 #include <boost/functional/hash.hpp>
 
-#include <unordered_map>
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <mutex>
+#include <optional>
 #include <shared_mutex>
-#include <atomic>
+#include <unordered_map>
 
 // There are currently two caches:
 //
 //    - the precomputed scalar multiples tables cache (~30KB per entry)
 //    - RSK cache (<1KB per entry)
 //
-// Entries in the RSK cache contain shared_ptr to tables in the tables cache.
+// Both caches share a single memory budget (see EGCache::setMemoryBudget),
+// of which the RSK cache gets a small, fixed part.
 //
-// The caches are protected by read/write-locks (shared_mutex), that is,
-// multiple readers (shared_lock), but only wone writer (unique_lock).
-// Each cache contains a generation counter which is incremented on
-// every new entry.
-// If an entry is used, the current generation counter is recorded to the
-// entry.*  If a cache grows too big, the least recently used entries are
-// pruned.
+// Each cache is split into ShardCount shards, picked by the hash of the
+// key, so that threads working on different keys rarely touch the same lock.
+// Each shard is protected by a read/write-lock (shared_mutex).  Lookups
+// only take a shared_lock and write nothing but relaxed atomics, so that
+// readers never wait on one another, only (briefly) on a writer adding
+// an entry to the same shard.
+// (We would have preferred to let readers load an immutable snapshot of the
+// shard through a std::atomic<std::shared_ptr>, but that is not provided by
+// libc++, which we use for our Emscripten builds.)
 //
-// If a cache is pruned twice in a short period, the cache is disabled
-// altogether to prevent denail of service.
+// A shard has room for a fixed number of entries ("frames"), derived from
+// the memory budget, which are recycled using the CLOCK algorithm:
+// a lookup sets the "referenced" bit of the frame it hits, and to make
+// room for a new entry the clock hand sweeps over the frames, clearing their
+// referenced bits, until it finds a frame whose bit was already cleared.
+// The entry in that frame is evicted.  This approximates LRU, and, unlike
+// our previous scheme (that disabled a cache altogether when it had to be
+// pruned twice in a short while), a flood of distinct keys cannot make the
+// cache stop working for the keys that are actually in use.
 //
-// * We do not protect the generation counters of entries with additional
-// locks or a memory barriers.
-// This means that two updates of the generation counter of an entry are
-// synchronised only when the cache has been modified inbetween.
-// But if two updates happen between consecutive writes to the cache,
-// that is, within one generation, they update the counter to the same
-// value, and so synchronisation is not required anyways.
-// (Besides, the value of the entry's generation counter is used only
-// during pruning, when the write lock is held.)
+// Values are computed without holding a lock, so that computing a table
+// (~1ms) does not block lookups in the shard.  The caches hand out
+// shared_ptr's to their values, so that evicting an entry does not
+// invalidate a value that is still being used.  RSK entries do not keep
+// (a reference to) the table of their public key: they look it up in the
+// table cache on use.  This way every table is accounted for in the table
+// cache's memory use only.
 //
-// We did, however, make the entries' generation counters atomic, because
-// otherwise the lack of synchronisation between their updates
-// constitutes a data race and thus undefined behaviour,
-//   https://en.cppreference.com/w/cpp/language/memory_model .
-// This is not just a formality since compilers can (and do) optimise
-// on the assumption that undefined behaviour does not occur, see e.g.
-//   https://www.usenix.org/legacy/events/hotpar11/tech/final%5ffiles/Boehm.pdf
+// If a TableStore has been set, the table cache loads tables from it rather
+// than computing them, and stores a table in it when the table is requested
+// for the second time.  (Storing tables that are used only once would allow
+// a flood of distinct keys to fill the store with tables that are of no use
+// after a restart.)
 //
-// By default operations on atomics are synchronised by memory barriers,
-// but this can be disabled by passing std::memory_model_relaxed to the
-// "load" and "store" methods.
-
-using namespace std::literals;
+// The referenced bits and the metrics' counters are atomics, because
+// they are updated by threads holding only a shared_lock: otherwise the
+// lack of synchronisation between their updates would constitute a data
+// race and thus undefined behaviour,
+//   https://en.cppreference.com/w/cpp/language/memory_model .
+// Their operations do not need to be ordered with respect to other memory
+// operations, so we pass std::memory_order_relaxed to "load", "store"
+// and "fetch_add".
 
 namespace pep {
 
@@ -60,234 +71,204 @@ namespace {
 
 const std::string LogTag("EGCache");
 
+constexpr size_t ShardBits = 4;
+constexpr size_t ShardCount = size_t{1} << ShardBits;
+
+// The part of the memory budget that is assigned to the RSK cache.
+constexpr size_t RskBudgetDivisor = 16;
+
 class EGCacheImp
   : public StaticSingleton<EGCacheImp>, public EGCache,
     private boost::noncopyable
 {
 private:
   // The RSK and table cache share the following pattern.
-  template<typename Key, typename Value, typename Options,
-    typename KeyHash=std::hash<Key>>
+  template<typename Key, typename Value, typename KeyHash=std::hash<Key>>
   class Cache {
-    // The 'Options' type should have the following static members:
-    static_assert(std::is_same_v<decltype(Options::PrunedSize), const size_t>);
-    static_assert(std::is_same_v<decltype(Options::MaxSize), const size_t>);
-    static_assert(std::is_same_v<decltype(Options::Name), const char* const>);
-
-    // 'Value' should have a constructor with signature
-    //    Value(EGCacheImp* egcache, Key&& key)
-    // The EGCache is passed along, because RekeyValue needs to access
-    // the table cache.
-    static_assert(std::is_constructible_v<Value, EGCacheImp*, const Key&>);
-
-    // 'Value' should have an explicit operator bool that indicates whether
-    // it was constructed successfully.
-    // TODO: static_assert this.
-
-    class Entry {
-    private:
-      Value value_;
-      std::atomic_uint64_t lastUse_;
-
-    public:
-      Entry(EGCacheImp* egcache, const Key& key, uint64_t generation)
-        : value_(egcache, key), lastUse_(generation) {}
-
-      inline uint64_t getLastUse() const {
-        return lastUse_.load(std::memory_order_relaxed);
-      }
-
-      inline void updateLastUse(uint64_t generation) {
-        lastUse_.store(generation, std::memory_order_relaxed);
-      }
-
-      inline Value& getValue() {
-        return value_;
-      }
-
-      inline explicit operator bool() const {
-        return value_ ? true : false;
-      }
+    struct Frame {
+      std::optional<Key> key;
+      std::shared_ptr<Value> value;
+      std::atomic_bool referenced = false;
+      std::atomic_bool reused = false; // hit at least once
     };
 
-    std::shared_mutex mux_;
-    std::unordered_map<Key, Entry, KeyHash> data_;
-    uint64_t generation_ = 0;
-    std::atomic_uint64_t useCount_ = 0; // for metrics
-    steady_seconds
-        lastPrune_ = TimeNow<steady_seconds>(),
-        disabledAt_ = TimeNow<steady_seconds>();
-    bool enabled_ = true;
-
-    using iterator = typename decltype(data_)::iterator;
-
-    inline void incrementUseCount() {
-      useCount_.fetch_add(1, std::memory_order_relaxed);
-    }
+    // Approximate number of bytes that an entry occupies: its frame,
+    // its node in the index, and its value.
+    static constexpr size_t EntryBytes = sizeof(Frame)
+      + sizeof(Key) + sizeof(size_t) + 2 * sizeof(void*)
+      + sizeof(Value);
+
+    struct Shard {
+      std::shared_mutex mux;
+      std::unordered_map<Key, size_t, KeyHash> index; // to frame
+      std::vector<Frame> frames; // of which [0, index.size()) are in use
+      size_t hand = 0;
+      uint64_t added = 0;
+
+      // for metrics
+      std::atomic_uint64_t hits = 0;
+      std::atomic_uint64_t misses = 0;
+      std::atomic_uint64_t evictions = 0;
+    };
 
-    inline uint64_t getUseCount() {
-      return useCount_.load(std::memory_order_relaxed);
-    }
+    const char* name_;
+    std::array<Shard, ShardCount> shards_;
 
-    inline void disableUnderUniqueLock() {
-      assert(enabled_);
-      enabled_ = false;
-      disabledAt_ = TimeNow<steady_seconds>();
+    Shard& shardOf(const Key& key) {
+      // Mix the hash before taking its top bits, because the shard's
+      // unordered_map uses the (low bits of the) same hash.
+      auto hash = static_cast<uint64_t>(KeyHash{}(key)) * 0x9E3779B97F4A7C15ULL;
+      return shards_[static_cast<size_t>(hash >> (64 - ShardBits))];
     }
 
-    // if the cache is disabled, but the prune has cooled down,
-    // the cache is said to be enablable.
-    inline bool enabledOrEnablableUnderSharedLock() {
-      if (enabled_)
-        return true;
-      return TimeNow<steady_seconds>() - disabledAt_ >= Options::ReEnableTime;
-    }
+    // returns the value that is cached for the key afterwards
+    static std::shared_ptr<Value> InsertUnderUniqueLock(Shard& shard, const Key& key, std::shared_ptr<Value> value) {
+      assert(!shard.frames.empty());
 
-    inline bool pruneCooledDownUnderSharedLock() {
-      return TimeNow<steady_seconds>() - lastPrune_ >= Options::PruneCooldown;
+      // the key might have been added in the meantime
+      auto found = shard.index.find(key);
+      if (found != shard.index.end())
+        return shard.frames[found->second].value;
+
+      auto slot = shard.index.size();
+      if (slot == shard.frames.size())
+        slot = EvictUnderUniqueLock(shard);
+
+      auto& frame = shard.frames[slot];
+      frame.key = key;
+      frame.value = std::move(value);
+      // A new entry has to be hit before the clock hand sweeps past it
+      // to survive, so that keys that are used only once are evicted first.
+      frame.referenced.store(false, std::memory_order_relaxed);
+      frame.reused.store(false, std::memory_order_relaxed);
+      shard.index.emplace(key, slot);
+      ++shard.added;
+
+      return frame.value;
     }
 
-    // prune cache, which might disable it
-    void pruneUnderUniqueLock() {
-      assert(enabled_);
-      if (!this->pruneCooledDownUnderSharedLock()) {
-        PEP_LOG(LogTag, Severity::Warning)
-          << Options::Name
-          << " cache overflows a second time in a short while. "
-          << "Disabling " << Options::Name
-          << " cache to mitigate potential DoS.";
-          this->disableUnderUniqueLock();
-          return;
-      }
-
-      size_t toEvict = data_.size() - Options::PrunedSize;
-      std::vector<std::pair<uint64_t, Key>> entries;
-      entries.reserve(data_.size());
-      for (const auto& pair : data_)
-        entries.emplace_back(pair.second.getLastUse(), pair.first);
-      std::sort(entries.begin(), entries.end(),
-          [](auto& a, auto& b) { return a.first < b.first; });
-      for (size_t i = 0; i < toEvict; i++) {
-        data_.erase(entries[i].second);
+    // returns the index of the frame whose entry was evicted
+    static size_t EvictUnderUniqueLock(Shard& shard) {
+      assert(!shard.frames.empty());
+      while (true) {
+        auto current = shard.hand;
+        shard.hand = (shard.hand + 1) % shard.frames.size();
+        auto& frame = shard.frames[current];
+        if (frame.referenced.load(std::memory_order_relaxed)) {
+          frame.referenced.store(false, std::memory_order_relaxed);
+        }
+        else {
+          shard.index.erase(*frame.key);
+          shard.evictions.fetch_add(1, std::memory_order_relaxed);
+          return current;
+        }
       }
-
-      PEP_LOG(LogTag, Severity::Info) << "Pruned " << Options::Name << " cache down to "
-        << data_.size();
-      lastPrune_ = TimeNow<steady_seconds>();
     }
 
-    // adds entry associated with the given key, and returns
-    // an iterator to it.
-    std::optional<iterator> cacheUnderUniqueLock(
-        EGCacheImp* egcache, const Key& key) {
-
-      assert(data_.find(key) == data_.end());
-      assert(enabled_);
-
-      if (data_.size() >= Options::MaxSize) {
-        // since entries are added one by one:
-        assert(data_.size()==Options::MaxSize);
-        this->pruneUnderUniqueLock();
-
-        if (!enabled_)
-          return std::nullopt;
+  public:
+    explicit Cache(const char* name) : name_(name) {}
+
+    // get the value associated with key, which is computed (and cached)
+    // using compute() if needed.  Returns nullptr if the cache is disabled.
+    // Calls onFirstReuse(value) (without holding a lock) the first time
+    // that an entry is hit.
+    template<typename Compute, typename OnFirstReuse>
+    std::shared_ptr<Value> get(const Key& key, const Compute& compute, const OnFirstReuse& onFirstReuse) {
+      auto& shard = this->shardOf(key);
+      std::shared_ptr<Value> value;
+      bool firstReuse = false;
+      {
+        auto readLock = std::shared_lock(shard.mux);
+
+        if (shard.frames.empty())
+          return nullptr;
+
+        auto found = shard.index.find(key);
+        if (found != shard.index.end()) {
+          auto& frame = shard.frames[found->second];
+          // Avoid writing to the frame's cache line when the bits are already set
+          if (!frame.referenced.load(std::memory_order_relaxed))
+            frame.referenced.store(true, std::memory_order_relaxed);
+          if (!frame.reused.load(std::memory_order_relaxed))
+            firstReuse = !frame.reused.exchange(true, std::memory_order_relaxed);
+          shard.hits.fetch_add(1, std::memory_order_relaxed);
+          value = frame.value;
+        }
+      }
+      if (value != nullptr) {
+        if (firstReuse)
+          onFirstReuse(*value);
+        return value;
       }
 
+      shard.misses.fetch_add(1, std::memory_order_relaxed);
+      value = compute();
 
-      auto [it, inserted] = data_.emplace(
-          std::piecewise_construct,
-          std::make_tuple(key),
-          std::make_tuple(egcache, key, ++generation_));
-
-      assert(inserted);
-
-      if (!it->second) {
-        // Creation of the entry failed.  The creation of an RSK entry might
-        // fail, for example, when the table cache is disabled.
-        PEP_LOG(LogTag, Severity::Warning)
-          << "Failed to add entry to " << Options::Name << " cache; "
-            << "disabling. ";
-        data_.erase(it);
-        this->disableUnderUniqueLock();
-        return std::nullopt;
-      }
+      auto writeLock = std::unique_lock(shard.mux);
 
-      PEP_LOG(LogTag, Severity::Debug)
-        << "Entry added to " << Options::Name << " cache.  size: "
-        << data_.size()
-          << "; generation: " << generation_;
+      // the memory budget might have been changed in the meantime
+      if (shard.frames.empty())
+        return value;
 
-      return it;
+      return InsertUnderUniqueLock(shard, key, std::move(value));
     }
 
-    // get cache entry associated with key, if it exists
-    std::optional<iterator> getUnderSharedLock(const Key& key) {
-      auto it = data_.find(key);
-      if (it != data_.end()) {
-        it->second.updateLastUse(generation_);
-        this->incrementUseCount();
-        return it;
-      }
-      return std::nullopt;
+    template<typename Compute>
+    std::shared_ptr<Value> get(const Key& key, const Compute& compute) {
+      return this->get(key, compute, [](const Value&) {});
     }
 
-  public:
-    // get cache entry associated with key, which is created if needed,
-    // unless the cache is disabled.
-    std::optional<iterator> get(EGCacheImp* egcache, const Key& key) {
-      {
-        auto readLock = std::shared_lock(mux_);
-
-        auto it = this->getUnderSharedLock(key);
-
-        if (it)
-          return it;
-
-        if (!this->enabledOrEnablableUnderSharedLock())
-          return std::nullopt;
+    // caches the value for the key, unless the key is cached already
+    // or the cache is disabled.
+    void put(const Key& key, std::shared_ptr<Value> value) {
+      auto& shard = this->shardOf(key);
+      auto writeLock = std::unique_lock(shard.mux);
+      if (!shard.frames.empty())
+        InsertUnderUniqueLock(shard, key, std::move(value));
+    }
 
-        // key is not present, so we need to obtain a write lock to add it
+    // the number of entries that the cache has room for
+    size_t capacity() {
+      size_t result = 0;
+      for (auto& shard : shards_) {
+        auto readLock = std::shared_lock(shard.mux);
+        result += shard.frames.size();
       }
+      return result;
+    }
 
-      auto writeLock = std::unique_lock(mux_);
-
-      // the key might have been added in the meantime
-      auto it = this->getUnderSharedLock(key);
-
-      if (it)
-        return it;
-
-      // the cache might have been disabled in the meantime.
-      if (!this->enabledOrEnablableUnderSharedLock())
-        return std::nullopt;
-
-      // enable cache, if necessary
-      if (!enabled_) {
-        PEP_LOG(LogTag, Severity::Warning)
-          << "Re-enabling " << Options::Name
-          << " cache.";
-        enabled_ = true;
+    // Evicts all entries and resizes the shards to fit the given budget.
+    void setMemoryBudget(size_t bytes) {
+      auto framesPerShard = bytes / EntryBytes / ShardCount;
+      for (auto& shard : shards_) {
+        auto writeLock = std::unique_lock(shard.mux);
+        shard.index.clear();
+        shard.frames = std::vector<Frame>(framesPerShard);
+        shard.hand = 0;
       }
-
-      return this->cacheUnderUniqueLock(egcache, key);
+      PEP_LOG(LogTag, Severity::Info) << name_ << " cache has room for "
+        << framesPerShard << " entries in each of its " << ShardCount << " shards";
     }
 
     void fillMetrics(EGCache::Metrics::OfCache& metrics) {
-      // Acquire unique lock to force all relaxed atomic
-      // operations to materialize.
-      // (A shared_lock would have suffices as well, if we do not care
-      //  about accuracy.)
-      auto uniqueLock = std::unique_lock(mux_);
-
-      metrics.generation = generation_;
-      metrics.useCount = this->getUseCount();
+      metrics.shards.reserve(ShardCount);
+      for (auto& shard : shards_) {
+        auto readLock = std::shared_lock(shard.mux);
+        auto& ofShard = metrics.shards.emplace_back();
+        ofShard.hits = shard.hits.load(std::memory_order_relaxed);
+        ofShard.misses = shard.misses.load(std::memory_order_relaxed);
+        ofShard.evictions = shard.evictions.load(std::memory_order_relaxed);
+        ofShard.bytes = shard.index.size() * EntryBytes;
+        metrics.generation += shard.added;
+        metrics.useCount += ofShard.hits + ofShard.misses;
+      }
     }
   };
 
 
   // RSK Cache
   //
-  // Caches 1/k, k*y and (reference to) scalar multiplication table of y.
+  // Caches 1/k and k*y.
   // Used to speed up the ElgamalEncryption::rsk operation and
   // ElgamalEncryption::rekey operations.
   struct RekeyKey {
@@ -302,56 +283,30 @@ private:
   };
 
   struct RekeyValue {
-    RekeyValue(EGCacheImp* egcache, const RekeyKey& key);
-
-    ElgamalEncryption rsk(
-            const CurvePoint& b, const CurvePoint& c,
-            const ElgamalTranslationKey& reshuffle) const;
-    ElgamalEncryption rk(const CurvePoint& b, const CurvePoint& c) const;
+    RekeyValue(EGCacheImp& egcache, const RekeyKey& key);
 
     CurveScalar kInv;
     CurvePoint kY;
-    std::shared_ptr<CurvePoint::ScalarMultTable> yTable;
-
-    // returns whether the value was successfully initialized
-    inline explicit operator bool() const {
-      return yTable ? true : false;
-    }
   };
 
-  struct RSKOptions {
-    static constexpr size_t PrunedSize = 250;
-    static constexpr size_t MaxSize = 500;
-    static constexpr const char *Name = "RSK";
-    static constexpr auto PruneCooldown = 15min;
-    static constexpr auto ReEnableTime = 1h;
-  };
-
-  Cache<RekeyKey, RekeyValue, RSKOptions, RekeyKey::hash> rskCache_;
+  Cache<RekeyKey, RekeyValue, RekeyKey::hash> rskCache_{"RSK"};
 
   // Scalar multiplication (table) cache
-  struct TableValue {
-    TableValue(EGCacheImp* egcache, const CurvePoint& p);
-    std::shared_ptr<CurvePoint::ScalarMultTable> table_;
+  Cache<CurvePoint, CurvePoint::ScalarMultTable> tableCache_{"Table"};
 
-    // creation of a TableValue, unlike RSKValue, always succeeds
-    inline explicit operator bool() const { return true; }
-  };
+  std::mutex tableStoreMux_;
+  std::shared_ptr<TableStore> tableStore_;
 
-  struct TableOptions {
-    static constexpr size_t PrunedSize = 750;
-    static constexpr size_t MaxSize = 1000;
-    static constexpr const char *Name = "Table";
-    static constexpr auto PruneCooldown = 15min;
-    static constexpr auto ReEnableTime = 1h;
-  };
-
-  static_assert(TableOptions::PrunedSize > RSKOptions::MaxSize,
-      "Every RSK cache entry may block a table cache entry");
+  std::shared_ptr<TableStore> getTableStore();
 
-  Cache<CurvePoint, TableValue, TableOptions> tableCache_;
+  // returns r * y, using the cached table for y if there is one
+  CurvePoint tableMult(const CurvePoint& y, const CurveScalar& r);
 
  public:
+  EGCacheImp() {
+    this->setMemoryBudget(DefaultMemoryBudget);
+  }
+
   ElgamalEncryption rsk(
     const ElgamalEncryption& eg,
     const CurveScalar& reshuffle,
@@ -370,6 +325,10 @@ private:
   std::shared_ptr<CurvePoint::ScalarMultTable>
   scalarMultTable(const CurvePoint& b) override;
 
+  void setMemoryBudget(size_t bytes) override;
+
+  void setTableStore(std::shared_ptr<TableStore> store) override;
+
   EGCache::Metrics getMetrics() override;
 
   using StaticSingleton<EGCacheImp>::Instance;
@@ -384,13 +343,52 @@ EGCache& EGCache::get() {
 
 std::shared_ptr<CurvePoint::ScalarMultTable>
 EGCacheImp::scalarMultTable(const CurvePoint& b) {
+  return tableCache_.get(b,
+    [this, &b] {
+      if (auto store = this->getTableStore()) {
+        if (auto table = store->load(b))
+          return table;
+      }
+      return std::make_shared<CurvePoint::ScalarMultTable>(b);
+    },
+    [this, &b](const CurvePoint::ScalarMultTable& table) {
+      if (auto store = this->getTableStore())
+        store->store(b, table);
+    });
+}
+
+std::shared_ptr<EGCache::TableStore> EGCacheImp::getTableStore() {
+  std::lock_guard lock(tableStoreMux_);
+  return tableStore_;
+}
 
-  auto optional_it = tableCache_.get(this, b);
+void EGCacheImp::setTableStore(std::shared_ptr<TableStore> store) {
+  {
+    std::lock_guard lock(tableStoreMux_);
+    tableStore_ = store;
+  }
+  if (store == nullptr)
+    return;
 
-  if (!optional_it)
-    return nullptr;
+  // Fill the table cache with the most recently stored tables
+  auto points = store->points();
+  auto count = std::min(points.size(), tableCache_.capacity());
+  size_t loaded = 0;
+  for (auto i = points.size() - count; i < points.size(); i++) {
+    if (auto table = store->load(points[i])) {
+      tableCache_.put(points[i], std::move(table));
+      ++loaded;
+    }
+  }
+  PEP_LOG(LogTag, Severity::Info) << "Loaded " << loaded << " of "
+    << points.size() << " stored tables into the Table cache";
+}
 
-  return (*optional_it)->second.getValue().table_;
+CurvePoint EGCacheImp::tableMult(const CurvePoint& y, const CurveScalar& r) {
+  auto table = this->scalarMultTable(y);
+  if (table == nullptr)
+    return r * y;
+  return table->mult(r);
 }
 
 ElgamalEncryption EGCacheImp::rsk(
@@ -400,16 +398,22 @@ ElgamalEncryption EGCacheImp::rsk(
 
   auto key = RekeyKey(rekey, eg.publicKey);
 
-  auto opt_it = rskCache_.get(this, key);
+  auto value = rskCache_.get(key, [this, &key] {
+    return std::make_shared<RekeyValue>(*this, key);
+  });
 
-  if (!opt_it) {
+  if (value == nullptr) {
     // fall back to uncached rsk
     return ElgamalEncryption(eg.b, eg.c, key.y)
-      .rerandomize()
-      .reshuffleRekey(reshuffle, key.k);
+      .rerandomizeReshuffleRekey(reshuffle, key.k);
   }
 
-  return (*opt_it)->second.getValue().rsk(eg.b, eg.c, reshuffle);
+  const auto r = CurveScalar::Random();
+  return {
+    reshuffle * value->kInv * (eg.b + (r * CurvePoint::Base)),
+    reshuffle * (eg.c + this->tableMult(key.y, r)),
+    value->kY,
+  };
 }
 
 ElgamalEncryption EGCacheImp::rk(
@@ -418,16 +422,23 @@ ElgamalEncryption EGCacheImp::rk(
 
   auto key = RekeyKey(rekey, eg.publicKey);
 
-  auto opt_it = rskCache_.get(this, key);
+  auto value = rskCache_.get(key, [this, &key] {
+    return std::make_shared<RekeyValue>(*this, key);
+  });
 
-  if (!opt_it) {
+  if (value == nullptr) {
     // fall back to uncached rk
     return ElgamalEncryption(eg.b, eg.c, key.y)
       .rerandomize()
       .rekey(key.k);
   }
 
-  return (*opt_it)->second.getValue().rk(eg.b, eg.c);
+  const auto r = CurveScalar::Random();
+  return {
+    value->kInv * (eg.b + (r * CurvePoint::Base)),
+    eg.c + this->tableMult(key.y, r),
+    value->kY,
+  };
 }
 
 ElgamalEncryption EGCacheImp::rerandomize(
@@ -446,45 +457,19 @@ ElgamalEncryption EGCacheImp::rerandomize(
   return ret;
 }
 
-bool EGCacheImp::RekeyKey::operator== (const EGCacheImp::RekeyKey& k) const {
-  return k.k == this->k && k.y == this->y;
-}
-
-ElgamalEncryption EGCacheImp::RekeyValue::rk(
-    const CurvePoint& b,
-    const CurvePoint& c) const {
-  const auto r = CurveScalar::Random();
-  return {
-    kInv * (b + (r * CurvePoint::Base)),
-    c + yTable->mult(r),
-    kY,
-  };
+void EGCacheImp::setMemoryBudget(size_t bytes) {
+  auto rskBytes = bytes / RskBudgetDivisor;
+  rskCache_.setMemoryBudget(rskBytes);
+  tableCache_.setMemoryBudget(bytes - rskBytes);
 }
 
-ElgamalEncryption EGCacheImp::RekeyValue::rsk(
-    const CurvePoint& b,
-    const CurvePoint& c,
-    const ElgamalTranslationKey& reshuffle) const {
-  const auto r = CurveScalar::Random();
-  return {
-    reshuffle * kInv * (b + (r * CurvePoint::Base)),
-    reshuffle * (c + yTable->mult(r)),
-    kY,
-  };
+bool EGCacheImp::RekeyKey::operator== (const EGCacheImp::RekeyKey& k) const {
+  return k.k == this->k && k.y == this->y;
 }
 
 EGCacheImp::RekeyValue::RekeyValue(
-    EGCacheImp* egcache, const EGCacheImp::RekeyKey& key)  {
-
-  yTable = egcache->scalarMultTable(key.y);
-
-  if (!yTable) {
-    // table cache is disabled; abort
-    return;
-  }
-
-  kY = yTable->mult(key.k);
-  kInv = key.k.invert();
+    EGCacheImp& egcache, const EGCacheImp::RekeyKey& key)
+  : kInv(key.k.invert()), kY(egcache.tableMult(key.y, key.k)) {
 }
 
 size_t EGCacheImp::RekeyKey::hash::operator()(const pep::EGCacheImp::RekeyKey& k) const {
@@ -494,10 +479,6 @@ size_t EGCacheImp::RekeyKey::hash::operator()(const pep::EGCacheImp::RekeyKey& k
   return ret;
 }
 
-EGCacheImp::TableValue::TableValue(EGCacheImp* egcache, const CurvePoint& p) {
-  table_ = std::make_shared<CurvePoint::ScalarMultTable>(p);
-}
-
 EGCache::Metrics EGCacheImp::getMetrics() {
   EGCache::Metrics result;
 
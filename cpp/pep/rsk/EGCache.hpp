@@ -3,6 +3,7 @@
 #include <pep/elgamal/ElgamalEncryption.hpp>
 
 #include <memory>
+#include <vector>
 
 namespace pep {
 
@@ -34,17 +35,53 @@ public:
   ) = 0;
 
   // Caching version of std::make_shared<CurvePoint::ScalarMultTable>(b).
-  // Returns nullptr when cache is disabled.
+  // Returns nullptr when cache is disabled, i.e. when its memory budget is zero.
   virtual std::shared_ptr<CurvePoint::ScalarMultTable>
   scalarMultTable(const CurvePoint& b) = 0;
 
+  // The (approximate) number of bytes the cached entries may occupy, unless
+  // changed using setMemoryBudget.
+  static constexpr size_t DefaultMemoryBudget = 32 * 1024 * 1024;
+
+  // Changes the number of bytes the cached entries may occupy, evicting
+  // all current entries.  A budget of zero disables caching.
+  virtual void setMemoryBudget(size_t bytes) = 0;
+
+  // Persistent storage for scalar multiplication tables, so that they need
+  // not be recomputed after a restart.  See e.g. ScalarMultTableFile.
+  class TableStore {
+  public:
+    virtual ~TableStore() = default;
+
+    // Returns the stored table for the point, or nullptr if there is none.
+    virtual std::shared_ptr<CurvePoint::ScalarMultTable> load(const CurvePoint& point) = 0;
+    // Stores the table of the point, unless it has been stored before.
+    virtual void store(const CurvePoint& point, const CurvePoint::ScalarMultTable& table) = 0;
+    // Returns the points whose tables are stored, least recently stored first.
+    virtual std::vector<CurvePoint> points() = 0;
+  };
+
+  // Makes scalarMultTable() load tables from the store instead of computing
+  // them, and store the tables it hands out more than once.  Fills the table
+  // cache with the most recently stored tables.  Pass nullptr to stop using
+  // a store.
+  virtual void setTableStore(std::shared_ptr<TableStore> store) = 0;
+
   // Since the EGCache will be called from many different threads,
   // it does not send its metrics directly to a prometheus registry.
   // Instead the metrics of the EGCache can be pulled with the following method.
   struct Metrics {
+    struct OfShard {
+      uint64_t hits = 0;
+      uint64_t misses = 0;
+      uint64_t evictions = 0;
+      uint64_t bytes = 0; // occupied by the shard's entries
+    };
+
     struct OfCache {
-      uint64_t generation = 0; // = # entries added = # cache misses
-      uint64_t useCount = 0; // = # of requests
+      uint64_t generation = 0; // = # entries added
+      uint64_t useCount = 0; // = # of requests = # hits + # misses
+      std::vector<OfShard> shards;
     };
 
     OfCache rsk;
@@ -1,9 +1,24 @@
 #include <pep/rsk/Proofs.hpp>
 
 #include <pep/elgamal/CryptoAssert.hpp>
+#include <pep/utils/Random.hpp>
+
+#include <span>
+#include <string>
 
 namespace pep {
 
+namespace {
+
+// Random 128-bit weight for a verification equation in a batch.
+CurveScalar RandomBatchWeight() {
+  std::string packed(CurveScalar::PackedBytes, '\0');
+  RandomBytes(std::span(packed).first(CurveScalar::PackedBytes / 2));
+  return CurveScalar(packed);
+}
+
+}
+
 ScalarMultProof ScalarMultProof::Create(
     const CurvePoint& secretTimesBase,
     const CurvePoint& pre,
@@ -28,14 +43,69 @@ void ScalarMultProof::verify(
     const CurvePoint& pre,
     const CurvePoint& post) const {
   pep::PublicCurveScalar challenge(ComputeChallenge(secretTimesBase, pre, post, cB_, cM_));
-  if ((mS_ * CurvePoint::Base != challenge * secretTimesBase + cB_)
-      || (mS_ * pre != challenge * post + cM_))
+  if (mS_ * CurvePoint::Base != challenge * secretTimesBase + cB_)
+    throw InvalidProof();
+  // Check s*pre - challenge*post == cM using a single (shared doublings) multi-scalar multiplication
+  const PublicCurveScalar scalars[] = { mS_, PublicCurveScalar(CurveScalar() - challenge) };
+  const CurvePoint points[] = { pre, post };
+  if (CurvePoint::MultiScalarMult(scalars, points) != cM_)
+    throw InvalidProof();
+}
+
+void ScalarMultProof::BatchVerifier::addTerm(const CurveScalar& scalar, const CurvePoint& point) {
+  auto [position, added] = pointIndices_.try_emplace(point, points_.size());
+  if (added) {
+    points_.push_back(point);
+    scalars_.emplace_back(scalar);
+  }
+  else {
+    auto& existing = scalars_[position->second];
+    existing = PublicCurveScalar(existing + scalar);
+  }
+}
+
+void ScalarMultProof::BatchVerifier::add(
+    const ScalarMultProof& proof,
+    const CurvePoint& secretTimesBase,
+    const CurvePoint& pre,
+    const CurvePoint& post) {
+  // The proof is valid iff both
+  //   cB + challenge*secretTimesBase - s*B == 0  and
+  //   cM + challenge*post - s*pre == 0.
+  // We add these with random weights w1 and w2 to the combination.  The
+  // equations are arranged such that the commitments (which are never
+  // shared between proofs) get the short weights as their scalars.
+  const CurveScalar zero;
+  auto challenge = ComputeChallenge(secretTimesBase, pre, post, proof.cB_, proof.cM_);
+  auto w1 = RandomBatchWeight();
+  auto w2 = RandomBatchWeight();
+  baseScalar_ = baseScalar_ - w1 * proof.mS_;
+  addTerm(w1 * challenge, secretTimesBase);
+  addTerm(w1, proof.cB_);
+  addTerm(zero - w2 * proof.mS_, pre);
+  addTerm(w2 * challenge, post);
+  addTerm(w2, proof.cM_);
+  ++size_;
+}
+
+void ScalarMultProof::BatchVerifier::verify() const {
+  if (size_ == 0) {
+    return;
+  }
+  auto sum = PublicCurveScalar(baseScalar_) * CurvePoint::Base
+    + CurvePoint::MultiScalarMult(scalars_, points_);
+  if (!sum.isZero()) {
     throw InvalidProof();
+  }
 }
 
 void ScalarMultProof::ensurePacked() const {
-  cB_.ensurePacked();
-  cM_.ensurePacked();
+  const CurvePoint* points[] = { &cB_, &cM_ };
+  CurvePoint::PackBatch(points);
+}
+
+void ScalarMultProof::addPointsTo(std::vector<const CurvePoint*>& points) const {
+  points.insert(points.end(), { &cB_, &cM_ });
 }
 
 CurveScalar ScalarMultProof::ComputeChallenge(
@@ -132,6 +202,20 @@ void RskProof::verify(
   }
 }
 
+void RskProof::addTo(
+    ScalarMultProof::BatchVerifier& batch,
+    const ElgamalEncryption& pre,
+    const ElgamalEncryption& post,
+    const ReshuffleRekeyVerifiers& verifiers) const {
+  if (post.publicKey != verifiers.rekeyedPublicKey) {
+    throw InvalidProof();
+  }
+  // See verify()
+  batch.add(rerandomizeTimesPubKeyProof, rerandomizePoint, pre.publicKey, rerandomizePubKey);
+  batch.add(reshuffleOverRekeyTimesBProof, verifiers.reshuffleOverRekeyCommitment, pre.b + rerandomizePoint, post.b);
+  batch.add(reshuffleTimesCProof, verifiers.reshuffleCommitment, pre.c + rerandomizePubKey, post.c);
+}
+
 ReshuffleRekeyVerifiers ReshuffleRekeyVerifiers::Compute(
     const CurveScalar& reshuffle,
     const CurveScalar& rekey,
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <exception>
+#include <unordered_map>
 #include <vector>
 
 #include <pep/elgamal/ElgamalEncryption.hpp>
@@ -38,6 +39,7 @@ public:
     : cB_(cb), cM_(cm), mS_(s) { }
 
   void ensurePacked() const; // See CurvePoint::ensurePacked()
+  void addPointsTo(std::vector<const CurvePoint*>& points) const; // See CurvePoint::PackBatch()
 
   // Constructs a proof from secretTimesBase, pre, post and secret.
   //
@@ -53,6 +55,42 @@ public:
     const CurvePoint& secretTimesBase,
     const CurvePoint& pre,
     const CurvePoint& post) const;
+
+  class BatchVerifier;
+};
+
+// Checks many ScalarMultProofs at once.
+//
+// Instead of checking the two verification equations of every proof
+// separately, a random linear combination of all of them is checked using
+// a single multi-scalar multiplication.  Terms for the same point (e.g. the
+// commitments shared by all proofs for the same recipient) are merged.
+// If the combination holds, all added proofs are valid, except with
+// probability 2^-128.  If it does not, at least one of the proofs is
+// invalid, but the batch does not tell which one: use
+// ScalarMultProof::verify() on the individual proofs to find out.
+class ScalarMultProof::BatchVerifier {
+  CurveScalar baseScalar_;
+  std::vector<PublicCurveScalar> scalars_;
+  std::vector<CurvePoint> points_;
+  std::unordered_map<CurvePoint, size_t> pointIndices_;
+  size_t size_{};
+
+  void addTerm(const CurveScalar& scalar, const CurvePoint& point);
+
+public:
+  // Adds a proof that would be checked by proof.verify(secretTimesBase, pre, post).
+  void add(
+    const ScalarMultProof& proof,
+    const CurvePoint& secretTimesBase,
+    const CurvePoint& pre,
+    const CurvePoint& post);
+
+  // The number of proofs added.
+  size_t size() const { return size_; }
+
+  // Checks all added proofs. Throws InvalidProof if any of them is invalid.
+  void verify() const;
 };
 
 /// Proof that a point X^{-1} is in the form of x^{-1}B, given X = xB
@@ -159,11 +197,16 @@ class RskProof {
     reshuffleTimesCProof(reshuffleTimesCProof) {}
 
   void ensurePacked() const {
-    rerandomizePubKey.ensurePacked();
-    rerandomizePoint.ensurePacked();
-    rerandomizeTimesPubKeyProof.ensurePacked();
-    reshuffleOverRekeyTimesBProof.ensurePacked();
-    reshuffleTimesCProof.ensurePacked();
+    std::vector<const CurvePoint*> points;
+    addPointsTo(points);
+    CurvePoint::PackBatch(points);
+  }
+
+  void addPointsTo(std::vector<const CurvePoint*>& points) const {
+    points.insert(points.end(), { &rerandomizePubKey, &rerandomizePoint });
+    rerandomizeTimesPubKeyProof.addPointsTo(points);
+    reshuffleOverRekeyTimesBProof.addPointsTo(points);
+    reshuffleTimesCProof.addPointsTo(points);
   }
 
   // Constructs a proof that pre is RSKed to post.
@@ -197,6 +240,15 @@ class RskProof {
     const ElgamalEncryption& pre,
     const ElgamalEncryption& post,
     const ReshuffleRekeyVerifiers& verifiers) const;
+
+  // Adds the checks done by verify() to a batch, see ScalarMultProof::BatchVerifier.
+  // Checks that do not involve scalar multiplications are done right away:
+  // throws InvalidProof if those fail.
+  void addTo(
+    ScalarMultProof::BatchVerifier& batch,
+    const ElgamalEncryption& pre,
+    const ElgamalEncryption& post,
+    const ReshuffleRekeyVerifiers& verifiers) const;
 };
 
 }
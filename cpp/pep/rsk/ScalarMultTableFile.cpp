@@ -0,0 +1,258 @@
+#include <pep/rsk/ScalarMultTableFile.hpp>
+
+#include <pep/utils/Log.hpp>
+#include <pep/utils/OpenSSLHasher.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+namespace pep {
+
+namespace {
+
+const std::string LogTag("ScalarMultTableFile");
+
+constexpr std::string_view Magic("PEPSMT01");
+constexpr size_t ChecksumBytes = 32;
+constexpr size_t RecordBytes = CurvePoint::PackedBytes + CurvePoint::ScalarMultTable::RawBytes + ChecksumBytes;
+constexpr size_t TableOffset = CurvePoint::PackedBytes; // within a record
+constexpr size_t ChecksumOffset = TableOffset + CurvePoint::ScalarMultTable::RawBytes; // within a record
+
+// The magic, followed by the size of a raw table in native byte order:
+// a file written on a platform with a different table representation
+// (probably) has a different header.
+std::string MakeHeader() {
+  std::string result(Magic);
+  uint64_t tableBytes = CurvePoint::ScalarMultTable::RawBytes;
+  result.append(reinterpret_cast<const char*>(&tableBytes), sizeof(tableBytes));
+  return result;
+}
+
+std::string Checksum(std::string_view packedPoint, std::string_view rawTable) {
+  return Sha256().digest(packedPoint, rawTable);
+}
+
+}
+
+ScalarMultTableFile::ScalarMultTableFile(std::filesystem::path path, uint64_t maxBytes)
+  : path_(std::move(path)), maxBytes_(maxBytes) {
+  auto lock = std::unique_lock(mux_);
+  const auto header = MakeHeader();
+
+  std::error_code ec;
+  uint64_t fileSize = std::filesystem::file_size(path_, ec);
+  if (ec)
+    fileSize = 0;
+
+  bool valid = false;
+  if (fileSize >= header.size()) {
+    size_ = header.size();
+    this->mapUnderUniqueLock();
+    valid = std::string_view(mapping_.data(), header.size()) == header;
+    mapping_.close();
+    mapped_ = 0;
+  }
+  if (!valid) {
+    if (fileSize != 0) {
+      PEP_LOG(LogTag, Severity::Warning) << "Discarding " << path_
+        << ": it has not been written by this build";
+    }
+    std::ofstream file(path_, std::ios::binary | std::ios::trunc);
+    file << header;
+    if (!file.flush())
+      throw std::runtime_error("Could not write " + path_.string());
+    fileSize = header.size();
+  }
+
+  // Cut off a trailing partial record, e.g. when we were stopped while appending one
+  size_ = header.size() + (fileSize - header.size()) / RecordBytes * RecordBytes;
+  if (size_ != fileSize) {
+    PEP_LOG(LogTag, Severity::Warning) << "Discarding incomplete record at the end of " << path_;
+    std::filesystem::resize_file(path_, size_);
+  }
+
+  this->mapUnderUniqueLock();
+  for (auto offset = header.size(); offset < size_; offset += RecordBytes) {
+    // If a point has been stored more than once, the last record wins
+    offsets_[CurvePoint(std::string_view(mapping_.data() + offset, CurvePoint::PackedBytes))] = offset;
+  }
+  reserved_ = size_;
+  PEP_LOG(LogTag, Severity::Info) << "Opened " << path_ << " with " << offsets_.size() << " tables";
+
+  writer_ = std::thread([this] { this->writePending(); });
+}
+
+ScalarMultTableFile::~ScalarMultTableFile() {
+  {
+    std::lock_guard lock(pendingMux_);
+    stopping_ = true;
+  }
+  pendingAdded_.notify_one();
+  writer_.join(); // after writing the pending records
+}
+
+void ScalarMultTableFile::mapUnderUniqueLock() {
+  if (mapped_ == size_)
+    return;
+  mapping_.close();
+  mapped_ = 0;
+  mapping_.open(path_.string(), static_cast<size_t>(size_));
+  mapped_ = size_;
+}
+
+std::shared_ptr<const std::string> ScalarMultTableFile::findPending(const CurvePoint& point) {
+  std::lock_guard lock(pendingMux_);
+  auto found = std::find_if(pending_.begin(), pending_.end(),
+      [&point](const Pending& pending) { return pending.point == point; });
+  return found == pending_.end() ? nullptr : found->record;
+}
+
+std::shared_ptr<CurvePoint::ScalarMultTable> ScalarMultTableFile::load(const CurvePoint& point) {
+  if (auto record = this->findPending(point))
+    return CurvePoint::ScalarMultTable::FromRaw(std::string_view(*record).substr(TableOffset, CurvePoint::ScalarMultTable::RawBytes));
+
+  for (bool remapped = false; ; remapped = true) {
+    {
+      auto lock = std::shared_lock(mux_);
+      auto found = offsets_.find(point);
+      if (found == offsets_.end())
+        return nullptr;
+
+      if (found->second + RecordBytes <= mapped_) {
+        auto record = std::string_view(mapping_.data() + found->second, RecordBytes);
+        auto packed = record.substr(0, CurvePoint::PackedBytes);
+        auto raw = record.substr(TableOffset, CurvePoint::ScalarMultTable::RawBytes);
+        if (Checksum(packed, raw) == record.substr(ChecksumOffset))
+          return CurvePoint::ScalarMultTable::FromRaw(raw);
+        break;
+      }
+      if (remapped) // The mapping should cover all indexed records
+        return nullptr;
+    }
+
+    // The record has been written since we last mapped the file: map it
+    // (and any other records written since) now.
+    auto lock = std::unique_lock(mux_);
+    this->mapUnderUniqueLock();
+  }
+
+  PEP_LOG(LogTag, Severity::Warning) << "Ignoring corrupt table in " << path_;
+  // Forget about the record, so that the table can be stored again
+  auto lock = std::unique_lock(mux_);
+  offsets_.erase(point);
+  return nullptr;
+}
+
+void ScalarMultTableFile::store(const CurvePoint& point, const CurvePoint::ScalarMultTable& table) {
+  {
+    auto lock = std::lock_guard(pendingMux_);
+    if (full_ || stopping_)
+      return;
+  }
+  if (this->findPending(point) != nullptr)
+    return;
+  {
+    auto lock = std::shared_lock(mux_);
+    if (offsets_.contains(point))
+      return;
+  }
+
+  auto packed = point.pack();
+  auto raw = table.raw();
+  auto record = std::make_shared<std::string>();
+  record->reserve(RecordBytes);
+  *record += packed;
+  *record += raw;
+  *record += Checksum(packed, raw);
+
+  {
+    auto lock = std::lock_guard(pendingMux_);
+    if (full_ || stopping_)
+      return;
+    if (reserved_ + RecordBytes > maxBytes_) {
+      PEP_LOG(LogTag, Severity::Info) << path_ << " is full: no longer storing tables";
+      full_ = true;
+      return;
+    }
+    reserved_ += RecordBytes;
+    pending_.push_back(Pending{ .point = point, .record = std::move(record) });
+  }
+  pendingAdded_.notify_one();
+}
+
+void ScalarMultTableFile::writePending() {
+  auto lock = std::unique_lock(pendingMux_);
+  while (true) {
+    pendingAdded_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+    if (pending_.empty())
+      return; // Stopping, and everything has been written
+
+    // Write everything that has been stored so far in a single batch. The
+    // records remain pending (and thus loadable) until they've been indexed.
+    auto batch = pending_;
+    lock.unlock();
+    auto written = this->append(batch);
+    lock.lock();
+
+    pending_.erase(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(batch.size()));
+    if (!written)
+      reserved_ -= batch.size() * RecordBytes;
+  }
+}
+
+bool ScalarMultTableFile::append(const std::vector<Pending>& batch) {
+  try {
+    // Write at the end of the last complete record, overwriting any partial
+    // record left behind by a failed write.
+    std::fstream file(path_, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(static_cast<std::streamoff>(size_));
+    for (const auto& pending : batch)
+      file << *pending.record;
+    if (!file.flush()) {
+      PEP_LOG(LogTag, Severity::Warning) << "Could not store tables in " << path_;
+      return false;
+    }
+  }
+  catch (const std::exception& e) {
+    PEP_LOG(LogTag, Severity::Warning) << "Could not store tables in " << path_ << ": " << e.what();
+    return false;
+  }
+
+  auto lock = std::unique_lock(mux_);
+  for (const auto& pending : batch) {
+    offsets_[pending.point] = size_;
+    size_ += RecordBytes;
+  }
+  return true;
+}
+
+std::vector<CurvePoint> ScalarMultTableFile::points() {
+  std::vector<std::pair<uint64_t, CurvePoint>> records;
+  {
+    auto lock = std::shared_lock(mux_);
+    records.reserve(offsets_.size());
+    for (const auto& [point, offset] : offsets_)
+      records.emplace_back(offset, point);
+  }
+  {
+    // Pending records will be written after the ones we already have
+    auto lock = std::lock_guard(pendingMux_);
+    auto offset = std::numeric_limits<uint64_t>::max() - pending_.size();
+    for (const auto& pending : pending_)
+      records.emplace_back(offset++, pending.point);
+  }
+  std::sort(records.begin(), records.end(),
+      [](const auto& a, const auto& b) { return a.first < b.first; });
+
+  std::vector<CurvePoint> result;
+  result.reserve(records.size());
+  for (auto& record : records) {
+    // A point may be listed twice while the writer is indexing its record
+    if (std::find(result.begin(), result.end(), record.second) == result.end())
+      result.push_back(std::move(record.second));
+  }
+  return result;
+}
+
+}
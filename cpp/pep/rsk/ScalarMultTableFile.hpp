@@ -0,0 +1,75 @@
+#pragma once
+
+#include <pep/rsk/EGCache.hpp>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace pep {
+
+// Stores CurvePoint::ScalarMultTable's in a memory mapped file, so that
+// the EGCache need not recompute them after a restart.
+//
+// The file consists of a header, identifying the format and the platform's
+// table representation, followed by records holding a packed point, the
+// raw table of that point and a SHA-256 checksum over both.  A file with
+// an unknown header is discarded, and a record whose checksum doesn't match
+// is ignored.  This protects against corruption, not against tampering:
+// the file should be as well protected as the server's other data.
+//
+// Stored tables are appended to the file in batches by a background thread,
+// so that callers of store() don't wait for disk I/O.  The file is (re)mapped
+// lazily, i.e. when a table is loaded that has been written since the last
+// mapping.  Pending tables are written when the object is destroyed.
+class ScalarMultTableFile : public EGCache::TableStore {
+public:
+  static constexpr uint64_t DefaultMaxBytes = 64 * 1024 * 1024;
+
+  // Opens (or creates) the file at the given path.  Tables are no longer
+  // stored once the file would grow beyond maxBytes.
+  explicit ScalarMultTableFile(std::filesystem::path path, uint64_t maxBytes = DefaultMaxBytes);
+  ~ScalarMultTableFile() override;
+
+  std::shared_ptr<CurvePoint::ScalarMultTable> load(const CurvePoint& point) override;
+  void store(const CurvePoint& point, const CurvePoint::ScalarMultTable& table) override;
+  std::vector<CurvePoint> points() override;
+
+private:
+  struct Pending {
+    CurvePoint point;
+    std::shared_ptr<const std::string> record;
+  };
+
+  void mapUnderUniqueLock();
+  std::shared_ptr<const std::string> findPending(const CurvePoint& point);
+  void writePending();
+  bool append(const std::vector<Pending>& batch);
+
+  std::filesystem::path path_;
+  uint64_t maxBytes_;
+
+  // Guards the mapping and the index of the records in the file
+  std::shared_mutex mux_;
+  boost::iostreams::mapped_file_source mapping_;
+  uint64_t mapped_ = 0; // number of bytes covered by mapping_
+  uint64_t size_ = 0; // of the part of the file holding complete records; only changed by the writer thread
+  std::unordered_map<CurvePoint, uint64_t> offsets_; // of records
+
+  // Guards the records that haven't been written yet. Never acquire mux_ after this.
+  std::mutex pendingMux_;
+  std::condition_variable pendingAdded_;
+  std::vector<Pending> pending_; // in the order they were stored
+  uint64_t reserved_ = 0; // size_ plus the size of pending records
+  bool full_ = false;
+  bool stopping_ = false;
+
+  std::thread writer_;
+};
+
+}
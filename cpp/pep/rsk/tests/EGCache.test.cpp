@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <pep/rsk/EGCache.hpp>
+#include <pep/rsk/ScalarMultTableFile.hpp>
+#include <pep/utils/Filesystem.hpp>
+
+#include <numeric>
+
+namespace {
+
+uint64_t TotalOf(const pep::EGCache::Metrics::OfCache& metrics, uint64_t pep::EGCache::Metrics::OfShard::* counter) {
+  return std::accumulate(metrics.shards.begin(), metrics.shards.end(), uint64_t{0},
+    [counter](uint64_t total, const auto& shard) { return total + shard.*counter; });
+}
+
+class EGCacheTest : public ::testing::Test {
+protected:
+  pep::EGCache& cache = pep::EGCache::get();
+
+  void TearDown() override {
+    cache.setTableStore(nullptr);
+    cache.setMemoryBudget(pep::EGCache::DefaultMemoryBudget);
+  }
+};
+
+TEST_F(EGCacheTest, RskMatchesUncached) {
+  auto privateKey = pep::CurveScalar::Random();
+  auto publicKey = privateKey * pep::CurvePoint::Base;
+  auto message = pep::CurvePoint::Random();
+  auto eg = pep::ElgamalEncryption(publicKey, message);
+  auto reshuffle = pep::CurveScalar::Random();
+  auto rekey = pep::CurveScalar::Random();
+
+  for (size_t budget : {pep::EGCache::DefaultMemoryBudget, size_t{0}}) {
+    cache.setMemoryBudget(budget);
+    for (int i = 0; i < 3; i++) {
+      EXPECT_EQ(cache.rsk(eg, reshuffle, rekey).decrypt(rekey * privateKey), reshuffle * message);
+      EXPECT_EQ(cache.rk(eg, rekey).decrypt(rekey * privateKey), message);
+      EXPECT_EQ(cache.rerandomize(eg).decrypt(privateKey), message);
+    }
+  }
+  EXPECT_EQ(cache.scalarMultTable(publicKey), nullptr) << "Cache should be disabled without a memory budget";
+}
+
+TEST_F(EGCacheTest, Metrics) {
+  cache.setMemoryBudget(pep::EGCache::DefaultMemoryBudget);
+  auto before = cache.getMetrics();
+  EXPECT_EQ(TotalOf(before.table, &pep::EGCache::Metrics::OfShard::bytes), 0U) << "Changing the budget should evict all entries";
+
+  auto point = pep::CurvePoint::Random();
+  auto table = cache.scalarMultTable(point);
+  ASSERT_NE(table, nullptr);
+  EXPECT_EQ(cache.scalarMultTable(point), table);
+
+  auto after = cache.getMetrics();
+  EXPECT_EQ(after.table.shards.size(), before.table.shards.size());
+  EXPECT_EQ(after.table.generation, before.table.generation + 1);
+  EXPECT_EQ(after.table.useCount, before.table.useCount + 2);
+  EXPECT_EQ(TotalOf(after.table, &pep::EGCache::Metrics::OfShard::misses), TotalOf(before.table, &pep::EGCache::Metrics::OfShard::misses) + 1);
+  EXPECT_EQ(TotalOf(after.table, &pep::EGCache::Metrics::OfShard::hits), TotalOf(before.table, &pep::EGCache::Metrics::OfShard::hits) + 1);
+  EXPECT_GT(TotalOf(after.table, &pep::EGCache::Metrics::OfShard::bytes), sizeof(pep::CurvePoint::ScalarMultTable));
+}
+
+TEST_F(EGCacheTest, EvictsWithinBudget) {
+  // Room for (at most) a handful of tables
+  const size_t budget = 64 * sizeof(pep::CurvePoint::ScalarMultTable);
+  cache.setMemoryBudget(budget);
+  auto before = cache.getMetrics();
+
+  for (int i = 0; i < 200; i++)
+    ASSERT_NE(cache.scalarMultTable(pep::CurvePoint::Random()), nullptr);
+
+  auto after = cache.getMetrics();
+  EXPECT_GT(TotalOf(after.table, &pep::EGCache::Metrics::OfShard::evictions), TotalOf(before.table, &pep::EGCache::Metrics::OfShard::evictions));
+  EXPECT_LE(TotalOf(after.table, &pep::EGCache::Metrics::OfShard::bytes), budget);
+
+  // Tables that are in use survive eviction
+  auto point = pep::CurvePoint::Random();
+  auto table = cache.scalarMultTable(point);
+  for (int i = 0; i < 200; i++)
+    (void) cache.scalarMultTable(pep::CurvePoint::Random());
+  auto scalar = pep::CurveScalar::Random();
+  EXPECT_EQ(table->mult(scalar), scalar * point);
+}
+
+TEST_F(EGCacheTest, TableStore) {
+  namespace fs = pep::filesystem;
+  fs::Temporary temp{fs::temp_directory_path() / fs::RandomizedName("pepTest-EGCache-%%%%-%%%%-%%%%")};
+  auto once = pep::CurvePoint::Random();
+  auto twice = pep::CurvePoint::Random();
+
+  cache.setMemoryBudget(pep::EGCache::DefaultMemoryBudget);
+  auto store = std::make_shared<pep::ScalarMultTableFile>(temp.path());
+  cache.setTableStore(store);
+  (void) cache.scalarMultTable(once);
+  (void) cache.scalarMultTable(twice);
+  (void) cache.scalarMultTable(twice);
+  EXPECT_EQ(store->points(), std::vector{twice}) << "Only tables that are used more than once should be stored";
+
+  // Simulate a restart
+  cache.setTableStore(nullptr);
+  cache.setMemoryBudget(pep::EGCache::DefaultMemoryBudget);
+  cache.setTableStore(std::make_shared<pep::ScalarMultTableFile>(temp.path()));
+
+  auto before = cache.getMetrics();
+  auto table = cache.scalarMultTable(twice);
+  auto after = cache.getMetrics();
+  EXPECT_EQ(TotalOf(after.table, &pep::EGCache::Metrics::OfShard::hits), TotalOf(before.table, &pep::EGCache::Metrics::OfShard::hits) + 1)
+    << "Stored table should have been loaded into the cache";
+  auto scalar = pep::CurveScalar::Random();
+  EXPECT_EQ(table->mult(scalar), scalar * twice);
+}
+
+}
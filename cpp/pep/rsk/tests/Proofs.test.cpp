@@ -2,6 +2,9 @@
 
 #include <pep/rsk/Proofs.hpp>
 
+#include <tuple>
+#include <vector>
+
 namespace {
 
 TEST(Proofs, ScalarMultProof) {
@@ -21,6 +24,29 @@ TEST(Proofs, ScalarMultProof) {
   }
 }
 
+TEST(Proofs, ScalarMultProofBatch) {
+  auto x = pep::CurveScalar::Random();
+  auto A = x * pep::CurvePoint::Base;
+  pep::ScalarMultProof::BatchVerifier batch;
+  std::vector<std::tuple<pep::ScalarMultProof, pep::CurvePoint, pep::CurvePoint>> proofs;
+  for (int i = 0; i < 20; i++) {
+    // Proofs for the same secret share their secretTimesBase point
+    auto M = pep::CurvePoint::Random();
+    auto N = x * M;
+    auto proof = pep::ScalarMultProof::Create(A, M, N, x);
+    batch.add(proof, A, M, N);
+    proofs.emplace_back(proof, M, N);
+  }
+  EXPECT_EQ(batch.size(), 20U);
+  EXPECT_NO_THROW(batch.verify());
+  EXPECT_NO_THROW(pep::ScalarMultProof::BatchVerifier().verify()) << "Empty batch should validate";
+
+  // A single bogus proof should invalidate the batch
+  auto [proof, M, N] = proofs.front();
+  batch.add(proof, A, N, M);
+  EXPECT_THROW(batch.verify(), pep::InvalidProof) << "Batch with bogus proof should fail to validate";
+}
+
 TEST(Proofs, InverseProof) {
   const auto secret = pep::CurveScalar::Random();
   const auto secretAsPoint = secret * pep::CurvePoint::Base;
@@ -110,6 +136,35 @@ TEST(Proofs, RskProof) {
   }
 }
 
+TEST(Proofs, RskProofBatch) {
+  auto rekey = pep::CurveScalar::Random();
+  auto reshuffle = pep::CurveScalar::Random();
+  auto publicKey = pep::CurvePoint::Random();
+  auto verifiers = pep::ReshuffleRekeyVerifiers::Compute(reshuffle, rekey, publicKey);
+
+  pep::ScalarMultProof::BatchVerifier batch;
+  for (int i = 0; i < 10; i++) {
+    auto pre = pep::ElgamalEncryption(pep::CurvePoint::Random(), pep::CurvePoint::Random(), publicKey);
+    pep::ElgamalEncryption post;
+    auto proof = pep::RskProof::CertifiedRsk(pre, post, reshuffle, rekey);
+    proof.addTo(batch, pre, post, verifiers);
+  }
+  EXPECT_EQ(batch.size(), 30U);
+  EXPECT_NO_THROW(batch.verify());
+
+  auto pre = pep::ElgamalEncryption(pep::CurvePoint::Random(), pep::CurvePoint::Random(), publicKey);
+  pep::ElgamalEncryption post;
+  auto proof = pep::RskProof::CertifiedRsk(pre, post, reshuffle, rekey);
+  auto wrongKey = post;
+  wrongKey.publicKey = pep::CurvePoint::Random();
+  EXPECT_THROW(proof.addTo(batch, pre, wrongKey, verifiers), pep::InvalidProof)
+    << "Proof with wrong public key should be rejected right away";
+  auto wrongB = post;
+  wrongB.b = pep::CurvePoint::Random();
+  proof.addTo(batch, pre, wrongB, verifiers);
+  EXPECT_THROW(batch.verify(), pep::InvalidProof) << "Batch with bogus proof should fail to validate";
+}
+
 // Test rerandomize part of RskProof.
 // Adapted from RerandomizeProof tests from reverted https://gitlab.pep.cs.ru.nl/pep/core/-/merge_requests/2394.
 //TODO Expand to make sure reshuffle/rekey commitments are also used.
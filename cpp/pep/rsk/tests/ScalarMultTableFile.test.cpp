@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <pep/rsk/ScalarMultTableFile.hpp>
+#include <pep/utils/Filesystem.hpp>
+
+#include <fstream>
+
+namespace {
+
+namespace fs = pep::filesystem;
+
+fs::Temporary MakeTemporaryFile() {
+  return fs::Temporary{fs::temp_directory_path() / fs::RandomizedName("pepTest-ScalarMultTableFile-%%%%-%%%%-%%%%")};
+}
+
+TEST(ScalarMultTableFile, StoresAcrossReopening) {
+  auto temp = MakeTemporaryFile();
+  std::vector<pep::CurvePoint> points{pep::CurvePoint::Random(), pep::CurvePoint::Random(), pep::CurvePoint::Random()};
+  {
+    pep::ScalarMultTableFile file(temp.path());
+    EXPECT_TRUE(file.points().empty());
+    EXPECT_EQ(file.load(points[0]), nullptr);
+    for (const auto& point : points) {
+      file.store(point, pep::CurvePoint::ScalarMultTable(point));
+    }
+    file.store(points[0], pep::CurvePoint::ScalarMultTable(points[0])); // should be ignored
+    EXPECT_NE(file.load(points[0]), nullptr) << "Stored tables should be available without reopening";
+  }
+
+  pep::ScalarMultTableFile file(temp.path());
+  EXPECT_EQ(file.points(), points) << "Points should be listed in the order they were stored";
+  auto scalar = pep::CurveScalar::Random();
+  for (const auto& point : points) {
+    auto table = file.load(point);
+    ASSERT_NE(table, nullptr);
+    EXPECT_EQ(table->mult(scalar), scalar * point);
+  }
+  EXPECT_EQ(file.load(pep::CurvePoint::Random()), nullptr);
+}
+
+TEST(ScalarMultTableFile, IgnoresCorruption) {
+  auto temp = MakeTemporaryFile();
+  auto point = pep::CurvePoint::Random();
+  pep::ScalarMultTableFile(temp.path()).store(point, pep::CurvePoint::ScalarMultTable(point));
+
+  // Flip a byte in the middle of the table
+  {
+    std::fstream stream(temp.path(), std::ios::in | std::ios::out | std::ios::binary);
+    stream.seekg(1000);
+    auto byte = static_cast<char>(stream.get());
+    stream.seekp(1000);
+    stream.put(static_cast<char>(byte ^ 1));
+  }
+  {
+    pep::ScalarMultTableFile file(temp.path());
+    EXPECT_EQ(file.load(point), nullptr) << "Corrupt table should not be loaded";
+    file.store(point, pep::CurvePoint::ScalarMultTable(point));
+    EXPECT_NE(file.load(point), nullptr) << "Corrupt table should be replaceable";
+  }
+  EXPECT_NE(pep::ScalarMultTableFile(temp.path()).load(point), nullptr) << "Replacement should survive reopening";
+
+  // Overwrite the header
+  {
+    std::fstream stream(temp.path(), std::ios::in | std::ios::out | std::ios::binary);
+    stream << "garbage";
+  }
+  pep::ScalarMultTableFile file(temp.path());
+  EXPECT_TRUE(file.points().empty()) << "File with unknown header should be discarded";
+}
+
+TEST(ScalarMultTableFile, RespectsMaxBytes) {
+  auto temp = MakeTemporaryFile();
+  pep::ScalarMultTableFile file(temp.path(), 2 * pep::CurvePoint::ScalarMultTable::RawBytes);
+  for (int i = 0; i < 3; i++) {
+    auto point = pep::CurvePoint::Random();
+    file.store(point, pep::CurvePoint::ScalarMultTable(point));
+  }
+  EXPECT_EQ(file.points().size(), 1U);
+}
+
+}
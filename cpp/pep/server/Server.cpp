@@ -1,5 +1,7 @@
 #include <chrono>
 #include <pep/auth/UserGroup.hpp>
+#include <pep/messaging/MessageCompression.hpp>
+#include <pep/rsk/ScalarMultTableFile.hpp>
 #include <pep/server/MonitoringSerializers.hpp>
 #include <pep/server/Server.hpp>
 
@@ -65,6 +67,30 @@ Server::Metrics::Metrics(std::shared_ptr<prometheus::Registry> registry) :
     .Help("Number of times the Table Cache was used")
     .Register(*registry)
     .Add({})),
+  egcacheHits(prometheus::BuildGauge()
+    .Name("pep_egcache_hits")
+    .Help("Number of requests that an EGCache shard could answer from its entries")
+    .Register(*registry)),
+  egcacheMisses(prometheus::BuildGauge()
+    .Name("pep_egcache_misses")
+    .Help("Number of requests for which an EGCache shard had to compute a new entry")
+    .Register(*registry)),
+  egcacheEvictions(prometheus::BuildGauge()
+    .Name("pep_egcache_evictions")
+    .Help("Number of entries evicted from an EGCache shard to make room for new ones")
+    .Register(*registry)),
+  egcacheBytes(prometheus::BuildGauge()
+    .Name("pep_egcache_bytes")
+    .Help("Approximate memory occupied by the entries of an EGCache shard in bytes")
+    .Register(*registry)),
+  messagesCompressed(prometheus::BuildGauge()
+    .Name("pep_messages_compressed")
+    .Help("Number of messages of a type that were sent compressed")
+    .Register(*registry)),
+  messageCompressionSavedBytes(prometheus::BuildGauge()
+    .Name("pep_message_compression_saved_bytes")
+    .Help("Number of bytes saved by compressing messages of a type")
+    .Register(*registry)),
   uptimeMetric(prometheus::BuildGauge()
     .Name("pep_uptime_seconds")
     .Help("Time since startup in seconds")
@@ -140,6 +166,12 @@ Server::Server(std::shared_ptr<Parameters> parameters)
   serverTraits_(parameters->serverTraits()),
   ioContext_(parameters->getIoContext()),
   rootCAs_(parameters->ensureValid().getRootCAs()) {
+  if (const auto& budget = parameters->getEgCacheMemoryBudget()) {
+    eGCache_.setMemoryBudget(*budget);
+  }
+  if (const auto& path = parameters->getScalarMultTableFilePath()) {
+    eGCache_.setTableStore(std::make_shared<ScalarMultTableFile>(*path));
+  }
   RegisterRequestHandlers(*this,
     &Server::handleMetricsRequest,
     &Server::handleChecksumChainNamesRequest,
@@ -175,6 +207,21 @@ std::shared_ptr<prometheus::Registry> Server::getMetricsRegistry() {
   metrics_->egcacheTableGeneration.Set(static_cast<double>(egcm.table.generation));
   metrics_->egcacheRSKUseCount.Set(static_cast<double>(egcm.rsk.useCount));
   metrics_->egcacheTableUseCount.Set(static_cast<double>(egcm.table.useCount));
+  for (const auto& [cache, ofCache] : {std::pair{"rsk", &egcm.rsk}, std::pair{"table", &egcm.table}}) {
+    for (size_t i = 0; i < ofCache->shards.size(); i++) {
+      const auto& shard = ofCache->shards[i];
+      prometheus::Labels labels{{"cache", cache}, {"shard", std::to_string(i)}};
+      metrics_->egcacheHits.Add(labels).Set(static_cast<double>(shard.hits));
+      metrics_->egcacheMisses.Add(labels).Set(static_cast<double>(shard.misses));
+      metrics_->egcacheEvictions.Add(labels).Set(static_cast<double>(shard.evictions));
+      metrics_->egcacheBytes.Add(labels).Set(static_cast<double>(shard.bytes));
+    }
+  }
+  for (const auto& [type, savings] : messaging::MessageCompression::GetSavings()) {
+    prometheus::Labels labels{{"type", type}};
+    metrics_->messagesCompressed.Add(labels).Set(static_cast<double>(savings.messages));
+    metrics_->messageCompressionSavedBytes.Add(labels).Set(static_cast<double>(savings.uncompressedBytes - savings.compressedBytes));
+  }
   metrics_->uptimeMetric.Set(std::chrono::duration<double>(std::chrono::steady_clock::now() - metrics_->startupTime).count()); // in seconds
   return registry_;
 }
@@ -182,6 +229,8 @@ std::shared_ptr<prometheus::Registry> Server::getMetricsRegistry() {
 Server::Parameters::Parameters(std::shared_ptr<boost::asio::io_context> ioContext, const Configuration& config)
   : ioContext_(std::move(ioContext)),
   rootCACertificatesFilePath_(config.get<std::filesystem::path>("CaCertificateFile")),
-  rootCAs_(MakeSharedCopy(X509RootCertificates::FromFile(rootCACertificatesFilePath_))) {}
+  rootCAs_(MakeSharedCopy(X509RootCertificates::FromFile(rootCACertificatesFilePath_))),
+  egCacheMemoryBudget_(config.get<std::optional<size_t>>("EGCacheMemoryBudget")),
+  scalarMultTableFilePath_(config.get<std::optional<std::filesystem::path>>("ScalarMultTableFile")) {}
 
 }
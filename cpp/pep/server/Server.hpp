@@ -95,6 +95,16 @@ private:
     prometheus::Gauge& egcacheRSKUseCount;
     prometheus::Gauge& egcacheTableUseCount;
 
+    // Labeled by cache ("rsk" or "table") and shard
+    prometheus::Family<prometheus::Gauge>& egcacheHits;
+    prometheus::Family<prometheus::Gauge>& egcacheMisses;
+    prometheus::Family<prometheus::Gauge>& egcacheEvictions;
+    prometheus::Family<prometheus::Gauge>& egcacheBytes;
+
+    // Labeled by message type
+    prometheus::Family<prometheus::Gauge>& messagesCompressed;
+    prometheus::Family<prometheus::Gauge>& messageCompressionSavedBytes;
+
     prometheus::Gauge& uptimeMetric;
   };
 
@@ -113,6 +123,8 @@ private:
   std::shared_ptr<boost::asio::io_context> ioContext_;
   std::filesystem::path rootCACertificatesFilePath_;
   std::shared_ptr<X509RootCertificates> rootCAs_;
+  std::optional<size_t> egCacheMemoryBudget_;
+  std::optional<std::filesystem::path> scalarMultTableFilePath_;
 
 protected:
   virtual void check() const {}
@@ -146,6 +158,14 @@ public:
   /// \brief Produces the root CA certificate(s) for this server's constellation.
   /// \return (A reference to) this server's constellation's root CA certificate(s).
   std::shared_ptr<X509RootCertificates> getRootCAs() const noexcept { return rootCAs_; }
+
+  /// \brief Produces the number of bytes that the EGCache may occupy, if configured.
+  /// \return The configured memory budget for the EGCache, or std::nullopt to keep its default.
+  const std::optional<size_t>& getEgCacheMemoryBudget() const noexcept { return egCacheMemoryBudget_; }
+
+  /// \brief Produces the path to the file in which the EGCache stores its scalar multiplication tables, if configured.
+  /// \return The path to the ScalarMultTableFile, or std::nullopt if the EGCache shouldn't store its tables.
+  const std::optional<std::filesystem::path>& getScalarMultTableFilePath() const noexcept { return scalarMultTableFilePath_; }
 };
 
 }
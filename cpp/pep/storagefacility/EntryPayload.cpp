@@ -13,11 +13,35 @@ namespace {
 const std::string FileSizeKey = "filesize";
 const std::string PageSizeKey = "pagesize";
 const std::string InlinePageKey = "inline-page";
+const std::string ContentAddressesKey = "page-addresses";
 
 std::string GetPagePath(const EntryName& entry, XXH64_hash_t xxhash) {
   return entry.string() + EntryName::Delimiter + std::to_string(xxhash) + ".page";
 }
 
+// Participant directories are named after (hex) local pseudonyms, so this can't clash with an entry's page paths
+const std::string ContentAddressedPagesDirectory = "content";
+
+std::string GetContentAddressedPagePath(const std::string& address) {
+  return ContentAddressedPagesDirectory + EntryName::Delimiter + address + ".page";
+}
+
+std::vector<std::string> ExtractContentAddresses(PersistedEntryProperties& properties, size_t pageCount) {
+  auto concatenated = TryExtractPersistedEntryProperty<std::string>(properties, ContentAddressesKey);
+  if (!concatenated.has_value()) {
+    return {};
+  }
+  if (concatenated->size() != pageCount * PageDeduplicator::AddressLength) {
+    throw std::runtime_error("Content addresses don't match the entry's pages");
+  }
+  std::vector<std::string> result;
+  result.reserve(pageCount);
+  for (size_t offset = 0U; offset < concatenated->size(); offset += PageDeduplicator::AddressLength) {
+    result.push_back(concatenated->substr(offset, PageDeduplicator::AddressLength));
+  }
+  return result;
+}
+
 }
 
 void EntryPayload::save(PersistedEntryProperties& properties, std::vector<PageId>& pages) const {
@@ -90,6 +114,7 @@ std::shared_ptr<InlinedEntryPayload> InlinedEntryPayload::Load(PersistedEntryPro
 bool PagedEntryPayload::allMemberVarsAreEqual(const EntryPayload& rhs) const {
   const auto& downcast = static_cast<const PagedEntryPayload&>(rhs);
   return this->pages_ == downcast.pages_
+      && this->contentAddresses_ == downcast.contentAddresses_
       && this->payloadSize_ == downcast.payloadSize_
       && this->pageSize_ == downcast.pageSize_;
 }
@@ -98,6 +123,15 @@ void PagedEntryPayload::save(PersistedEntryProperties& properties, std::vector<P
   assert(pages.empty());
 
   pages = pages_;
+  if (!contentAddresses_.empty()) {
+    assert(contentAddresses_.size() == pages_.size());
+    std::string concatenated;
+    concatenated.reserve(contentAddresses_.size() * PageDeduplicator::AddressLength);
+    for (const auto& address : contentAddresses_) {
+      concatenated += address;
+    }
+    SetPersistedEntryProperty(properties, ContentAddressesKey, concatenated);
+  }
   EntryPayload::save(properties, pages);
 }
 
@@ -135,7 +169,7 @@ uint64_t EntryPayload::ExtractPageSize(PersistedEntryProperties& properties) {
   return result.value_or(uint64_t{0});
 }
 
-rxcpp::observable<std::string> PagedEntryPayload::appendPage(PageStore& pageStore, const EntryName& name, uint64_t pagenr, std::shared_ptr<std::string> rawPage, uint64_t payloadSize)
+rxcpp::observable<std::string> PagedEntryPayload::appendPage(PageStore& pageStore, const EntryName& name, uint64_t pagenr, std::shared_ptr<std::string> rawPage, uint64_t payloadSize, PageDeduplicator* deduplicator)
 {
   if (this->pageCount() != pagenr)
     throw Error("Cannot append page: "
@@ -150,14 +184,31 @@ rxcpp::observable<std::string> PagedEntryPayload::appendPage(PageStore& pageStor
     throw std::runtime_error("FileStore error, duplicate data hash found in Entry Change: " + name.string() + ", a hashing collision has (likely) occurred.");
   }
 
+  if (deduplicator != nullptr && this->contentAddresses_.size() != this->pages_.size()) {
+    throw std::runtime_error("Cannot append content addressed page to payload whose pages are stored by name");
+  }
+
   this->pages_.push_back(xxhash);
   payloadSize_ += payloadSize;
   if (pagenr == 0) {
     pageSize_ = payloadSize;
   }
 
+  if (deduplicator == nullptr) {
+    return pageStore.put(
+      GetPagePath(name, xxhash),
+      std::vector<std::shared_ptr<std::string>>{ rawPage,
+      std::make_shared<std::string>(xxhashstr) });
+  }
+
+  auto address = deduplicator->address(*rawPage);
+  this->contentAddresses_.push_back(address);
+  if (deduplicator->isStored(address)) {
+    deduplicator->countDeduplicatedUpload();
+    return rxcpp::observable<>::just(ETag(*rawPage, xxhashstr));
+  }
   return pageStore.put(
-    GetPagePath(name, xxhash),
+    GetContentAddressedPagePath(address),
     std::vector<std::shared_ptr<std::string>>{ rawPage,
     std::make_shared<std::string>(xxhashstr) });
 }
@@ -169,7 +220,8 @@ size_t EntryPayload::validatedPageIndex(size_t index) const {
 }
 
 PagedEntryPayload::PagedEntryPayload(PersistedEntryProperties& properties, std::vector<PageId> pages)
-  : pages_(std::move(pages)), payloadSize_(ExtractFileSize(properties)), pageSize_(ExtractPageSize(properties)) {
+  : pages_(std::move(pages)), contentAddresses_(ExtractContentAddresses(properties, pages_.size())),
+  payloadSize_(ExtractFileSize(properties)), pageSize_(ExtractPageSize(properties)) {
 }
 
 std::optional<uint64_t> PagedEntryPayload::pageSize() const {
@@ -181,17 +233,28 @@ std::optional<uint64_t> PagedEntryPayload::pageSize() const {
 
 std::set<std::string> PagedEntryPayload::getPagePaths(const EntryName& name) const {
   std::set<std::string> result;
+  if (!contentAddresses_.empty()) {
+    InsertNonDuplicates(result, contentAddresses_ | std::ranges::views::transform(GetContentAddressedPagePath));
+    return result;
+  }
   InsertNonDuplicates(result, pages_ | std::ranges::views::transform([&name](PageId hash) {
     return GetPagePath(name, hash);
     }));
   return result;
 }
 
+std::string PagedEntryPayload::getPagePath(const EntryName& name, size_t index) const {
+  if (!contentAddresses_.empty()) {
+    return GetContentAddressedPagePath(contentAddresses_[index]);
+  }
+  return GetPagePath(name, pages_[index]);
+}
+
 messaging::MessageSequence PagedEntryPayload::readPage(std::shared_ptr<PageStore> pageStore, const EntryName& name, size_t index) const {
   index = this->validatedPageIndex(index);
 
   uint64_t expected_hash = pages_[index];
-  std::string path = GetPagePath(name, expected_hash);
+  std::string path = this->getPagePath(name, index);
 
   return pageStore->get(path).map(
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <pep/storagefacility/EntryName.hpp>
+#include <pep/storagefacility/PageDeduplicator.hpp>
 #include <pep/storagefacility/PersistedEntryProperties.hpp>
 #include <pep/storagefacility/PageStore.hpp>
 #include <pep/messaging/MessageSequence.hpp>
@@ -82,10 +83,12 @@ public:
   static std::shared_ptr<InlinedEntryPayload> Load(PersistedEntryProperties& properties, std::vector<PageId>& pages);
 };
 
-/// An entry payload whose pages are stored in a PageStore.
+/// \brief An entry payload whose pages are stored in a PageStore.
+/// \remark Pages are stored under a path derived from the entry's name, or under their content address if the payload was created with a PageDeduplicator.
 class PagedEntryPayload : public EntryPayload {
 private:
   std::vector<PageId> pages_;
+  std::vector<std::string> contentAddresses_; // One per page, or empty if pages are stored under the entry's name
   uint64_t payloadSize_ = 0;
   uint64_t pageSize_ = 0; // Zero for old entries that didn't store the property
 
@@ -98,6 +101,8 @@ public:
   PagedEntryPayload() = default;
   PagedEntryPayload(PersistedEntryProperties& properties, std::vector<PageId> pages);
 
+  const std::vector<std::string>& contentAddresses() const noexcept { return contentAddresses_; }
+
   std::shared_ptr<EntryPayload> clone() const override { return std::make_shared<PagedEntryPayload>(*this); }
 
   size_t pageCount() const noexcept override { return pages_.size(); }
@@ -109,7 +114,13 @@ public:
 
   static std::shared_ptr<PagedEntryPayload> Load(PersistedEntryProperties& properties, std::vector<PageId>& pages);
 
-  rxcpp::observable<std::string> appendPage(PageStore& pageStore, const EntryName& name, uint64_t pagenr, std::shared_ptr<std::string> rawPage, uint64_t payloadSize); // returns MD5( data xxhash(data) )
+  /// \brief Adds a page to the payload, uploading it to the page store.
+  /// \param deduplicator If specified, the page is stored under its content address, and its upload is skipped if a page with that address has already been stored.
+  /// \return MD5( data xxhash(data) )
+  rxcpp::observable<std::string> appendPage(PageStore& pageStore, const EntryName& name, uint64_t pagenr, std::shared_ptr<std::string> rawPage, uint64_t payloadSize, PageDeduplicator* deduplicator = nullptr);
+
+private:
+  std::string getPagePath(const EntryName& name, size_t index) const;
 };
 
 }
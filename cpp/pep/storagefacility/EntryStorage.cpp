@@ -0,0 +1,621 @@
+#include <pep/storagefacility/EntryStorage.hpp>
+#include <pep/utils/Defer.hpp>
+#include <pep/utils/File.hpp>
+#include <pep/utils/Log.hpp>
+#include <pep/utils/Random.hpp>
+#include <pep/utils/Raw.hpp>
+
+#include <boost/lexical_cast.hpp>
+
+#include <cassert>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <xxhash.h>
+
+using namespace std::chrono;
+
+namespace pep {
+
+namespace {
+
+const std::string LogTag("EntryStorage");
+
+uint64_t Hash(std::string_view data) {
+  return XXH64(data.data(), data.size(), 0ULL);
+}
+
+/// \brief Stores every entry in a file of its own, in a directory per cell: <directory>/<participant>/<column>/<validFrom>.entry
+class DirectoryEntryStorage : public EntryStorage {
+private:
+  static const std::string FileExtension;
+
+  CheckedPath directory_;
+  std::mutex unsyncedMux_; // Guards the unsynced paths, which write() adds to while sync() may be running on another thread
+  std::set<std::filesystem::path> unsyncedFiles_; // Entry files written since the last sync()
+  std::set<std::filesystem::path> unsyncedDirectories_; // Directories whose entries (files or subdirectories) were added since the last sync()
+
+  CheckedPath cellPath(const EntryName& name) const {
+    return directory_ / CheckedFileName(name.participant()) / CheckedFileName(name.column());
+  }
+
+  CheckedPath entryPath(const EntryName& name, Timestamp validFrom, const std::string& extension) const {
+    return this->cellPath(name) / CheckedFileName(std::to_string(TicksSinceEpoch<milliseconds>(validFrom)) + extension);
+  }
+
+public:
+  explicit DirectoryEntryStorage(CheckedPath directory)
+    : directory_(std::move(directory)) {
+  }
+
+  static bool IsParticipantDirectory(const std::filesystem::directory_entry& entry) {
+    return entry.is_directory() && entry.path().filename().string().size() == LocalPseudonym::TextLength();
+  }
+
+  void load(const CellLoader& loader) override {
+    for (const auto& participant : std::filesystem::directory_iterator(directory_)) {
+      if (!IsParticipantDirectory(participant)) {
+        continue;
+      }
+      for (const auto& cell : std::filesystem::directory_iterator(participant.path())) {
+        if (!cell.is_directory()) {
+          continue;
+        }
+        std::vector<EntryVersion> versions;
+        for (const auto& file : std::filesystem::directory_iterator(cell.path())) {
+          const auto& path = file.path();
+          if (file.is_regular_file() && path.extension().string() == FileExtension) {
+            versions.push_back(EntryVersion{
+              .validFrom = Timestamp(milliseconds{boost::lexical_cast<milliseconds::rep>(path.stem().string())})
+            });
+          }
+        }
+        loader(participant.path().filename().string(), cell.path().filename().string(), std::move(versions), false);
+      }
+    }
+  }
+
+  std::string read(const EntryName& name, const EntryVersion& version) override {
+    // Note: On case-insensitive filesystems (e.g. Windows), file names could collide.
+    // Additionally, NTFS 8.3 short names could collide (a column called "PARTIC~1" will collide with "ParticipantIdentifier").
+    // See https://learn.microsoft.com/en-us/windows/win32/fileio/naming-a-file.
+    // This may lead to security issues.
+    // So basically, we should not run the production StorageFacility on Windows with the current code.
+    return ReadFile(this->entryPath(name, version.validFrom, FileExtension));
+  }
+
+  void sync() override {
+    // Sync everything that was written since the previous sync() in one go, so that entries written (by separate
+    // requests) in the meantime share the cost
+    std::set<std::filesystem::path> files, directories;
+    {
+      std::lock_guard lock(unsyncedMux_);
+      files.swap(unsyncedFiles_);
+      directories.swap(unsyncedDirectories_);
+    }
+    try {
+      // Files before directories, so that a directory entry never refers to a file whose content isn't durable yet
+      for (const auto& file : files) {
+        SyncFile(file);
+      }
+      for (const auto& directory : directories) {
+        SyncDirectory(directory);
+      }
+    }
+    catch (...) {
+      // Have the next sync() try again
+      std::lock_guard lock(unsyncedMux_);
+      unsyncedFiles_.merge(files);
+      unsyncedDirectories_.merge(directories);
+      throw;
+    }
+  }
+
+  uint64_t write(const EntryName& name, const EntryVersion& version, const std::string& serialized) override {
+    auto cellPath = this->cellPath(name);
+    // throws when an error occurs while creating any of the given directories in the supplied path
+    auto createdCell = std::filesystem::create_directories(cellPath);
+
+    std::filesystem::path tempfile = this->entryPath(name, version.validFrom, ".tmp").path();
+    std::ofstream outfile;
+    outfile.open(tempfile, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!outfile.is_open())
+      throw std::invalid_argument("could not write file: " + tempfile.string());
+
+    outfile << serialized;
+    if (!outfile) {
+      throw std::runtime_error("failed to write content to file: " + tempfile.string());
+    }
+    outfile.close();
+
+    auto path = this->entryPath(name, version.validFrom, FileExtension).path();
+    std::filesystem::rename(tempfile, path);
+
+    std::lock_guard lock(unsyncedMux_);
+    unsyncedFiles_.insert(path);
+    unsyncedDirectories_.insert(cellPath.path());
+    if (createdCell) {
+      // Also sync the directories that (may) have received the new participant and/or cell directory
+      unsyncedDirectories_.insert(cellPath.path().parent_path());
+      unsyncedDirectories_.insert(directory_.path());
+    }
+    return 0U;
+  }
+};
+
+const std::string DirectoryEntryStorage::FileExtension = ".entry";
+
+
+/// \brief Stores entries in a single append-only log file, in which every record consists of
+///  - the length of the record's body,
+///  - the body, containing the entry's name, its EntryVersion summary and the serialized entry,
+///  - an XXH64 hash of the body.
+/// Records are located by their offset in the log.
+///
+/// To prevent having to read the entire log at startup, an index file lists the (summaries of the) cell versions
+/// contained in the log, grouped by participant and column. The index is rewritten at checkpoints, and records that
+/// have been appended to the log since then are replayed at startup. A trailing incomplete record (e.g. left behind
+/// when we were stopped halfway through an append) is discarded. A damaged record anywhere else is an error, since
+/// discarding it would also discard the (valid and acknowledged) records that follow it.
+class LogEntryStorage : public EntryStorage {
+private:
+  static const std::string LogFileName;
+  static const std::string IndexFileName;
+  static const std::string CompactionFileName;
+
+  static constexpr std::string_view LogMagic = "PEPELOG1";
+  static constexpr std::string_view IndexMagic = "PEPEIDX1";
+  static constexpr uint64_t LogHeaderSize = LogMagic.size() + sizeof(uint64_t);
+
+  enum VersionFlags : uint32_t {
+    OriginalPayloadOwner = 1U << 0,
+    Tombstone = 1U << 1,
+  };
+
+  struct Record {
+    std::string participant;
+    std::string column;
+    EntryVersion version;
+    std::string serialized;
+  };
+
+  CheckedPath directory_;
+  CheckedPath logPath_;
+  CheckedPath indexPath_;
+  uint64_t logId_{}; // Random number in the log header, binding index files to the log
+  uint64_t size_{}; // of the part of the log holding complete records
+  std::mutex readMux_; // Guards reader_, and size_ against modification while read() is invoked from another thread
+  uint64_t indexedSize_{}; // of the part of the log that's covered by our index file
+  std::ofstream writer_;
+  std::ifstream reader_;
+
+  static void WriteVersion(std::ostream& out, const EntryVersion& version) {
+    WriteBinary(out, static_cast<uint64_t>(TicksSinceEpoch<milliseconds>(version.validFrom)));
+    WriteBinary(out, version.checksumSubstitute);
+    WriteBinary(out, version.payloadSize);
+    uint32_t flags = (version.isOriginalPayloadOwner ? OriginalPayloadOwner : 0U) | (version.isTombstone ? Tombstone : 0U);
+    WriteBinary(out, flags);
+  }
+
+  static EntryVersion ReadVersion(std::istream& in) {
+    EntryVersion result;
+    result.validFrom = Timestamp(milliseconds{ReadBinary(in, uint64_t{})});
+    result.checksumSubstitute = ReadBinary(in, uint64_t{});
+    result.payloadSize = ReadBinary(in, uint64_t{});
+    auto flags = ReadBinary(in, uint32_t{});
+    result.isOriginalPayloadOwner = (flags & OriginalPayloadOwner) != 0U;
+    result.isTombstone = (flags & Tombstone) != 0U;
+    return result;
+  }
+
+  static std::string MakeLogHeader(uint64_t logId) {
+    std::ostringstream header;
+    header << LogMagic;
+    WriteBinary(header, logId);
+    return std::move(header).str();
+  }
+
+  static std::string EncodeRecord(const EntryName& name, const EntryVersion& version, const std::string& serialized) {
+    std::ostringstream body;
+    WriteBinary(body, name.participant());
+    WriteBinary(body, name.column());
+    WriteVersion(body, version);
+    WriteBinary(body, serialized);
+    auto content = std::move(body).str();
+    if (content.size() > std::numeric_limits<uint32_t>::max()) {
+      throw std::runtime_error("Entry too large to store: " + name.string());
+    }
+
+    std::ostringstream record;
+    WriteBinary(record, static_cast<uint32_t>(content.size()));
+    record << content;
+    WriteBinary(record, Hash(content));
+    return std::move(record).str();
+  }
+
+  /// \brief Reads the record at the stream's current position.
+  /// \param available The number of bytes that the stream (still) holds.
+  /// \param size Receives the number of bytes that the record occupies (or claims to occupy).
+  /// \return The record, or std::nullopt if the available bytes don't contain a complete record with a valid hash.
+  static std::optional<Record> ReadRecord(std::istream& in, uint64_t available, uint64_t& size) {
+    size = available;
+    if (available < sizeof(uint32_t)) {
+      return std::nullopt;
+    }
+    auto bodySize = ReadBinary(in, uint32_t{});
+    size = sizeof(uint32_t) + uint64_t{bodySize} + sizeof(uint64_t);
+    if (!in.good() || size > available) {
+      return std::nullopt;
+    }
+    std::string body(bodySize, '\0');
+    in.read(body.data(), static_cast<std::streamsize>(body.size()));
+    auto hash = ReadBinary(in, uint64_t{});
+    if (!in.good() || hash != Hash(body)) {
+      return std::nullopt;
+    }
+
+    std::istringstream content(std::move(body));
+    Record result;
+    result.participant = ReadBinary(content, std::string());
+    result.column = ReadBinary(content, std::string());
+    result.version = ReadVersion(content);
+    result.serialized = ReadBinary(content, std::string());
+    if (!content.good()) {
+      throw std::runtime_error("Could not parse entry log record");
+    }
+    return result;
+  }
+
+  /// \brief Determines whether a valid record starts anywhere in the specified part of the log.
+  bool containsRecord(uint64_t begin, uint64_t end) {
+    for (auto offset = begin; offset < end; ++offset) {
+      auto& in = this->reader();
+      in.seekg(static_cast<std::streamoff>(offset));
+      uint64_t recordSize{};
+      if (ReadRecord(in, end - offset, recordSize).has_value()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// \brief Determines whether an unreadable record at the specified offset is what an interrupted append leaves behind,
+  ///        i.e. whether it's the last thing in the log and it's shorter than it claims to be.
+  bool isIncompleteTrailingRecord(uint64_t offset, uint64_t recordSize) {
+    auto available = size_ - offset;
+    if (available < sizeof(uint32_t)) {
+      return true; // Not even the length was written completely
+    }
+    return recordSize > available
+      && !this->containsRecord(offset + sizeof(uint32_t), size_);
+  }
+
+  /// \brief Reports the cells listed in the index file to the loader.
+  /// \return The size of the part of the log that's covered by the index, or std::nullopt if we don't have a (usable) index.
+  std::optional<uint64_t> loadIndex(const CellLoader& loader) const {
+    if (!std::filesystem::exists(indexPath_)) {
+      return std::nullopt;
+    }
+    auto content = ReadFile(indexPath_);
+    if (content.size() < IndexMagic.size() + 3 * sizeof(uint64_t)
+      || !content.starts_with(IndexMagic)) {
+      PEP_LOG(LogTag, Severity::Warning) << "Ignoring " << indexPath_ << ": it is not an entry log index";
+      return std::nullopt;
+    }
+    auto hashed = std::string_view(content).substr(0, content.size() - sizeof(uint64_t));
+    std::istringstream trailer(content.substr(hashed.size()));
+    if (ReadBinary(trailer, uint64_t{}) != Hash(hashed)) {
+      PEP_LOG(LogTag, Severity::Warning) << "Ignoring " << indexPath_ << ": its checksum doesn't match";
+      return std::nullopt;
+    }
+
+    std::istringstream in(std::move(content));
+    in.seekg(static_cast<std::streamoff>(IndexMagic.size()));
+    auto logId = ReadBinary(in, uint64_t{});
+    auto covered = ReadBinary(in, uint64_t{});
+    if (logId != logId_ || covered < LogHeaderSize || covered > size_) {
+      PEP_LOG(LogTag, Severity::Warning) << "Ignoring " << indexPath_ << ": it was not written for the current log";
+      return std::nullopt;
+    }
+
+    for (auto participant = ReadBinary(in, std::string()); !participant.empty(); participant = ReadBinary(in, std::string())) {
+      auto cellCount = ReadBinary(in, uint32_t{});
+      for (uint32_t i = 0U; i < cellCount; ++i) {
+        auto column = ReadBinary(in, std::string());
+        auto versionCount = ReadBinary(in, uint32_t{});
+        std::vector<EntryVersion> versions;
+        versions.reserve(versionCount);
+        for (uint32_t j = 0U; j < versionCount; ++j) {
+          auto& version = versions.emplace_back(ReadVersion(in));
+          version.location = ReadBinary(in, uint64_t{});
+        }
+        if (!in.good()) {
+          throw std::runtime_error("Could not parse entry log index " + indexPath_.text());
+        }
+        loader(participant, column, std::move(versions), true);
+      }
+    }
+    return covered;
+  }
+
+  void closeFiles() {
+    writer_.close();
+    reader_.close();
+  }
+
+  std::ofstream& writer() {
+    if (!writer_.is_open()) {
+      writer_.open(logPath_.path(), std::ios::binary | std::ios::out | std::ios::app);
+      if (!writer_.is_open()) {
+        throw std::runtime_error("could not open entry log for writing: " + logPath_.text());
+      }
+    }
+    return writer_;
+  }
+
+  std::ifstream& reader() {
+    if (!reader_.is_open()) {
+      reader_.open(logPath_.path(), std::ios::binary | std::ios::in);
+      if (!reader_.is_open()) {
+        throw std::runtime_error("could not open entry log for reading: " + logPath_.text());
+      }
+    }
+    reader_.clear(); // Reset EOF and/or error state from a previous read
+    return reader_;
+  }
+
+public:
+  explicit LogEntryStorage(CheckedPath directory)
+    : directory_(std::move(directory)), logPath_(directory_ / CheckedFileName(LogFileName)), indexPath_(directory_ / CheckedFileName(IndexFileName)) {
+    // throws when an error occurs while creating any of the given directories in the supplied path
+    std::filesystem::create_directories(directory_);
+
+    if (!std::filesystem::exists(logPath_)) {
+      std::filesystem::remove(indexPath_); // A (stale) index can't be used for a new log
+      logId_ = RandomInteger<uint64_t>();
+      std::ofstream file(logPath_.path(), std::ios::binary | std::ios::out | std::ios::trunc);
+      file << MakeLogHeader(logId_);
+      if (!file.flush()) {
+        throw std::runtime_error("Could not write " + logPath_.text());
+      }
+      file.close();
+      SyncFile(logPath_.path());
+      SyncDirectory(directory_.path());
+    }
+    else {
+      std::ifstream file(logPath_.path(), std::ios::binary | std::ios::in);
+      std::string magic(LogMagic.size(), '\0');
+      file.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+      logId_ = ReadBinary(file, uint64_t{});
+      if (!file.good() || magic != LogMagic) {
+        throw std::runtime_error(logPath_.text() + " is not an entry log");
+      }
+    }
+
+    size_ = indexedSize_ = LogHeaderSize;
+  }
+
+  ~LogEntryStorage() noexcept override = default;
+
+  static bool Exists(const CheckedPath& directory) {
+    return std::filesystem::exists(directory / CheckedFileName(LogFileName));
+  }
+
+  void load(const CellLoader& loader) override {
+    assert(!writer_.is_open());
+    size_ = std::filesystem::file_size(logPath_);
+
+    auto covered = this->loadIndex(loader);
+    indexedSize_ = covered.value_or(LogHeaderSize);
+
+    // Replay records that were appended after the index was written
+    size_t replayed = 0U;
+    auto& in = this->reader();
+    in.seekg(static_cast<std::streamoff>(indexedSize_));
+    for (auto offset = indexedSize_; offset < size_; ) {
+      uint64_t recordSize{};
+      auto record = ReadRecord(in, size_ - offset, recordSize);
+      if (!record.has_value()) {
+        if (!this->isIncompleteTrailingRecord(offset, recordSize)) {
+          throw std::runtime_error("Entry log " + logPath_.text() + " contains a damaged record at offset " + std::to_string(offset));
+        }
+        PEP_LOG(LogTag, Severity::Warning) << "Discarding incomplete record at the end of " << logPath_;
+        reader_.close();
+        std::filesystem::resize_file(logPath_, offset);
+        size_ = offset;
+        break;
+      }
+      record->version.location = offset;
+      loader(record->participant, record->column, std::vector<EntryVersion>{record->version}, true);
+      offset += recordSize;
+      ++replayed;
+    }
+
+    PEP_LOG(LogTag, Severity::Info) << "Loaded entry log " << logPath_ << ": "
+      << (covered.has_value() ? "used index and " : "no usable index; ") << "replayed " << replayed << " record(s)";
+  }
+
+  std::string read(const EntryName& name, const EntryVersion& version) override {
+    std::lock_guard lock(readMux_);
+    if (version.location < LogHeaderSize || version.location >= size_) {
+      throw std::runtime_error("Entry " + name.string() + " is not located in the entry log");
+    }
+    auto& in = this->reader();
+    in.seekg(static_cast<std::streamoff>(version.location));
+    uint64_t recordSize{};
+    auto record = ReadRecord(in, size_ - version.location, recordSize);
+    if (!record.has_value()
+      || record->participant != name.participant()
+      || record->column != name.column()
+      || record->version.validFrom != version.validFrom) {
+      throw std::runtime_error("Could not read entry " + name.string() + " at timestamp "
+        + std::to_string(TicksSinceEpoch<milliseconds>(version.validFrom)) + " from the entry log");
+    }
+    return std::move(record->serialized);
+  }
+
+  uint64_t write(const EntryName& name, const EntryVersion& version, const std::string& serialized) override {
+    auto record = EncodeRecord(name, version, serialized);
+    auto& out = this->writer();
+    out << record;
+    if (!out.flush()) {
+      // We can't tell how much of the record has been written. Ensure that a (possibly) partial record is overwritten by the next one.
+      out.close();
+      std::filesystem::resize_file(logPath_, size_);
+      throw std::runtime_error("failed to append entry " + name.string() + " to " + logPath_.text());
+    }
+    std::lock_guard lock(readMux_);
+    auto location = size_;
+    size_ += record.size();
+    return location;
+  }
+
+  void sync() override {
+    // Records are flushed (to the OS) by write(), so we only need to have the OS transfer them to the storage device
+    SyncFile(logPath_.path());
+  }
+
+  void checkpoint(const CellEnumerator& cells) override {
+    if (indexedSize_ == size_) {
+      return; // Index is up to date
+    }
+
+    auto tempPath = indexPath_ + ".tmp";
+    std::ofstream file(tempPath.path(), std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+      throw std::runtime_error("could not write file: " + tempPath.text());
+    }
+    auto state = XXH64_createState();
+    if (state == nullptr) {
+      throw std::bad_alloc();
+    }
+    PEP_DEFER(XXH64_freeState(state));
+    XXH64_reset(state, 0ULL);
+    auto emit = [&file, state](const std::string& data) {
+      XXH64_update(state, data.data(), data.size());
+      file << data;
+    };
+
+    std::ostringstream header;
+    header << IndexMagic;
+    WriteBinary(header, logId_);
+    WriteBinary(header, size_);
+    emit(std::move(header).str());
+
+    // Cells are enumerated per participant: buffer a participant's cells until we know how many it has
+    std::optional<std::string> participant;
+    uint32_t cellCount = 0U;
+    std::ostringstream participantCells;
+    auto emitParticipant = [&]() {
+      if (participant.has_value()) {
+        std::ostringstream head;
+        WriteBinary(head, *participant);
+        WriteBinary(head, cellCount);
+        emit(std::move(head).str());
+        emit(std::exchange(participantCells, std::ostringstream()).str());
+      }
+      cellCount = 0U;
+    };
+    cells([&](const EntryName& name, const EntryVersions& versions) {
+      if (name.participant() != participant) {
+        emitParticipant();
+        participant = name.participant();
+      }
+      WriteBinary(participantCells, name.column());
+      WriteBinary(participantCells, static_cast<uint32_t>(versions.size()));
+      for (const auto& version : versions) {
+        WriteVersion(participantCells, version);
+        WriteBinary(participantCells, version.location);
+      }
+      ++cellCount;
+    });
+    emitParticipant();
+
+    std::ostringstream trailer;
+    WriteBinary(trailer, std::string()); // Marks the end of the participant list
+    emit(std::move(trailer).str());
+    WriteBinary(file, uint64_t{XXH64_digest(state)});
+    if (!file.flush()) {
+      throw std::runtime_error("failed to write entry log index to file: " + tempPath.text());
+    }
+    file.close();
+
+    std::filesystem::rename(tempPath, indexPath_);
+    indexedSize_ = size_;
+  }
+
+  std::optional<std::vector<uint64_t>> compact(const CellEnumerator& cells) override {
+    auto compactedPath = directory_ / CheckedFileName(CompactionFileName);
+    auto compactedId = RandomInteger<uint64_t>();
+    std::ofstream file(compactedPath.path(), std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+      throw std::runtime_error("could not write file: " + compactedPath.text());
+    }
+    file << MakeLogHeader(compactedId);
+
+    std::vector<uint64_t> locations;
+    uint64_t size = LogHeaderSize;
+    cells([&](const EntryName& name, const EntryVersions& versions) {
+      for (const auto& version : versions) {
+        auto record = EncodeRecord(name, version, this->read(name, version));
+        file << record;
+        locations.push_back(size);
+        size += record.size();
+      }
+    });
+    if (!file.flush()) {
+      throw std::runtime_error("failed to write compacted entry log to file: " + compactedPath.text());
+    }
+    file.close();
+    // Ensure that the compacted log is on the storage device before it replaces the (durable) current one
+    SyncFile(compactedPath.path());
+
+    PEP_LOG(LogTag, Severity::Info) << "Compacted entry log " << logPath_ << " from " << size_ << " to " << size << " bytes";
+
+    // Discard the index before replacing the log, so that we'll never apply it to the compacted log
+    std::lock_guard lock(readMux_);
+    this->closeFiles();
+    std::filesystem::remove(indexPath_);
+    std::filesystem::rename(compactedPath, logPath_);
+    SyncDirectory(directory_.path());
+    logId_ = compactedId;
+    size_ = size;
+    indexedSize_ = LogHeaderSize;
+    return locations;
+  }
+};
+
+const std::string LogEntryStorage::LogFileName = "entries.log";
+const std::string LogEntryStorage::IndexFileName = "entries.log.index";
+const std::string LogEntryStorage::CompactionFileName = "entries.log.compacting";
+
+}
+
+bool EntryStorage::Exists(Type type, const CheckedPath& directory) {
+  if (!std::filesystem::is_directory(directory.path())) {
+    return false;
+  }
+  switch (type) {
+  case Type::Directory:
+  {
+    auto participants = std::filesystem::directory_iterator(directory);
+    return std::any_of(begin(participants), end(participants), &DirectoryEntryStorage::IsParticipantDirectory);
+  }
+  case Type::Log:
+    return LogEntryStorage::Exists(directory);
+  }
+  throw std::runtime_error("Unsupported entry storage type " + std::to_string(static_cast<int>(type)));
+}
+
+std::unique_ptr<EntryStorage> EntryStorage::Create(Type type, const CheckedPath& directory) {
+  switch (type) {
+  case Type::Directory:
+    return std::make_unique<DirectoryEntryStorage>(directory);
+  case Type::Log:
+    return std::make_unique<LogEntryStorage>(directory);
+  }
+  throw std::runtime_error("Unsupported entry storage type " + std::to_string(static_cast<int>(type)));
+}
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <pep/storagefacility/EntryName.hpp>
+#include <pep/utils/CheckedPath.hpp>
+#include <pep/utils/PropertyBasedContainer.hpp>
+#include <pep/utils/Timestamp.hpp>
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pep {
+
+/// \brief Summary of a cell version ("data card"), as kept in memory by the FileStore.
+struct EntryVersion {
+  Timestamp validFrom;
+  uint64_t checksumSubstitute{};
+  uint64_t payloadSize{};
+  bool isOriginalPayloadOwner{};
+  bool isTombstone{};
+  uint64_t location{}; // Where the EntryStorage keeps the (serialized) entry, if it needs to know
+};
+using EntryVersions = PropertyBasedContainer<EntryVersion, &EntryVersion::validFrom>::set;
+
+/// \brief Persists the FileStore's (serialized) entries.
+/// \remark Like the FileStore itself, implementations are not thread safe, except that read() may be invoked
+///         from other threads (e.g. a worker pool) while the FileStore's thread uses the storage.
+class EntryStorage {
+public:
+  enum class Type {
+    /// \brief A directory per participant, containing a directory per column, containing a file per entry.
+    /// \remark sync() has to sync every entry file (and its directory) separately, making it slower than the Log's.
+    Directory,
+    /// \brief An append-only log of (checksummed) entries, plus an index of the cells that the log contains.
+    Log,
+  };
+
+  /// \brief Receives (some of) the stored versions of a cell.
+  /// \remark If "summarized" is false, the storage only knows the versions' validFrom timestamps. The FileStore must
+  ///         then read and deserialize the entries to produce the rest of the summary.
+  using CellLoader = std::function<void(const std::string& participant, const std::string& column, std::vector<EntryVersion> versions, bool summarized)>;
+  /// \brief Receives a cell and its versions.
+  using CellVisitor = std::function<void(const EntryName& name, const EntryVersions& versions)>;
+  /// \brief Invokes the visitor for every cell held by the FileStore.
+  using CellEnumerator = std::function<void(const CellVisitor& visitor)>;
+
+  virtual ~EntryStorage() noexcept = default;
+
+  /// \brief Reports all stored cell versions to the loader. May report a cell more than once, in which case the versions should be merged.
+  virtual void load(const CellLoader& loader) = 0;
+
+  /// \brief Produces the serialized entry for the specified version, i.e. the data that was passed to write().
+  /// \remark May be invoked from any thread, concurrently with write(), but not with compact().
+  virtual std::string read(const EntryName& name, const EntryVersion& version) = 0;
+
+  /// \brief Stores the serialized entry for the specified version.
+  /// \return The location of the stored entry, to be included in the EntryVersion that is subsequently passed to read().
+  virtual uint64_t write(const EntryName& name, const EntryVersion& version, const std::string& serialized) = 0;
+
+  /// \brief Ensures that entries that were previously write()n have been transferred to the storage device.
+  /// \remark May be invoked from any thread, concurrently with read() and write().
+  virtual void sync() = 0;
+
+  /// \brief Persists whatever (e.g. index) the storage needs to load() quickly. Invoked when the FileStore has finished loading and when it's discarded.
+  virtual void checkpoint(const CellEnumerator&) {}
+
+  /// \brief Rewrites the storage so that it only contains the (enumerated) cell versions.
+  /// \return The versions' new locations in the order in which they were enumerated, or std::nullopt if the storage doesn't support compaction.
+  virtual std::optional<std::vector<uint64_t>> compact(const CellEnumerator&) { return std::nullopt; }
+
+  /// \brief Determines whether the specified directory contains entries stored by a storage of the specified type.
+  static bool Exists(Type type, const CheckedPath& directory);
+  static std::unique_ptr<EntryStorage> Create(Type type, const CheckedPath& directory);
+
+protected:
+  EntryStorage() = default;
+};
+
+}
@@ -1,16 +1,21 @@
 #include <pep/storagefacility/FileStore.hpp>
 #include <pep/storagefacility/EntryPayload.hpp>
 #include <pep/utils/BuildFlavor.hpp>
+#include <pep/utils/Exceptions.hpp>
 #include <pep/storagefacility/Constants.hpp>
+#include <pep/utils/File.hpp>
 #include <pep/utils/Log.hpp>
 #include <pep/utils/Random.hpp>
 #include <pep/utils/Raw.hpp>
 #include <pep/morphing/MorphingSerializers.hpp>
+#include <pep/async/CreateObservable.hpp>
+#include <pep/async/WorkerPool.hpp>
 
-#include <boost/lexical_cast.hpp>
+#include <prometheus/counter.h>
+#include <prometheus/gauge.h>
+#include <rxcpp/operators/rx-map.hpp>
 
 #include <filesystem>
-#include <fstream>
 #include <random>
 #include <sstream>
 
@@ -30,6 +35,34 @@ uint64_t GenerateChecksumSubstitute() {
 const std::string EntryFileType("pepentry");
 const std::string LogTag("StorageFacility");
 
+FileStore::CellVersion MakeCellVersion(const FileStore::Entry& entry, uint64_t location) {
+  return FileStore::CellVersion{
+    .validFrom = entry.getValidFrom(),
+    .checksumSubstitute = entry.getChecksumSubstitute(),
+    .payloadSize = entry.payloadSize(),
+    .isOriginalPayloadOwner = entry.isOriginalPayloadOwner(),
+    .isTombstone = entry.isTombstone(),
+    .location = location,
+  };
+}
+
+// Produces the content addresses of the entry's pages, or nullptr if it doesn't have content addressed pages
+const std::vector<std::string>* ContentAddresses(const FileStore::Entry* entry) {
+  if (entry == nullptr || entry->content() == nullptr) {
+    return nullptr;
+  }
+  auto paged = std::dynamic_pointer_cast<PagedEntryPayload>(entry->content()->payload());
+  if (paged == nullptr || paged->contentAddresses().empty()) {
+    return nullptr;
+  }
+  return &paged->contentAddresses();
+}
+
+std::runtime_error LoadError(const EntryName& name, const EntryVersion& version, const std::exception& cause) {
+  return std::runtime_error("Could not load entry for cell " + name.string()
+    + " at timestamp " + std::to_string(TicksSinceEpoch<milliseconds>(version.validFrom)) + ": " + cause.what());
+}
+
 }
 
 // Design:
@@ -43,11 +76,9 @@ const std::string LogTag("StorageFacility");
 
  // Challenges:
  // - correctly (with all error condition) retrieve data from S3 interface
- // - if there are many entries; starting will take longer (possible migrate to mmap()ed data structure)
+ // - if there are many entries; starting will take longer (use the "Log" EntryStorage, which loads from an index)
  // - partitioning (within a host; but also mutliple storage facilities)
 
-const std::string FileStore::Entry::FileExtension = ".entry";
-
 EntryContent::MetadataEntry FileStore::makeMetadataEntry(std::string key, std::string value) {
   auto pos = metadataValues_.emplace(std::move(key), std::set<std::string>()).first;
   auto valuePos = pos->second.emplace(std::move(value)).first;
@@ -102,24 +133,95 @@ const std::string& FileStore::getColumnString(const std::string& value) {
   return *columnNames_.insert(value).first;
 }
 
+FileStore::Metrics::Metrics(std::shared_ptr<prometheus::Registry> registry)
+  : historicalEntryCacheHits(prometheus::BuildCounter()
+    .Name("pep_sf_historical_entry_cache_hits")
+    .Help("Number of historical entry lookups that were served from memory")
+    .Register(*registry)
+    .Add({})),
+  historicalEntryCacheMisses(prometheus::BuildCounter()
+    .Name("pep_sf_historical_entry_cache_misses")
+    .Help("Number of historical entry lookups that required the entry to be loaded from storage")
+    .Register(*registry)
+    .Add({})),
+  historicalEntryCacheBytes(prometheus::BuildGauge()
+    .Name("pep_sf_historical_entry_cache_bytes")
+    .Help("(Serialized) size of the historical entries kept in memory")
+    .Register(*registry)
+    .Add({})) {
+}
+
+std::shared_ptr<FileStore::Entry> FileStore::HistoricalEntryCache::lookup(const Cell& cell, Timestamp validFrom) {
+  auto position = index_.find(Key(&cell, validFrom));
+  if (position == index_.end()) {
+    return nullptr;
+  }
+  entries_.splice(entries_.begin(), entries_, position->second);
+  return position->second->entry;
+}
+
+void FileStore::HistoricalEntryCache::insert(std::shared_ptr<Entry> entry, uint64_t size) {
+  if (size > maxBytes_) {
+    return; // Would evict everything else and then itself
+  }
+
+  Key key(&entry->getCell(), entry->getValidFrom());
+  auto position = index_.find(key);
+  if (position != index_.end()) { // Concurrent lookups loaded the same entry: keep the existing one
+    entries_.splice(entries_.begin(), entries_, position->second);
+    return;
+  }
+
+  bytes_ += size;
+  entries_.push_front(Cached{ .key = key, .entry = std::move(entry), .size = size });
+  index_.emplace(key, entries_.begin());
+
+  while (bytes_ > maxBytes_) {
+    auto& evicted = entries_.back();
+    bytes_ -= evicted.size;
+    index_.erase(evicted.key);
+    entries_.pop_back();
+  }
+}
+
+void FileStore::HistoricalEntryCache::clear() {
+  index_.clear();
+  entries_.clear();
+  bytes_ = 0U;
+}
+
 FileStore::FileStore(
   const std::filesystem::path& metadatapath,
   const Configuration& pageStoreConfig,
   std::shared_ptr<boost::asio::io_context> io_context,
-  std::shared_ptr<prometheus::Registry> metrics_registry)
+  std::shared_ptr<prometheus::Registry> metrics_registry,
+  EntryStorage::Type storageType,
+  uint64_t historicalEntryCacheSize,
+  std::optional<std::string> pageAddressKey)
   : path_(CheckedPath::FromTrusted(metadatapath)),
-  pagestore_(PageStore::Create(io_context, metrics_registry, pageStoreConfig))
+  ioContext_(io_context),
+  pagestore_(PageStore::Create(io_context, metrics_registry, pageStoreConfig)),
+  historicalEntries_(historicalEntryCacheSize),
+  deduplicator_(pageAddressKey.has_value() ? std::make_unique<PageDeduplicator>(std::move(*pageAddressKey)) : nullptr),
+  metrics_(metrics_registry ? std::make_optional<Metrics>(metrics_registry) : std::nullopt)
 {
   // throws when an error occurs while creating any of the given directories in the supplied path
   std::filesystem::create_directories(path_);
 
   auto start_time = steady_clock::now();
-  for (const auto& p : std::filesystem::directory_iterator(path_)) {
-    auto name = p.path().filename().string();
-    if (std::filesystem::is_directory(p.path()) && name.size() == LocalPseudonym::TextLength()) {
-      participants_.emplace(std::make_unique<Participant>(*this, name, true));
-    }
+  if (storageType == EntryStorage::Type::Log
+    && !EntryStorage::Exists(EntryStorage::Type::Log, path_)
+    && EntryStorage::Exists(EntryStorage::Type::Directory, path_)) {
+    this->migrateToLog();
+  }
+  storage_ = EntryStorage::Create(storageType, path_);
+  if (storageType == EntryStorage::Type::Directory) {
+    PEP_LOG(LogTag, Severity::Warning) << "File store entries in " << path_ << " are kept in directory storage,"
+      << " which must sync every entry file and directory separately before changes are acknowledged."
+      << " Use \"Log\" MetadataStorage to store and sync entries more efficiently";
   }
+  this->load();
+  storage_->checkpoint([this](const EntryStorage::CellVisitor& visitor) { this->enumerateCells(visitor); });
 
   size_t entryCount{};
   uint64_t totalPayloadBytes_{}, rollingPayloadBytes_{};
@@ -136,47 +238,181 @@ FileStore::FileStore(
   PEP_LOG(LogTag, Severity::Info) << message.str();
 }
 
-FileStore::Participant::Participant(FileStore& store, std::string name, bool load)
-  : store_(store), name_(std::move(name)) {
-  if (load) {
-    for (const auto& p : std::filesystem::directory_iterator(this->path())) {
-      if (p.is_directory()) {
-        cells_.emplace(std::make_unique<Cell>(*this, p.path().filename().string(), true));
-      }
+FileStore::~FileStore() noexcept {
+  try {
+    if (syncedWrites_ != writes_) {
+      storage_->sync();
     }
+    storage_->checkpoint([this](const EntryStorage::CellVisitor& visitor) { this->enumerateCells(visitor); });
   }
-  else {
-    // throws when an error occurs while creating any of the given directories in the supplied path
-    std::filesystem::create_directories(this->path());
+  catch (const std::exception& e) {
+    PEP_LOG(LogTag, Severity::Error) << "Could not checkpoint file store entry storage: " << e.what();
   }
 }
 
-FileStore::CellVersion FileStore::CellVersion::FromEntry(const Entry& entry) {
-  return CellVersion{
-    .validFrom = entry.getValidFrom(),
-    .checksumSubstitute = entry.getChecksumSubstitute(),
-    .payloadSize = entry.payloadSize(),
-    .isOriginalPayloadOwner = entry.isOriginalPayloadOwner(),
-    .isTombstone = entry.isTombstone(),
-  };
+void FileStore::load() {
+  storage_->load([this](const std::string& participant, const std::string& column, std::vector<CellVersion> versions, bool summarized) {
+    auto& cell = this->provideParticipant(participant).provideCell(column);
+    for (const auto& version : versions) {
+      if (summarized) {
+        cell.addVersion(version);
+      }
+      else {
+        cell.addEntry(Entry::Load(cell, version), version.location);
+      }
+    }
+  });
+
+  for (const auto& participant : participants_) {
+    for (const auto& cell : participant->cells_) {
+      cell->loadLatest();
+    }
+  }
 }
 
-FileStore::Cell::Cell(Participant& participant, const std::string& columnName, bool load)
-  : participant_(participant), columnName_(participant.fileStore().getColumnString(columnName)) {
-  if (load) {
-    for (const auto& p : std::filesystem::directory_iterator(this->path())) {
-      auto entry = Entry::TryLoad(*this, CheckedPath::FromTrusted(p.path()));
-      if (entry != nullptr) {
-        this->addEntry(entry);
+void FileStore::migrateToLog() {
+  PEP_LOG(LogTag, Severity::Info) << "Migrating file store entries in " << path_ << " to an entry log";
+  storage_ = EntryStorage::Create(EntryStorage::Type::Directory, path_);
+  this->load();
+
+  // Write the log into a subdirectory, and only move it into place when it's complete
+  auto migrationPath = path_ / CheckedFileName("log-migration");
+  std::filesystem::remove_all(migrationPath);
+  size_t migrated = 0U;
+  {
+    auto log = EntryStorage::Create(EntryStorage::Type::Log, migrationPath);
+    this->enumerateCells([this, &log, &migrated](const EntryName& name, const CellVersions& versions) {
+      for (const auto& version : versions) {
+        log->write(name, version, storage_->read(name, version));
+        ++migrated;
       }
+    });
+    log->sync(); // Before we move the log into place: see below
+  }
+  for (const auto& file : std::filesystem::directory_iterator(migrationPath)) {
+    std::filesystem::rename(file.path(), path_.path() / file.path().filename());
+  }
+  // Once the log exists, we'll no longer load the directory storage: ensure that it's complete on the storage device
+  SyncDirectory(path_.path());
+  std::filesystem::remove(migrationPath);
+
+  historicalEntries_.clear();
+  if (deduplicator_ != nullptr) {
+    deduplicator_->clear(); // Discards the references from the participants that we're about to clear
+  }
+  participants_.clear();
+  storage_.reset();
+  PEP_LOG(LogTag, Severity::Info) << "Migrated " << migrated << " file store entries to an entry log."
+    << " The participant directories in " << path_ << " are no longer used and can be removed";
+}
+
+void FileStore::enumerateCells(const EntryStorage::CellVisitor& visitor) const {
+  for (const auto& participant : participants_) {
+    for (const auto& cell : participant->cells_) {
+      visitor(cell->entryName(), cell->versions());
     }
   }
+}
+
+rxcpp::observable<FakeVoid> FileStore::whenDurable(std::shared_ptr<WorkerPool> workerPool) {
+  if (syncedWrites_ == writes_) {
+    return rxcpp::observable<>::just(FakeVoid());
+  }
+  return CreateObservable<FakeVoid>([self = SharedFrom(*this), workerPool, writes = writes_](rxcpp::subscriber<FakeVoid> subscriber) {
+    self->durabilityWaiters_.push_back(DurabilityWaiter{ .writes = writes, .subscriber = subscriber });
+    self->syncWrites(workerPool);
+  });
+}
+
+void FileStore::syncWrites(std::shared_ptr<WorkerPool> workerPool) {
+  if (syncing_ || durabilityWaiters_.empty()) {
+    return; // We'll sync again (if needed) when the current sync has finished
+  }
+
+  syncing_ = true;
+  auto self = SharedFrom(*this);
+  auto writes = writes_;
+  rxcpp::observable<>::just(FakeVoid())
+    .observe_on(workerPool->worker())
+    .map([self](FakeVoid) {
+      self->storage_->sync();
+      return FakeVoid();
+    })
+    .observe_on(ObserveOnAsio(*ioContext_))
+    .subscribe(
+      [self, workerPool, writes](FakeVoid) { self->finishSync(writes, nullptr, workerPool); },
+      [self, workerPool, writes](std::exception_ptr error) { self->finishSync(writes, error, workerPool); });
+}
+
+void FileStore::finishSync(uint64_t synced, std::exception_ptr error, std::shared_ptr<WorkerPool> workerPool) {
+  syncing_ = false;
+  if (error == nullptr) {
+    syncedWrites_ = synced;
+  }
   else {
-    // throws when an error occurs while creating any of the given directories in the supplied path
-    std::filesystem::create_directories(this->path());
+    PEP_LOG(LogTag, Severity::Error) << "Could not sync file store entries to storage: " << GetExceptionMessage(error);
+  }
+
+  // Notify the waiters that were covered by this sync, retaining the ones that need a followup sync
+  auto waiters = std::move(durabilityWaiters_);
+  durabilityWaiters_.clear();
+  for (auto& waiter : waiters) {
+    if (waiter.writes > synced) {
+      durabilityWaiters_.push_back(std::move(waiter));
+    }
+    else if (error != nullptr) {
+      waiter.subscriber.on_error(error);
+    }
+    else {
+      waiter.subscriber.on_next(FakeVoid());
+      waiter.subscriber.on_completed();
+    }
+  }
+
+  this->syncWrites(workerPool);
+}
+
+void FileStore::cacheHistoricalEntry(std::shared_ptr<Entry> entry, uint64_t size) {
+  historicalEntries_.insert(std::move(entry), size);
+  if (metrics_.has_value()) {
+    metrics_->historicalEntryCacheBytes.Set(static_cast<double>(historicalEntries_.bytes()));
+  }
+}
+
+void FileStore::countHistoricalLookup(bool hit) {
+  if (metrics_.has_value()) {
+    (hit ? metrics_->historicalEntryCacheHits : metrics_->historicalEntryCacheMisses).Increment();
   }
 }
 
+void FileStore::compact() {
+  auto enumerate = [this](const EntryStorage::CellVisitor& visitor) { this->enumerateCells(visitor); };
+  auto locations = storage_->compact(enumerate);
+  if (!locations.has_value()) {
+    return;
+  }
+
+  std::span<const uint64_t> remaining(*locations);
+  for (const auto& participant : participants_) {
+    for (const auto& cell : participant->cells_) {
+      auto count = cell->versions().size();
+      assert(remaining.size() >= count);
+      cell->relocateVersions(remaining.first(count));
+      remaining = remaining.subspan(count);
+    }
+  }
+  assert(remaining.empty());
+  storage_->checkpoint(enumerate);
+}
+
+FileStore::Participant::Participant(FileStore& store, std::string name)
+  : store_(store), name_(std::move(name)) {
+}
+
+FileStore::Cell::Cell(Participant& participant, const std::string& columnName)
+  : participant_(participant), columnName_(participant.fileStore().getColumnString(columnName)) {
+}
+
 void FileStore::getMetrics(size_t& entryCount, uint64_t& totalPayloadBytes, uint64_t& rollingPayloadBytes, const std::set<std::string>& columns) const {
   entryCount = 0U;
   totalPayloadBytes = 0U;
@@ -221,7 +457,73 @@ std::shared_ptr<FileStore::Entry> FileStore::lookup(const EntryName& name, Times
   return participant->lookup(name.column(), validAt);
 }
 
-std::shared_ptr<FileStore::Entry> FileStore::Cell::lookup(Timestamp validAt) {
+rxcpp::observable<std::vector<std::shared_ptr<FileStore::Entry>>> FileStore::lookupAsync(std::vector<EntryKey> keys, std::shared_ptr<WorkerPool> workerPool) {
+  struct Load {
+    size_t index{}; // into the key and result vectors
+    Cell* cell{};
+    CellVersion version;
+    std::string serialized; // filled in on the worker pool
+  };
+
+  // Serve what we can from memory, collecting the historical entries that must be loaded from storage
+  auto sharedKeys = std::make_shared<const std::vector<EntryKey>>(std::move(keys));
+  std::vector<std::shared_ptr<Entry>> entries(sharedKeys->size());
+  std::vector<Load> loads;
+  for (size_t i = 0; i < sharedKeys->size(); ++i) {
+    const auto& key = (*sharedKeys)[i];
+    auto participant = this->getParticipant(key.name.participant());
+    auto cell = participant == nullptr ? nullptr : participant->getCell(key.name.column());
+    auto version = cell == nullptr ? nullptr : cell->findVersion(key.validAt);
+    if (version == nullptr) {
+      continue;
+    }
+    if (version->validFrom == cell->latest()->getValidFrom()) {
+      entries[i] = cell->latest();
+      continue;
+    }
+    entries[i] = historicalEntries_.lookup(*cell, version->validFrom);
+    this->countHistoricalLookup(entries[i] != nullptr);
+    if (entries[i] == nullptr) {
+      loads.push_back(Load{ .index = i, .cell = cell, .version = *version, .serialized = {} });
+    }
+  }
+
+  if (loads.empty()) {
+    return rxcpp::observable<>::just(std::move(entries));
+  }
+
+  // Storage reads may block, so we perform them on the worker pool. Entries are deserialized back on our
+  // I/O context because that (a.o.) interns metadata strings in our (non-thread safe) collections.
+  auto self = SharedFrom(*this);
+  return workerPool->batched_map<8>(std::move(loads),
+    ObserveOnAsio(*ioContext_),
+    [self, sharedKeys](Load load) {
+      const auto& name = (*sharedKeys)[load.index].name;
+      try {
+        load.serialized = self->storage_->read(name, load.version);
+      }
+      catch (const std::exception& e) {
+        throw LoadError(name, load.version, e);
+      }
+      return load;
+    })
+    .map([self, sharedKeys, entries = std::move(entries)](std::vector<Load> loaded) mutable {
+      for (auto& load : loaded) {
+        std::shared_ptr<Entry> entry;
+        try {
+          entry = Entry::Deserialize(*load.cell, load.version.validFrom, load.serialized);
+        }
+        catch (const std::exception& e) {
+          throw LoadError((*sharedKeys)[load.index].name, load.version, e);
+        }
+        self->cacheHistoricalEntry(entry, load.serialized.size());
+        entries[load.index] = std::move(entry);
+      }
+      return std::move(entries);
+    });
+}
+
+const FileStore::CellVersion* FileStore::Cell::findVersion(Timestamp validAt) const {
   // The std::map<>::lower_bound function will find the entry _after_ the one we need when validAt == Timestamp::max().
   // So to make the function produce consistent results, we search for "validAt+1" to ensure that we _always_ find the entry after the one we need.
   auto find = validAt == Timestamp::max() ? Timestamp::max() : validAt + 1ms;
@@ -233,12 +535,29 @@ std::shared_ptr<FileStore::Entry> FileStore::Cell::lookup(Timestamp validAt) {
 
   // Since we're positioned after the item we're interested in, we skip back.
   --it;
+  return &*it;
+}
+
+std::shared_ptr<FileStore::Entry> FileStore::Cell::lookup(Timestamp validAt) {
+  auto version = this->findVersion(validAt);
+  if (version == nullptr) {
+    return nullptr;
+  }
 
   assert(latest_ != nullptr);
-  if (it->validFrom == latest_->getValidFrom()) {
+  if (version->validFrom == latest_->getValidFrom()) {
     return latest_;
   }
-  return Entry::Load(*this, it->validFrom);
+
+  auto& store = participant_.fileStore();
+  auto entry = store.historicalEntries_.lookup(*this, version->validFrom);
+  store.countHistoricalLookup(entry != nullptr);
+  if (entry == nullptr) {
+    uint64_t size{};
+    entry = Entry::Load(*this, *version, &size);
+    store.cacheHistoricalEntry(entry, size);
+  }
+  return entry;
 }
 
 std::set<std::string> FileStore::Cell::pagePaths() const {
@@ -267,11 +586,6 @@ FileStore::EntryChange::EntryChange(const Entry& overwrites)
   : EntryBase(overwrites.getCell(), GenerateChecksumSubstitute(), overwrites.cloneContent()), lastEntryValidFrom_(overwrites.getValidFrom()) {
 }
 
-CheckedPath FileStore::Entry::getFilePath(const std::string& extension) const {
-  auto filename = std::to_string(TicksSinceEpoch<milliseconds>(this->getValidFrom())) + extension;
-  return this->getCell().path() / CheckedFileName(filename);
-}
-
 FileStore::EntryBase::EntryBase(Cell& cell, uint64_t checksumSubstitute, std::unique_ptr<EntryContent> content)
   : cell_(cell), checksumSubstitute_(checksumSubstitute), content_(std::move(content)) {
 }
@@ -328,7 +642,7 @@ messaging::MessageSequence FileStore::Entry::readPage(size_t index) {
   return payload->readPage(cell.participant().fileStore().pagestore_, cell.entryName(), index);
 }
 
-void FileStore::Entry::save() const {
+std::string FileStore::Entry::serialize() const {
   std::ostringstream out;
 
   out << EntryFileType;
@@ -347,20 +661,9 @@ void FileStore::Entry::save() const {
   std::string content = std::move(out).str();
   XXH64_hash_t hash = XXH64(content.data(), content.length(), 0ULL);
 
-  std::filesystem::path tempfile = this->getFilePath(".tmp");
-  std::ofstream outfile;
-  outfile.open(tempfile, std::ios::binary | std::ios::out | std::ios::trunc);
-  if (!outfile.is_open())
-    throw std::invalid_argument("could not write file: " + tempfile.string());
-
-  outfile << content;
-  WriteBinary(outfile, uint64_t{hash});
-  if (!outfile) {
-    throw std::runtime_error("failed to write content to file: " + tempfile.string());
-  }
-  outfile.close();
-
-  std::filesystem::rename(tempfile, this->getFilePath(Entry::FileExtension));
+  std::ostringstream trailer;
+  WriteBinary(trailer, uint64_t{hash});
+  return content + std::move(trailer).str();
 }
 
 void FileStore::EntryChange::commit(Timestamp availableFrom) && {
@@ -394,10 +697,12 @@ void FileStore::EntryChange::commit(Timestamp availableFrom) && {
   // Prevent this EntryChange from being re-used (a.o. because we just std::moved it)
   valid_ = false;
 
-  // Save to disk
-  entry->save();
+  // Save to disk. Callers should wait for whenDurable() before reporting the entry as stored
+  auto& store = this->getFileStore();
+  auto location = store.storage_->write(entry->getName(), MakeCellVersion(*entry, 0U), entry->serialize());
+  ++store.writes_;
   // Include memory data structure in tree
-  this->getCell().addEntry(entry);
+  this->getCell().addEntry(entry, location);
 }
 
 void FileStore::EntryChange::cancel() && {
@@ -409,78 +714,58 @@ void FileStore::EntryChange::cancel() && {
   valid_ = false;
 }
 
-std::shared_ptr<FileStore::Entry> FileStore::Entry::Load(Cell& cell, Timestamp timestamp) {
-  // Note: On case-insensitive filesystems (e.g. Windows), file names could collide.
-  // Additionally, NTFS 8.3 short names could collide (a column called "PARTIC~1" will collide with "ParticipantIdentifier").
-  // See https://learn.microsoft.com/en-us/windows/win32/fileio/naming-a-file.
-  // This may lead to security issues.
-  // So basically, we should not run the production StorageFacility on Windows with the current code.
-  auto filename = std::to_string(TicksSinceEpoch<milliseconds>(timestamp)) + FileExtension;
-  auto result = TryLoad(cell, cell.path() / CheckedFileName(filename));
-  if (result == nullptr) {
-    throw std::runtime_error("Could not load entry for cell " + cell.entryName().string()
-        + " at timestamp " + std::to_string(TicksSinceEpoch<milliseconds>(timestamp)));
+std::shared_ptr<FileStore::Entry> FileStore::Entry::Load(Cell& cell, const EntryVersion& version, uint64_t* serializedSize) {
+  auto name = cell.entryName();
+  try {
+    auto serialized = cell.participant().fileStore().storage_->read(name, version);
+    if (serializedSize != nullptr) {
+      *serializedSize = serialized.size();
+    }
+    return Deserialize(cell, version.validFrom, serialized);
   }
-  return result;
-}
-
-std::shared_ptr<FileStore::Entry> FileStore::Entry::TryLoad(Cell& cell, const CheckedPath& checkedPath) {
-  const std::filesystem::path& path = checkedPath;
-  if (!std::filesystem::is_regular_file(path) || path.extension().string() != FileExtension) {
-    return nullptr;
+  catch (const std::exception& e) {
+    throw LoadError(name, version, e);
   }
+}
 
-  Timestamp validFrom(milliseconds{boost::lexical_cast<milliseconds::rep>(path.stem().string())});
-
-  std::ifstream infile;
-  infile.open(path, std::ios::binary | std::ios::in);
-  if (!infile.is_open())
-    throw std::invalid_argument("could not open file for reading");
+std::shared_ptr<FileStore::Entry> FileStore::Entry::Deserialize(Cell& cell, Timestamp validFrom, const std::string& serialized) {
+  std::istringstream in(serialized);
 
-  // Read magic bytes from start of file, validating that this is file indeed represents a file store entry
+  // Read magic bytes from start of data, validating that it indeed represents a file store entry
   std::string fileType(EntryFileType.size(), '\0');
-  infile.read(fileType.data(), static_cast<std::streamsize>(fileType.size()));
+  in.read(fileType.data(), static_cast<std::streamsize>(fileType.size()));
   if (fileType != EntryFileType) {
-    throw std::invalid_argument("could not read file (wrong file type): " + path.string());
+    throw std::invalid_argument("could not read entry (wrong file type)");
   }
 
-  // Read the entry's contents from the file
-  auto storedName = ReadBinary(infile, std::string());
+  // Read the entry's contents
+  auto storedName = ReadBinary(in, std::string());
   if (storedName != cell.entryName().string()) {
-    throw std::runtime_error("could not read file (wrong entry name)");
+    throw std::runtime_error("could not read entry (wrong entry name)");
   }
 
-  Timestamp storedValidFrom(milliseconds{ReadBinary(infile, std::uint64_t{})});
+  Timestamp storedValidFrom(milliseconds{ReadBinary(in, std::uint64_t{})});
   if (storedValidFrom != validFrom) {
-    throw std::runtime_error("could not read file (wrong validity timestamp)");
+    throw std::runtime_error("could not read entry (wrong validity timestamp)");
   }
 
-  auto pages = ReadBinary(infile, std::vector<PageId>());
-  auto properties = ReadBinary(infile, PersistedEntryProperties());
+  auto pages = ReadBinary(in, std::vector<PageId>());
+  auto properties = ReadBinary(in, PersistedEntryProperties());
 
   auto checksumSubstitute = ExtractPersistedEntryProperty<uint64_t>(properties, ChecksumSubstituteKey);
   auto entryContent = EntryContent::Load(cell.participant().fileStore(), properties, pages);
 
-  // Read content hash from (end of) file
+  // Read content hash from (end of) data
   uint64_t expectedHash = 0;
-  expectedHash = ReadBinary(infile, expectedHash);
-  if (!infile.good())
-    throw std::invalid_argument("could not read file (error reading): " + path.string());
-
-  // Read the data that the hash was calculated over: the entire file minus the hash itself
-  auto size = static_cast<std::streamsize>(infile.tellg()) - static_cast<std::streamsize>(sizeof(expectedHash));
-  std::string content(static_cast<size_t>(size), '\0');
-  infile.seekg(0, std::ios::beg);
-  infile.read(content.data(), size);
-  if (!infile.good())
-    throw std::invalid_argument("could not read file (for hash)");
-
-  infile.close();
-
-  // Validate file content against its hash
-  uint64_t calculatedHash = XXH64(content.data(), content.length(), uint64_t{0});
+  expectedHash = ReadBinary(in, expectedHash);
+  if (!in.good())
+    throw std::invalid_argument("could not read entry (error reading)");
+
+  // Validate the data that the hash was calculated over: everything minus the hash itself
+  auto size = static_cast<size_t>(in.tellg()) - sizeof(expectedHash);
+  uint64_t calculatedHash = XXH64(serialized.data(), size, uint64_t{0});
   if (calculatedHash != expectedHash)
-    throw std::invalid_argument("hash did not match for file " + path.string());
+    throw std::invalid_argument("hash did not match for entry");
 
   return Entry::Create(cell, validFrom, checksumSubstitute, std::move(entryContent));
 }
@@ -512,17 +797,14 @@ rxcpp::observable<std::string> FileStore::EntryChange::appendPage(std::shared_pt
   if (pagedPayload_ == nullptr) {
     throw std::runtime_error("Can't append page to nonpaged payload");
   }
-  return pagedPayload_->appendPage(*this->getFileStore().pagestore_, this->getName(), pagenr, rawPage, payloadSize);
+  auto& store = this->getFileStore();
+  return pagedPayload_->appendPage(*store.pagestore_, this->getName(), pagenr, rawPage, payloadSize, store.deduplicator_.get());
 }
 
 EntryName FileStore::Cell::entryName() const {
   return EntryName(this->participant().name(), columnName_);
 }
 
-CheckedPath FileStore::Cell::path() const {
-  return this->participant().path() / CheckedFileName(columnName_);
-}
-
 void FileStore::Cell::getMetrics(size_t& entryCount, uint64_t& totalPayloadBytes, uint64_t& rollingPayloadBytes) const {
   entryCount = versions_.size();
 
@@ -536,8 +818,8 @@ void FileStore::Cell::getMetrics(size_t& entryCount, uint64_t& totalPayloadBytes
   rollingPayloadBytes = latest_ ? latest_->payloadSize() : 0U;
 }
 
-void FileStore::Cell::addEntry(std::shared_ptr<Entry> entry) {
-  auto emplaced = versions_.emplace(CellVersion::FromEntry(*entry)).second;
+void FileStore::Cell::addEntry(std::shared_ptr<Entry> entry, uint64_t location) {
+  auto emplaced = versions_.emplace(MakeCellVersion(*entry, location)).second;
   if (!emplaced) {
     auto msg = "Couldn't overwrite existing entry with name " + entry->getName().string()
         + " and timestamp " + std::to_string(TicksSinceEpoch<milliseconds>(entry->getValidFrom()));
@@ -545,10 +827,57 @@ void FileStore::Cell::addEntry(std::shared_ptr<Entry> entry) {
     throw std::runtime_error(msg);
   }
   if (latest_ == nullptr || entry->getValidFrom() > latest_->getValidFrom()) {
-    latest_ = entry;
+    this->setLatest(entry);
   }
 }
 
+void FileStore::Cell::addVersion(const CellVersion& version) {
+  auto existing = versions_.find(version.validFrom);
+  if (existing != versions_.end()) {
+    PEP_LOG(LogTag, Severity::Warning) << "Entry " << this->entryName().string()
+      << " with timestamp " << TicksSinceEpoch<milliseconds>(version.validFrom) << " has been stored more than once: using the last one";
+    if (latest_ != nullptr && latest_->getValidFrom() == version.validFrom) {
+      this->setLatest(nullptr);
+    }
+    versions_.erase(existing);
+  }
+  versions_.emplace(version);
+}
+
+void FileStore::Cell::loadLatest() {
+  if (versions_.empty()) {
+    return;
+  }
+  const auto& version = *versions_.rbegin();
+  if (latest_ == nullptr || latest_->getValidFrom() != version.validFrom) {
+    this->setLatest(Entry::Load(*this, version));
+  }
+}
+
+void FileStore::Cell::setLatest(std::shared_ptr<Entry> entry) {
+  auto deduplicator = this->participant().fileStore().deduplicator_.get();
+  if (deduplicator != nullptr) {
+    if (const auto* addresses = ContentAddresses(entry.get())) {
+      deduplicator->addReferences(*addresses);
+    }
+    if (const auto* addresses = ContentAddresses(latest_.get())) {
+      deduplicator->removeReferences(*addresses);
+    }
+  }
+  latest_ = std::move(entry);
+}
+
+void FileStore::Cell::relocateVersions(std::span<const uint64_t> locations) {
+  assert(locations.size() == versions_.size());
+  CellVersions relocated;
+  auto location = locations.begin();
+  for (auto version : versions_) {
+    version.location = *location++;
+    relocated.emplace_hint(relocated.end(), version);
+  }
+  versions_ = std::move(relocated);
+}
+
 FileStore::Cell* FileStore::Participant::getCell(const std::string& columnName) const {
   auto pos = cells_.find(columnName);
   if (pos == cells_.cend()) {
@@ -562,6 +891,8 @@ FileStore::Cell& FileStore::Participant::provideCell(const std::string& columnNa
   if (existing != nullptr) {
     return *existing;
   }
+  // Column names must (also) be usable as directory names, e.g. to allow migration to and from the "Directory" EntryStorage
+  (void)CheckedFileName(columnName);
   return **cells_.emplace(std::make_unique<Cell>(*this, columnName)).first;
 }
 
@@ -575,10 +906,6 @@ PropertyBasedContainer<const FileStore::Cell*, &FileStore::Cell::columnName>::se
   return result;
 }
 
-CheckedPath FileStore::Participant::path() const {
-  return this->fileStore().metaDir() / CheckedFileName(name_);
-}
-
 void FileStore::Participant::getMetrics(size_t& entryCount, uint64_t& totalPayloadBytes, uint64_t& rollingPayloadBytes, const std::set<std::string>& columns) const {
   entryCount = 0U;
   totalPayloadBytes = 0U;
@@ -3,18 +3,31 @@
 #include <pep/utils/CheckedPath.hpp>
 #include <pep/utils/Shared.hpp>
 #include <pep/storagefacility/EntryContent.hpp>
+#include <pep/storagefacility/EntryStorage.hpp>
 #include <pep/messaging/MessageSequence.hpp>
+#include <pep/async/FakeVoid.hpp>
 
 #include <filesystem>
+#include <list>
 #include <string>
 #include <memory>
+#include <optional>
+#include <span>
+
+namespace prometheus {
+  class Counter;
+  class Gauge;
+  class Registry;
+}
 
 namespace pep {
 
-/// directory structure:
-/// - .1, .2, .3 are pages
-/// - name.mtime.entry is a snapshot of all the metadata and pages that are used
-class FileStore : public SharedConstructor<FileStore> {
+class WorkerPool;
+
+/// Keeps (the summaries of) all cell versions in memory, plus the latest entry of every cell.
+/// Entries are persisted by an EntryStorage, from which historical entries are loaded on demand.
+/// Recently used historical entries are kept in a (memory-budgeted) cache.
+class FileStore : public std::enable_shared_from_this<FileStore>, public SharedConstructor<FileStore> {
   friend class SharedConstructor<FileStore>;
   friend class EntryContent;
 
@@ -23,6 +36,15 @@ public:
   class Cell;
   class Entry;
 
+  /// \brief Default memory budget for historical entries, in (serialized) bytes.
+  static constexpr uint64_t DefaultHistoricalEntryCacheSize = 64U * 1024U * 1024U;
+
+  /// \brief Specifies an entry to look up: the version of the named cell that was valid at the specified time.
+  struct EntryKey {
+    EntryName name;
+    Timestamp validAt = Timestamp::max();
+  };
+
   /// \brief Utility base class for Entry and EntryChange classes (defined below).
   /// \remark Ensures that appropriate values are copied when we
   ///         - create an EntryChange on the basis of an existing Entry, i.e. when preparing a cell update.
@@ -97,36 +119,24 @@ public:
     friend class EntryChange;
 
   private:
-    static const std::string FileExtension;
-
     Timestamp validFrom_;
 
     Entry(EntryChange&& source, Timestamp validFrom);
     Entry(Cell& cell, Timestamp validFrom, uint64_t checksumSubstitute, std::unique_ptr<EntryContent> content);
 
-    CheckedPath getFilePath(const std::string& extension) const;
-
   public:
     std::unique_ptr<EntryContent> cloneContent() const;
 
     Timestamp getValidFrom() const noexcept { return validFrom_; }
     messaging::MessageSequence readPage(size_t index);
 
-    void save() const;
-    static std::shared_ptr<Entry> TryLoad(Cell& cell, const CheckedPath& path);
-    static std::shared_ptr<Entry> Load(Cell& cell, Timestamp timestamp);
+    std::string serialize() const;
+    static std::shared_ptr<Entry> Deserialize(Cell& cell, Timestamp validFrom, const std::string& serialized);
+    static std::shared_ptr<Entry> Load(Cell& cell, const EntryVersion& version, uint64_t* serializedSize = nullptr);
   };
 
-  struct CellVersion {
-    Timestamp validFrom;
-    uint64_t checksumSubstitute{};
-    uint64_t payloadSize{};
-    bool isOriginalPayloadOwner{};
-    bool isTombstone{};
-
-    static CellVersion FromEntry(const Entry& entry);
-  };
-  using CellVersions = typename PropertyBasedContainer<CellVersion, &CellVersion::validFrom>::set;
+  using CellVersion = EntryVersion;
+  using CellVersions = EntryVersions;
 
   class Cell {
   private:
@@ -135,8 +145,10 @@ public:
     CellVersions versions_;
     std::shared_ptr<Entry> latest_;
 
+    void setLatest(std::shared_ptr<Entry> entry); // keeps the FileStore's page references up to date
+
   public:
-    Cell(Participant& participant, const std::string& columnName, bool load = false);
+    Cell(Participant& participant, const std::string& columnName);
 
     Participant& participant() { return participant_; }
     const Participant& participant() const { return participant_; }
@@ -144,16 +156,22 @@ public:
     const CellVersions& versions() const noexcept { return versions_; }
 
     EntryName entryName() const;
-    CheckedPath path() const;
 
     void getMetrics(size_t& entryCount, uint64_t& totalPayloadBytes, uint64_t& rollingPayloadBytes) const;
-    void addEntry(std::shared_ptr<Entry> entry);
+    void addEntry(std::shared_ptr<Entry> entry, uint64_t location);
+    void addVersion(const CellVersion& version); // supersedes an existing version with the same validFrom
+    void loadLatest(); // ensures that the latest version's entry is in memory after versions were added
+    void relocateVersions(std::span<const uint64_t> locations);
     std::shared_ptr<Entry> lookup(Timestamp validAt = Timestamp::max()); // (Absent or) max value indicates "latest version"
+    const CellVersion* findVersion(Timestamp validAt) const; // Produces nullptr if no version was valid at the specified time
+    const std::shared_ptr<Entry>& latest() const noexcept { return latest_; }
 
     std::set<std::string> pagePaths() const; // for latest version
   };
 
   class Participant {
+    friend class FileStore;
+
   private:
     FileStore& store_;
     std::string name_; // text representation of the local SF pseudonym
@@ -163,15 +181,13 @@ public:
     Cell& provideCell(const std::string& columnName);
 
   public:
-    Participant(FileStore& store, std::string name, bool load = false);
+    Participant(FileStore& store, std::string name);
 
     FileStore& fileStore() noexcept { return store_; }
     const FileStore& fileStore() const noexcept { return store_; }
     const std::string& name() const noexcept { return name_; }
     PropertyBasedContainer<const Cell*, &Cell::columnName>::set cells() const;
 
-    CheckedPath path() const;
-
     std::shared_ptr<EntryChange> createEntry(const std::string& columnName) { return EntryChange::Create(this->provideCell(columnName)); }
 
     void getMetrics(size_t& entryCount, uint64_t& totalPayloadBytes, uint64_t& rollingPayloadBytes, const std::set<std::string>& columns) const;
@@ -181,11 +197,48 @@ public:
   };
 
 private:
+  struct Metrics {
+    prometheus::Counter& historicalEntryCacheHits;
+    prometheus::Counter& historicalEntryCacheMisses;
+    prometheus::Gauge& historicalEntryCacheBytes;
+
+    explicit Metrics(std::shared_ptr<prometheus::Registry> registry);
+  };
+
+  /// \brief Keeps recently used historical (i.e. non-latest) entries, evicting the least recently used ones
+  ///        when their (serialized) size exceeds the budget.
+  class HistoricalEntryCache {
+  private:
+    using Key = std::pair<const Cell*, Timestamp>;
+    struct Cached {
+      Key key;
+      std::shared_ptr<Entry> entry;
+      uint64_t size;
+    };
+
+    const uint64_t maxBytes_;
+    std::list<Cached> entries_; // Most recently used first
+    std::map<Key, std::list<Cached>::iterator> index_;
+    uint64_t bytes_ = 0U;
+
+  public:
+    explicit HistoricalEntryCache(uint64_t maxBytes) : maxBytes_(maxBytes) {}
+
+    std::shared_ptr<Entry> lookup(const Cell& cell, Timestamp validFrom);
+    void insert(std::shared_ptr<Entry> entry, uint64_t size);
+    void clear();
+
+    uint64_t bytes() const noexcept { return bytes_; }
+  };
+
   FileStore(
     const std::filesystem::path& metadatapath,
     const Configuration& pageStoreConfig,
     std::shared_ptr<boost::asio::io_context> io_context,
-    std::shared_ptr<prometheus::Registry> metrics_registry);
+    std::shared_ptr<prometheus::Registry> metrics_registry,
+    EntryStorage::Type storageType = EntryStorage::Type::Directory,
+    uint64_t historicalEntryCacheSize = DefaultHistoricalEntryCacheSize,
+    std::optional<std::string> pageAddressKey = std::nullopt); // If specified, new pages are stored under their content address
 
   // Keep collections of unique strings to save memory: see https://gitlab.pep.cs.ru.nl/pep/core/-/issues/2322 .
   // Note that "No iterators or references are invalidated" when an std::set or std::map changes, so
@@ -195,7 +248,22 @@ private:
 
   PropertyBasedContainer<std::unique_ptr<Participant>, &Participant::name>::set participants_;
   CheckedPath path_;
+  std::shared_ptr<boost::asio::io_context> ioContext_;
   std::shared_ptr<PageStore> pagestore_;
+  std::unique_ptr<EntryStorage> storage_;
+  HistoricalEntryCache historicalEntries_;
+  std::unique_ptr<PageDeduplicator> deduplicator_; // nullptr if pages aren't content addressed
+  std::optional<Metrics> metrics_;
+
+  // Group commit: see whenDurable()
+  struct DurabilityWaiter {
+    uint64_t writes; // The number of writes that must have been synced before the subscriber is notified
+    rxcpp::subscriber<FakeVoid> subscriber;
+  };
+  uint64_t writes_ = 0U; // Number of entries written to storage
+  uint64_t syncedWrites_ = 0U; // Number of entries written to storage before the last (successful) sync was started
+  bool syncing_ = false;
+  std::vector<DurabilityWaiter> durabilityWaiters_;
 
   const std::string& getColumnString(const std::string& value);
   EntryContent::MetadataEntry makeMetadataEntry(std::string key, std::string value);
@@ -203,12 +271,32 @@ private:
   Participant* getParticipant(const std::string& name) const;
   Participant& provideParticipant(const std::string& name);
 
+  void load();
+  void migrateToLog();
+  void enumerateCells(const EntryStorage::CellVisitor& visitor) const;
+  void syncWrites(std::shared_ptr<WorkerPool> workerPool);
+  void finishSync(uint64_t synced, std::exception_ptr error, std::shared_ptr<WorkerPool> workerPool);
+  void cacheHistoricalEntry(std::shared_ptr<Entry> entry, uint64_t size);
+  void countHistoricalLookup(bool hit);
+
 public:
+  ~FileStore() noexcept;
+
   PropertyBasedContainer<const Participant*, &Participant::name>::set participants() const;
+  size_t participantCount() const noexcept { return participants_.size(); }
 
   std::shared_ptr<Entry> lookup(const EntryName& name, Timestamp validAt = Timestamp::max());
+  /// \brief Looks up multiple entries, loading (uncached) historical entries from storage on the worker pool.
+  /// \return An observable emitting (on the FileStore's I/O context) a single vector containing the entries in the order of the keys, or nullptr for keys that don't match an entry.
+  /// \remark Like the other methods, must be invoked on the FileStore's I/O context.
+  rxcpp::observable<std::vector<std::shared_ptr<Entry>>> lookupAsync(std::vector<EntryKey> keys, std::shared_ptr<WorkerPool> workerPool);
   std::shared_ptr<EntryChange> modifyEntry(const EntryName& name, bool createIfNeeded = false);
 
+  /// \brief Produces an observable that emits (on the FileStore's I/O context) when all entries that have been committed so far are durably stored.
+  /// \remark Entries are synced to storage in groups: a single sync (on the worker pool) covers all entries that were committed before
+  ///         it started. Entries committed while a sync is in progress are synced together when it has finished.
+  rxcpp::observable<FakeVoid> whenDurable(std::shared_ptr<WorkerPool> workerPool);
+
   EntryContent::Metadata makeMetadataMap(const std::map<std::string, MetadataXEntry>& xentries);
   std::map<std::string, MetadataXEntry> extractMetadataMap(const EntryContent::Metadata& metadata);
 
@@ -219,6 +307,12 @@ public:
   }
 
   std::set<std::string> pagePaths() const; // for latest version
+
+  /// \return The FileStore's page deduplication (reference counts), or nullptr if pages aren't content addressed
+  const PageDeduplicator* pageDeduplicator() const noexcept { return deduplicator_.get(); }
+
+  /// \brief Rewrites the entry storage (if it supports compaction) so that it only holds the current cell versions, in cell order.
+  void compact();
 };
 
 }
@@ -0,0 +1,70 @@
+#include <pep/storagefacility/PageDeduplicator.hpp>
+#include <pep/utils/Hmac.hpp>
+#include <pep/utils/OpenSSLHasher.hpp>
+
+#include <boost/algorithm/hex.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
+
+#include <cassert>
+#include <stdexcept>
+
+namespace pep {
+
+PageDeduplicator::PageDeduplicator(std::string key)
+  : key_(std::move(key)) {
+  if (key_.empty()) {
+    throw std::invalid_argument("Page deduplication requires a key");
+  }
+}
+
+std::string PageDeduplicator::address(std::string_view rawPage) const {
+  auto digest = Hmac<Sha256>(key_, rawPage);
+  static_assert(AddressLength % 2U == 0U);
+  assert(digest.size() >= AddressLength / 2U);
+  digest.resize(AddressLength / 2U);
+  return boost::algorithm::to_lower_copy(boost::algorithm::hex(digest));
+}
+
+bool PageDeduplicator::isStored(const std::string& address) const {
+  return counts_.contains(address);
+}
+
+void PageDeduplicator::addReferences(const std::vector<std::string>& addresses) {
+  for (const auto& address : addresses) {
+    auto& count = counts_[address];
+    if (count == 0U) {
+      ++referencedPages_;
+    }
+    ++count;
+    ++references_;
+  }
+}
+
+void PageDeduplicator::removeReferences(const std::vector<std::string>& addresses) {
+  for (const auto& address : addresses) {
+    auto position = counts_.find(address);
+    if (position == counts_.end() || position->second == 0U) {
+      throw std::logic_error("Can't remove unregistered reference to page " + address);
+    }
+    // Keep the (zero) count: the page is still stored
+    if (--position->second == 0U) {
+      --referencedPages_;
+    }
+    --references_;
+  }
+}
+
+void PageDeduplicator::clear() {
+  counts_.clear();
+  references_ = 0U;
+  referencedPages_ = 0U;
+}
+
+double PageDeduplicator::ratio() const noexcept {
+  if (referencedPages_ == 0U) {
+    return 1.0;
+  }
+  return static_cast<double>(references_) / static_cast<double>(referencedPages_);
+}
+
+}
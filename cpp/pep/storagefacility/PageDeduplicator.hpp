@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace pep {
+
+// Supports storing pages in the PageStore under a content address: a keyed hash
+// of the (encrypted) page. Pages with the same content then share a single object
+// in the PageStore, e.g. when an entry is overwritten with the same data, or when
+// the same file is stored for multiple participants.
+//
+// The address is keyed so that the PageStore's operator can't tell which pages
+// have the same content by hashing them. Note that pages are encrypted with random
+// keys, so only pages that were uploaded (by the client) with identical ciphertext
+// are deduplicated.
+//
+// Content addresses are reference counted: the FileStore registers the addresses
+// of each cell's latest entry. Since historical entries keep referring to their
+// pages (and the PageStore never deletes pages), an address remains known to be
+// stored when its count drops to zero.
+class PageDeduplicator {
+public:
+  static constexpr size_t AddressLength = 32U; // hex digits, i.e. 128 bits
+
+  explicit PageDeduplicator(std::string key);
+
+  /// \return The content address (of AddressLength hex digits) for the specified page
+  std::string address(std::string_view rawPage) const;
+
+  /// \return Whether a page with the specified content address has been (durably) stored
+  bool isStored(const std::string& address) const;
+
+  void addReferences(const std::vector<std::string>& addresses);
+  void removeReferences(const std::vector<std::string>& addresses);
+  void countDeduplicatedUpload() noexcept { ++deduplicatedUploads_; }
+  void clear();
+
+  uint64_t references() const noexcept { return references_; }
+  uint64_t referencedPages() const noexcept { return referencedPages_; }
+  uint64_t deduplicatedUploads() const noexcept { return deduplicatedUploads_; }
+  /// \return The number of references per referenced page, or 1 if no pages are referenced
+  double ratio() const noexcept;
+
+private:
+  std::string key_;
+  std::unordered_map<std::string, uint64_t> counts_;
+  uint64_t references_ = 0U;
+  uint64_t referencedPages_ = 0U; // Number of addresses with a nonzero count
+  uint64_t deduplicatedUploads_ = 0U;
+};
+
+}
@@ -0,0 +1,59 @@
+#include <pep/storagefacility/PagePutWindow.hpp>
+#include <pep/async/CreateObservable.hpp>
+
+#include <cassert>
+#include <stdexcept>
+
+#include <rxcpp/operators/rx-finally.hpp>
+
+namespace pep {
+
+std::shared_ptr<PagePutWindow> PagePutWindow::Create(uint64_t maxBytes) {
+  return std::make_shared<PagePutWindow>(maxBytes);
+}
+
+PagePutWindow::PagePutWindow(uint64_t maxBytes)
+  : maxBytes_(maxBytes) {
+  if (maxBytes_ == 0U) {
+    throw std::invalid_argument("Page put window must have room for at least one byte");
+  }
+}
+
+bool PagePutWindow::admits(uint64_t bytes) const noexcept {
+  return pendingBytes_ == 0U || pendingBytes_ + bytes <= maxBytes_;
+}
+
+rxcpp::observable<std::string> PagePutWindow::put(uint64_t bytes, rxcpp::observable<std::string> put) {
+  return CreateObservable<std::string>([self = shared_from_this(), bytes, put = std::move(put)](rxcpp::subscriber<std::string> subscriber) {
+    auto start = [self, bytes, put, subscriber]() {
+      if (!subscriber.is_subscribed()) {
+        return; // Subscriber lost interest while we were deferred
+      }
+      self->pendingBytes_ += bytes;
+      put
+        .finally([self, bytes]() { self->release(bytes); })
+        .subscribe(subscriber);
+    };
+
+    // Don't overtake puts that were deferred before us
+    if (self->deferred_.empty() && self->admits(bytes)) {
+      start();
+    }
+    else {
+      self->deferred_.push(Deferred{ bytes, std::move(start) });
+    }
+  });
+}
+
+void PagePutWindow::release(uint64_t bytes) {
+  assert(pendingBytes_ >= bytes);
+  pendingBytes_ -= bytes;
+
+  while (!deferred_.empty() && this->admits(deferred_.front().bytes)) {
+    auto start = std::move(deferred_.front().start);
+    deferred_.pop();
+    start(); // May (synchronously) finish the put and re-enter this method
+  }
+}
+
+}
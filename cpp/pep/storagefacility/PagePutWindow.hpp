@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <string>
+
+#include <rxcpp/rx-lite.hpp>
+
+namespace pep {
+
+// Limits the number of bytes that are being put into the PageStore at the same
+// time (for a single request), so that a client sending many large pages
+// doesn't have them all uploaded to S3 at once.
+//
+// Puts are started in the order in which they are subscribed to.  A put that
+// would exceed the window is deferred until enough preceding puts have finished,
+// but a put is always started when no other puts are in progress, so that pages
+// that are larger than the window can still be stored.
+//
+// Not thread safe: puts must be subscribed to, and finish, on a single thread
+// (i.e. the I/O thread).
+class PagePutWindow : public std::enable_shared_from_this<PagePutWindow> {
+public:
+  static std::shared_ptr<PagePutWindow> Create(uint64_t maxBytes);
+
+  /// \brief Defers (subscription to) a put of \c bytes until the window has room for it.
+  /// \param put A (cold) observable that performs the put when it's subscribed to, e.g. as returned by PageStore::put
+  rxcpp::observable<std::string> put(uint64_t bytes, rxcpp::observable<std::string> put);
+
+  uint64_t pendingBytes() const noexcept { return pendingBytes_; }
+  size_t deferredPuts() const noexcept { return deferred_.size(); }
+
+  // public constructor for the sake of std::make_shared
+  explicit PagePutWindow(uint64_t maxBytes);
+
+private:
+  bool admits(uint64_t bytes) const noexcept;
+  void release(uint64_t bytes);
+
+  struct Deferred {
+    uint64_t bytes;
+    std::function<void()> start;
+  };
+
+  uint64_t maxBytes_;
+  uint64_t pendingBytes_ = 0U;
+  std::queue<Deferred> deferred_;
+};
+
+}
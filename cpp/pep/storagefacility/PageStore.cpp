@@ -2,27 +2,50 @@
 #include <pep/storagefacility/S3Client.hpp>
 #include <pep/storagefacility/S3Credentials.PropertySerializer.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <filesystem>
+#include <functional>
+#include <list>
+#include <tuple>
+#include <unordered_map>
 
+#include <pep/utils/Exceptions.hpp>
 #include <pep/utils/Log.hpp>
 
 #include <rxcpp/operators/rx-switch_if_empty.hpp>
+#include <rxcpp/operators/rx-filter.hpp>
+#include <rxcpp/operators/rx-take.hpp>
 #include <rxcpp/operators/rx-merge.hpp>
 #include <rxcpp/operators/rx-flat_map.hpp>
+#include <rxcpp/operators/rx-map.hpp>
+#include <rxcpp/operators/rx-observe_on.hpp>
+#include <rxcpp/operators/rx-on_error_resume_next.hpp>
+#include <rxcpp/operators/rx-tap.hpp>
 
 #include <pep/utils/OpenSSLHasher.hpp>
 #include <pep/async/RxLazy.hpp>
 #include <pep/async/RxButFirst.hpp>
 #include <pep/async/RxToVector.hpp>
+#include <pep/async/RxParallelConcat.hpp>
 #include <pep/utils/Configuration.hpp>
 #include <pep/async/CreateObservable.hpp>
+#include <pep/async/FakeVoid.hpp>
+#include <pep/async/OnAsio.hpp>
+#include <pep/async/WorkerPool.hpp>
 #include <pep/utils/Defer.hpp>
 #include <pep/utils/File.hpp>
 #include <pep/networking/EndPoint.PropertySerializer.hpp>
 
+#include <prometheus/counter.h>
 #include <prometheus/gauge.h>
 #include <prometheus/registry.h>
+#include <prometheus/summary.h>
+
+#include <boost/algorithm/hex.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/asio/post.hpp>
 
 namespace pep
 {
@@ -52,24 +75,69 @@ namespace {
     // pubic constructor for the sake of std::make_shared
     S3PageStore(
       const s3::Client::Parameters& s3params,
-        unsigned int conn_count,
+        unsigned int minConnections,
+        unsigned int maxConnections,
         const std::string& writeBucket_,
         const std::vector<std::string>& buckets_,
+        bool probeBucketsConcurrently,
+        uint64_t multipartThreshold,
+        uint64_t multipartPartSize,
         std::shared_ptr<prometheus::Registry> metrics_registry);
 
     ~S3PageStore() override;
 
   private:
-    std::vector<std::shared_ptr<s3::Client>> clients_;
+    // A connection to S3, together with the work currently assigned to it
+    struct Connection {
+      std::shared_ptr<s3::Client> client;
+      unsigned int slot; // distinguishes the connection in the metrics
+      unsigned int openRequests = 0;
+      uint64_t openBytes = 0; // (estimated) payload size of the open requests
+      prometheus::Summary* requestDuration = nullptr;
+    };
 
-    // keeps track of the number of open requests per connection
-    std::shared_ptr<std::vector<unsigned int>> openRequestsCounts_;
+    s3::Client::Parameters s3params_;
+    unsigned int minConnections_;
+    unsigned int maxConnections_;
+    std::vector<std::shared_ptr<Connection>> connections_;
+
+    // Estimate of the size of the next object we'll retrieve, since we
+    // don't know it up front but want to balance the connections on bytes
+    uint64_t expectedGetSize_ = 0;
 
     std::string writeBucket_;
     std::vector<std::string> buckets_;
 
-    // gets the index of (one of) the quietest connections
-    size_t getQuietestConn();
+    // whether get(path) queries all buckets at once instead of one by one
+    bool probeBucketsConcurrently_;
+
+    // Pages of at least multipartThreshold_ bytes are uploaded in parts of
+    // multipartPartSize_ bytes (the last part may be larger), which are sent
+    // in parallel over our connections.
+    uint64_t multipartThreshold_;
+    uint64_t multipartPartSize_;
+
+    // Assigns a request with the given (estimated) payload size to the
+    // connection with the fewest outstanding bytes, opening a new connection
+    // when all existing ones are busy and we haven't reached maxConnections_.
+    std::shared_ptr<Connection> acquireConn(uint64_t bytes);
+    // Unassigns a request from its connection, and closes the connection
+    // if it (and another one) became idle and we have more than minConnections_.
+    void releaseConn(std::shared_ptr<Connection> conn, uint64_t bytes,
+        std::chrono::steady_clock::time_point start);
+    std::shared_ptr<Connection> openConn();
+    void closeIdleConn(std::shared_ptr<Connection> conn);
+
+    // Sends a request with the given payload size over one of our
+    // connections, which is picked when the returned observable is
+    // subscribed to.
+    template <typename T>
+    rxcpp::observable<T> sendRequest(uint64_t bytes,
+        std::function<rxcpp::observable<T>(s3::Client&)> send);
+
+    // puts page using a multipart upload
+    rxcpp::observable<std::string> putMultipart(const std::string& path,
+        const std::vector<std::shared_ptr<std::string>>& page_parts);
 
     // gets page from specified bucket
     messaging::MessageSequence get(const std::string& path,
@@ -80,6 +148,8 @@ namespace {
       prometheus::Gauge& active_requests;
       prometheus::Gauge& pending_requests;
       prometheus::Gauge& pending_pages_size;
+      prometheus::Gauge& connections;
+      prometheus::Family<prometheus::Summary>& request_duration;
 
       Metrics(std::shared_ptr<prometheus::Registry> registry)
         : active_requests(prometheus::BuildGauge()
@@ -96,7 +166,16 @@ namespace {
             .Name("pep_sf_s3_pending_pages_size")
             .Help("total size of the pages pending to be sent to S3")
             .Register(*registry)
-            .Add({})) { }
+            .Add({})),
+          connections(prometheus::BuildGauge()
+            .Name("pep_sf_s3_connections")
+            .Help("number of open connections to S3")
+            .Register(*registry)
+            .Add({})),
+          request_duration(prometheus::BuildSummary()
+            .Name("pep_sf_s3_request_duration_seconds")
+            .Help("duration of requests to S3, per connection")
+            .Register(*registry)) { }
     };
 
     std::optional<Metrics> metrics_;
@@ -116,7 +195,17 @@ namespace {
       config.get<std::optional<bool>>("UseHttps")
     };
 
-    unsigned int conn_count = config.get<unsigned int>("Connections", 5);
+    unsigned int minConnections = config.get<unsigned int>("Connections", 5);
+    unsigned int maxConnections = config.get<std::optional<unsigned int>>(
+        "MaxConnections").value_or(minConnections);
+
+    if (minConnections == 0)
+      throw std::runtime_error("S3PageStore configuration error: "
+          "at least one connection is needed!");
+
+    if (maxConnections < minConnections)
+      throw std::runtime_error("S3PageStore configuration error: "
+          "MaxConnections is smaller than Connections!");
     std::string writeBucket = config.get<std::string>("WriteToBucket");
 
     std::vector<std::string> buckets;
@@ -136,78 +225,252 @@ namespace {
           "writing to a bucket we're not reading from!");
     }
 
-    return std::make_shared<S3PageStore>(
-        s3params, conn_count, writeBucket, buckets, metrics_registry);
+    bool probeBucketsConcurrently = config.get<std::optional<bool>>(
+        "ProbeBucketsConcurrently").value_or(false);
+
+    auto multipartPartSize = config.get<std::optional<uint64_t>>(
+        "MultipartPartSize").value_or(8 * 1024 * 1024);
+    auto multipartThreshold = config.get<std::optional<uint64_t>>(
+        "MultipartThreshold").value_or(2 * multipartPartSize);
+
+    if (multipartPartSize < s3::Client::MinimumPartSize)
+      throw std::runtime_error("S3PageStore configuration error: "
+          "MultipartPartSize is smaller than S3 allows!");
+
+    if (multipartThreshold < multipartPartSize)
+      throw std::runtime_error("S3PageStore configuration error: "
+          "MultipartThreshold is smaller than MultipartPartSize!");
+
+    return std::make_shared<S3PageStore>(s3params, minConnections,
+        maxConnections, writeBucket, buckets, probeBucketsConcurrently,
+        multipartThreshold, multipartPartSize, metrics_registry);
   }
 
 
 
   S3PageStore::S3PageStore(
       const s3::Client::Parameters& s3params,
-      unsigned int conn_count,
+      unsigned int minConnections,
+      unsigned int maxConnections,
       const std::string& writeBucket_,
       const std::vector<std::string>& buckets_,
+      bool probeBucketsConcurrently,
+      uint64_t multipartThreshold,
+      uint64_t multipartPartSize,
       std::shared_ptr<prometheus::Registry> metrics_registry)
 
     : PageStore(),
-      clients_(),
-      openRequestsCounts_(std::make_shared<std::vector<unsigned int>>()),
+      s3params_(s3params),
+      minConnections_(minConnections),
+      maxConnections_(maxConnections),
+      connections_(),
       writeBucket_(writeBucket_),
       buckets_(buckets_),
+      probeBucketsConcurrently_(probeBucketsConcurrently),
+      multipartThreshold_(multipartThreshold),
+      multipartPartSize_(multipartPartSize),
       metrics_(metrics_registry ? std::make_optional<Metrics>(metrics_registry)
                                : std::nullopt)
   {
-    for (auto i = 0U; i < conn_count; i++) {
-      auto client = s3::Client::Create(s3params);
-      client->start();
-      this->clients_.push_back(client);
-      this->openRequestsCounts_->push_back(0);
+    assert(minConnections_ > 0 && minConnections_ <= maxConnections_);
+    for (auto i = 0U; i < minConnections_; i++) {
+      this->openConn();
     }
   }
 
   S3PageStore::~S3PageStore() {
-    for (auto client : clients_) {
-      client->shutdown();
+    for (const auto& conn : connections_) {
+      conn->client->shutdown();
     }
 #if PEP_BUILD_HAS_DEBUG_FLAVOR()
-    for (unsigned int count : *(this->openRequestsCounts_))
-      assert(count == 0);
-    // The "count" variable is only used in an assertion, making it
+    for (const auto& conn : connections_)
+      assert(conn->openRequests == 0);
+    // The "conn" variable is only used in an assertion, making it
     // unused in non-debug builds.
     //
     // Why not a PEP_LOG(LogTag, Severity::Error) here instead of an assert?
     //
     // Either there's a bug in the open requests counting code---which we don't
     // want to be buried in the logs---or some request is actually still active,
-    // which will cause an inexplicable segfault when it'll try to decrement
-    // the deleted openRequestsCounts_[idx] upon completion.
+    // which will cause an inexplicable segfault when it'll try to release
+    // its connection upon completion.
 #endif
   }
 
 
-  size_t S3PageStore::getQuietestConn() {
-    size_t candidate = 0;
+  std::shared_ptr<S3PageStore::Connection> S3PageStore::openConn() {
+    // Reuse the lowest free slot, so that the number of distinct
+    // (per connection) metrics stays bounded by maxConnections_.
+    unsigned int slot = 0;
+    while (std::any_of(connections_.begin(), connections_.end(),
+          [slot](const auto& conn) { return conn->slot == slot; })) {
+      slot++;
+    }
+
+    auto conn = std::make_shared<Connection>();
+    conn->client = s3::Client::Create(s3params_);
+    conn->slot = slot;
+    if (metrics_) {
+      conn->requestDuration = &metrics_->request_duration.Add(
+          {{"connection", std::to_string(slot)}},
+          prometheus::Summary::Quantiles{
+            {0.5, 0.05}, {0.9, 0.01}, {0.99, 0.001} }, std::chrono::minutes{ 5 });
+      metrics_->connections.Increment();
+    }
+    conn->client->start();
+    connections_.push_back(conn);
+    return conn;
+  }
 
-    unsigned int candidate_count = this->openRequestsCounts_->at(candidate);
 
-    for (size_t contender=1;
-        contender < this->openRequestsCounts_->size(); contender++) {
+  void S3PageStore::closeIdleConn(std::shared_ptr<Connection> conn) {
+    auto position = std::find(connections_.begin(), connections_.end(), conn);
+    if (position == connections_.end()
+        || conn->openRequests != 0
+        || connections_.size() <= minConnections_) {
+      return;
+    }
 
-      unsigned int contender_count = this->openRequestsCounts_->at(contender);
+    // Keep the connection if it's the only idle one, so that we don't
+    // close and reopen connections all the time under steady load.
+    auto otherIdle = std::any_of(connections_.begin(), connections_.end(),
+        [conn](const auto& other) {
+          return other != conn && other->openRequests == 0;
+        });
+    if (!otherIdle) {
+      return;
+    }
 
-      if (contender_count < candidate_count) {
-        candidate = contender;
-        candidate_count = contender_count;
-      }
+    connections_.erase(position);
+    conn->client->shutdown();
+    if (metrics_)
+      metrics_->connections.Decrement();
+  }
+
+
+  std::shared_ptr<S3PageStore::Connection>
+      S3PageStore::acquireConn(uint64_t bytes) {
+    assert(!connections_.empty());
+
+    // Balance on outstanding bytes rather than on the number of requests,
+    // so that small requests don't queue behind a connection that's busy
+    // transferring large pages.  Ties are broken on the number of requests.
+    auto conn = *std::min_element(connections_.begin(), connections_.end(),
+        [](const auto& lhs, const auto& rhs) {
+          return std::tie(lhs->openBytes, lhs->openRequests)
+            < std::tie(rhs->openBytes, rhs->openRequests);
+        });
+
+    if (conn->openRequests != 0 && connections_.size() < maxConnections_) {
+      conn = this->openConn();
     }
 
-    return candidate;
+    conn->openRequests++;
+    conn->openBytes += bytes;
+    if (metrics_) {
+      metrics_->active_requests.Increment();
+    }
+    return conn;
+  }
+
+
+  void S3PageStore::releaseConn(std::shared_ptr<Connection> conn,
+      uint64_t bytes, std::chrono::steady_clock::time_point start) {
+    assert(conn->openRequests > 0 && conn->openBytes >= bytes);
+    conn->openRequests--;
+    conn->openBytes -= bytes;
+    if (metrics_) {
+      metrics_->active_requests.Decrement();
+      conn->requestDuration->Observe(std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count()); // in seconds
+    }
+
+    if (conn->openRequests == 0 && connections_.size() > minConnections_) {
+      // We're (most likely) being invoked from one of the client's own
+      // callbacks, so we close the connection after they've finished.
+      boost::asio::post(*s3params_.ioContext,
+        [weak = this->weak_from_this(), conn] {
+          if (auto self = weak.lock()) {
+            self->closeIdleConn(conn);
+          }
+        });
+    }
   }
 
 
   messaging::MessageSequence
     S3PageStore::get(const std::string& path) {
 
+    if (probeBucketsConcurrently_ && buckets_.size() > 1) {
+      // Sends a request to every bucket at once, so that a page residing in
+      // one of the later buckets doesn't have to wait for a (round trip to
+      // each of the) preceding buckets to report that it's missing.
+      // RxParallelConcat passes on the buckets' outcomes in bucket order, so
+      // we can emit the page as soon as its bucket and all preceding ones
+      // have reported, as get(path) would.  We then unsubscribe from the
+      // requests to the remaining buckets, discarding what they produce.
+      // A failing bucket doesn't fail the other requests: when it keeps us
+      // from knowing which bucket (first) had the page, we wait for all
+      // buckets and produce an error listing their outcomes.
+      struct Probe {
+        std::string bucket;
+        std::shared_ptr<std::string> page; // nullptr if not found
+        std::exception_ptr error;
+      };
+
+      return RxLazy<std::shared_ptr<std::string>>(
+          [self = this->shared_from_this(), path]()
+            -> messaging::MessageSequence {
+        // Outcomes of the buckets that didn't produce the page (yet),
+        // without the pages themselves
+        auto outcomes = std::make_shared<std::vector<Probe>>();
+
+        return rxcpp::observable<>::iterate(self->buckets_)
+          .map([self, path](const std::string& bucket) {
+            return self->get(path, bucket)
+              .map([bucket](std::shared_ptr<std::string> page) {
+                return Probe{ bucket, std::move(page), nullptr };
+              })
+              .switch_if_empty(rxcpp::observable<>::just(Probe{ bucket, nullptr, nullptr }))
+              .on_error_resume_next([bucket](std::exception_ptr error) {
+                return rxcpp::observable<>::just(Probe{ bucket, nullptr, error });
+              })
+              .as_dynamic();
+          })
+          .op(RxParallelConcat(self->buckets_.size()))
+          .filter([outcomes](const Probe& probe) {
+            auto failed = std::any_of(outcomes->begin(), outcomes->end(),
+                [](const Probe& preceding) { return preceding.error != nullptr; });
+            if (probe.page && !failed) {
+              return true;
+            }
+            outcomes->push_back(Probe{ probe.bucket,
+                probe.page ? std::make_shared<std::string>() : nullptr, // "found" marker
+                probe.error });
+            return false;
+          })
+          .take(1)
+          .map([](const Probe& probe) { return probe.page; })
+          .switch_if_empty(RxLazy<std::shared_ptr<std::string>>(
+              [outcomes, path]() -> messaging::MessageSequence {
+            if (std::none_of(outcomes->begin(), outcomes->end(),
+                  [](const Probe& probe) { return probe.error != nullptr; })) {
+              return rxcpp::observable<>::empty<std::shared_ptr<std::string>>();
+            }
+
+            std::string described;
+            for (const auto& probe : *outcomes) {
+              described += "\n  " + probe.bucket + ": "
+                + (probe.error ? GetExceptionMessage(probe.error)
+                  : probe.page ? std::string("found") : std::string("not found"));
+            }
+            return rxcpp::observable<>::error<std::shared_ptr<std::string>>(
+                std::runtime_error("Could not retrieve page '" + path
+                  + "' from S3 buckets:" + described));
+          }));
+      });
+    }
+
     // If the object is not in the first bucket, it might be in one of the
     // next buckets_, so the idea is to first call
     //
@@ -283,24 +546,22 @@ namespace {
     [self,path,bucket,post_pending=std::move(post_pending)]()
       -> messaging::MessageSequence {
 
-      size_t conn_idx = self->getQuietestConn();
+      uint64_t expected_size = self->expectedGetSize_;
+      auto conn = self->acquireConn(expected_size);
+      auto start = std::chrono::steady_clock::now();
 
       post_pending->trigger();
       // NB. We can't use post_pending.reset() since post_pending is const.
 
-      (self->openRequestsCounts_->at(conn_idx))++;
-
-      if (self->metrics_) {
-        self->metrics_->active_requests.Increment();
-      }
-
-      auto post_active = DeferShared([self, conn_idx]{
-        (self->openRequestsCounts_->at(conn_idx))--;
-        if (self->metrics_)
-          self->metrics_->active_requests.Decrement();
+      auto post_active = DeferShared([self, conn, expected_size, start]{
+        self->releaseConn(conn, expected_size, start);
       });
 
-      return self->clients_.at(conn_idx)->getObject(path, bucket)
+      return conn->client->getObject(path, bucket)
+        .tap([self](const std::shared_ptr<std::string>& page) {
+          // moving average that follows the typical page size
+          self->expectedGetSize_ = (7 * self->expectedGetSize_ + page->size()) / 8;
+        })
         .op(RxButFirst(
 
           // RxButFirst makes sure the function below is called after
@@ -344,30 +605,44 @@ namespace {
     // The "subscribe" on the returned observable may be called much later,
     // so we do not immediately pick a connection.
     return RxLazy<std::string>(
-    [self,path,page_parts=std::move(page_parts),post_pending=std::move(post_pending)]()
+    [self,path,pages_size,page_parts=std::move(page_parts),post_pending=std::move(post_pending)]()
       -> rxcpp::observable<std::string> {
 
-      size_t conn_idx = self->getQuietestConn();
-
       post_pending->trigger();
 
-      (self->openRequestsCounts_->at(conn_idx))++;
-      if (self->metrics_) {
-        self->metrics_->active_requests.Increment();
+      if (pages_size >= self->multipartThreshold_) {
+        return self->putMultipart(path, page_parts);
       }
 
-      auto post_active = DeferShared([self,conn_idx](){
-        (self->openRequestsCounts_->at(conn_idx))--;
-        if (self->metrics_)
-          self->metrics_->active_requests.Decrement();
+      return self->sendRequest<std::string>(pages_size,
+        [self,path,page_parts](s3::Client& client) {
+          return client.putObject(path, self->writeBucket_, page_parts);
+        });
+
+    });
+  }
+
+
+  template <typename T>
+  rxcpp::observable<T> S3PageStore::sendRequest(uint64_t bytes,
+      std::function<rxcpp::observable<T>(s3::Client&)> send)
+  {
+    return RxLazy<T>(
+    [self=this->shared_from_this(),bytes,send=std::move(send)]()
+      -> rxcpp::observable<T> {
+
+      auto conn = self->acquireConn(bytes);
+      auto start = std::chrono::steady_clock::now();
+
+      auto post_active = DeferShared([self,conn,bytes,start](){
+        self->releaseConn(conn, bytes, start);
       });
 
-      return self->clients_.at(conn_idx)->putObject(path,
-        self->writeBucket_, page_parts)
+      return send(*conn->client)
         .op(RxButFirst(
 
           // RxButFirst makes sure the function below is called after
-          // putObject's work should be done.
+          // the request's work should be done.
           [post_active=std::move(post_active)](){
             post_active->trigger();
           }
@@ -376,6 +651,100 @@ namespace {
     });
   }
 
+
+  rxcpp::observable<std::string> S3PageStore::putMultipart(
+      const std::string& path,
+      const std::vector<std::shared_ptr<std::string>>& page_parts)
+  {
+    // Cut the page into parts of multipartPartSize_ bytes, adding the
+    // remainder to the last part (so that it isn't below the minimum size).
+    uint64_t pages_size = 0;
+    for (const auto& page_part : page_parts) {
+      pages_size += page_part->size();
+    }
+    auto partCount = std::max<uint64_t>(pages_size / multipartPartSize_, 1);
+
+    std::vector<std::shared_ptr<std::string>> parts;
+    Md5 hasher;
+    auto part = std::make_shared<std::string>();
+    for (const auto& page_part : page_parts) {
+      hasher.update(*page_part);
+      std::string_view remaining = *page_part;
+      while (!remaining.empty()) {
+        auto take = remaining.size();
+        if (parts.size() + 1 < partCount) {
+          take = std::min<size_t>(take, multipartPartSize_ - part->size());
+        }
+        part->append(remaining.substr(0, take));
+        remaining.remove_prefix(take);
+        if (parts.size() + 1 < partCount && part->size() == multipartPartSize_) {
+          parts.push_back(std::move(part));
+          part = std::make_shared<std::string>();
+        }
+      }
+    }
+    parts.push_back(std::move(part));
+    assert(parts.size() == partCount);
+
+    // We return the ETag that putObject would have returned for the whole
+    // page, since our callers compare it to the page's MD5.
+    auto etag = "\"" + boost::algorithm::to_lower_copy(
+        boost::algorithm::hex(hasher.digest())) + "\"";
+
+    auto self = this->shared_from_this();
+    std::string bucket = writeBucket_;
+
+    return this->sendRequest<std::string>(0,
+      [path,bucket](s3::Client& client) {
+        return client.createMultipartUpload(path, bucket);
+      })
+    .flat_map([self,path,bucket,parts,etag](const std::string& uploadId) {
+      return rxcpp::observable<>::range<unsigned int>(1, static_cast<unsigned int>(parts.size()))
+        .map([self,path,bucket,uploadId,parts](unsigned int partNumber) {
+          auto part = parts[partNumber - 1];
+          return self->sendRequest<std::string>(part->size(),
+            [path,bucket,uploadId,partNumber,part](s3::Client& client) {
+              return client.uploadPart(path, bucket, uploadId, partNumber, { part });
+            })
+            .map([part](const std::string& partETag) {
+              if (partETag != s3::ETag(*part)) {
+                throw std::runtime_error("S3 returned unexpected ETag for uploaded part");
+              }
+              return partETag;
+            });
+        })
+        .op(RxParallelConcat(self->maxConnections_))
+        .op(RxToVector())
+        .flat_map([self,path,bucket,uploadId,etag](
+              std::shared_ptr<std::vector<std::string>> partETags) {
+          return self->sendRequest<std::string>(0,
+            [path,bucket,uploadId,partETags](s3::Client& client) {
+              return client.completeMultipartUpload(path, bucket, uploadId, *partETags);
+            })
+            .map([partETags,etag](const std::string& objectETag) {
+              if (objectETag != s3::MultipartETag(*partETags)) {
+                throw std::runtime_error("S3 returned unexpected ETag for object assembled from parts");
+              }
+              return etag;
+            });
+        })
+        .on_error_resume_next([self,path,bucket,uploadId](std::exception_ptr error) {
+          // Don't leave the uploaded parts lingering in the bucket
+          self->sendRequest<FakeVoid>(0,
+            [path,bucket,uploadId](s3::Client& client) {
+              return client.abortMultipartUpload(path, bucket, uploadId);
+            })
+            .subscribe(
+              [](FakeVoid) { /* ignore */ },
+              [path](std::exception_ptr abortError) {
+                PEP_LOG(LogTag, Severity::Warning) << "Failed to abort multipart upload of "
+                  << path << ": " << GetExceptionMessage(abortError);
+              });
+          return rxcpp::observable<>::error<std::string>(error);
+        });
+    });
+  }
+
   // stores data directly on disk
   class LocalPageStore
     : public PageStore,
@@ -595,6 +964,321 @@ namespace {
       }).as_dynamic();
   }
 
+  // Keeps recently read and written pages of another page store in a
+  // size-bounded cache, either in memory or in a directory on local disk.
+  // Pages (i.e. objects) are stored in the cache together with their ETag,
+  // which is checked whenever a page is read back from disk. Disk I/O is
+  // performed on the WorkerPool, while bookkeeping stays on our I/O context.
+  class CachingPageStore
+    : public PageStore,
+      public std::enable_shared_from_this<CachingPageStore>
+  {
+  public:
+
+    messaging::MessageSequence
+      get(const std::string& path) override;
+
+    rxcpp::observable<std::string> put(
+        const std::string& path,
+        std::vector<std::shared_ptr<std::string>> page_parts) override;
+
+    static std::shared_ptr<CachingPageStore> Create(
+        std::shared_ptr<boost::asio::io_context> io_context,
+        std::shared_ptr<PageStore> store,
+        std::shared_ptr<prometheus::Registry> metrics_registry,
+        const Configuration& config);
+
+    // pubic constructor for the sake of std::make_shared
+    CachingPageStore(
+        std::shared_ptr<boost::asio::io_context> io_context,
+        std::shared_ptr<PageStore> store,
+        uint64_t maxBytes,
+        std::optional<std::filesystem::path> directory,
+        std::shared_ptr<prometheus::Registry> metrics_registry);
+
+    ~CachingPageStore() override;
+
+  private:
+    struct Cached {
+      std::string path; // of the page in the underlying store
+      std::string etag;
+      uint64_t size;
+      std::shared_ptr<const std::string> page; // nullptr if the page is cached on disk
+      uint64_t fileId = 0; // if the page is cached on disk
+    };
+
+    std::shared_ptr<boost::asio::io_context> ioContext_;
+    std::shared_ptr<WorkerPool> workerPool_;
+    std::shared_ptr<PageStore> store_;
+    const uint64_t maxBytes_;
+    std::optional<std::filesystem::path> directory_; // std::nullopt if pages are cached in memory
+
+    std::list<Cached> entries_; // Most recently used first
+    std::unordered_map<std::string, std::list<Cached>::iterator> index_;
+    uint64_t bytes_ = 0U;
+    uint64_t nextFileId_ = 0U;
+
+    std::filesystem::path getFilePath(uint64_t fileId) const;
+    void removeFile(uint64_t fileId) const;
+    // Emits the cached page, or nullptr if the page isn't (validly) cached
+    rxcpp::observable<std::shared_ptr<std::string>> lookup(const std::string& path);
+    // Completes when the page has been cached (or has been found uncachable)
+    rxcpp::observable<FakeVoid> insert(const std::string& path, std::shared_ptr<std::string> page, std::string etag);
+    void add(Cached cached);
+    void erase(std::list<Cached>::iterator position);
+
+    struct Metrics {
+      prometheus::Counter& hits;
+      prometheus::Counter& misses;
+      prometheus::Counter& corrupt_pages;
+      prometheus::Gauge& size;
+
+      Metrics(std::shared_ptr<prometheus::Registry> registry)
+        : hits(prometheus::BuildCounter()
+            .Name("pep_sf_page_cache_hits")
+            .Help("number of pages retrieved from the page cache")
+            .Register(*registry)
+            .Add({})),
+          misses(prometheus::BuildCounter()
+            .Name("pep_sf_page_cache_misses")
+            .Help("number of pages that had to be retrieved from the underlying page store")
+            .Register(*registry)
+            .Add({})),
+          corrupt_pages(prometheus::BuildCounter()
+            .Name("pep_sf_page_cache_corrupt_pages")
+            .Help("number of cached pages discarded because they didn't match their ETag")
+            .Register(*registry)
+            .Add({})),
+          size(prometheus::BuildGauge()
+            .Name("pep_sf_page_cache_bytes")
+            .Help("total size of the pages in the page cache")
+            .Register(*registry)
+            .Add({})) { }
+    };
+
+    std::optional<Metrics> metrics_;
+  };
+
+  std::shared_ptr<CachingPageStore> CachingPageStore::Create(
+      std::shared_ptr<boost::asio::io_context> io_context,
+      std::shared_ptr<PageStore> store,
+      std::shared_ptr<prometheus::Registry> metrics_registry,
+      const Configuration& config)
+  {
+    auto maxBytes = config.get<uint64_t>("MaxSize");
+    if (maxBytes == 0U) {
+      throw std::runtime_error("Configuration error: page cache MaxSize must be positive");
+    }
+    return std::make_shared<CachingPageStore>(io_context, store, maxBytes,
+        config.get<std::optional<std::filesystem::path>>("Directory"),
+        metrics_registry);
+  }
+
+  CachingPageStore::CachingPageStore(
+      std::shared_ptr<boost::asio::io_context> io_context,
+      std::shared_ptr<PageStore> store,
+      uint64_t maxBytes,
+      std::optional<std::filesystem::path> directory,
+      std::shared_ptr<prometheus::Registry> metrics_registry)
+    : ioContext_(io_context),
+      workerPool_(WorkerPool::getShared()),
+      store_(store),
+      maxBytes_(maxBytes),
+      metrics_(metrics_registry ? std::make_optional<Metrics>(metrics_registry)
+                               : std::nullopt)
+  {
+    if (directory) {
+      // We don't keep an index of cached files across restarts, so we start
+      // with an empty (sub)directory of our own.
+      directory_ = *directory / "page-cache";
+      std::filesystem::remove_all(*directory_);
+      std::filesystem::create_directories(*directory_);
+    }
+  }
+
+  CachingPageStore::~CachingPageStore() {
+    if (directory_) {
+      std::error_code ec;
+      std::filesystem::remove_all(*directory_, ec);
+    }
+  }
+
+  std::filesystem::path CachingPageStore::getFilePath(uint64_t fileId) const {
+    assert(directory_);
+    return *directory_ / (std::to_string(fileId) + ".page");
+  }
+
+  void CachingPageStore::removeFile(uint64_t fileId) const {
+    // Fire and forget: the file is no longer indexed, so nobody will start reading it
+    rxcpp::observable<>::just(this->getFilePath(fileId))
+      .observe_on(workerPool_->worker())
+      .subscribe([](const std::filesystem::path& file) {
+        std::error_code ec;
+        std::filesystem::remove(file, ec);
+      });
+  }
+
+  rxcpp::observable<std::shared_ptr<std::string>> CachingPageStore::lookup(const std::string& path) {
+    auto found = index_.find(path);
+    if (found == index_.end()) {
+      return rxcpp::observable<>::just(std::shared_ptr<std::string>());
+    }
+    auto position = found->second;
+    entries_.splice(entries_.begin(), entries_, position);
+
+    if (position->page != nullptr) {
+      // Return a copy, since consumers (such as PagedEntryPayload::readPage) may modify the page
+      return rxcpp::observable<>::just(std::make_shared<std::string>(*position->page));
+    }
+
+    return rxcpp::observable<>::just(FakeVoid())
+      .observe_on(workerPool_->worker())
+      .map([file = this->getFilePath(position->fileId), size = position->size, etag = position->etag, path](FakeVoid)
+          -> std::shared_ptr<std::string> {
+        try {
+          auto page = std::make_shared<std::string>(ReadFile(file));
+          if (page->size() == size && s3::ETag(*page) == etag) {
+            return page;
+          }
+        }
+        catch (const std::exception& e) {
+          PEP_LOG(LogTag, Severity::Warning) << "Could not read cached page " << path << ": " << e.what();
+        }
+        return nullptr;
+      })
+      .observe_on(ObserveOnAsio(*ioContext_))
+      .map([self = this->shared_from_this(), path, fileId = position->fileId](std::shared_ptr<std::string> page) {
+        if (page == nullptr) {
+          // Discard the entry, unless it has been evicted or replaced while we were reading it
+          auto found = self->index_.find(path);
+          if (found != self->index_.end() && found->second->fileId == fileId) {
+            PEP_LOG(LogTag, Severity::Warning) << "Discarding corrupt cached page " << path;
+            if (self->metrics_) {
+              self->metrics_->corrupt_pages.Increment();
+            }
+            self->erase(found->second);
+          }
+        }
+        return page;
+      });
+  }
+
+  rxcpp::observable<FakeVoid> CachingPageStore::insert(const std::string& path,
+      std::shared_ptr<std::string> page, std::string etag) {
+    auto existing = index_.find(path);
+    if (existing != index_.end()) {
+      this->erase(existing->second);
+    }
+    if (page->size() > maxBytes_) {
+      return rxcpp::observable<>::just(FakeVoid());
+    }
+
+    Cached cached{ .path = path, .etag = std::move(etag), .size = page->size() };
+    if (!directory_) {
+      // Keep a copy, since consumers (such as PagedEntryPayload::readPage) may modify the page
+      cached.page = std::make_shared<const std::string>(*page);
+      this->add(std::move(cached));
+      return rxcpp::observable<>::just(FakeVoid());
+    }
+
+    // Only index the page once its file has been written, so that lookups can't read a partial file
+    cached.fileId = nextFileId_++;
+    return rxcpp::observable<>::just(FakeVoid())
+      .observe_on(workerPool_->worker())
+      .map([file = this->getFilePath(cached.fileId), page, path](FakeVoid) {
+        try {
+          WriteFile(file, *page);
+          return true;
+        }
+        catch (const std::exception& e) {
+          PEP_LOG(LogTag, Severity::Warning) << "Could not cache page " << path << ": " << e.what();
+          return false;
+        }
+      })
+      .observe_on(ObserveOnAsio(*ioContext_))
+      .map([self = this->shared_from_this(), cached](bool written) {
+        if (written) {
+          if (self->index_.contains(cached.path)) { // Cached by another insert while we were writing
+            self->removeFile(cached.fileId);
+          }
+          else {
+            self->add(cached);
+          }
+        }
+        return FakeVoid();
+      });
+  }
+
+  void CachingPageStore::add(Cached cached) {
+    bytes_ += cached.size;
+    entries_.push_front(std::move(cached));
+    index_[entries_.front().path] = entries_.begin();
+
+    while (bytes_ > maxBytes_) {
+      this->erase(std::prev(entries_.end()));
+    }
+    if (metrics_) {
+      metrics_->size.Set(static_cast<double>(bytes_));
+    }
+  }
+
+  void CachingPageStore::erase(std::list<Cached>::iterator position) {
+    if (directory_) {
+      this->removeFile(position->fileId);
+    }
+    bytes_ -= position->size;
+    index_.erase(position->path);
+    entries_.erase(position);
+    if (metrics_) {
+      metrics_->size.Set(static_cast<double>(bytes_));
+    }
+  }
+
+  messaging::MessageSequence
+      CachingPageStore::get(const std::string& path) {
+    return this->lookup(path)
+      .flat_map([self = this->shared_from_this(), path](std::shared_ptr<std::string> page) -> messaging::MessageSequence {
+        if (page != nullptr) {
+          if (self->metrics_) {
+            self->metrics_->hits.Increment();
+          }
+          return rxcpp::observable<>::just(page).as_dynamic();
+        }
+
+        if (self->metrics_) {
+          self->metrics_->misses.Increment();
+        }
+        return self->store_->get(path)
+          .flat_map([self, path](std::shared_ptr<std::string> page) {
+            // Emit the page after caching it, since consumers may modify it
+            return self->insert(path, page, s3::ETag(*page))
+              .map([page](FakeVoid) { return page; });
+          })
+          .as_dynamic();
+      });
+  }
+
+  rxcpp::observable<std::string> CachingPageStore::put(
+      const std::string& path,
+      std::vector<std::shared_ptr<std::string>> page_parts) {
+    // Cache the object as the underlying store will have stored it
+    auto page = std::make_shared<std::string>();
+    for (const auto& part : page_parts) {
+      *page += *part;
+    }
+
+    return store_->put(path, std::move(page_parts))
+      .flat_map([self = this->shared_from_this(), path, page](const std::string& etag) -> rxcpp::observable<std::string> {
+        // Only cache what we know the underlying store has received intact
+        if (etag != s3::ETag(*page)) {
+          return rxcpp::observable<>::just(etag).as_dynamic();
+        }
+        return self->insert(path, page, etag)
+          .map([etag](FakeVoid) { return etag; })
+          .as_dynamic();
+      });
+  }
+
 }
 
 
@@ -605,18 +1289,26 @@ std::shared_ptr<PageStore> PageStore::Create(
 {
   auto s3Config = config.get_child_optional("S3");
   auto localConfig = config.get_child_optional("Local");
+  auto cacheConfig = config.get_child_optional("Cache");
 
+  std::shared_ptr<PageStore> result;
   if (s3Config && localConfig) {
-    return DualPageStore::Create(io_context, metrics_registry, *s3Config, *localConfig);
+    result = DualPageStore::Create(io_context, metrics_registry, *s3Config, *localConfig);
+  }
+  else if (s3Config) {
+    result = S3PageStore::Create(io_context, metrics_registry, *s3Config);
   }
-  if (s3Config) {
-    return S3PageStore::Create(io_context, metrics_registry, *s3Config);
+  else if (localConfig) {
+    result = LocalPageStore::Create(io_context, *localConfig);
   }
-  if (localConfig) {
-    return LocalPageStore::Create(io_context, *localConfig);
+  else {
+    throw std::runtime_error("Configuration error: no page store implementation specified");
   }
 
-  throw std::runtime_error("Configuration error: no page store implementation specified");
+  if (cacheConfig) {
+    result = CachingPageStore::Create(io_context, result, metrics_registry, *cacheConfig);
+  }
+  return result;
 }
 
 }
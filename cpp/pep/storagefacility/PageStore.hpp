@@ -24,7 +24,9 @@ namespace pep
         const std::string& path) = 0;
 
     // returns the MD5 ('ETag') of the page computed by the backend,
-    // usually the S3 server.
+    // usually the S3 server.  (For pages that S3PageStore uploads in
+    // multiple parts, it's computed locally instead, after checking
+    // the parts' ETags.)
     virtual rxcpp::observable<std::string> put(
         const std::string& path,
         std::vector<std::shared_ptr<std::string>> page_parts) = 0;
@@ -51,6 +53,11 @@ namespace pep
     //     Both:     use both an S3 server and legacy local storage -
     //               used by integration, to keep the two methods in sync.
     //
+    // May additionally contain a "Cache" subkey, to keep recently read and
+    // written pages in a cache of at most "MaxSize" bytes in front of the
+    // store(s) above: in the specified "Directory" on local disk, or in
+    // memory if no directory is specified.
+    //
     // The exact format for the "config" can be found in the
     // <Type>PageStore::Create static methods in PageStore.cpp.
     static std::shared_ptr<PageStore> Create(
@@ -283,4 +283,19 @@ std::string ETag(const std::string& object) {
   return pep::ETag(object);  // see storagefacility/PageHash.hpp
 }
 
+
+std::string MultipartETag(const std::vector<std::string>& partETags) {
+  // The MD5 of the concatenated (binary) MD5s of the parts, followed
+  // by the number of parts, as in  "<hex md5>-<part count>".
+  Md5 hasher;
+  for (const auto& partETag : partETags) {
+    if (partETag.size() < 2 || partETag.front() != '"' || partETag.back() != '"') {
+      throw std::invalid_argument("Invalid ETag: " + partETag);
+    }
+    hasher.update(boost::algorithm::unhex(partETag.substr(1, partETag.size() - 2)));
+  }
+  return "\"" + boost::algorithm::to_lower_copy(boost::algorithm::hex(hasher.digest()))
+    + "-" + std::to_string(partETags.size()) + "\"";
+}
+
 }
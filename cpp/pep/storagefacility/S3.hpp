@@ -89,4 +89,8 @@ std::string TimeInAmzIso8601(void);
 // in one part (using the PUT Object command, without server-side encryption.)
 std::string ETag(const std::string& object);
 
+// Computes the ETag we should expect after uploading an object in multiple
+// parts (using a multipart upload), given the ETags of those parts.
+std::string MultipartETag(const std::vector<std::string>& partETags);
+
 }
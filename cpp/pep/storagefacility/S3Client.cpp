@@ -4,6 +4,7 @@
 
 #include <pep/utils/OpenSSLHasher.hpp>
 
+#include <cctype>
 #include <sstream>
 
 #include <boost/property_tree/ptree.hpp>
@@ -45,6 +46,28 @@ private:
       const std::string& name,
       const std::string& bucket) override;
 
+  rxcpp::observable<std::string> createMultipartUpload(
+      const std::string& name,
+      const std::string& bucket) override;
+
+  rxcpp::observable<std::string> uploadPart(
+      const std::string& name,
+      const std::string& bucket,
+      const std::string& uploadId,
+      unsigned int partNumber,
+      std::vector<std::shared_ptr<std::string>> payload) override;
+
+  rxcpp::observable<std::string> completeMultipartUpload(
+      const std::string& name,
+      const std::string& bucket,
+      const std::string& uploadId,
+      const std::vector<std::string>& partETags) override;
+
+  rxcpp::observable<FakeVoid> abortMultipartUpload(
+      const std::string& name,
+      const std::string& bucket,
+      const std::string& uploadId) override;
+
   // helper function to create a basic unsigned S3 http request
   HTTPRequest requestTemplate(
       const std::string& path,
@@ -58,6 +81,34 @@ private:
   std::set<std::string> unexpectedHeaders_;
 };
 
+// Encodes a query parameter value as required for the "Authorization"
+// header, see
+//
+//   https://docs.aws.amazon.com/AmazonS3/latest/API/sig-v4-header-based-auth.html
+std::string UriEncode(const std::string& value) {
+  static const char* hexDigits = "0123456789ABCDEF";
+  std::string result;
+  for (unsigned char c : value) {
+    if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+      result += static_cast<char>(c);
+    }
+    else {
+      result += '%';
+      result += hexDigits[c >> 4];
+      result += hexDigits[c & 0xF];
+    }
+  }
+  return result;
+}
+
+// Parses the XML body of a response to a multipart upload request.
+boost::property_tree::ptree ParseXmlBody(const HTTPResponse& resp) {
+  boost::property_tree::ptree result;
+  std::istringstream bodyss(resp.getBody());
+  boost::property_tree::read_xml(bodyss, result);
+  return result;
+}
+
 // to define the contructor of ClientImp,
 // we need the following function to pass
 // Client::Parameters values to HttpClient::Create
@@ -220,8 +271,15 @@ messaging::MessageSequence
 
     unsigned int status_code = resp.getStatusCode();
 
-    if (status_code == 200)
-      return rxcpp::observable<>::just(resp.getBodypart());
+    if (status_code == 200) {
+      // A chunked response yields multiple bodyparts, which we join
+      // (instead of having getBodypart() throw).
+      auto body = resp.getBodyparts().size() == 1
+        ? resp.getBodyparts().front()
+        : std::make_shared<std::string>(resp.getBody());
+
+      return rxcpp::observable<>::just(body);
+    }
 
     assert(status_code == 404);
 
@@ -260,6 +318,138 @@ messaging::MessageSequence
 
 }
 
+rxcpp::observable<std::string> ClientImp::createMultipartUpload(
+      const std::string& name,
+      const std::string& bucket)
+{
+  auto request = this->requestTemplate(
+      "/" + bucket + "/" + name,
+      networking::HttpMethod::Post);
+  request.uri().set_encoded_query("uploads");
+
+  request::Sign(request, credentials_);
+
+  return http_->sendRequest(std::move(request)).map(
+
+  [self = SharedFrom(*this)](HTTPResponse resp) -> std::string {
+
+    self->precheckResponse(resp, { /* acceptable status code: */ 200 });
+
+    auto uploadId = ParseXmlBody(resp).get<std::string>(
+        "InitiateMultipartUploadResult.UploadId", "");
+    if (uploadId.empty()) {
+      throw std::runtime_error("S3 did not return the ID of the multipart "
+          "upload: " + resp.getBody());
+    }
+    return uploadId;
+  });
+}
+
+rxcpp::observable<std::string> ClientImp::uploadPart(
+      const std::string& name,
+      const std::string& bucket,
+      const std::string& uploadId,
+      unsigned int partNumber,
+      std::vector<std::shared_ptr<std::string>> payload)
+{
+  auto request = this->requestTemplate(
+      "/" + bucket + "/" + name,
+      networking::HttpMethod::Put, payload);
+  request.uri().set_encoded_query("partNumber=" + std::to_string(partNumber)
+      + "&uploadId=" + UriEncode(uploadId));
+
+  request::Sign(request, credentials_);
+
+  return http_->sendRequest(std::move(request)).map(
+
+  [self = SharedFrom(*this)](HTTPResponse resp) -> std::string {
+
+    self->precheckResponse(resp, { /* acceptable status code: */ 200 });
+
+    if (!resp.hasHeader("ETag")) {
+      throw std::runtime_error("S3 did not return the MD5 hash "
+          "of the uploaded part (the 'ETag' header.)");
+    }
+
+    return resp.header("ETag");
+  });
+}
+
+rxcpp::observable<std::string> ClientImp::completeMultipartUpload(
+      const std::string& name,
+      const std::string& bucket,
+      const std::string& uploadId,
+      const std::vector<std::string>& partETags)
+{
+  boost::property_tree::ptree parts;
+  for (size_t i = 0; i < partETags.size(); ++i) {
+    boost::property_tree::ptree part;
+    part.put("PartNumber", i + 1);
+    part.put("ETag", partETags[i]);
+    parts.add_child("Part", part);
+  }
+  boost::property_tree::ptree body;
+  body.add_child("CompleteMultipartUpload", parts);
+  std::ostringstream bodyss;
+  boost::property_tree::write_xml(bodyss, body);
+
+  auto request = this->requestTemplate(
+      "/" + bucket + "/" + name,
+      networking::HttpMethod::Post,
+      { std::make_shared<std::string>(std::move(bodyss).str()) });
+  request.uri().set_encoded_query("uploadId=" + UriEncode(uploadId));
+
+  request::Sign(request, credentials_);
+
+  return http_->sendRequest(std::move(request)).map(
+
+  [self = SharedFrom(*this), name, bucket](HTTPResponse resp) -> std::string {
+
+    self->precheckResponse(resp, { /* acceptable status code: */ 200 });
+
+    // S3 may report that assembling the object failed (after it already
+    // sent the status line) by responding with an error document.
+    auto result = ParseXmlBody(resp);
+    if (result.count("Error") != 0) {
+      PEP_LOG(LogTag, Severity::Warning) << "Completing multipart upload of '"
+        << name << "' to bucket '" << bucket << "' gave '"
+        << result.get<std::string>("Error.Code", "") << "' error code";
+      throw std::runtime_error("Request to S3 backend failed");
+    }
+
+    auto etag = result.get<std::string>("CompleteMultipartUploadResult.ETag", "");
+    if (etag.empty()) {
+      throw std::runtime_error("S3 did not return the ETag "
+          "of the assembled object: " + resp.getBody());
+    }
+    return etag;
+  });
+}
+
+rxcpp::observable<FakeVoid> ClientImp::abortMultipartUpload(
+      const std::string& name,
+      const std::string& bucket,
+      const std::string& uploadId)
+{
+  auto request = this->requestTemplate(
+      "/" + bucket + "/" + name,
+      networking::HttpMethod::Delete);
+  request.uri().set_encoded_query("uploadId=" + UriEncode(uploadId));
+
+  request::Sign(request, credentials_);
+
+  return http_->sendRequest(std::move(request)).map(
+
+  [self = SharedFrom(*this)](HTTPResponse resp) {
+
+    self->precheckResponse(resp, { // acceptable status codes:
+        204, // upload aborted
+        404  // upload was already aborted or completed
+    });
+    return FakeVoid();
+  });
+}
+
 }
 
 std::shared_ptr<Client> Client::Create(const Client::Parameters& p) {
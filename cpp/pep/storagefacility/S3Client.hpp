@@ -1,4 +1,5 @@
 #pragma once
+#include <pep/async/FakeVoid.hpp>
 #include <pep/networking/EndPoint.hpp>
 #include <pep/messaging/MessageSequence.hpp>
 #include <pep/storagefacility/S3.hpp>
@@ -8,6 +9,7 @@
 #include <pep/async/IoContext_fwd.hpp>
 
 #include <filesystem>
+#include <optional>
 
 namespace pep::s3 {
 
@@ -65,6 +67,45 @@ public:
     const std::string& name,
     const std::string& bucket) = 0;
 
+  // Objects can also be uploaded in parts (for example in parallel, over
+  // multiple connections) using a multipart upload, see
+  //
+  //   https://docs.aws.amazon.com/AmazonS3/latest/userguide/mpuoverview.html
+  //
+  // All parts but the last must be at least MinimumPartSize bytes.
+  static constexpr uint64_t MinimumPartSize = 5 * 1024 * 1024;
+
+  // Starts a multipart upload, and returns its upload ID, to be passed
+  // to the methods below.
+  virtual rxcpp::observable<std::string> createMultipartUpload(
+    const std::string& name,
+    const std::string& bucket) = 0;
+
+  // Uploads part number partNumber (starting at 1) of a multipart upload.
+  // Returns the part's Etag (=MD5), as computed by the S3 server.
+  virtual rxcpp::observable<std::string> uploadPart(
+    const std::string& name,
+    const std::string& bucket,
+    const std::string& uploadId,
+    unsigned int partNumber,
+    std::vector<std::shared_ptr<std::string>> payload) = 0;
+
+  // Assembles the object from its parts, whose Etags are passed in order of
+  // their part numbers.  Returns the ETag of the object, which (unlike the
+  // one returned by putObject) is not the MD5 of the object: see MultipartETag.
+  virtual rxcpp::observable<std::string> completeMultipartUpload(
+    const std::string& name,
+    const std::string& bucket,
+    const std::string& uploadId,
+    const std::vector<std::string>& partETags) = 0;
+
+  // Discards a multipart upload that won't be completed, together with
+  // the parts that were uploaded for it.
+  virtual rxcpp::observable<FakeVoid> abortMultipartUpload(
+    const std::string& name,
+    const std::string& bucket,
+    const std::string& uploadId) = 0;
+
   virtual void start() = 0;
   virtual void shutdown() = 0;
 
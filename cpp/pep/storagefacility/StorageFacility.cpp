@@ -7,12 +7,15 @@
 #include <pep/async/CreateObservable.hpp>
 #include <pep/utils/Random.hpp>
 #include <pep/utils/Hasher.hpp>
+#include <pep/utils/Hmac.hpp>
+#include <pep/utils/OpenSSLHasher.hpp>
 #include <pep/async/RxIterate.hpp>
 #include <pep/async/RxParallelConcat.hpp>
 #include <pep/utils/ApplicationMetrics.hpp>
 #include <pep/auth/EnrolledParty.hpp>
 #include <pep/storagefacility/StorageFacilitySerializers.hpp>
 #include <pep/storagefacility/SFIdSerializer.hpp>
+#include <pep/storagefacility/PagePutWindow.hpp>
 #include <pep/messaging/MessageHeader.hpp>
 #include <pep/utils/Defer.hpp>
 #include <pep/morphing/MorphingPropertySerializers.hpp>
@@ -29,6 +32,7 @@
 #include <rxcpp/operators/rx-reduce.hpp>
 #include <rxcpp/operators/rx-tap.hpp>
 
+#include <span>
 #include <unordered_map>
 #include <sstream>
 
@@ -43,6 +47,9 @@ namespace pep {
 namespace {
 
 constexpr size_t EnumerationResponseMaxEntries = 2500;
+constexpr size_t TicketPseudonymDecryptionBatchSize = 64;
+constexpr size_t SFIdDecryptionBatchSize = 64;
+constexpr size_t RerandomizationBatchSize = 8;
 constexpr size_t PayloadPagesMaxConcurrency = 1000; // Prevent excessive memory use: see https://gitlab.pep.cs.ru.nl/pep/ppp-config/-/issues/166#note_50515
 
 class TicketIndices {
@@ -51,27 +58,17 @@ public:
 
 private:
   std::unordered_map<std::string, Index> columns_;
-  std::unordered_map<LocalPseudonym, Index> pseudonyms_;
+  std::shared_ptr<const TicketPseudonyms> pseudonyms_;
 
 public:
-  TicketIndices(const Ticket2& ticket, const ElgamalPrivateKey& pseudonymKey) {
+  TicketIndices(const Ticket2& ticket, std::shared_ptr<const TicketPseudonyms> pseudonyms)
+    : pseudonyms_(std::move(pseudonyms)) {
     if (ticket.columns.size() > std::numeric_limits<Index>::max()) {
       throw std::runtime_error("Ticket contains too many columns to map into an IndexList");
     }
     for (size_t i = 0U; i < ticket.columns.size(); ++i) {
       columns_[ticket.columns[i]] = static_cast<Index>(i);
     }
-
-    if (ticket.accessSubjects.size() > std::numeric_limits<Index>::max()) {
-      throw std::runtime_error("Ticket contains too many subjects to map into an IndexList");
-    }
-    // TODO keep a decryption cache?  If a ticket with a lot of pseudonyms is
-    // reused often (for each file), then we're wasting a lot of time.
-    // See issue #592.
-    for (size_t i = 0U; i < ticket.accessSubjects.size(); ++i) {
-      LocalPseudonym sfPseud = ticket.accessSubjects[i].storageFacility.decrypt(pseudonymKey);
-      pseudonyms_[sfPseud] = static_cast<Index>(i);
-    }
   }
 
   Index getColumnIndex(const std::string& column) const {
@@ -87,11 +84,11 @@ public:
   }
 
   Index getPseudonymIndex(const LocalPseudonym& spPseud) {
-    auto position = pseudonyms_.find(spPseud);
-    if (position == pseudonyms_.cend()) {
+    auto index = pseudonyms_->find(spPseud);
+    if (!index.has_value()) {
       throw Error("Ticket does not grant access to that participant");
     }
-    return position->second;
+    return *index;
   }
 
   void verifyPseudonymAccess(const LocalPseudonym& spPseud) {
@@ -99,6 +96,21 @@ public:
   }
 };
 
+// Returns the ticket's local pseudonyms at the specified indices, or all of them if no indices are specified.
+// Return value indices correspond with the ticket's access subject indices: other elements are std::nullopt.
+std::vector<std::optional<LocalPseudonym>> SelectLocalPseudonyms(const TicketPseudonyms& pseudonyms, std::vector<uint32_t> const *indices) {
+  const auto& source = pseudonyms.localPseudonyms();
+  if (indices == nullptr) {
+    return std::vector<std::optional<LocalPseudonym>>(source.begin(), source.end());
+  }
+
+  std::vector<std::optional<LocalPseudonym>> result(source.size());
+  for (auto i : *indices) { // May contain duplicates, which is harmless here
+    result.at(i) = source.at(i);
+  }
+  return result;
+}
+
 template <typename T>
 bool ReadOptionalNonZeroConfigValue(T& destination, const Configuration& config, const std::string& key) {
   if (auto value = config.get<std::optional<T>>(key)) {
@@ -159,7 +171,7 @@ StorageFacility::Metrics::Metrics(std::shared_ptr<prometheus::Registry> registry
     .Add({})),
   entriesInMetaDir(prometheus::BuildGauge()
     .Name("pep_sf_meta_on_disk")
-    .Help("Number of entries in the meta/ dir") // normally the number of subdirectories, i.e. the number of rows ("participants")
+    .Help("Number of participants (rows) managed by FileStore") // used to be the number of entries in the meta/ dir, i.e. the number of participant subdirectories
     .Register(*registry)
     .Add({})),
   totalPayloadBytes(prometheus::BuildGauge() // Defined as a gauge instead of a Counter (despite only increasing) so that we can .Set it
@@ -171,6 +183,31 @@ StorageFacility::Metrics::Metrics(std::shared_ptr<prometheus::Registry> registry
     .Name("pep_rolling_payload_bytes")
     .Help("Total bytes in payload(page)s of current/latest/rolling data, rounded to configured resolution")
     .Register(*registry)
+    .Add({})),
+  ticketPseudonymCacheHits(prometheus::BuildCounter()
+    .Name("pep_sf_ticket_pseudonym_cache_hits")
+    .Help("Number of requests whose ticket's local pseudonyms had already been decrypted")
+    .Register(*registry)
+    .Add({})),
+  ticketPseudonymCacheMisses(prometheus::BuildCounter()
+    .Name("pep_sf_ticket_pseudonym_cache_misses")
+    .Help("Number of requests whose ticket's local pseudonyms had to be decrypted")
+    .Register(*registry)
+    .Add({})),
+  ticketPseudonymCachePseudonyms(prometheus::BuildGauge()
+    .Name("pep_sf_ticket_pseudonym_cache_pseudonyms")
+    .Help("Number of decrypted local pseudonyms in the ticket pseudonym cache")
+    .Register(*registry)
+    .Add({})),
+  pageDedupeRatio(prometheus::BuildGauge()
+    .Name("pep_sf_page_dedupe_ratio")
+    .Help("Number of references (from current entries) per content addressed page")
+    .Register(*registry)
+    .Add({})),
+  deduplicatedPageUploads(prometheus::BuildGauge() // Defined as a gauge instead of a Counter (despite only increasing) so that we can .Set it
+    .Name("pep_sf_deduplicated_page_uploads")
+    .Help("Number of page uploads that were skipped because a page with the same content had already been stored")
+    .Register(*registry)
     .Add({}))
 { }
 
@@ -184,11 +221,28 @@ StorageFacility::Parameters::Parameters(std::shared_ptr<boost::asio::io_context>
 
     // See the declaration/definition of the fields for default values
     ReadOptionalNonZeroConfigValue(parallelisationWidth_, config, "ParallelisationWidth");
+    ReadOptionalNonZeroConfigValue(maxPendingPageBytes_, config, "MaxPendingPageBytes");
     ReadOptionalNonZeroConfigValue(dataSizeResolution_, config, "DataSizeResolution");
+    ReadOptionalNonZeroConfigValue(ticketPseudonymCacheSize_, config, "TicketPseudonymCacheSize");
 
     encIdKeyFile = config.get<std::filesystem::path>("EncIdKeyFile");
     storagePath_ = config.get<std::filesystem::path>("StoragePath");
     pageStoreConfig_ = std::make_shared<Configuration>(config.get_child("PageStore"));
+
+    if (auto metadataStorage = config.get<std::optional<std::string>>("MetadataStorage")) {
+      if (*metadataStorage == "Directory") {
+        metadataStorage_ = EntryStorage::Type::Directory;
+      }
+      else if (*metadataStorage == "Log") {
+        metadataStorage_ = EntryStorage::Type::Log;
+      }
+      else {
+        throw std::runtime_error("Unsupported MetadataStorage: " + *metadataStorage);
+      }
+    }
+    compactMetadata_ = config.get<std::optional<bool>>("CompactMetadata").value_or(false);
+    historicalEntryCacheSize_ = config.get<std::optional<uint64_t>>("HistoricalEntryCacheSize").value_or(historicalEntryCacheSize_); // May be zero to disable caching
+    contentAddressedPages_ = config.get<std::optional<bool>>("ContentAddressedPages").value_or(false);
   }
   catch (std::exception& e) {
     PEP_LOG(LogTag, Severity::Critical) << "Error with configuration file: " << e.what();
@@ -326,10 +380,16 @@ StorageFacility::handleDataEnumerationRequest2(std::shared_ptr<SignedDataEnumera
   const auto& rootCAs = *this->getRootCAs();
 
   auto certified = signedRequest->open(rootCAs);
-  const auto& request = certified.message;
   auto accessGroup = certified.signatory.organizationalUnit();
-  auto ticket = request.ticket.open(rootCAs, accessGroup, "read-meta");
+  auto ticket = MakeSharedCopy(certified.message.ticket.open(rootCAs, accessGroup, "read-meta"));
+  auto pseudonyms = this->getTicketPseudonyms(certified.message.ticket, *ticket);
 
+  return pseudonyms.flat_map([server = SharedFrom(*this), request = MakeSharedCopy(std::move(certified.message)), ticket, time](std::shared_ptr<const TicketPseudonyms> pseudonyms) {
+    return server->enumerateData(*request, *ticket, *pseudonyms, time);
+  });
+}
+
+messaging::MessageBatches StorageFacility::enumerateData(const DataEnumerationRequest2& request, const Ticket2& ticket, const TicketPseudonyms& pseudonyms, std::chrono::steady_clock::time_point time) {
   struct ResponseEntry {
     DataEnumerationEntry2 entry;
     std::shared_ptr<FileStore::Entry> fileStoreEntry;
@@ -358,9 +418,10 @@ StorageFacility::handleDataEnumerationRequest2(std::shared_ptr<SignedDataEnumera
     columnIndex[ticket.columns[i]] = i;
   }
   // Decrypt pseudonyms.
-  auto localPseudonyms = this->decryptLocalPseudonyms(ticket.accessSubjects, request.pseudonyms.has_value() ? &request.pseudonyms->indices : nullptr);
+  auto localPseudonyms = SelectLocalPseudonyms(pseudonyms, request.pseudonyms.has_value() ? &request.pseudonyms->indices : nullptr);
 
-  std::vector<uint64_t> ids; // used to lookup id from responseEntry index_
+  // Prepare a response entry for every cell that we'll look up: it'll be completed (or discarded) when we've found the cell's entry
+  std::vector<FileStore::EntryKey> keys;
   for (size_t pseud_index = 0; pseud_index < localPseudonyms.size(); pseud_index++) {
     if (!localPseudonyms[pseud_index].has_value()) {
       continue;
@@ -371,34 +432,13 @@ StorageFacility::handleDataEnumerationRequest2(std::shared_ptr<SignedDataEnumera
         continue;
       }
 
-      // enumerateData returns an error if there are no entries, which
-      // we will ignore. Other errors are already logged.
-      EntryName key(*localPseudonyms[pseud_index], col);
-      auto entry = fileStore_->lookup(key, ticket.timestamp);
-      if (!entry) {
-        continue;
-      }
-      const auto& content = entry->content();
-      if (content == nullptr) {
-        continue;
-      }
-      assert(content->payload() != nullptr);
-
+      keys.push_back({ .name = EntryName(*localPseudonyms[pseud_index], col), .validAt = ticket.timestamp });
       auto& re = responseEntries.emplace_back();
-      re.fileStoreEntry = entry;
-      re.entry.metadata = this->compileMetadata(col, *entry);
-      re.entry.fileSize = entry->content()->payload()->size();
-      re.entry.polymorphicKey = content->getPolymorphicKey(); // will be rerandomized later
       re.entry.columnIndex = colIndexIt->second;
       re.entry.pseudonymIndex = static_cast<uint32_t>(pseud_index);
     }
   }
 
-  if (responseEntries.size() > std::numeric_limits<uint32_t>::max()) {
-    // Would overflow index_ otherwise.
-    throw Error("Number of matching entries exceeds uint32");
-  }
-
   struct StreamContext {
     // Context used earlier
     decltype(time) startTime;
@@ -406,121 +446,176 @@ StorageFacility::handleDataEnumerationRequest2(std::shared_ptr<SignedDataEnumera
   auto ctx = std::make_shared<StreamContext>();
   ctx->startTime = time;
 
-  // Rerandomize encrypted polymorphic keys and add the encrypted
-  // SF identifiers.
-  return workerPool_->batched_map<8>(std::move(responseEntries),
-    ObserveOnAsio(*getIoContext()),
-    [ctx, this](ResponseEntry re) {
-      re.entry.polymorphicKey = this->getEgCache().rerandomize(
-        re.entry.polymorphicKey
-      );
-      re.entry.polymorphicKey.ensurePacked();
-
-      auto& sfEntry = re.fileStoreEntry;
-      re.entry.id = encryptId(sfEntry->getName().string(), sfEntry->getValidFrom());
-
-      return re;
-    })
-    .map([](std::vector<ResponseEntry> respEntries) {return std::make_shared<std::vector<ResponseEntry>>(std::move(respEntries)); }) // Ensure flat_map gets a cheaply copyable parameter value. See #1019
-    .flat_map([ctx, server = SharedFrom(*this)](std::shared_ptr<std::vector<ResponseEntry>> respEntriesPtr)
-      -> messaging::MessageBatches {
-
-      // Generate response(s)
-      std::vector<DataEnumerationResponse2> responseMsgs;
-      responseMsgs.emplace_back();
-      size_t i = 0;
-      for (const auto& re : *respEntriesPtr) {
-        responseMsgs.back().entries.push_back(re.entry);
-
-        // We use index_ to lookup the primary key in ids when serving data below.
-        // The client should not learn index_, so we clear it.
-        responseMsgs.back().entries.back().index = 0;
-        if (++i == EnumerationResponseMaxEntries) {
-          i = 0;
-          responseMsgs.back().hasMore = true;
-          responseMsgs.emplace_back();
+  return fileStore_->lookupAsync(std::move(keys), workerPool_)
+    .flat_map([ctx, server = SharedFrom(*this), candidates = MakeSharedCopy(std::move(responseEntries))](std::vector<std::shared_ptr<FileStore::Entry>> entries) {
+      std::vector<ResponseEntry> foundEntries;
+      for (size_t i = 0; i < entries.size(); ++i) {
+        // Cells without (non-deleted) entries are not included in the response
+        const auto& entry = entries[i];
+        if (!entry) {
+          continue;
         }
+        const auto& content = entry->content();
+        if (content == nullptr) {
+          continue;
+        }
+        assert(content->payload() != nullptr);
+
+        auto& re = foundEntries.emplace_back(std::move((*candidates)[i]));
+        re.fileStoreEntry = entry;
+        re.entry.metadata = server->compileMetadata(entry->getName().column(), *entry);
+        re.entry.fileSize = content->payload()->size();
+        re.entry.polymorphicKey = content->getPolymorphicKey(); // will be rerandomized later
       }
-      std::vector<messaging::MessageSequence> response;
-      response.reserve(responseMsgs.size());
-      for (const auto& msg : responseMsgs) {
-        response.push_back(rxcpp::observable<>::from(
-          std::make_shared<std::string>(Serialization::ToString(msg))));
+
+      if (foundEntries.size() > std::numeric_limits<uint32_t>::max()) {
+        // Would overflow index_ otherwise.
+        throw Error("Number of matching entries exceeds uint32");
       }
 
-      server->metrics_->dataEnumerationRequestDuration.Observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - ctx->startTime).count()); // in seconds
-      return RxIterate(std::move(response));
-      });
+      // Rerandomize encrypted polymorphic keys and add the encrypted
+      // SF identifiers.
+      return server->workerPool_->batched_map<RerandomizationBatchSize>(std::move(foundEntries),
+        ObserveOnAsio(*server->getIoContext()),
+        [server](ResponseEntry re) {
+          re.entry.polymorphicKey = server->getEgCache().rerandomize(
+            re.entry.polymorphicKey
+          );
+
+          auto& sfEntry = re.fileStoreEntry;
+          re.entry.id = server->encryptId(sfEntry->getName().string(), sfEntry->getValidFrom());
+
+          return re;
+        },
+        [](std::span<ResponseEntry> respEntries) {
+          std::vector<const CurvePoint*> points;
+          for (const auto& re : respEntries)
+            re.entry.polymorphicKey.addPointsTo(points);
+          CurvePoint::PackBatch(points);
+        })
+        .map([](std::vector<ResponseEntry> respEntries) {return std::make_shared<std::vector<ResponseEntry>>(std::move(respEntries)); }) // Ensure flat_map gets a cheaply copyable parameter value. See #1019
+        .flat_map([ctx, server](std::shared_ptr<std::vector<ResponseEntry>> respEntriesPtr)
+          -> messaging::MessageBatches {
+
+          // Generate response(s)
+          std::vector<DataEnumerationResponse2> responseMsgs;
+          responseMsgs.emplace_back();
+          size_t i = 0;
+          for (const auto& re : *respEntriesPtr) {
+            responseMsgs.back().entries.push_back(re.entry);
+
+            // We use index_ to lookup the primary key in ids when serving data below.
+            // The client should not learn index_, so we clear it.
+            responseMsgs.back().entries.back().index = 0;
+            if (++i == EnumerationResponseMaxEntries) {
+              i = 0;
+              responseMsgs.back().hasMore = true;
+              responseMsgs.emplace_back();
+            }
+          }
+          std::vector<messaging::MessageSequence> response;
+          response.reserve(responseMsgs.size());
+          for (const auto& msg : responseMsgs) {
+            response.push_back(rxcpp::observable<>::from(
+              std::make_shared<std::string>(Serialization::ToString(msg))));
+          }
+
+          server->metrics_->dataEnumerationRequestDuration.Observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - ctx->startTime).count()); // in seconds
+          return RxIterate(std::move(response));
+          });
+    });
 }
 
 messaging::MessageBatches
 StorageFacility::handleMetadataReadRequest2(std::shared_ptr<SignedMetadataReadRequest2> signedRequest) {
-  return rxcpp::observable<>::just(CreateObservable<std::shared_ptr<std::string>>([signedRequest, server = SharedFrom(*this)](rxcpp::subscriber<std::shared_ptr<std::string>> subscriber) {
-    auto rootCAs = server->getRootCAs();
-    auto certified = signedRequest->open(*rootCAs);
-    const auto& request = certified.message;
-    auto userGroup = certified.signatory.organizationalUnit();
-
-    auto ticket = request.ticket.open(
-      *rootCAs,
-      userGroup,
-      "read-meta"
-    );
+  auto rootCAs = this->getRootCAs();
+  auto certified = signedRequest->open(*rootCAs);
+  auto userGroup = certified.signatory.organizationalUnit();
 
-    // Create look-up-tables for columns and pseudonyms from ticket
-    TicketIndices indices(ticket, server->pseudonymKey_);
+  auto ticket = certified.message.ticket.open(
+    *rootCAs,
+    userGroup,
+    "read-meta"
+  );
+  auto pseudonyms = this->getTicketPseudonyms(certified.message.ticket, ticket);
+
+  return pseudonyms.flat_map([request = MakeSharedCopy(std::move(certified.message)), ticket = MakeSharedCopy(std::move(ticket)), server = SharedFrom(*this)](std::shared_ptr<const TicketPseudonyms> pseudonyms) {
+    return server->lookupEncryptedIds(request->ids)
+      .flat_map([request, ticket, pseudonyms, server](std::shared_ptr<std::vector<std::shared_ptr<FileStore::Entry>>> sfentries) {
+        // Create look-up-tables for columns and pseudonyms from ticket
+        TicketIndices indices(*ticket, pseudonyms);
+
+        std::vector<DataEnumerationEntry2> entries;
+        entries.reserve(sfentries->size());
+        for (size_t i = 0; i < sfentries->size(); i++) {
+          const auto& sfentry = (*sfentries)[i];
+          if (sfentry == nullptr) {
+            throw Error("openExistingDataEntry failed");
+          }
+          const auto& sfcontent = sfentry->content();
+          if (sfcontent == nullptr) {
+            throw Error("Cannot read data of a deleted entry");
+          }
+          assert(sfcontent->payload() != nullptr);
+
+          // Parse entry name into properties
+          LocalPseudonym pseud = sfentry->getName().pseudonym();
+          std::string column = sfentry->getName().column();
+
+          auto& entry = entries.emplace_back();
+          entry.metadata = server->compileMetadata(column, *sfentry);
+          entry.polymorphicKey = sfcontent->getPolymorphicKey(); // will be rerandomized below
+          entry.fileSize = sfcontent->payload()->size();
+          entry.id = request->ids[i];
+          entry.index = static_cast<uint32_t>(i);
+          entry.columnIndex = indices.getColumnIndex(column);
+          entry.pseudonymIndex = indices.getPseudonymIndex(pseud);
+        }
 
-    // Create initial response object
-    auto response = std::make_shared<DataEnumerationResponse2>();
-    // (Lambda that) sends the current response object to the subscriber and assigns a new, empty (followup) response object to the "response" variable
-    auto sendResponse = [subscriber, &response]() {
-      auto serialized = std::make_shared<std::string>(Serialization::ToString(*response));
-      if (serialized->size() >= messaging::MaxSizeOfMessage) {
-        throw std::runtime_error("Enumeration response too large to send out");
-      }
-      subscriber.on_next(serialized);
-      response = std::make_shared<DataEnumerationResponse2>();
-    };
+        // Rerandomize encrypted polymorphic keys, retaining the entries' order
+        return server->workerPool_->batched_map<RerandomizationBatchSize>(std::move(entries),
+          ObserveOnAsio(*server->getIoContext()),
+          [server](DataEnumerationEntry2 entry) {
+            entry.polymorphicKey = server->getEgCache().rerandomize(entry.polymorphicKey);
+            return entry;
+          },
+          [](std::span<DataEnumerationEntry2> entries) {
+            std::vector<const CurvePoint*> points;
+            for (const auto& entry : entries)
+              entry.polymorphicKey.addPointsTo(points);
+            CurvePoint::PackBatch(points);
+          });
+      })
+      .map([](std::vector<DataEnumerationEntry2> entries) {
+      return CreateObservable<std::shared_ptr<std::string>>([entries = MakeSharedCopy(std::move(entries))](rxcpp::subscriber<std::shared_ptr<std::string>> subscriber) {
+        // Create initial response object
+        auto response = std::make_shared<DataEnumerationResponse2>();
+        // (Lambda that) sends the current response object to the subscriber and assigns a new, empty (followup) response object to the "response" variable
+        auto sendResponse = [subscriber, &response]() {
+          auto serialized = std::make_shared<std::string>(Serialization::ToString(*response));
+          if (serialized->size() >= messaging::MaxSizeOfMessage) {
+            throw std::runtime_error("Enumeration response too large to send out");
+          }
+          subscriber.on_next(serialized);
+          response = std::make_shared<DataEnumerationResponse2>();
+        };
+
+        for (auto& entry : *entries) {
+          response->entries.push_back(std::move(entry));
+
+          // Prevent individual DataEnumerationResponse2 messages from becoming too large
+          if (response->entries.size() >= EnumerationResponseMaxEntries) {
+            response->hasMore = true;
+            sendResponse();
+          }
+        }
 
-    for (size_t i = 0; i < request.ids.size(); i++) {
-      // TODO execute decryption in WorkerPool
-      auto sfid = server->decryptId(request.ids[i]);
-      auto sfentry = server->fileStore_->lookup(EntryName::Parse(sfid.path), sfid.time);
-      if (sfentry == nullptr) {
-        throw Error("openExistingDataEntry failed");
-      }
-      const auto& sfcontent = sfentry->content();
-      if (sfcontent == nullptr) {
-        throw Error("Cannot read data of a deleted entry");
-      }
-      assert(sfcontent->payload() != nullptr);
-
-      // Parse entry name into properties
-      LocalPseudonym pseud = sfentry->getName().pseudonym();
-      std::string column = sfentry->getName().column();
-
-      DataEnumerationEntry2 entry;
-      entry.metadata = server->compileMetadata(column, *sfentry);
-      // TODO execute rerandomization in WorkerPool
-      entry.polymorphicKey = server->getEgCache().rerandomize(sfcontent->getPolymorphicKey());
-      entry.fileSize = sfcontent->payload()->size();
-      entry.id = request.ids[i];
-      entry.index = static_cast<uint32_t>(i);
-      entry.columnIndex = indices.getColumnIndex(column);
-      entry.pseudonymIndex = indices.getPseudonymIndex(pseud);
-      response->entries.push_back(std::move(entry));
-
-      // Prevent individual DataEnumerationResponse2 messages from becoming too large
-      if (response->entries.size() >= EnumerationResponseMaxEntries) {
-        response->hasMore = true;
+        // Always send a final response with hasMore_ = false. If zero entries were requested, this will be the only response we send.
         sendResponse();
-      }
-    }
-
-    // Always send a final response with hasMore_ = false. If zero entries were requested, this will be the only response we send.
-    sendResponse();
-    subscriber.on_completed();
-  }));
+        subscriber.on_completed();
+      });
+    });
+  });
 }
 
 messaging::MessageBatches
@@ -529,38 +624,23 @@ StorageFacility::handleDataReadRequest2(std::shared_ptr<SignedDataReadRequest2>
 
   auto rootCAs = this->getRootCAs();
   auto certified = signedRequest->open(*rootCAs);
-  const auto& request = certified.message;
   auto userGroup = certified.signatory.organizationalUnit();
 
-  auto ticket = request.ticket.open(
+  auto ticket = MakeSharedCopy(certified.message.ticket.open(
     *rootCAs,
     userGroup,
     "read"
-  );
+  ));
+  auto pseudonyms = this->getTicketPseudonyms(certified.message.ticket, *ticket);
 
-  // Create look-up-tables for columns and pseudonyms from ticket
-  TicketIndices indices(ticket, pseudonymKey_);
-  std::vector<std::shared_ptr<FileStore::Entry>> entries;
-  entries.resize(request.ids.size());
-
-  // open files
-  for (size_t i = 0; i < request.ids.size(); i++) {
-    // TODO execute decryption in WorkerPool
-    auto sfid = decryptId(request.ids[i]);
-    auto entry = fileStore_->lookup(EntryName::Parse(sfid.path), sfid.time);
-    if (entry == nullptr) {
-      throw Error("openExistingDataEntry failed");
-    }
-    if (entry->isTombstone()) {
-      throw Error("Cannot read data of a deleted entry");
-    }
-
-    entries[i] = entry;
+  return pseudonyms.flat_map([server = SharedFrom(*this), request = MakeSharedCopy(std::move(certified.message)), ticket, time](std::shared_ptr<const TicketPseudonyms> pseudonyms) {
+    return server->readData(*request, *ticket, std::move(pseudonyms), time);
+  });
+}
 
-    // Check permission
-    indices.verifyColumnAccess(entry->getName().column());
-    indices.verifyPseudonymAccess(entry->getName().pseudonym());
-  }
+messaging::MessageBatches StorageFacility::readData(const DataReadRequest2& request, const Ticket2& ticket, std::shared_ptr<const TicketPseudonyms> pseudonyms, std::chrono::steady_clock::time_point time) {
+  // Create look-up-tables for columns and pseudonyms from ticket
+  auto indices = std::make_shared<TicketIndices>(ticket, std::move(pseudonyms));
 
   class StreamContext : public std::enable_shared_from_this<StreamContext>, public SharedConstructor<StreamContext> {
     friend class SharedConstructor<StreamContext>;
@@ -653,13 +733,31 @@ StorageFacility::handleDataReadRequest2(std::shared_ptr<SignedDataReadRequest2>
     }
   };
 
-  auto ctx = StreamContext::Create(std::move(entries), metrics_, time);
+  // open files
+  return this->lookupEncryptedIds(request.ids,
+    [indices](const EntryName& name) {
+      // Check permission before we (possibly) load the entry
+      indices->verifyColumnAccess(name.column());
+      indices->verifyPseudonymAccess(name.pseudonym());
+    })
+    .flat_map([metrics = metrics_, time](std::shared_ptr<std::vector<std::shared_ptr<FileStore::Entry>>> entries) {
+      for (const auto& entry : *entries) {
+        if (entry == nullptr) {
+          throw Error("openExistingDataEntry failed");
+        }
+        if (entry->isTombstone()) {
+          throw Error("Cannot read data of a deleted entry");
+        }
+      }
 
-  return CreateObservable<messaging::MessageSequence>(
-    [ctx](rxcpp::subscriber<messaging::MessageSequence> subscriber) {
-      ctx->emitTo(subscriber);
-    }
-  );
+      auto ctx = StreamContext::Create(std::move(*entries), metrics, time);
+
+      return CreateObservable<messaging::MessageSequence>(
+        [ctx](rxcpp::subscriber<messaging::MessageSequence> subscriber) {
+          ctx->emitTo(subscriber);
+        }
+      );
+    });
 }
 
 template <typename TRequest>
@@ -732,13 +830,15 @@ messaging::MessageBatches StorageFacility::handleDataAlterationRequest(
 
     auto server = SharedFrom(*this);
     auto hasher = std::make_shared<XxHasher>(0ULL);
+    // Up to parallelisationWidth_ pages are put at the same time, as long as they fit in the window
+    auto window = PagePutWindow::Create(maxPendingPageBytes_);
 
     return CreateObservable<messaging::MessageSequence>(
-      [ctx, server, request, tail, hasher, this, getResponse](
+      [ctx, server, request, tail, hasher, window, this, getResponse](
         rxcpp::subscriber<messaging::MessageSequence>
         subscriber) {
         tail.map(
-          [server, subscriber, ctx, request]
+          [server, subscriber, ctx, request, window]
           (std::shared_ptr<std::string> rawPage) // incoming page
           -> rxcpp::observable<std::string> {// md5 of page
             MessageMagic magic{};
@@ -768,7 +868,8 @@ messaging::MessageBatches StorageFacility::handleDataAlterationRequest(
             if (fs > 100000000) {
               throw Error("Incoming page is too large");
             }
-            return sfentry->appendPage(rawPage, fs, page.pageNumber).tap(
+            // Note that appendPage must be invoked here (and not deferred by the window), since it registers pages in order
+            return window->put(rawPage->size(), sfentry->appendPage(rawPage, fs, page.pageNumber)).tap(
               [server, rawPage](const std::string& md5hash) {
                 server->metrics_->dataStoredBytes.Increment(static_cast<double>(rawPage->size()));
               });
@@ -808,16 +909,22 @@ messaging::MessageBatches StorageFacility::handleDataAlterationRequest(
 
               server->updateFileStoreMetrics();
 
-              if (!ctx->errors.empty()) {
-                auto description = boost::algorithm::join(ctx->errors, "; ");
-                subscriber.on_error(std::make_exception_ptr(Error(description)));
-                // TODO: don't invoke on_next and on_completed anymore
-              }
-
-              subscriber.on_next(rxcpp::observable<>::from(
-                MakeSharedCopy(getResponse(time, ctx->ids, hasher->digest()))));
-              server->metrics_->dataStoreRequestDuration.Observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - ctx->startTime).count()); // in seconds
-              subscriber.on_completed();
+              // Only respond when the committed entries have been stored durably
+              server->fileStore_->whenDurable(server->workerPool_).subscribe(
+                [](FakeVoid) { /* ignore */ },
+                [subscriber](std::exception_ptr error) { subscriber.on_error(error); },
+                [server, subscriber, ctx, hasher, getResponse, time]() {
+                  if (!ctx->errors.empty()) {
+                    auto description = boost::algorithm::join(ctx->errors, "; ");
+                    subscriber.on_error(std::make_exception_ptr(Error(description)));
+                    // TODO: don't invoke on_next and on_completed anymore
+                  }
+
+                  subscriber.on_next(rxcpp::observable<>::from(
+                    MakeSharedCopy(getResponse(time, ctx->ids, hasher->digest()))));
+                  server->metrics_->dataStoreRequestDuration.Observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - ctx->startTime).count()); // in seconds
+                  subscriber.on_completed();
+                });
             });
       });
 }
@@ -922,7 +1029,10 @@ StorageFacility::handleMetadataStoreRequest2(std::shared_ptr<SignedMetadataUpdat
     response.ids.push_back(id);
   }
 
-  return rxcpp::observable<>::just(rxcpp::observable<>::just(MakeSharedCopy(Serialization::ToString(response))).as_dynamic());
+  // Only respond when the committed entries have been stored durably
+  return fileStore_->whenDurable(workerPool_).map([response = MakeSharedCopy(Serialization::ToString(response))](FakeVoid) {
+    return rxcpp::observable<>::just(response).as_dynamic();
+  });
 }
 
 messaging::MessageBatches
@@ -955,6 +1065,41 @@ StorageFacility::handleDataDeleteRequest2(std::shared_ptr<SignedDataDeleteReques
   return this->handleDataAlterationRequest<DataDeleteRequest2>(signedRequest, tail, true, getEntryContent, getResponse);
 }
 
+rxcpp::observable<std::shared_ptr<const TicketPseudonyms>> StorageFacility::getTicketPseudonyms(const SignedTicket2& signedTicket, const Ticket2& ticket) {
+  auto key = signedTicket.signatureDigest();
+  if (auto cached = ticketPseudonymCache_->lookup(key)) {
+    metrics_->ticketPseudonymCacheHits.Increment();
+    return rxcpp::observable<>::just(std::move(cached)).as_dynamic();
+  }
+  metrics_->ticketPseudonymCacheMisses.Increment();
+
+  std::vector<EncryptedLocalPseudonym> encrypted;
+  encrypted.reserve(ticket.accessSubjects.size());
+  for (const auto& subject : ticket.accessSubjects) {
+    encrypted.push_back(subject.storageFacility);
+  }
+  return workerPool_->batched_map<TicketPseudonymDecryptionBatchSize>(std::move(encrypted),
+    ObserveOnAsio(*getIoContext()),
+    [pseudonymKey = pseudonymKey_](const EncryptedLocalPseudonym& localPseudonym) {
+      return localPseudonym.decrypt(pseudonymKey);
+    },
+    [](std::span<LocalPseudonym> localPseudonyms) {
+      // Pack on the worker, so that TicketPseudonyms can cheaply hash them
+      std::vector<const CurvePoint*> points;
+      points.reserve(localPseudonyms.size());
+      for (const auto& localPseudonym : localPseudonyms)
+        points.push_back(&localPseudonym.getValidCurvePoint());
+      CurvePoint::PackBatch(points);
+    })
+    .map([server = SharedFrom(*this), key](std::vector<LocalPseudonym> localPseudonyms) {
+      auto result = std::make_shared<const TicketPseudonyms>(std::move(localPseudonyms));
+      server->ticketPseudonymCache_->insert(key, result);
+      server->metrics_->ticketPseudonymCachePseudonyms.Set(static_cast<double>(server->ticketPseudonymCache_->pseudonyms()));
+      return result;
+    })
+    .as_dynamic();
+}
+
 std::vector<std::optional<LocalPseudonym>> StorageFacility::decryptLocalPseudonyms(const std::vector<LocalPseudonyms>& source, std::vector<uint32_t> const *indices) const {
   std::vector<bool> includePseudonym(source.size(), indices == nullptr); // Include all pseudonyms (initialize elements to "true") if no indices have been specified
 
@@ -990,13 +1135,19 @@ StorageFacility::handleDataHistoryRequest2(std::shared_ptr<SignedDataHistoryRequ
   auto start_time = std::chrono::steady_clock::now();
   const auto& rootCAs = this->getRootCAs();
   auto certified = signedRequest->open(*rootCAs);
-  const auto& request = certified.message;
 
   auto accessGroup = certified.signatory.organizationalUnit();
   UserGroup::EnsureAccess({UserGroup::DataAdministrator, UserGroup::Watchdog}, accessGroup);
 
-  auto ticket = request.ticket.open(*rootCAs, accessGroup, "read-meta");
+  auto ticket = MakeSharedCopy(certified.message.ticket.open(*rootCAs, accessGroup, "read-meta"));
+  auto pseudonyms = this->getTicketPseudonyms(certified.message.ticket, *ticket);
+
+  return pseudonyms.map([server = SharedFrom(*this), request = MakeSharedCopy(std::move(certified.message)), ticket, start_time](std::shared_ptr<const TicketPseudonyms> pseudonyms) {
+    return server->retrieveHistory(*request, *ticket, *pseudonyms, start_time);
+  });
+}
 
+messaging::MessageSequence StorageFacility::retrieveHistory(const DataHistoryRequest2& request, const Ticket2& ticket, const TicketPseudonyms& pseudonyms, std::chrono::steady_clock::time_point start_time) {
   DataHistoryResponse2 response;
 
   // Look-up table to check whether to include column
@@ -1019,7 +1170,7 @@ StorageFacility::handleDataHistoryRequest2(std::shared_ptr<SignedDataHistoryRequ
     columnIndex[ticket.columns[i]] = i;
   }
   // Decrypt pseudonyms.
-  auto localPseudonyms = this->decryptLocalPseudonyms(ticket.accessSubjects, request.pseudonyms.has_value() ? &request.pseudonyms->indices : nullptr);
+  auto localPseudonyms = SelectLocalPseudonyms(pseudonyms, request.pseudonyms.has_value() ? &request.pseudonyms->indices : nullptr);
 
   std::vector<uint64_t> ids; // used to lookup id from responseEntry index_
   auto participants = fileStore_->participants();
@@ -1060,8 +1211,7 @@ StorageFacility::handleDataHistoryRequest2(std::shared_ptr<SignedDataHistoryRequ
 
   metrics_->dataHistoryRequestDuration.Observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count()); // in seconds
 
-  return rxcpp::observable<>::just(
-    rxcpp::observable<>::just(MakeSharedCopy(Serialization::ToString(response))).as_dynamic());
+  return rxcpp::observable<>::just(MakeSharedCopy(Serialization::ToString(response))).as_dynamic();
 }
 
 messaging::MessageBatches StorageFacility::handleDataSizeRequest(std::shared_ptr<SignedDataSizeRequest> signedRequest) {
@@ -1129,6 +1279,28 @@ SFId StorageFacility::decryptId(std::string_view encId) {
   return Serialization::FromString<EncryptedSFId>(encId, false).decrypt(encIdKey_);
 }
 
+rxcpp::observable<std::shared_ptr<std::vector<std::shared_ptr<FileStore::Entry>>>> StorageFacility::lookupEncryptedIds(std::vector<std::string> encIds, const std::function<void(const EntryName&)>& verifyAccess) {
+  // Decrypt on the WorkerPool, since requests may contain (many) thousands of IDs
+  return workerPool_->batched_map<SFIdDecryptionBatchSize>(std::move(encIds),
+    ObserveOnAsio(*getIoContext()),
+    [server = SharedFrom(*this)](const std::string& encId) {
+      return server->decryptId(encId);
+    })
+    .flat_map([server = SharedFrom(*this), verifyAccess](std::vector<SFId> sfids) {
+      std::vector<FileStore::EntryKey> keys;
+      keys.reserve(sfids.size());
+      for (auto& sfid : sfids) {
+        auto name = EntryName::Parse(sfid.path);
+        if (verifyAccess) {
+          verifyAccess(name);
+        }
+        keys.push_back({ .name = std::move(name), .validAt = sfid.time });
+      }
+      return server->fileStore_->lookupAsync(std::move(keys), server->workerPool_);
+    })
+    .map([](std::vector<std::shared_ptr<FileStore::Entry>> entries) { return MakeSharedCopy(std::move(entries)); }); // Ensure flat_map gets a cheaply copyable parameter value. See #1019
+}
+
 Metadata StorageFacility::compileMetadata(
   std::string column,
   const FileStore::Entry& entry) {
@@ -1161,10 +1333,7 @@ void StorageFacility::statsTimer(const boost::system::error_code& e) {
   if (e == boost::asio::error::operation_aborted) {
     return;
   }
-  auto metaDirs = std::filesystem::directory_iterator(fileStore_->metaDir());
-  auto metaDirsCount = std::distance(metaDirs, std::filesystem::directory_iterator());
-
-  metrics_->entriesInMetaDir.Set(static_cast<double>(metaDirsCount));
+  metrics_->entriesInMetaDir.Set(static_cast<double>(fileStore_->participantCount()));
 
   timer_.expires_after(60s);
   timer_.async_wait(boost::bind(&pep::StorageFacility::statsTimer, this, boost::asio::placeholders::error));
@@ -1174,14 +1343,22 @@ StorageFacility::StorageFacility(std::shared_ptr<pep::StorageFacility::Parameter
   : SigningServer(parameters),
   pseudonymKey_(parameters->getPseudonymKey()), encIdKey_(parameters->getEncIdKey()),
   workerPool_(WorkerPool::getShared()),
+  ticketPseudonymCache_(std::make_shared<TicketPseudonymCache>(parameters->getTicketPseudonymCacheSize())),
   fileStore_(FileStore::Create(
     parameters->getStoragePath().string(),
     *parameters->getPageStoreConfig(),
     parameters->getIoContext(),
-    registry_)),
+    registry_,
+    parameters->getMetadataStorage(),
+    parameters->getHistoricalEntryCacheSize(),
+    // Content addresses are keyed with a key derived from the EncIdKey, which (like the addresses) must never change
+    parameters->getContentAddressedPages()
+      ? std::make_optional(Hmac<Sha256>(parameters->getEncIdKey(), "content addressed pages"))
+      : std::nullopt)),
   metrics_(std::make_shared<Metrics>(registry_)),
   timer_(*parameters->getIoContext()),
   parallelisationWidth_(parameters->getParallelisationWidth()),
+  maxPendingPageBytes_(parameters->getMaxPendingPageBytes()),
   dataSizeResolution_(parameters->getDataSizeResolution()) {
   RegisterRequestHandlers(*this,
                           &StorageFacility::handleMetadataReadRequest2,
@@ -1194,6 +1371,9 @@ StorageFacility::StorageFacility(std::shared_ptr<pep::StorageFacility::Parameter
                           &StorageFacility::handleDataSizeRequest,
                           &StorageFacility::handlePagePathRequest);
 
+  if (parameters->getCompactMetadata()) {
+    fileStore_->compact();
+  }
   this->updateFileStoreMetrics();
   statsTimer({});
 }
@@ -1222,6 +1402,11 @@ void StorageFacility::updateFileStoreMetrics() {
   metrics_->entriesIncludingHistory.Set(static_cast<double>(entryCount));
   metrics_->totalPayloadBytes.Set(static_cast<double>(totalPayloadBytes));
   metrics_->rollingPayloadBytes.Set(static_cast<double>(rollingPayloadBytes));
+
+  if (const auto* deduplicator = fileStore_->pageDeduplicator()) {
+    metrics_->pageDedupeRatio.Set(deduplicator->ratio());
+    metrics_->deduplicatedPageUploads.Set(static_cast<double>(deduplicator->deduplicatedUploads()));
+  }
 }
 
 }
@@ -6,9 +6,11 @@
 #include <pep/storagefacility/FileStore.hpp>
 #include <pep/storagefacility/StorageFacilityMessages.hpp>
 #include <pep/storagefacility/SFId.hpp>
+#include <pep/storagefacility/TicketPseudonymCache.hpp>
 
 #include <boost/asio/steady_timer.hpp>
 #include <filesystem>
+#include <functional>
 #include <optional>
 
 namespace pep {
@@ -31,6 +33,13 @@ private:
 
     prometheus::Gauge& totalPayloadBytes; // including history
     prometheus::Gauge& rollingPayloadBytes; // "latest" snapshot
+
+    prometheus::Counter& ticketPseudonymCacheHits;
+    prometheus::Counter& ticketPseudonymCacheMisses;
+    prometheus::Gauge& ticketPseudonymCachePseudonyms;
+
+    prometheus::Gauge& pageDedupeRatio;
+    prometheus::Gauge& deduplicatedPageUploads;
   };
 
   void getFileStoreMetrics(size_t& entryCount, uint64_t& roundedTotalBytes, uint64_t& roundedRollingBytes, const std::set<std::string>& columns = {});
@@ -57,14 +66,22 @@ public:
     uint8_t getParallelisationWidth() const {
       return parallelisationWidth_;
     }
+    uint64_t getMaxPendingPageBytes() const {
+      return maxPendingPageBytes_;
+    }
     std::filesystem::path getStoragePath() const {
       return storagePath_;
     }
     std::shared_ptr<Configuration> getPageStoreConfig() const {
       return pageStoreConfig_;
     }
+    EntryStorage::Type getMetadataStorage() const { return metadataStorage_; }
+    bool getCompactMetadata() const { return compactMetadata_; }
+    uint64_t getHistoricalEntryCacheSize() const { return historicalEntryCacheSize_; }
+    bool getContentAddressedPages() const { return contentAddressedPages_; }
 
     uint64_t getDataSizeResolution() const { return dataSizeResolution_; }
+    size_t getTicketPseudonymCacheSize() const { return ticketPseudonymCacheSize_; }
 
   protected:
     void check() const override;
@@ -73,11 +90,17 @@ public:
     std::optional<ElgamalPrivateKey> pseudonymKey_;
     std::optional<std::string> encIdKey_;
     uint8_t parallelisationWidth_ = 10; // passed to RxParalellConcat
+    uint64_t maxPendingPageBytes_ = 128U * 1024U * 1024U; // passed to PagePutWindow
     uint64_t dataSizeResolution_ = 1024U * 1024U;
+    size_t ticketPseudonymCacheSize_ = TicketPseudonymCache::DefaultMaxPseudonyms; // in local pseudonyms
 
     // passed to FileStore::Create
     std::filesystem::path storagePath_;
     std::shared_ptr<Configuration> pageStoreConfig_;
+    EntryStorage::Type metadataStorage_ = EntryStorage::Type::Directory;
+    bool compactMetadata_ = false;
+    uint64_t historicalEntryCacheSize_ = FileStore::DefaultHistoricalEntryCacheSize; // in (serialized) bytes
+    bool contentAddressedPages_ = false;
   };
 
 public:
@@ -103,9 +126,18 @@ private:
   messaging::MessageBatches handleDataSizeRequest(std::shared_ptr<SignedDataSizeRequest> signedRequest);
   messaging::MessageBatches handlePagePathRequest(std::shared_ptr<SignedPagePathRequest> signedRequest);
 
+  messaging::MessageBatches enumerateData(const DataEnumerationRequest2& request, const Ticket2& ticket, const TicketPseudonyms& pseudonyms, std::chrono::steady_clock::time_point time);
+  messaging::MessageBatches readData(const DataReadRequest2& request, const Ticket2& ticket, std::shared_ptr<const TicketPseudonyms> pseudonyms, std::chrono::steady_clock::time_point time);
+  messaging::MessageSequence retrieveHistory(const DataHistoryRequest2& request, const Ticket2& ticket, const TicketPseudonyms& pseudonyms, std::chrono::steady_clock::time_point time);
+
   std::string encryptId(std::string path, Timestamp time);
   SFId decryptId(std::string_view encId);
+  /// \brief Decrypts SF IDs (on the WorkerPool) and looks up the corresponding entries, in the same order as the IDs.
+  /// \param verifyAccess If specified, is invoked (and may raise an exception) for every entry name before any entries are looked up.
+  rxcpp::observable<std::shared_ptr<std::vector<std::shared_ptr<FileStore::Entry>>>> lookupEncryptedIds(std::vector<std::string> encIds, const std::function<void(const EntryName&)>& verifyAccess = {});
   std::vector<std::optional<LocalPseudonym>> decryptLocalPseudonyms(const std::vector<LocalPseudonyms>& source, std::vector<uint32_t> const *indices) const;
+  /// \brief Produces the (decrypted) local pseudonyms of a ticket whose signatures have been validated, from cache if possible.
+  rxcpp::observable<std::shared_ptr<const TicketPseudonyms>> getTicketPseudonyms(const SignedTicket2& signedTicket, const Ticket2& ticket);
 
   Metadata compileMetadata(std::string column, const FileStore::Entry& entry);
 
@@ -125,10 +157,12 @@ private:
   ElgamalPrivateKey pseudonymKey_;
   std::string encIdKey_;
   std::shared_ptr<WorkerPool> workerPool_;
+  std::shared_ptr<TicketPseudonymCache> ticketPseudonymCache_;
   std::shared_ptr<FileStore> fileStore_;
   std::shared_ptr<Metrics> metrics_;
   boost::asio::steady_timer timer_;
   const uint8_t parallelisationWidth_ = 0; // passed to RxParallelConcat
+  const uint64_t maxPendingPageBytes_; // passed to PagePutWindow
   const uint64_t dataSizeResolution_;
 };
 
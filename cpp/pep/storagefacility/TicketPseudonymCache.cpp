@@ -0,0 +1,75 @@
+#include <pep/storagefacility/TicketPseudonymCache.hpp>
+
+#include <limits>
+#include <stdexcept>
+
+namespace pep {
+
+TicketPseudonyms::TicketPseudonyms(std::vector<LocalPseudonym> localPseudonyms)
+  : localPseudonyms_(std::move(localPseudonyms)) {
+  if (localPseudonyms_.size() > std::numeric_limits<Index>::max()) {
+    throw std::runtime_error("Ticket contains too many subjects to map into an IndexList");
+  }
+  indices_.reserve(localPseudonyms_.size());
+  for (size_t i = 0U; i < localPseudonyms_.size(); ++i) {
+    indices_[localPseudonyms_[i]] = static_cast<Index>(i);
+  }
+}
+
+std::optional<TicketPseudonyms::Index> TicketPseudonyms::find(const LocalPseudonym& localPseudonym) const {
+  auto position = indices_.find(localPseudonym);
+  if (position == indices_.cend()) {
+    return std::nullopt;
+  }
+  return position->second;
+}
+
+TicketPseudonymCache::TicketPseudonymCache(size_t maxPseudonyms)
+  : maxPseudonyms_(maxPseudonyms) {
+}
+
+std::shared_ptr<const TicketPseudonyms> TicketPseudonymCache::lookup(const std::string& key) {
+  std::lock_guard lock(mux_);
+  auto position = index_.find(key);
+  if (position == index_.end()) {
+    return nullptr;
+  }
+  entries_.splice(entries_.begin(), entries_, position->second);
+  return position->second->second;
+}
+
+void TicketPseudonymCache::insert(const std::string& key, std::shared_ptr<const TicketPseudonyms> pseudonyms) {
+  std::lock_guard lock(mux_);
+  if (pseudonyms->size() > maxPseudonyms_) {
+    return; // Would evict everything else and then itself
+  }
+
+  auto position = index_.find(key);
+  if (position != index_.end()) { // Concurrent requests for the same ticket: keep the existing entry
+    entries_.splice(entries_.begin(), entries_, position->second);
+    return;
+  }
+
+  pseudonyms_ += pseudonyms->size();
+  entries_.emplace_front(key, std::move(pseudonyms));
+  index_.emplace(key, entries_.begin());
+
+  while (pseudonyms_ > maxPseudonyms_) {
+    auto& evicted = entries_.back();
+    pseudonyms_ -= evicted.second->size();
+    index_.erase(evicted.first);
+    entries_.pop_back();
+  }
+}
+
+size_t TicketPseudonymCache::tickets() const {
+  std::lock_guard lock(mux_);
+  return entries_.size();
+}
+
+size_t TicketPseudonymCache::pseudonyms() const {
+  std::lock_guard lock(mux_);
+  return pseudonyms_;
+}
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <pep/rsk-pep/Pseudonyms.hpp>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pep {
+
+// The (decrypted) storage facility local pseudonyms of a ticket's access subjects,
+// plus a look-up table mapping them back to their index in the ticket.
+class TicketPseudonyms {
+public:
+  using Index = uint32_t;
+
+  explicit TicketPseudonyms(std::vector<LocalPseudonym> localPseudonyms);
+
+  const std::vector<LocalPseudonym>& localPseudonyms() const noexcept { return localPseudonyms_; }
+  size_t size() const noexcept { return localPseudonyms_.size(); }
+
+  /// \return The index of the local pseudonym in the ticket, or std::nullopt if the ticket doesn't contain it
+  std::optional<Index> find(const LocalPseudonym& localPseudonym) const;
+
+private:
+  std::vector<LocalPseudonym> localPseudonyms_;
+  std::unordered_map<LocalPseudonym, Index> indices_;
+};
+
+// Keeps the TicketPseudonyms of recently used tickets. Clients tend to reuse a
+// ticket for many requests, so this saves the storage facility from decrypting
+// the ticket's access subjects over and over again (see issue #592).
+//
+// Entries are keyed by a digest of the ticket's signatures. Only use the cache
+// for tickets whose signatures have been validated: that binds the digest to
+// the ticket's contents. Once the cached tickets hold more than maxPseudonyms
+// local pseudonyms in total, the least recently used tickets are evicted.
+class TicketPseudonymCache {
+public:
+  static constexpr size_t DefaultMaxPseudonyms = 250'000;
+
+  explicit TicketPseudonymCache(size_t maxPseudonyms = DefaultMaxPseudonyms);
+
+  /// \return The cached pseudonyms for the ticket with the given key, or nullptr if they're not cached
+  std::shared_ptr<const TicketPseudonyms> lookup(const std::string& key);
+  void insert(const std::string& key, std::shared_ptr<const TicketPseudonyms> pseudonyms);
+
+  size_t tickets() const;
+  size_t pseudonyms() const;
+
+private:
+  using Entry = std::pair<std::string, std::shared_ptr<const TicketPseudonyms>>;
+
+  const size_t maxPseudonyms_;
+
+  mutable std::mutex mux_;
+  std::list<Entry> entries_; // Most recently used first
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+  size_t pseudonyms_ = 0;
+};
+
+}
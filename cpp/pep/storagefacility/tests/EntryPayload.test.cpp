@@ -144,3 +144,33 @@ TEST(EntryPayload, payloads_report_correct_number_of_page_paths) {
   const auto nonempty = MakeEntryPayload<PagedEntryPayload>(props, pageIds);
   EXPECT_EQ(nonempty->getPagePaths(entryName).size(), pageIds.size()) << "Non-empty paged payload should report all its page paths";
 }
+
+TEST(EntryPayload, content_addressed_payloads_report_shared_page_paths) {
+  const std::string address(PageDeduplicator::AddressLength, 'a');
+  const std::vector<PageId> pageIds{ 12, 13 };
+
+  auto makePayload = [&address, &pageIds]() {
+    auto props = AsPersistentEntryProperties({ .filesize = 11, .pagesize = 11 });
+    SetPersistedEntryProperty(props, "page-addresses", address + address);
+    auto result = std::make_shared<PagedEntryPayload>(props, pageIds);
+    EXPECT_TRUE(props.empty()) << "Constructor should consume all properties";
+    return result;
+  };
+
+  const auto first = makePayload(), second = makePayload();
+  const EntryName firstName(pep::LocalPseudonym::Random().text(), "SomeColumn");
+  const EntryName secondName(pep::LocalPseudonym::Random().text(), "SomeColumn");
+  EXPECT_EQ(1, first->getPagePaths(firstName).size()) << "Pages with the same content address should share a path";
+  EXPECT_EQ(first->getPagePaths(firstName), second->getPagePaths(secondName)) << "Content addressed page paths should not depend on the entry";
+  EXPECT_EQ(first->contentAddresses(), std::vector<std::string>(pageIds.size(), address));
+
+  // Saving and loading preserves the content addresses
+  PersistedEntryProperties saved;
+  std::vector<PageId> savedPages;
+  EntryPayload::Save(first, saved, savedPages);
+  EXPECT_TRUE(EntryPayload::Load(saved, savedPages)->isStrictlyEqualTo(*first));
+
+  auto mismatched = AsPersistentEntryProperties({ .filesize = 11, .pagesize = 11 });
+  SetPersistedEntryProperty(mismatched, "page-addresses", address);
+  EXPECT_ANY_THROW(std::make_shared<PagedEntryPayload>(mismatched, pageIds)) << "Number of content addresses should match number of pages";
+}
@@ -1,12 +1,15 @@
 #include <pep/storagefacility/FileStore.hpp>
 
 #include <pep/storagefacility/Constants.hpp>
+#include <pep/async/WorkerPool.hpp>
 #include <pep/utils/Configuration.hpp>
 #include <pep/utils/Defer.hpp>
+#include <pep/utils/Raw.hpp>
 #include <pep/async/tests/RxTestUtils.hpp>
 
 #include <gtest/gtest.h>
 #include <filesystem>
+#include <fstream>
 
 using pep::EntryContent;
 using pep::FileStore;
@@ -23,6 +26,9 @@ struct Context {
 
   std::filesystem::path path = std::filesystem::temp_directory_path() / "pep-sf-tests";
   std::string bucket = "myBucket";
+  pep::EntryStorage::Type storageType;
+  uint64_t historicalEntryCacheSize = FileStore::DefaultHistoricalEntryCacheSize;
+  std::optional<std::string> pageAddressKey;
   std::shared_ptr<FileStore> store;
 
   std::filesystem::path metapath() { return this->path / "meta"; }
@@ -32,12 +38,20 @@ struct Context {
   }
 
   ~Context() {
+    this->store.reset(); // Let it write its files before we remove them
     std::filesystem::remove_all(this->path);
   }
 
-  Context() {
+  explicit Context(pep::EntryStorage::Type storageType = pep::EntryStorage::Type::Directory)
+    : storageType(storageType) {
     std::filesystem::create_directories(this->bucketpath());
     std::filesystem::create_directories(this->metapath());
+    this->reopen();
+  }
+
+  // Discards the FileStore (if any) and creates a new one, loading the entries from disk
+  void reopen() {
+    this->store.reset();
 
     boost::property_tree::ptree localConf;
     localConf.put("DataDir", this->datapath().string());
@@ -48,10 +62,35 @@ struct Context {
 
     this->store = FileStore::Create(
         this->metapath().string(), pep::Configuration::FromPtree(pageStoreConf), this->io_context,
-        std::shared_ptr<prometheus::Registry>() // intentionally null
+        std::shared_ptr<prometheus::Registry>(), // intentionally null
+        this->storageType,
+        this->historicalEntryCacheSize,
+        this->pageAddressKey
     );
   }
 
+  void commitInlinePage(const pep::EntryName& name, pep::Timestamp validFrom, const std::string& page) {
+    auto change = this->store->modifyEntry(name, true);
+    ASSERT_TRUE(change != nullptr);
+    change->setContent(std::make_unique<EntryContent>(
+      EntryContent::Metadata(),
+      EntryContent::PayloadData(
+        {.polymorphicKey = pep::EncryptedKey(pep::CurvePoint::Random(), pep::CurvePoint::Random(), pep::CurvePoint::Random()), .blindingTimestamp = validFrom, .scheme = pep::EncryptionScheme::V3},
+        nullptr)));
+    this->exhaust<std::string>(change->appendPage(std::make_shared<std::string>(page), page.size(), 0));
+    std::move(*change).commit(validFrom);
+  }
+
+  std::string readInlinePage(const pep::EntryName& name, pep::Timestamp validAt) {
+    auto entry = this->store->lookup(name, validAt);
+    if (entry == nullptr) {
+      return {};
+    }
+    auto pages = this->exhaust<std::shared_ptr<std::string>>(entry->readPage(0));
+    EXPECT_EQ(1U, pages->size());
+    return *pages->front();
+  }
+
   template <typename T>
   std::shared_ptr<std::vector<T>> exhaust(rxcpp::observable<T> obs) {
     return pep::testutils::exhaust<T>(*(this->io_context), obs);
@@ -143,4 +182,234 @@ TEST(FileStore, PathTraversal) {
     std::runtime_error);
 }
 
+TEST(FileStore, LogStorageReloads) {
+  Context context(pep::EntryStorage::Type::Log);
+  auto first = pep::EntryName(pep::LocalPseudonym::Random(), "first");
+  auto second = pep::EntryName(pep::LocalPseudonym::Random(), "second");
+  context.commitInlinePage(first, 1_unixMs, "one");
+  context.commitInlinePage(first, 3_unixMs, "three");
+  context.commitInlinePage(second, 2_unixMs, "two");
+
+  auto verify = [&context, &first, &second]() {
+    EXPECT_EQ(2U, context.store->participantCount());
+    EXPECT_EQ("", context.readInlinePage(first, 0_unixMs));
+    EXPECT_EQ("one", context.readInlinePage(first, 2_unixMs));
+    EXPECT_EQ("three", context.readInlinePage(first, 4_unixMs));
+    EXPECT_EQ("two", context.readInlinePage(second, 2_unixMs));
+  };
+  verify();
+
+  // Load from the index that the previous FileStore wrote when it was discarded
+  context.reopen();
+  verify();
+  EXPECT_TRUE(std::filesystem::exists(context.metapath() / "entries.log.index"));
+
+  // Load by replaying the log, ignoring an incomplete record at its end (as if we crashed halfway through an append)
+  context.store.reset();
+  std::filesystem::remove(context.metapath() / "entries.log.index");
+  std::ofstream(context.metapath() / "entries.log", std::ios::binary | std::ios::app) << "incomplete";
+  context.reopen();
+  verify();
+
+  // Entries appended after the incomplete record was discarded are retained
+  context.commitInlinePage(second, 5_unixMs, "five");
+  context.reopen();
+  EXPECT_EQ("two", context.readInlinePage(second, 4_unixMs));
+  EXPECT_EQ("five", context.readInlinePage(second, 5_unixMs));
+}
+
+TEST(FileStore, LogStorageRefusesDamagedRecord) {
+  Context context(pep::EntryStorage::Type::Log);
+  auto name = pep::EntryName(pep::LocalPseudonym::Random(), "test");
+  context.commitInlinePage(name, 1_unixMs, "one");
+  context.commitInlinePage(name, 2_unixMs, "two");
+  context.commitInlinePage(name, 3_unixMs, "three");
+  context.store.reset();
+  std::filesystem::remove(context.metapath() / "entries.log.index");
+
+  // Corrupt the length of the second record, making it claim to extend beyond the end of the log
+  auto logPath = context.metapath() / "entries.log";
+  auto size = std::filesystem::file_size(logPath);
+  {
+    std::fstream log(logPath, std::ios::binary | std::ios::in | std::ios::out);
+    constexpr std::streamoff logHeaderSize = 16; // Magic and log ID
+    log.seekg(logHeaderSize);
+    auto firstBodySize = pep::ReadBinary(log, uint32_t{});
+    log.seekp(logHeaderSize + static_cast<std::streamoff>(sizeof(uint32_t) + firstBodySize + sizeof(uint64_t)));
+    pep::WriteBinary(log, uint32_t{0xFFFFFFFF});
+    ASSERT_TRUE(log.flush());
+  }
+
+  // The valid record that follows the damaged one should not be discarded as if it were part of an incomplete append
+  EXPECT_ANY_THROW(context.reopen());
+  EXPECT_EQ(size, std::filesystem::file_size(logPath));
+}
+
+TEST(FileStore, MigratesDirectoryStorageToLog) {
+  Context context(pep::EntryStorage::Type::Directory);
+  auto name = pep::EntryName(pep::LocalPseudonym::Random(), "test");
+  context.commitInlinePage(name, 1_unixMs, "one");
+  context.commitInlinePage(name, 2_unixMs, "two");
+  EXPECT_FALSE(pep::EntryStorage::Exists(pep::EntryStorage::Type::Log, pep::CheckedPath::FromTrusted(context.metapath())));
+
+  context.storageType = pep::EntryStorage::Type::Log;
+  context.reopen();
+  EXPECT_TRUE(pep::EntryStorage::Exists(pep::EntryStorage::Type::Log, pep::CheckedPath::FromTrusted(context.metapath())));
+  EXPECT_EQ("one", context.readInlinePage(name, 1_unixMs));
+  EXPECT_EQ("two", context.readInlinePage(name, 2_unixMs));
+
+  // Entries stored after the migration don't end up in the directory storage
+  context.commitInlinePage(name, 3_unixMs, "three");
+  context.reopen();
+  EXPECT_EQ("three", context.readInlinePage(name, 3_unixMs));
+  context.storageType = pep::EntryStorage::Type::Directory;
+  context.reopen();
+  EXPECT_EQ("two", context.readInlinePage(name, 3_unixMs));
+}
+
+TEST(FileStore, CompactsLogStorage) {
+  Context context(pep::EntryStorage::Type::Log);
+  auto first = pep::EntryName(pep::LocalPseudonym::Random(), "first");
+  auto second = pep::EntryName(pep::LocalPseudonym::Random(), "second");
+  context.commitInlinePage(first, 1_unixMs, "one");
+  context.commitInlinePage(second, 2_unixMs, "two");
+  context.commitInlinePage(first, 3_unixMs, "three");
+
+  context.store->compact();
+  EXPECT_EQ("one", context.readInlinePage(first, 1_unixMs));
+  EXPECT_EQ("three", context.readInlinePage(first, 3_unixMs));
+  EXPECT_EQ("two", context.readInlinePage(second, 2_unixMs));
+
+  context.commitInlinePage(second, 4_unixMs, "four");
+  context.reopen();
+  EXPECT_EQ("one", context.readInlinePage(first, 1_unixMs));
+  EXPECT_EQ("two", context.readInlinePage(second, 2_unixMs));
+  EXPECT_EQ("four", context.readInlinePage(second, 4_unixMs));
+}
+
+TEST(FileStore, CachesHistoricalEntries) {
+  Context context(pep::EntryStorage::Type::Log);
+  auto name = pep::EntryName(pep::LocalPseudonym::Random(), "test");
+  context.commitInlinePage(name, 1_unixMs, "one");
+  context.commitInlinePage(name, 2_unixMs, "two");
+  context.commitInlinePage(name, 3_unixMs, "three");
+
+  // Historical entries are loaded once, and then served from memory
+  auto historical = context.store->lookup(name, 1_unixMs);
+  ASSERT_NE(nullptr, historical);
+  EXPECT_EQ(historical, context.store->lookup(name, 1_unixMs));
+
+  // Asynchronous lookups use (and fill) the same cache
+  auto results = context.exhaust<std::vector<std::shared_ptr<FileStore::Entry>>>(context.store->lookupAsync({
+      { .name = name, .validAt = 0_unixMs },
+      { .name = name, .validAt = 1_unixMs },
+      { .name = name, .validAt = 2_unixMs },
+      { .name = name },
+      { .name = pep::EntryName(pep::LocalPseudonym::Random(), "test") },
+    }, pep::WorkerPool::getShared()));
+  ASSERT_EQ(1U, results->size());
+  const auto& entries = results->front();
+  ASSERT_EQ(5U, entries.size());
+  EXPECT_EQ(nullptr, entries[0]);
+  EXPECT_EQ(historical, entries[1]);
+  ASSERT_NE(nullptr, entries[2]);
+  EXPECT_EQ(2_unixMs, entries[2]->getValidFrom());
+  EXPECT_EQ(entries[2], context.store->lookup(name, 2_unixMs));
+  EXPECT_EQ(context.store->lookup(name), entries[3]);
+  EXPECT_EQ(nullptr, entries[4]);
+  EXPECT_EQ("two", context.readInlinePage(name, 2_unixMs));
+}
+
+TEST(FileStore, HistoricalEntryCacheCanBeDisabled) {
+  Context context;
+  auto name = pep::EntryName(pep::LocalPseudonym::Random(), "test");
+  context.commitInlinePage(name, 1_unixMs, "one");
+  context.commitInlinePage(name, 2_unixMs, "two");
+  context.historicalEntryCacheSize = 0U;
+  context.reopen();
+
+  auto first = context.store->lookup(name, 1_unixMs);
+  auto second = context.store->lookup(name, 1_unixMs);
+  ASSERT_NE(nullptr, first);
+  ASSERT_NE(nullptr, second);
+  EXPECT_NE(first, second);
+  EXPECT_EQ(first->getValidFrom(), second->getValidFrom());
+  EXPECT_EQ("one", context.readInlinePage(name, 1_unixMs));
+
+  // The latest entry is always kept in memory
+  EXPECT_EQ(context.store->lookup(name), context.store->lookup(name, 2_unixMs));
+}
+
+TEST(FileStore, WaitsUntilEntriesAreDurable) {
+  for (auto storageType : { pep::EntryStorage::Type::Directory, pep::EntryStorage::Type::Log }) {
+    Context context(storageType);
+    auto workerPool = pep::WorkerPool::getShared();
+
+    // Nothing to wait for if nothing has been committed
+    EXPECT_EQ(1U, context.exhaust<pep::FakeVoid>(context.store->whenDurable(workerPool))->size());
+
+    // Entries committed (by separate requests) before we start waiting are synced together
+    context.commitInlinePage(pep::EntryName(pep::LocalPseudonym::Random(), "first"), 1_unixMs, "one");
+    context.commitInlinePage(pep::EntryName(pep::LocalPseudonym::Random(), "second"), 1_unixMs, "two");
+    bool firstDurable = false;
+    context.store->whenDurable(workerPool).subscribe([&firstDurable](pep::FakeVoid) { firstDurable = true; });
+    EXPECT_EQ(1U, context.exhaust<pep::FakeVoid>(context.store->whenDurable(workerPool))->size());
+    EXPECT_TRUE(firstDurable);
+
+    EXPECT_EQ(1U, context.exhaust<pep::FakeVoid>(context.store->whenDurable(workerPool))->size());
+  }
+}
+
+TEST(FileStore, DeduplicatesContentAddressedPages) {
+  Context context;
+  context.pageAddressKey = "not so secret";
+  context.reopen();
+
+  std::string page(pep::InlinePageThreshold, 'x'); // Large enough to be stored in the page store
+  auto first = pep::EntryName(pep::LocalPseudonym::Random(), "test");
+  auto second = pep::EntryName(pep::LocalPseudonym::Random(), "test");
+
+  for (const auto& name : { first, second }) {
+    auto change = context.store->modifyEntry(name, true);
+    ASSERT_TRUE(change != nullptr);
+    change->setContent(std::make_unique<EntryContent>(
+      EntryContent::Metadata(),
+      EntryContent::PayloadData(
+        {.polymorphicKey = pep::EncryptedKey(pep::CurvePoint::Random(), pep::CurvePoint::Random(), pep::CurvePoint::Random()), .blindingTimestamp = 1_unixMs, .scheme = pep::EncryptionScheme::V3},
+        nullptr)));
+    context.exhaust<std::string>(change->appendPage(std::make_shared<std::string>(page), page.size(), 0));
+    std::move(*change).commit(1_unixMs);
+  }
+
+  // Both entries refer to the same (single) page, which was uploaded only once
+  auto paths = context.store->lookup(first)->pagePaths();
+  ASSERT_EQ(1U, paths.size());
+  EXPECT_EQ(paths, context.store->lookup(second)->pagePaths());
+  EXPECT_EQ(paths, context.store->pagePaths());
+  EXPECT_TRUE(std::filesystem::exists(context.bucketpath() / *paths.begin()));
+
+  const auto* deduplicator = context.store->pageDeduplicator();
+  ASSERT_NE(nullptr, deduplicator);
+  EXPECT_EQ(1U, deduplicator->deduplicatedUploads());
+  EXPECT_EQ(2U, deduplicator->references());
+  EXPECT_EQ(1U, deduplicator->referencedPages());
+
+  // Reference counts are restored when entries are loaded
+  context.reopen();
+  deduplicator = context.store->pageDeduplicator();
+  EXPECT_EQ(2U, deduplicator->references());
+  EXPECT_EQ(1U, deduplicator->referencedPages());
+
+  for (const auto& name : { first, second }) {
+    auto pages = context.exhaust<std::shared_ptr<std::string>>(context.store->lookup(name)->readPage(0));
+    ASSERT_EQ(1U, pages->size());
+    EXPECT_EQ(page, *pages->front());
+  }
+
+  // Stores without a key keep storing pages by entry name
+  context.pageAddressKey.reset();
+  context.reopen();
+  EXPECT_EQ(nullptr, context.store->pageDeduplicator());
+}
+
 }
@@ -0,0 +1,49 @@
+#include <pep/storagefacility/PageDeduplicator.hpp>
+
+#include <gtest/gtest.h>
+
+using pep::PageDeduplicator;
+
+namespace {
+
+TEST(PageDeduplicator, AddressesDependOnContentAndKey) {
+  PageDeduplicator deduplicator("key"), other("other key");
+
+  auto address = deduplicator.address("page");
+  EXPECT_EQ(PageDeduplicator::AddressLength, address.size());
+  EXPECT_EQ(address, deduplicator.address("page"));
+  EXPECT_NE(address, deduplicator.address("other page"));
+  EXPECT_NE(address, other.address("page"));
+
+  EXPECT_THROW(PageDeduplicator(""), std::invalid_argument);
+}
+
+TEST(PageDeduplicator, CountsReferences) {
+  PageDeduplicator deduplicator("key");
+  auto first = deduplicator.address("first"), second = deduplicator.address("second");
+
+  EXPECT_FALSE(deduplicator.isStored(first));
+  EXPECT_EQ(1.0, deduplicator.ratio());
+
+  deduplicator.addReferences({ first, second });
+  deduplicator.addReferences({ first });
+  EXPECT_TRUE(deduplicator.isStored(first));
+  EXPECT_TRUE(deduplicator.isStored(second));
+  EXPECT_EQ(3U, deduplicator.references());
+  EXPECT_EQ(2U, deduplicator.referencedPages());
+  EXPECT_EQ(1.5, deduplicator.ratio());
+
+  // Unreferenced pages are still stored
+  deduplicator.removeReferences({ second });
+  EXPECT_TRUE(deduplicator.isStored(second));
+  EXPECT_EQ(2U, deduplicator.references());
+  EXPECT_EQ(1U, deduplicator.referencedPages());
+  EXPECT_THROW(deduplicator.removeReferences({ second }), std::logic_error);
+  EXPECT_THROW(deduplicator.removeReferences({ deduplicator.address("unknown") }), std::logic_error);
+
+  deduplicator.clear();
+  EXPECT_FALSE(deduplicator.isStored(first));
+  EXPECT_EQ(0U, deduplicator.references());
+}
+
+}
@@ -0,0 +1,95 @@
+#include <pep/storagefacility/PagePutWindow.hpp>
+#include <pep/async/CreateObservable.hpp>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <vector>
+
+using pep::PagePutWindow;
+
+namespace {
+
+// Puts that remain in progress until the test finishes them
+class Puts {
+private:
+  std::map<std::string, rxcpp::subscriber<std::string>> started_;
+
+public:
+  rxcpp::observable<std::string> create(const std::string& name) {
+    return pep::CreateObservable<std::string>([this, name](rxcpp::subscriber<std::string> subscriber) {
+      started_.emplace(name, subscriber);
+    });
+  }
+
+  bool started(const std::string& name) const { return started_.contains(name); }
+
+  void finish(const std::string& name) {
+    auto subscriber = started_.at(name);
+    subscriber.on_next(name);
+    subscriber.on_completed();
+  }
+};
+
+TEST(PagePutWindow, DefersPutsThatExceedWindow) {
+  auto window = PagePutWindow::Create(100);
+  Puts puts;
+  std::vector<std::string> results;
+  auto subscribe = [&window, &puts, &results](const std::string& name, uint64_t bytes) {
+    window->put(bytes, puts.create(name)).subscribe([&results](const std::string& result) { results.push_back(result); });
+  };
+
+  subscribe("first", 60);
+  subscribe("second", 60);
+  subscribe("third", 10);
+  EXPECT_TRUE(puts.started("first"));
+  EXPECT_FALSE(puts.started("second"));
+  EXPECT_FALSE(puts.started("third")); // Doesn't overtake "second", even though it fits
+  EXPECT_EQ(60U, window->pendingBytes());
+  EXPECT_EQ(2U, window->deferredPuts());
+
+  puts.finish("first");
+  EXPECT_TRUE(puts.started("second"));
+  EXPECT_TRUE(puts.started("third"));
+  EXPECT_EQ(70U, window->pendingBytes());
+
+  puts.finish("third");
+  puts.finish("second");
+  EXPECT_EQ(0U, window->pendingBytes());
+  EXPECT_EQ((std::vector<std::string>{ "first", "third", "second" }), results);
+}
+
+TEST(PagePutWindow, StartsLargePutWhenIdle) {
+  auto window = PagePutWindow::Create(100);
+  Puts puts;
+
+  window->put(1000, puts.create("large")).subscribe([](const std::string&) {});
+  EXPECT_TRUE(puts.started("large"));
+  window->put(1, puts.create("small")).subscribe([](const std::string&) {});
+  EXPECT_FALSE(puts.started("small"));
+
+  puts.finish("large");
+  EXPECT_TRUE(puts.started("small"));
+  puts.finish("small");
+  EXPECT_EQ(0U, window->pendingBytes());
+
+  EXPECT_THROW(PagePutWindow::Create(0), std::invalid_argument);
+}
+
+TEST(PagePutWindow, SkipsUnsubscribedPuts) {
+  auto window = PagePutWindow::Create(100);
+  Puts puts;
+
+  window->put(100, puts.create("first")).subscribe([](const std::string&) {});
+  auto abandoned = window->put(100, puts.create("abandoned")).subscribe([](const std::string&) {});
+  window->put(100, puts.create("last")).subscribe([](const std::string&) {});
+  abandoned.unsubscribe();
+
+  puts.finish("first");
+  EXPECT_FALSE(puts.started("abandoned"));
+  EXPECT_TRUE(puts.started("last"));
+  EXPECT_EQ(100U, window->pendingBytes());
+  EXPECT_EQ(0U, window->deferredPuts());
+}
+
+}
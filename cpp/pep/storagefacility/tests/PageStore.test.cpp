@@ -1,4 +1,5 @@
 #include <pep/storagefacility/PageStore.hpp>
+#include <pep/storagefacility/S3.hpp>
 #include <pep/storagefacility/tests/sftest.hpp>
 
 #include <gtest/gtest.h>
@@ -7,6 +8,7 @@
 #include <pep/async/tests/RxTestUtils.hpp>
 #include <pep/utils/Configuration.hpp>
 #include <pep/utils/Defer.hpp>
+#include <pep/utils/Filesystem.hpp>
 #include <pep/utils/Random.hpp>
 #include <pep/networking/EndPoint.PropertySerializer.hpp>
 #include <pep/storagefacility/S3Credentials.PropertySerializer.hpp>
@@ -14,6 +16,15 @@
 #include <boost/algorithm/hex.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#include <prometheus/metric_family.h>
+#include <prometheus/registry.h>
+#include <rxcpp/operators/rx-flat_map.hpp>
+#include <rxcpp/operators/rx-map.hpp>
+
 using namespace pep;
 
 // This test requires an S3 server (such as minio or s3proxy) to be running
@@ -24,13 +35,7 @@ using namespace pep;
 // then the PEP_ROOT_CA environmental variable might not be set (correctly).
 namespace {
 
-TEST(PageStore, basic) {
-  auto io_context = std::make_shared<boost::asio::io_context>();
-  // Run the I/O service one final time after all other PEP_DEFER invocations have scheduled their I/O cleanup jobs (i.e. TLS shutdowns)
-  PEP_DEFER(io_context->run());
-
-  sftest::Envs envs; // filled by constructor
-
+boost::property_tree::ptree S3PageStoreConfig(sftest::Envs& envs) {
   boost::property_tree::ptree s3Conf;
   SerializeProperties(s3Conf, "EndPoint", EndPoint(envs.host, envs.port, envs.expectCommonName));
   SerializeProperties(s3Conf, "Credentials", s3::Credentials{
@@ -41,9 +46,27 @@ TEST(PageStore, basic) {
   s3Conf.put("CaCertificateFile", envs.GetCaCertFilepath().string());
   s3Conf.put("WriteToBucket", envs.s3TestBucket);
   SerializeProperties(s3Conf, "ReadFromBuckets", std::vector{envs.s3TestBucket, envs.s3TestBucket2});
+  return s3Conf;
+}
+
+double GetGaugeValue(const prometheus::Registry& registry, const std::string& name) {
+  for (const auto& family : registry.Collect()) {
+    if (family.name == name) {
+      return family.metric.at(0).gauge.value;
+    }
+  }
+  throw std::runtime_error("No metric named " + name);
+}
+
+TEST(PageStore, basic) {
+  auto io_context = std::make_shared<boost::asio::io_context>();
+  // Run the I/O service one final time after all other PEP_DEFER invocations have scheduled their I/O cleanup jobs (i.e. TLS shutdowns)
+  PEP_DEFER(io_context->run());
+
+  sftest::Envs envs; // filled by constructor
 
   boost::property_tree::ptree pageStoreConf;
-  pageStoreConf.put_child("S3", s3Conf);
+  pageStoreConf.put_child("S3", S3PageStoreConfig(envs));
 
   std::shared_ptr<PageStore> store = PageStore::Create(
     io_context,
@@ -93,4 +116,219 @@ TEST(PageStore, basic) {
 
 }
 
+TEST(PageStore, ConcurrentRequests) {
+  auto io_context = std::make_shared<boost::asio::io_context>();
+  PEP_DEFER(io_context->run());
+
+  sftest::Envs envs; // filled by constructor
+
+  // Start with a single connection, that the store should add to under load
+  auto s3Conf = S3PageStoreConfig(envs);
+  s3Conf.put("Connections", 1);
+  s3Conf.put("MaxConnections", 4);
+  s3Conf.put("ProbeBucketsConcurrently", true);
+
+  boost::property_tree::ptree pageStoreConf;
+  pageStoreConf.put_child("S3", s3Conf);
+
+  auto registry = std::make_shared<prometheus::Registry>();
+  std::shared_ptr<PageStore> store = PageStore::Create(
+    io_context,
+    registry,
+    Configuration::FromPtree(pageStoreConf)
+  );
+  PEP_DEFER(store.reset());
+
+  // Sampled whenever a request completes, i.e. while other requests may still be using additional connections
+  double maxConnections = 0;
+  auto sampleConnections = [&registry, &maxConnections] {
+    maxConnections = std::max(maxConnections, GetGaugeValue(*registry, "pep_sf_s3_connections"));
+  };
+
+  std::shared_ptr<s3::Client> direct_conn
+    = envs.CreateS3Client(io_context);
+  direct_conn->start();
+  PEP_DEFER(direct_conn->shutdown());
+
+  std::vector<std::string> paths, contents;
+  for (size_t i = 0; i < 16; ++i) {
+    paths.push_back(boost::algorithm::hex(RandomString(5)));
+    contents.push_back(RandomString(100 * (i + 1)));
+  }
+
+  // a page that can only be found in the second bucket
+  std::string fallbackPath = boost::algorithm::hex(RandomString(5));
+  std::string fallbackData = RandomString(10);
+  EXPECT_EQ(testutils::exhaust<std::string>(*io_context,
+    direct_conn->putObject(fallbackPath, envs.s3TestBucket2, fallbackData))->size(), 1);
+
+  auto indices = rxcpp::observable<>::range<size_t>(0, paths.size() - 1);
+
+  EXPECT_EQ(testutils::exhaust<std::string>(*io_context,
+    indices.flat_map([&store, &paths, &contents, &sampleConnections](size_t i) {
+      return store->put(paths[i], contents[i]).map([&sampleConnections](std::string etag) {
+        sampleConnections();
+        return etag;
+      });
+    }))->size(), paths.size());
+
+  auto results = testutils::exhaust<std::pair<size_t, std::shared_ptr<std::string>>>(*io_context,
+    indices.flat_map([&store, &paths, &sampleConnections](size_t i) {
+      return store->get(paths[i]).map([i, &sampleConnections](std::shared_ptr<std::string> page) {
+        sampleConnections();
+        return std::make_pair(i, page);
+      });
+    }));
+  ASSERT_EQ(results->size(), paths.size());
+  for (const auto& [i, page] : *results) {
+    EXPECT_EQ(*page, contents[i]);
+  }
+  EXPECT_GT(maxConnections, 1.0) << "Store should have opened additional connections for concurrent requests";
+  EXPECT_LE(maxConnections, 4.0) << "Store should not exceed MaxConnections";
+
+  auto fallback = testutils::exhaust<std::shared_ptr<std::string>>(
+    *io_context, store->get(fallbackPath));
+  ASSERT_EQ(fallback->size(), 1);
+  EXPECT_EQ(*((*fallback)[0]), fallbackData);
+}
+
+TEST(PageStore, ConcurrentProbeReportsAllBuckets) {
+  auto io_context = std::make_shared<boost::asio::io_context>();
+  PEP_DEFER(io_context->run());
+
+  sftest::Envs envs; // filled by constructor
+
+  auto s3Conf = S3PageStoreConfig(envs);
+  s3Conf.erase("ReadFromBuckets");
+  SerializeProperties(s3Conf, "ReadFromBuckets", std::vector<std::string>{envs.s3TestBucket, "myNonExistingBucket"});
+  s3Conf.put("ProbeBucketsConcurrently", true);
+
+  boost::property_tree::ptree pageStoreConf;
+  pageStoreConf.put_child("S3", s3Conf);
+
+  std::shared_ptr<PageStore> store = PageStore::Create(
+    io_context,
+    std::shared_ptr<prometheus::Registry>(), // intentionally null
+    Configuration::FromPtree(pageStoreConf)
+  );
+  PEP_DEFER(store.reset());
+
+  // A page in the first bucket is found, even though the (later) second bucket fails
+  std::string path = boost::algorithm::hex(RandomString(5));
+  std::string data = RandomString(10);
+  EXPECT_EQ(testutils::exhaust<std::string>(
+    *io_context, store->put(path, data))->size(), 1);
+  auto results = testutils::exhaust<std::shared_ptr<std::string>>(
+    *io_context, store->get(path));
+  ASSERT_EQ(results->size(), 1);
+  EXPECT_EQ(*((*results)[0]), data);
+
+  // A page that the first bucket doesn't have may be in the failing one, so we get an error reporting on both buckets
+  try {
+    testutils::exhaust<std::shared_ptr<std::string>>(
+      *io_context, store->get(boost::algorithm::hex(RandomString(5))));
+    ADD_FAILURE() << "Retrieving a page from a failing bucket should produce an error";
+  }
+  catch (const std::exception& e) {
+    std::string message = e.what();
+    EXPECT_NE(message.find(envs.s3TestBucket + ": not found"), std::string::npos) << message;
+    EXPECT_NE(message.find("myNonExistingBucket: "), std::string::npos) << message;
+  }
+}
+
+TEST(PageStore, MultipartUpload) {
+  auto io_context = std::make_shared<boost::asio::io_context>();
+  PEP_DEFER(io_context->run());
+
+  sftest::Envs envs; // filled by constructor
+
+  auto s3Conf = S3PageStoreConfig(envs);
+  s3Conf.put("MaxConnections", 3);
+  s3Conf.put("MultipartPartSize", s3::Client::MinimumPartSize);
+  s3Conf.put("MultipartThreshold", s3::Client::MinimumPartSize);
+
+  boost::property_tree::ptree pageStoreConf;
+  pageStoreConf.put_child("S3", s3Conf);
+
+  std::shared_ptr<PageStore> store = PageStore::Create(
+    io_context,
+    std::make_shared<prometheus::Registry>(),
+    Configuration::FromPtree(pageStoreConf)
+  );
+  PEP_DEFER(store.reset());
+
+  // Two full parts, with the remainder (spread over both page parts) added to the last
+  std::string path = boost::algorithm::hex(RandomString(5));
+  auto data = std::make_shared<std::string>(RandomString(2 * s3::Client::MinimumPartSize + 10));
+  auto suffix = std::make_shared<std::string>(RandomString(10));
+
+  auto etags = testutils::exhaust<std::string>(*io_context, store->put(path, { data, suffix }));
+  ASSERT_EQ(etags->size(), 1);
+  // The ETag of the whole page, as a single-part upload would have returned
+  EXPECT_EQ(etags->front(), s3::ETag(*data + *suffix));
+
+  auto results = testutils::exhaust<std::shared_ptr<std::string>>(*io_context, store->get(path));
+  ASSERT_EQ(results->size(), 1);
+  EXPECT_EQ(*results->front(), *data + *suffix);
+}
+
+TEST(PageStore, CachesPages) {
+  for (bool onDisk : { false, true }) {
+    auto io_context = std::make_shared<boost::asio::io_context>();
+    pep::filesystem::Temporary temp{pep::filesystem::temp_directory_path() / pep::filesystem::RandomizedName("pepTest-PageCache-%%%%-%%%%-%%%%")};
+    const auto& dir = temp.path();
+    std::filesystem::create_directories(dir / "data" / "bucket");
+
+    boost::property_tree::ptree pageStoreConf;
+    pageStoreConf.put("Local.DataDir", (dir / "data").string());
+    pageStoreConf.put("Local.Bucket", "bucket");
+    pageStoreConf.put("Cache.MaxSize", 100);
+    if (onDisk) {
+      pageStoreConf.put("Cache.Directory", (dir / "cache").string());
+    }
+
+    std::shared_ptr<PageStore> store = PageStore::Create(
+      io_context,
+      std::make_shared<prometheus::Registry>(),
+      Configuration::FromPtree(pageStoreConf)
+    );
+    auto get = [&store, &io_context](const std::string& path) -> std::optional<std::string> {
+      auto results = testutils::exhaust<std::shared_ptr<std::string>>(*io_context, store->get(path));
+      if (results->empty()) {
+        return std::nullopt;
+      }
+      EXPECT_EQ(results->size(), 1);
+      return *results->front();
+    };
+
+    std::string data(60, 'a'), data2(60, 'b');
+    EXPECT_EQ(testutils::exhaust<std::string>(*io_context, store->put("first.page", data))->size(), 1);
+
+    // The written page is served from the cache, even if it disappears from the underlying store
+    std::filesystem::remove(dir / "data" / "bucket" / "first.page");
+    EXPECT_EQ(get("first.page"), data);
+
+    // Caching a second page evicts the first, since both don't fit
+    EXPECT_EQ(testutils::exhaust<std::string>(*io_context, store->put("second.page", data2))->size(), 1);
+    EXPECT_EQ(get("first.page"), std::nullopt);
+
+    if (onDisk) {
+      // Corrupt cached pages are discarded and retrieved from the underlying store instead
+      for (const auto& file : std::filesystem::directory_iterator(dir / "cache" / "page-cache")) {
+        std::ofstream(file.path()) << "corrupt";
+      }
+    }
+    else {
+      // Consumers can't modify cached pages
+      auto page = testutils::exhaust<std::shared_ptr<std::string>>(*io_context, store->get("second.page"));
+      ASSERT_EQ(page->size(), 1);
+      page->front()->clear();
+    }
+    EXPECT_EQ(get("second.page"), data2);
+
+    store.reset();
+    io_context->run();
+  }
+}
+
 }
@@ -306,5 +306,14 @@ namespace {
   }
 
 
-}
+  TEST(S3, MultipartETag) {
+    // "a" and "b" uploaded as separate parts
+    EXPECT_EQ(MultipartETag({ ETag("a"), ETag("b") }),
+        "\"96e024ba2074fe77e8e965ba43a704be-2\"");
+    EXPECT_NE(MultipartETag({ ETag("b"), ETag("a") }),
+        MultipartETag({ ETag("a"), ETag("b") }));
+    EXPECT_ANY_THROW(MultipartETag({ "unquoted" }));
+  }
 
+
+}
@@ -61,4 +61,55 @@ namespace {
         client->getObject("objectName", "myNonExistingBucket")));
   }
 
+  TEST(S3Client, multipartUpload) {
+    auto io_context = std::make_shared<boost::asio::io_context>();
+    sftest::Envs envs; // fills itself with environment variables PEP_*
+
+    std::shared_ptr<Client> client = envs.CreateS3Client(io_context);
+    client->start();
+    PEP_DEFER(client->shutdown(); io_context->run(););
+
+    auto first = std::make_shared<std::string>(Client::MinimumPartSize, 'a');
+    auto last = std::make_shared<std::string>(10, 'b');
+
+    auto uploadIds = testutils::exhaust<std::string>(*io_context,
+      client->createMultipartUpload("multipartObject", envs.s3TestBucket));
+    ASSERT_EQ(uploadIds->size(), 1);
+    auto uploadId = uploadIds->front();
+
+    std::vector<std::string> partETags;
+    for (const auto& [partNumber, part] : { std::make_pair(1U, first), std::make_pair(2U, last) }) {
+      auto results = testutils::exhaust<std::string>(*io_context,
+        client->uploadPart("multipartObject", envs.s3TestBucket, uploadId, partNumber, { part }));
+      ASSERT_EQ(results->size(), 1);
+      EXPECT_EQ(results->front(), ETag(*part));
+      partETags.push_back(results->front());
+    }
+
+    {
+      auto results = testutils::exhaust<std::string>(*io_context,
+        client->completeMultipartUpload("multipartObject", envs.s3TestBucket, uploadId, partETags));
+      ASSERT_EQ(results->size(), 1);
+      EXPECT_EQ(results->front(), MultipartETag(partETags));
+    }
+
+    {
+      auto results = testutils::exhaust<std::shared_ptr<std::string>>(
+          *io_context, client->getObject("multipartObject", envs.s3TestBucket));
+      ASSERT_EQ(results->size(), 1);
+      EXPECT_EQ(*((*results)[0]), *first + *last);
+    }
+
+    // An aborted upload doesn't produce an object
+    uploadIds = testutils::exhaust<std::string>(*io_context,
+      client->createMultipartUpload("abortedObject", envs.s3TestBucket));
+    ASSERT_EQ(uploadIds->size(), 1);
+    EXPECT_EQ(testutils::exhaust<std::string>(*io_context,
+      client->uploadPart("abortedObject", envs.s3TestBucket, uploadIds->front(), 1, { last }))->size(), 1);
+    EXPECT_EQ(testutils::exhaust<FakeVoid>(*io_context,
+      client->abortMultipartUpload("abortedObject", envs.s3TestBucket, uploadIds->front()))->size(), 1);
+    EXPECT_TRUE(testutils::exhaust<std::shared_ptr<std::string>>(
+      *io_context, client->getObject("abortedObject", envs.s3TestBucket))->empty());
+  }
+
 }
@@ -0,0 +1,58 @@
+#include <pep/storagefacility/TicketPseudonymCache.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace pep;
+
+namespace {
+
+std::shared_ptr<const TicketPseudonyms> MakeTicketPseudonyms(size_t count) {
+  std::vector<LocalPseudonym> localPseudonyms;
+  for (size_t i = 0; i < count; ++i) {
+    localPseudonyms.push_back(LocalPseudonym::Random());
+  }
+  return std::make_shared<const TicketPseudonyms>(std::move(localPseudonyms));
+}
+
+TEST(TicketPseudonyms, FindsIndices) {
+  auto pseudonyms = MakeTicketPseudonyms(3);
+  for (size_t i = 0; i < pseudonyms->size(); ++i) {
+    EXPECT_EQ(pseudonyms->find(pseudonyms->localPseudonyms()[i]), i);
+  }
+  EXPECT_EQ(pseudonyms->find(LocalPseudonym::Random()), std::nullopt);
+}
+
+TEST(TicketPseudonymCache, LooksUpInsertedEntries) {
+  TicketPseudonymCache cache;
+  auto pseudonyms = MakeTicketPseudonyms(2);
+  EXPECT_EQ(cache.lookup("ticket"), nullptr);
+  cache.insert("ticket", pseudonyms);
+  EXPECT_EQ(cache.lookup("ticket"), pseudonyms);
+  EXPECT_EQ(cache.lookup("other ticket"), nullptr);
+
+  // Inserting a ticket again keeps the existing entry
+  cache.insert("ticket", MakeTicketPseudonyms(2));
+  EXPECT_EQ(cache.lookup("ticket"), pseudonyms);
+  EXPECT_EQ(cache.tickets(), 1U);
+  EXPECT_EQ(cache.pseudonyms(), 2U);
+}
+
+TEST(TicketPseudonymCache, EvictsLeastRecentlyUsed) {
+  TicketPseudonymCache cache(5);
+  cache.insert("a", MakeTicketPseudonyms(2));
+  cache.insert("b", MakeTicketPseudonyms(2));
+  EXPECT_NE(cache.lookup("a"), nullptr); // "b" is now the least recently used
+
+  cache.insert("c", MakeTicketPseudonyms(2));
+  EXPECT_NE(cache.lookup("a"), nullptr);
+  EXPECT_EQ(cache.lookup("b"), nullptr);
+  EXPECT_NE(cache.lookup("c"), nullptr);
+  EXPECT_EQ(cache.pseudonyms(), 4U);
+
+  // Entries larger than the cache itself are not cached at all
+  cache.insert("d", MakeTicketPseudonyms(6));
+  EXPECT_EQ(cache.lookup("d"), nullptr);
+  EXPECT_EQ(cache.tickets(), 2U);
+}
+
+}
@@ -37,6 +37,15 @@ std::string GenerateShortPseudonym(std::string_view prefix, const std::size_t le
   return pseudonym;
 }
 
+std::string GenerateUniqueShortPseudonym(std::string_view prefix, std::size_t len, std::unordered_set<std::string>& existing) {
+  while (true) {
+    auto [position, added] = existing.insert(GenerateShortPseudonym(prefix, len));
+    if (added) {
+      return *position;
+    }
+  }
+}
+
 bool ShortPseudonymIsValid(const std::string& shortPseudonym) {
   return Mod97::Verify(shortPseudonym);
 }
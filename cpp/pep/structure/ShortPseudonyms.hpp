@@ -4,6 +4,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 namespace pep {
@@ -15,6 +16,15 @@ namespace pep {
 /// \return The generated short pseudonym
 std::string GenerateShortPseudonym(std::string_view prefix, std::size_t len);
 
+/// \brief Generate a short pseudonym (see GenerateShortPseudonym) that doesn't occur in the existing set yet, and add it to that set.
+/// \remark Each attempt is a single hash lookup, so the cost doesn't depend on the number of existing values.
+///
+/// \param prefix Prefix for the short pseudonym to be generated
+/// \param len Length of random part of the short pseudonym to be generated
+/// \param existing The values that the generated short pseudonym must not collide with
+/// \return The generated short pseudonym
+std::string GenerateUniqueShortPseudonym(std::string_view prefix, std::size_t len, std::unordered_set<std::string>& existing);
+
 /// \brief Verify whether the check digits (last two characters) of the provided short pseudonym are valid.
 ///
 /// \param shortPseudonym p_shortPseudonym:...
@@ -13,6 +13,17 @@ TEST(ShortPseudonymsTest, TestGenerateShortPseudonym) {
   EXPECT_TRUE(pep::ShortPseudonymIsValid(shortPseudonym));
 }
 
+TEST(ShortPseudonymsTest, TestGenerateUniqueShortPseudonym) {
+  // A single random digit allows for 10 distinct short pseudonyms
+  std::unordered_set<std::string> existing{ "unrelated" };
+  for (size_t i = 1; i <= 10; ++i) {
+    auto shortPseudonym = pep::GenerateUniqueShortPseudonym("P-", 1, existing);
+    EXPECT_TRUE(pep::ShortPseudonymIsValid(shortPseudonym));
+    EXPECT_EQ(existing.count(shortPseudonym), 1U);
+    EXPECT_EQ(existing.size(), i + 1U) << "Generated short pseudonym should not have been present yet";
+  }
+}
+
 TEST(ShortPseudonymsTest, TestIsValid) {
   // Some random short pseudonyms
   EXPECT_TRUE(pep::ShortPseudonymIsValid("POM-TEST-25"));
@@ -1,17 +1,24 @@
 #include <pep/auth/ServerTraits.hpp>
 #include <pep/ticketing/TicketingSerializers.hpp>
 #include <pep/utils/Math.hpp>
+#include <pep/utils/OpenSSLHasher.hpp>
 
 using namespace std::literals;
 
 namespace pep {
 
 void LocalPseudonyms::ensurePacked() const {
-  accessManager.ensurePacked();
-  storageFacility.ensurePacked();
-  polymorphic.ensurePacked();
+  std::vector<const CurvePoint*> points;
+  addPointsTo(points);
+  CurvePoint::PackBatch(points);
+}
+
+void LocalPseudonyms::addPointsTo(std::vector<const CurvePoint*>& points) const {
+  accessManager.addPointsTo(points);
+  storageFacility.addPointsTo(points);
+  polymorphic.addPointsTo(points);
   if (accessGroup)
-    accessGroup->ensurePacked();
+    accessGroup->addPointsTo(points);
 }
 
 std::vector<PolymorphicPseudonym> GetPolymorphicPseudonyms(const std::vector<LocalPseudonyms>& lps) {
@@ -107,6 +114,14 @@ Ticket2 SignedTicket2::openForLogging(const X509RootCertificates& rootCAs, std::
   return ticket;
 }
 
+std::string SignedTicket2::signatureDigest() const {
+  if (!signature_)
+    throw Error("AccessManager signature is missing");
+  if (!transcryptorSignature_)
+    throw Error("Transcryptor signature is missing");
+  return Sha256().digest(signature_->signature(), transcryptorSignature_->signature());
+}
+
 Signed<Ticket2>::Signed(Ticket2 ticket,
   const X509Identity& identity) {
   auto data = Serialization::ToString(std::move(ticket));
@@ -14,6 +14,8 @@ struct LocalPseudonyms {
   // Ensures the underlying CurvePoint's are pre-packed for serialization.
   // See CurvePoint::ensurePacked().
   void ensurePacked() const;
+  // Adds the underlying CurvePoint's to points, to pack them using CurvePoint::PackBatch().
+  void addPointsTo(std::vector<const CurvePoint*>& points) const;
 };
 
 /// Utility function to convert a vector of LocalPseudonyms to a vector of PolymorphicPseudonyms
@@ -60,6 +62,10 @@ public:
     const std::optional<std::string>& accessMode = std::nullopt) const;
 
   Ticket2 openForLogging(const X509RootCertificates& rootCAs, std::string& serialized) const;
+
+  /// \brief Produces a digest of the ticket's signatures, e.g. to key a cache on.
+  /// \warning Only identifies the ticket's contents after open() has validated the signatures.
+  std::string signatureDigest() const;
 };
 
 class SignedTicket2ValidityPeriodError : public DeserializableDerivedError<SignedTicket2ValidityPeriodError> {
@@ -10,6 +10,7 @@
 #include <pep/elgamal/ElgamalSerializers.hpp>
 #include <pep/ticketing/TicketingSerializers.hpp>
 #include <pep/crypto/CryptoSerializers.hpp>
+#include <pep/database/RecordChecksumChain.hpp>
 #include <pep/database/Storage.hpp>
 
 #include <sqlite_orm/sqlite_orm.h>
@@ -573,33 +574,7 @@ struct TranscryptorStorageBackend : database::Storage<TsCreateDb> {
 namespace {
 
 template <typename TRecord>
-class ChecksumChainFor : public transcryptor::ChecksumChain {
-protected:
-  Result calculate(std::shared_ptr<TranscryptorStorageBackend> storage, const Result& partial, uint64_t maxCheckpoint) const override {
-    assert(partial.checkpoint < maxCheckpoint);
-    auto result = partial;
-
-    int64_t minSeqNo = -1; // The full chain includes all sequence numbers (0 or higher, i.e. greater than -1)
-    if (partial.checkpoint != EmptyTableCheckpoint) { // If we have a (previously calculated) partial result...
-      assert(partial.checkpoint > EmptyTableCheckpoint);
-      minSeqNo = CheckpointToSeqNo(partial.checkpoint); // ... only process records (with sequence numbers) that aren't included in the partial result yet
-    }
-
-    for (const auto& record : storage->raw.iterate<TRecord>(
-      where(c(&TRecord::seqno) > minSeqNo // Only process entries that aren't included in the "partial" result yet
-        && c(&TRecord::seqno) <= CheckpointToSeqNo(maxCheckpoint)))) { // Only process entries up to (and including) the specified "maxCheckpoint"
-
-      // Keep track of the highest checkpoint encountered: we're iterating/processing in arbitrary order
-      result.checkpoint = std::max(result.checkpoint, SeqNoToCheckpoint(record.seqno));
-      result.checksum ^= record.checksum();
-        }
-
-    return result;
-  }
-
-public:
-  explicit ChecksumChainFor(std::string name) noexcept : ChecksumChain(std::move(name)) {}
-};
+using ChecksumChainFor = database::RecordChecksumChain<TranscryptorStorageBackend, TRecord>;
 
 [[nodiscard]] std::string CertificateHash(const X509Certificate& cert) {
   return Sha256{}.digest(cert.toDer());
@@ -608,22 +583,22 @@ public:
 }
 
 TranscryptorStorage::TranscryptorStorage(
-    const std::filesystem::path& path) : path_(path.string()) {
-  storage_ = std::make_shared<TranscryptorStorageBackend>(path.string());
+    const std::filesystem::path& path, database::StorageProfile profile) : path_(path.string()) {
+  storage_ = std::make_shared<TranscryptorStorageBackend>(path.string(), std::move(profile));
 
   ensureInitialized();
   removeOutdatedRecords();
 
   // Can't assign an { initializer-list } to checksumChains_ because it requires copy construction of the elements, which std::unique_ptr<> doesn't support
-  checksumChains_.insert(std::make_unique<ChecksumChainFor<MigrationRecord>>("migration"));
-  checksumChains_.insert(std::make_unique<ChecksumChainFor<TicketRequestRecord>>("ticket-request"));
-  checksumChains_.insert(std::make_unique<ChecksumChainFor<TicketIssueRecord>>("ticket-issue"));
-  checksumChains_.insert(std::make_unique<ChecksumChainFor<PseudonymSetRecord>>("pseudonym-set"));
-  checksumChains_.insert(std::make_unique<ChecksumChainFor<PseudonymSetPseudonymRecord>>("pseudonym-set-pseudonym"));
-  checksumChains_.insert(std::make_unique<ChecksumChainFor<ColumnSetRecord>>("column-set"));
-  checksumChains_.insert(std::make_unique<ChecksumChainFor<ColumnSetColumnRecord>>("column-set-column"));
-  checksumChains_.insert(std::make_unique<ChecksumChainFor<ModeSetRecord>>("mode-set"));
-  checksumChains_.insert(std::make_unique<ChecksumChainFor<ModeSetModeRecord>>("mode-set-mode"));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<MigrationRecord>>("migration", storage_));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<TicketRequestRecord>>("ticket-request", storage_));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<TicketIssueRecord>>("ticket-issue", storage_));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<PseudonymSetRecord>>("pseudonym-set", storage_));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<PseudonymSetPseudonymRecord>>("pseudonym-set-pseudonym", storage_));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<ColumnSetRecord>>("column-set", storage_));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<ColumnSetColumnRecord>>("column-set-column", storage_));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<ModeSetRecord>>("mode-set", storage_));
+  checksumChains_.insert(std::make_unique<ChecksumChainFor<ModeSetModeRecord>>("mode-set-mode", storage_));
 }
 
 // Makes sure that the database is correctly initialized.  Adds columns
@@ -779,7 +754,7 @@ void TranscryptorStorage::computeChecksum(const std::string& chain,
     throw Error("No such checksum chain");
   }
 
-  auto result = (*position)->get(storage_, maxCheckpoint.value_or(std::numeric_limits<int64_t>::max()));
+  auto result = (*position)->get(maxCheckpoint.value_or(std::numeric_limits<int64_t>::max()));
   checksum = result.checksum;
   checkpoint = result.checkpoint;
 }
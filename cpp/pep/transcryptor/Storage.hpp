@@ -8,18 +8,21 @@
 #include <pep/rsk/Proofs.hpp>
 #include <pep/rsk-pep/Pseudonyms.hpp>
 #include <pep/ticketing/TicketingMessages.hpp>
-#include <pep/transcryptor/ChecksumChain.hpp>
+#include <pep/database/ChecksumChain.hpp>
+#include <pep/database/StorageProfile.hpp>
 #include <pep/utils/PropertyBasedContainer.hpp>
 
 #include <filesystem>
 
 namespace pep {
 
+struct TranscryptorStorageBackend;
+
 class TranscryptorStorage {
 private:
   std::shared_ptr<TranscryptorStorageBackend> storage_;
   std::string path_;
-  PropertyBasedContainer<std::unique_ptr<transcryptor::ChecksumChain>, &transcryptor::ChecksumChain::name>::set checksumChains_;
+  PropertyBasedContainer<std::unique_ptr<database::ChecksumChain>, &database::ChecksumChain::name>::set checksumChains_;
 
   void ensureInitialized();
   void ensureInitialized_unguarded(bool& migrated);
@@ -39,7 +42,7 @@ private:
 
   std::string getPath() const { return path_; }
 
-  TranscryptorStorage(const std::filesystem::path& path);
+  TranscryptorStorage(const std::filesystem::path& path, database::StorageProfile profile = {});
 
   /// Retrieve stored verifiers for domain & session corresponding to certificate.
   std::optional<ReshuffleRekeyVerifiers> getUserVerifiers(const X509Certificate& userCertificate);
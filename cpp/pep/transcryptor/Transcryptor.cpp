@@ -1,6 +1,7 @@
 #include <pep/transcryptor/Transcryptor.hpp>
 
 #include <pep/auth/EnrolledParty.hpp>
+#include <pep/database/StorageProfile.PropertySerializer.hpp>
 #include <pep/morphing/MorphingPropertySerializers.hpp>
 #include <pep/morphing/RepoKeys.hpp>
 #include <pep/morphing/RepoRecipient.hpp>
@@ -25,8 +26,10 @@
 #include <rxcpp/operators/rx-flat_map.hpp>
 #include <rxcpp/operators/rx-tap.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <numeric>
+#include <span>
 
 namespace pep {
 
@@ -35,6 +38,11 @@ const std::string LogTag ("Transcryptor");
 constexpr Severity TranscryptorRequestLoggingSeverity = Severity::Debug;
 constexpr Severity LogIssuedTicketRequestLoggingSeverity = Severity::Debug;
 constexpr Severity ChecksumChainCalculationLoggingSeverity = Severity::Debug;
+
+// Number of request entries whose RSK proofs are verified as a single batch.
+// Larger chunks amortize more of the verification cost, smaller chunks spread
+// the work better over the worker pool.
+constexpr size_t ProofCheckChunkSize = 16U;
 }
 
 Transcryptor::Metrics::Metrics(std::shared_ptr<prometheus::Registry> registry) :
@@ -56,11 +64,13 @@ Transcryptor::Parameters::Parameters(std::shared_ptr<boost::asio::io_context> io
   : KeyComponentServer::Parameters(io_context, config) {
   std::filesystem::path keysFile;
   std::filesystem::path storageFile;
+  std::optional<database::StorageProfile> storageProfile;
   std::filesystem::path verifiersFile; // used to check RSK proofs made by access manager
 
   try {
     keysFile = config.get<std::filesystem::path>("EnrolledPartyKeysFile");
     storageFile = config.get<std::filesystem::path>("StorageFile");
+    storageProfile = config.get<std::optional<database::StorageProfile>>("StorageProfile");
     verifiersFile = config.get<std::filesystem::path>("VerifiersFile");
 
     auto serverEndPoints = config.get_child("ServerEndPoints");
@@ -82,7 +92,7 @@ Transcryptor::Parameters::Parameters(std::shared_ptr<boost::asio::io_context> io
          "this is an error" << std::endl;
   }
 
-  setStorage(std::make_shared<TranscryptorStorage>(storageFile));
+  setStorage(std::make_shared<TranscryptorStorage>(storageFile, storageProfile.value_or(database::StorageProfile())));
 
   try {
     setVerifiers(
@@ -201,78 +211,87 @@ messaging::MessageBatches Transcryptor::handleTranscryptorRequest(std::shared_pt
     return batch;
       })
     .concat_map([server, ctx](std::shared_ptr<Batch> batch) {
-    std::vector<size_t> is(batch->requestEntries.size());
     PEP_LOG(LogTag, TranscryptorRequestLoggingSeverity) << "Transcryptor request " << ctx->requestNumber << " processing " << batch->requestEntries.size() << "-entry batch";
-    std::iota(is.begin(), is.end(), 0);
-    return server->workerPool_->batched_map<8>(std::move(is),
+    // Entries are processed in chunks, so that the RSK proofs of each chunk can be verified at once
+    std::vector<size_t> chunks((batch->requestEntries.size() + ProofCheckChunkSize - 1) / ProofCheckChunkSize);
+    std::iota(chunks.begin(), chunks.end(), 0);
+    return server->workerPool_->batched_map<1>(std::move(chunks),
       ObserveOnAsio(*server->getIoContext()),
-      [server, ctx, batch](size_t i) {
-      const auto& entry = batch->requestEntries[i];
-      auto& ret = batch->results.responseEntries[i];
-      auto& localPseudonym = batch->results.localPseudonyms[i];
-
-      if (ctx->includeUserGroupPseudonyms) {
-        if (!entry.userGroup)
-          throw Error("AccessGroup pseudonym missing "
-            "even though includeAccessGroupPseudonyms is set");
-        if (!entry.userGroupProof)
-          throw Error("AccessGroup RskProof missing "
-            "even though includeAccessGroupPseudonyms is set");
-      }
-      else {
-        if (entry.userGroup)
-          throw Error("AccessGroup pseudonym set even though "
-            "includeAccessGroupPseudonyms is not set");
-        if (entry.userGroupProof)
-          throw Error("AccessGroup RskProof set even though "
-            "includeAccessGroupPseudonyms is not set");
-      }
-
+      [server, ctx, batch](size_t chunk) {
+      auto begin = chunk * ProofCheckChunkSize;
+      auto end = std::min(begin + ProofCheckChunkSize, batch->requestEntries.size());
       const PseudonymTranslator& pseudonymTranslator = server->pseudonymTranslator();
-      // Verify that the AM has properly RSKed the pseudonyms.
-      try {
-        pseudonymTranslator.checkTranslationProof(
-            entry.polymorphic, entry.accessManager,
-            entry.accessManagerProof, server->verifiers_.accessManager);
-        pseudonymTranslator.checkTranslationProof(
-            entry.polymorphic, entry.storageFacility,
-            entry.storageFacilityProof, server->verifiers_.storageFacility);
-        pseudonymTranslator.checkTranslationProof(
-            entry.polymorphic, entry.transcryptor,
-            entry.transcryptorProof, server->verifiers_.transcryptor);
 
+      std::vector<PseudonymTranslator::TranslationProofCheck> checks;
+      for (auto i = begin; i < end; ++i) {
+        const auto& entry = batch->requestEntries[i];
         if (ctx->includeUserGroupPseudonyms) {
-          pseudonymTranslator.checkTranslationProof(
-              entry.polymorphic, *entry.userGroup,
-              *entry.userGroupProof, *ctx->userVerifiers);
+          if (!entry.userGroup)
+            throw Error("AccessGroup pseudonym missing "
+              "even though includeAccessGroupPseudonyms is set");
+          if (!entry.userGroupProof)
+            throw Error("AccessGroup RskProof missing "
+              "even though includeAccessGroupPseudonyms is set");
+        }
+        else {
+          if (entry.userGroup)
+            throw Error("AccessGroup pseudonym set even though "
+              "includeAccessGroupPseudonyms is not set");
+          if (entry.userGroupProof)
+            throw Error("AccessGroup RskProof set even though "
+              "includeAccessGroupPseudonyms is not set");
+        }
+
+        // Verify that the AM has properly RSKed the pseudonyms.
+        checks.push_back({entry.polymorphic, entry.accessManager,
+            entry.accessManagerProof, server->verifiers_.accessManager});
+        checks.push_back({entry.polymorphic, entry.storageFacility,
+            entry.storageFacilityProof, server->verifiers_.storageFacility});
+        checks.push_back({entry.polymorphic, entry.transcryptor,
+            entry.transcryptorProof, server->verifiers_.transcryptor});
+        if (ctx->includeUserGroupPseudonyms) {
+          checks.push_back({entry.polymorphic, *entry.userGroup,
+              *entry.userGroupProof, *ctx->userVerifiers});
         }
       }
-      catch (const InvalidProof&) {
-        throw Error("RSK Proof invalid");
+      if (auto invalid = pseudonymTranslator.findInvalidTranslationProof(checks)) {
+        auto checksPerEntry = checks.size() / (end - begin);
+        throw Error("RSK Proof invalid for entry " + std::to_string(begin + *invalid / checksPerEntry));
       }
 
-      // All seems fine: create final encrypted pseudonyms
-      ret.polymorphic = entry.polymorphic;
-      ret.storageFacility = pseudonymTranslator.translateStep(
-          entry.storageFacility,
-          RecipientForServer(EnrolledParty::StorageFacility));
-      ret.accessManager = pseudonymTranslator.translateStep(
-          entry.accessManager,
-          RecipientForServer(EnrolledParty::AccessManager));
-      localPseudonym = pseudonymTranslator.translateStep(
-          entry.transcryptor,
-          RecipientForServer(EnrolledParty::Transcryptor)
-      ).decrypt(*server->pseudonymKey_);
-
-      if (ctx->includeUserGroupPseudonyms) {
-        ret.accessGroup = pseudonymTranslator.translateStep(
-            *entry.userGroup,
-            *ctx->userRecipient);
+      for (auto i = begin; i < end; ++i) {
+        const auto& entry = batch->requestEntries[i];
+        auto& ret = batch->results.responseEntries[i];
+        auto& localPseudonym = batch->results.localPseudonyms[i];
+
+        // All seems fine: create final encrypted pseudonyms
+        ret.polymorphic = entry.polymorphic;
+        ret.storageFacility = pseudonymTranslator.translateStep(
+            entry.storageFacility,
+            RecipientForServer(EnrolledParty::StorageFacility));
+        ret.accessManager = pseudonymTranslator.translateStep(
+            entry.accessManager,
+            RecipientForServer(EnrolledParty::AccessManager));
+        localPseudonym = pseudonymTranslator.translateStep(
+            entry.transcryptor,
+            RecipientForServer(EnrolledParty::Transcryptor)
+        ).decrypt(*server->pseudonymKey_);
+
+        if (ctx->includeUserGroupPseudonyms) {
+          ret.accessGroup = pseudonymTranslator.translateStep(
+              *entry.userGroup,
+              *ctx->userRecipient);
+        }
       }
 
-      localPseudonym.ensurePacked();
-      ret.ensurePacked(); // prepack pseudonyms
-      return i;
+      // Prepack pseudonyms
+      std::vector<const CurvePoint*> points;
+      for (auto i = begin; i < end; ++i) {
+        batch->results.responseEntries[i].addPointsTo(points);
+        batch->results.localPseudonyms[i].addPointsTo(points);
+      }
+      CurvePoint::PackBatch(points);
+      return chunk;
       })
       .map([batch](const std::vector<size_t>& unused [[maybe_unused]] ) {return batch; });
       })
@@ -391,10 +410,10 @@ messaging::MessageBatches Transcryptor::handleRekeyRequest(std::shared_ptr<Rekey
           ObserveOnAsio(*getIoContext()),
       [server = SharedFrom(*this), recipient](EncryptedKey entry) {
 
-    EncryptedKey retEntry = server->dataTranslator().translateStep(entry, recipient);
-    retEntry.ensurePacked();
-
-    return retEntry;
+    return server->dataTranslator().translateStep(entry, recipient);
+  },
+  [](std::span<EncryptedKey> keys) {
+    ElgamalEncryption::EnsurePacked(keys);
   }).map([](std::vector<EncryptedKey> keys){
     RekeyResponse resp;
     resp.keys = std::move(keys);
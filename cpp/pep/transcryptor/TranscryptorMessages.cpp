@@ -3,17 +3,23 @@
 namespace pep {
 
 void TranscryptorRequestEntry::ensurePacked() const {
-  polymorphic.ensurePacked();
-  accessManager.ensurePacked();
-  storageFacility.ensurePacked();
-  transcryptor.ensurePacked();
-  accessManagerProof.ensurePacked();
-  storageFacilityProof.ensurePacked();
-  transcryptorProof.ensurePacked();
+  std::vector<const CurvePoint*> points;
+  addPointsTo(points);
+  CurvePoint::PackBatch(points);
+}
+
+void TranscryptorRequestEntry::addPointsTo(std::vector<const CurvePoint*>& points) const {
+  polymorphic.addPointsTo(points);
+  accessManager.addPointsTo(points);
+  storageFacility.addPointsTo(points);
+  transcryptor.addPointsTo(points);
+  accessManagerProof.addPointsTo(points);
+  storageFacilityProof.addPointsTo(points);
+  transcryptorProof.addPointsTo(points);
   if (userGroup)
-    userGroup->ensurePacked();
+    userGroup->addPointsTo(points);
   if (userGroupProof)
-    userGroupProof->ensurePacked();
+    userGroupProof->addPointsTo(points);
 }
 
 }
@@ -33,6 +33,8 @@ struct TranscryptorRequestEntry {
   // Ensures the underlying CurvePoint's are pre-packed for serialization.
   // See CurvePoint::ensurePacked().
   void ensurePacked() const;
+  // Adds the underlying CurvePoint's to points, to pack them using CurvePoint::PackBatch().
+  void addPointsTo(std::vector<const CurvePoint*>& points) const;
 };
 
 struct TranscryptorRequestEntries {
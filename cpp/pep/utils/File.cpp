@@ -13,6 +13,13 @@
 #include <regex>
 #include <cassert>
 
+#ifdef _WIN32
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
+#include <fcntl.h>
+
 using namespace std::literals;
 
 namespace pep {
@@ -60,6 +67,41 @@ void WriteFile(const std::filesystem::path& path, const std::string& content) {
   output.close();
 }
 
+void SyncFile(const std::filesystem::path& path) {
+#ifdef _WIN32
+  auto fd = _wopen(path.c_str(), _O_RDWR | _O_BINARY);
+#else
+  auto fd = open(path.c_str(), O_RDONLY);
+#endif
+  if (fd < 0) {
+    throw std::runtime_error("Could not open file for syncing: " + path.string());
+  }
+#ifdef _WIN32
+  auto result = _commit(fd);
+  _close(fd);
+#else
+  auto result = fsync(fd);
+  close(fd);
+#endif
+  if (result != 0) {
+    throw std::runtime_error("Could not sync file to storage: " + path.string());
+  }
+}
+
+void SyncDirectory(const std::filesystem::path& path) {
+#ifndef _WIN32
+  auto fd = open(path.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0) {
+    throw std::runtime_error("Could not open directory for syncing: " + path.string());
+  }
+  auto result = fsync(fd);
+  close(fd);
+  if (result != 0) {
+    throw std::runtime_error("Could not sync directory to storage: " + path.string());
+  }
+#endif
+}
+
 bool IsValidFileExtension(const std::string& extension) {
   const std::regex extensionRegex("(\\.[A-Za-z0-9]+)+");
   return std::regex_match(extension, extensionRegex);
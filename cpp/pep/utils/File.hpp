@@ -10,6 +10,11 @@ namespace pep {
 std::string ReadFile(const std::filesystem::path& path);
 std::optional<std::string> ReadFileIfExists(const std::filesystem::path& path);
 void WriteFile(const std::filesystem::path& path, const std::string& content);
+/// \brief Ensures that the (previously written) contents of the file have been transferred to the storage device, e.g. using fsync.
+void SyncFile(const std::filesystem::path& path);
+/// \brief Ensures that changes to the directory's entries (e.g. files that were created or renamed into it) have been transferred to the storage device.
+/// \remark A no-op on Windows, which doesn't support syncing directories (and whose NTFS journals such changes).
+void SyncDirectory(const std::filesystem::path& path);
 [[nodiscard]] bool IsValidFileExtension(const std::string& extension);
 
 [[nodiscard]] bool IsValidUnixFileName(std::string_view name);